@@ -34,6 +34,7 @@ int EXPORT_OUT_API SMO_close(SMO_Handle p_handle);
 int EXPORT_OUT_API SMO_open(SMO_Handle p_handle, const char *path);
 int EXPORT_OUT_API SMO_getVersion(SMO_Handle p_handle, int *version);
 int EXPORT_OUT_API SMO_getProjectSize(SMO_Handle p_handle, int **int_out, int *int_dim);
+int EXPORT_OUT_API SMO_getSavedVariables(SMO_Handle p_handle, SMO_elementType type, int **int_out, int *int_dim);
 
 int EXPORT_OUT_API SMO_getUnits(SMO_Handle p_handle, int **int_out, int *int_dim);
 int EXPORT_OUT_API SMO_getStartDate(SMO_Handle p_handle, double *date);
@@ -44,6 +45,8 @@ int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex,
 int EXPORT_OUT_API SMO_getNodeSeries(SMO_Handle p_handle, int nodeIndex, SMO_nodeAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getLinkSeries(SMO_Handle p_handle, int linkIndex, SMO_linkAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
+int EXPORT_OUT_API SMO_getElementSeries(SMO_Handle p_handle, SMO_elementType type, const int *elementIndex, int numElements, const int *attrIndex, int numAttrs, int startPeriod, int endPeriod, float *float_out, int length);
+int EXPORT_OUT_API SMO_transpose(SMO_Handle p_handle, const char *path, int blockPeriods, int compress);
 
 int EXPORT_OUT_API SMO_getSubcatchAttribute(SMO_Handle p_handle, int timeIndex, SMO_subcatchAttribute attr, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getNodeAttribute(SMO_Handle p_handle, int timeIndex, SMO_nodeAttribute attr, float **float_out, int *int_dim);
@@ -14,10 +14,19 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#ifdef _WIN32
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
 
 #include "errormanager.h"
 #include "messages.h"
+#include "shared/xorcodec.h"
 
 #include "swmm_output.h"
 
@@ -31,12 +40,17 @@
 #endif
 
 #define INT4 int      // Must be a 4 byte / 32 bit integer type
+#define INT8 long long    // Must be a 8 byte / 64 bit integer type
 #define REAL4 float   // Must be a 4 byte / 32 bit real type
 
 #define RECORDSIZE 4  // Memory alignment 4 byte word size for both int and real
 #define DATESIZE 8    // Dates are stored as 8 byte word size
 
 #define NELEMENTTYPES 5    // Number of element types
+
+#define MAGICNUMBER 516114522         // Opens and closes output file
+#define BLOCKMAGICNUMBER 516114523    // Closes output saved in blocks
+#define LAYOUT_VERSION 1              // Version of block layout record
 #define MEMCHECK(x) (((x) == NULL) ? 414 : 0)
 
 
@@ -69,6 +83,12 @@ typedef struct Handle {
     int LinkVars;        // number of link reporting variables
     int SysVars;         // number of system reporting variables
 
+    // Only some of an element type's variables may be saved. The position
+    // of each subcatchment, node and link attribute among the results saved
+    // for an element is found from the codes of the variables saved.
+    int  NumAttrs[3];    // number of attributes of each element type
+    int* AttrPos[3];     // position of each attribute (-1 if not saved)
+
     double StartDate;     // start date of simulation
     int    ReportStep;    // reporting time step (seconds)
 
@@ -77,6 +97,35 @@ typedef struct Handle {
     F_OFF ResultsPos;        // file position where results start
     F_OFF BytesPerPeriod;    // bytes used for results in each period
 
+    // Results are saved in blocks of BlockPeriods periods, each holding the
+    // dates of its periods followed by the values of each result for all of
+    // them (element-major order). Blocks of one period are the original
+    // period-major layout, for which no index of blocks is saved.
+    int    BlockPeriods;    // number of periods per block
+    int    NumBlocks;       // number of blocks
+    F_OFF* BlockPos;        // file position of each block (NULL if none)
+    int    Encoding;        // encoding of results (see xorcodec.h)
+    int    RunError;        // error code saved at end of file
+
+    // Blocks of encoded results hold the dates of their periods, the
+    // encoded series of each result and the offset (from the first series)
+    // where each series ends. The series last decoded are kept in memory.
+    REAL4*         decoded;         // decoded series of results
+    size_t         decodedSize;     // size of decoded (records)
+    int            decodedBlock;    // block the series were decoded from
+    F_OFF          decodedFirst;    // index of first result decoded
+    int            decodedCount;    // number of results decoded
+    unsigned char* bytes;           // encoded series read from an unmapped file
+    size_t         bytesSize;       // size of bytes
+
+    char* map;         // file mapped into memory (NULL if not mapped)
+    F_OFF mapSize;     // size of mapped file (bytes)
+#ifdef _WIN32
+    HANDLE mapHandle;  // file mapping object
+#endif
+    REAL4* buffer;     // results read from an unmapped file
+    F_OFF  bufferSize; // size of buffer (records)
+
     error_handle_t* error_handle;
 } data_t, *SMO_Handle;
 
@@ -87,6 +136,29 @@ typedef struct Handle {
 void errorLookup(int errcode, char *errmsg, int length);
 int  validateFile(data_t *p_data);
 void initElementNames(data_t *p_data);
+void mapFile(data_t *p_data);
+void unmapFile(data_t *p_data);
+int  readRecords(data_t *p_data, F_OFF offset, size_t size, int n, void *dest);
+const REAL4 *getPeriodValues(data_t *p_data, int timeIndex, F_OFF first,
+    F_OFF count);
+int  getElementInfo(data_t *p_data, SMO_elementType type, int elementIndex,
+    F_OFF *first, int *numVars);
+int   readVarCodes(data_t *p_data, SMO_elementType type, int numVars,
+    int numAttrs);
+int   getAttrPos(data_t *p_data, SMO_elementType type, int attr);
+void  scatterResults(data_t *p_data, SMO_elementType type, float *values);
+int   readLayout(data_t *p_data);
+F_OFF getBlockPos(data_t *p_data, int block);
+int   getBlockSize(data_t *p_data, int block);
+F_OFF getResultIndex(data_t *p_data, SMO_elementType type, int elementIndex,
+    int attr);
+F_OFF getResultPos(data_t *p_data, int timeIndex, F_OFF result);
+void  readResults(data_t *p_data, int timeIndex, F_OFF first, int n,
+    float *dest);
+int   readSeries(data_t *p_data, F_OFF result, int startPeriod, int n,
+    float *dest);
+const REAL4 *decodeResults(data_t *p_data, int block, F_OFF first, int n);
+const unsigned char *readBytes(data_t *p_data, F_OFF offset, size_t size);
 
 double getTimeValue(data_t *p_data, int timeIndex);
 float  getSubcatchValue(data_t *p_data, int timeIndex, int subcatchIndex, SMO_subcatchAttribute attr);
@@ -155,6 +227,14 @@ int EXPORT_OUT_API SMO_close(SMO_Handle p_handle)
 
         dst_errormanager(p_data->error_handle);
 
+        unmapFile(p_data);
+        free(p_data->buffer);
+        free(p_data->BlockPos);
+        free(p_data->decoded);
+        free(p_data->bytes);
+        for (i = 0; i < 3; i++)
+            free(p_data->AttrPos[i]);
+
         if (p_data->file != NULL)
             fclose(p_data->file);
 
@@ -213,18 +293,25 @@ int EXPORT_OUT_API SMO_open(SMO_Handle p_handle, const char *path)
                 _fseek(p_data->file, offset, SEEK_SET);
                 fread(&(p_data->SubcatchVars), RECORDSIZE, 1,
                         p_data->file);    // # Subcatch variables
+                err = readVarCodes(p_data, SMO_subcatch, p_data->SubcatchVars,
+                        SMO_pollutant_conc_subcatch + p_data->Npolluts);
 
-                _fseek(p_data->file, p_data->SubcatchVars * RECORDSIZE, SEEK_CUR);
                 fread(&(p_data->NodeVars), RECORDSIZE, 1,
                         p_data->file);    // # Node variables
+                if (!err)
+                    err = readVarCodes(p_data, SMO_node, p_data->NodeVars,
+                        SMO_pollutant_conc_node + p_data->Npolluts);
 
-                _fseek(p_data->file, p_data->NodeVars * RECORDSIZE, SEEK_CUR);
                 fread(&(p_data->LinkVars), RECORDSIZE, 1,
                         p_data->file);    // # Link variables
+                if (!err)
+                    err = readVarCodes(p_data, SMO_link, p_data->LinkVars,
+                        SMO_pollutant_conc_link + p_data->Npolluts);
 
-                _fseek(p_data->file, p_data->LinkVars * RECORDSIZE, SEEK_CUR);
                 fread(&(p_data->SysVars), RECORDSIZE, 1,
                         p_data->file);    // # System variables
+                if (err)
+                    errorcode = err;
 
                 // --- read data just before start of output results
                 offset = p_data->ResultsPos - 3 * RECORDSIZE;
@@ -240,6 +327,10 @@ int EXPORT_OUT_API SMO_open(SMO_Handle p_handle, const char *path)
                         p_data->Nnodes * p_data->NodeVars +
                         p_data->Nlinks * p_data->LinkVars + p_data->SysVars) *
                         RECORDSIZE;
+
+                // --- results are read straight out of memory when the
+                //     file can be mapped (otherwise with fseek/fread)
+                mapFile(p_data);
             }
 // ############################################################################
         }
@@ -311,6 +402,49 @@ int EXPORT_OUT_API SMO_getProjectSize(SMO_Handle p_handle, int **elementCount, i
 }
 
 
+int EXPORT_OUT_API SMO_getSavedVariables(SMO_Handle p_handle,
+    SMO_elementType type, int **attrIndex, int *length)
+//
+//   Purpose: Returns the attributes of an element type whose results were
+//   saved to the file (only those selected in the [REPORT] section).
+//
+{
+    int     attr, n = 0, errorcode = 0;
+    int     *temp;
+    data_t  *p_data;
+
+    p_data = (data_t*)p_handle;
+
+    *attrIndex = NULL;
+    *length = 0;
+
+    if (p_data == NULL)
+        return -1;
+    else if (type < SMO_subcatch || type > SMO_sys)
+        errorcode = 421;
+    else if (type == SMO_sys) {
+        if (MEMCHECK(temp = newIntArray(p_data->SysVars)))
+            errorcode = 414;
+        else
+            for (attr = 0; attr < p_data->SysVars; attr++)
+                temp[n++] = attr;
+    }
+    else if (MEMCHECK(temp = newIntArray(p_data->NumAttrs[type])))
+        errorcode = 414;
+    else {
+        for (attr = 0; attr < p_data->NumAttrs[type]; attr++)
+            if (p_data->AttrPos[type][attr] >= 0)
+                temp[n++] = attr;
+    }
+
+    if (!errorcode) {
+        *attrIndex = temp;
+        *length    = n;
+    }
+    return set_error(p_data->error_handle, errorcode);
+}
+
+
 int EXPORT_OUT_API SMO_getUnits(SMO_Handle p_handle, int **unitFlag, int *length)
 //
 //  Purpose: Returns unit flags for unit_system, flow, and pollutants.
@@ -484,7 +618,7 @@ int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex,
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, pos, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -497,15 +631,17 @@ int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex,
     else if (startPeriod < 0 || endPeriod < startPeriod ||
         endPeriod >= p_data->Nperiods)
         errorcode = 422;
+    else if ((pos = getAttrPos(p_data, SMO_subcatch, attr)) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod + 1))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] =
-                getSubcatchValue(p_data, startPeriod + k, subcatchIndex, attr);
+        // read time series (stored together within each block of periods)
+        readSeries(p_data,
+            getResultIndex(p_data, SMO_subcatch, subcatchIndex, pos),
+            startPeriod, len, temp);
 
         *outValueArray = temp;
         *length         = len;
@@ -522,7 +658,7 @@ int EXPORT_OUT_API SMO_getNodeSeries(SMO_Handle p_handle, int nodeIndex,
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, pos, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -535,14 +671,16 @@ int EXPORT_OUT_API SMO_getNodeSeries(SMO_Handle p_handle, int nodeIndex,
         else if (startPeriod < 0 || endPeriod < startPeriod ||
             endPeriod >= p_data->Nperiods)
         errorcode = 422;
+    else if ((pos = getAttrPos(p_data, SMO_node, attr)) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod + 1))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] = getNodeValue(p_data, startPeriod + k, nodeIndex, attr);
+        // read time series (stored together within each block of periods)
+        readSeries(p_data, getResultIndex(p_data, SMO_node, nodeIndex, pos),
+            startPeriod, len, temp);
 
         *outValueArray = temp;
         *length         = len;
@@ -559,7 +697,7 @@ int EXPORT_OUT_API SMO_getLinkSeries(SMO_Handle p_handle, int linkIndex,
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, pos, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -572,14 +710,16 @@ int EXPORT_OUT_API SMO_getLinkSeries(SMO_Handle p_handle, int linkIndex,
         else if (startPeriod < 0 || endPeriod < startPeriod ||
             endPeriod >= p_data->Nperiods)
         errorcode = 422;
+    else if ((pos = getAttrPos(p_data, SMO_link, attr)) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod + 1))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] = getLinkValue(p_data, startPeriod + k, linkIndex, attr);
+        // read time series (stored together within each block of periods)
+        readSeries(p_data, getResultIndex(p_data, SMO_link, linkIndex, pos),
+            startPeriod, len, temp);
 
         *outValueArray = temp;
         *length         = len;
@@ -595,7 +735,7 @@ int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -606,14 +746,16 @@ int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute
         else if (startPeriod < 0 || endPeriod < startPeriod ||
             endPeriod >= p_data->Nperiods)
         errorcode = 422;
+    else if (getAttrPos(p_data, SMO_sys, attr) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod + 1))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] = getSystemValue(p_data, startPeriod + k, attr);
+        // read time series (stored together within each block of periods)
+        readSeries(p_data, getResultIndex(p_data, SMO_sys, 0, attr),
+            startPeriod, len, temp);
 
         *outValueArray = temp;
         *length         = len;
@@ -622,6 +764,251 @@ int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute
     return set_error(p_data->error_handle, errorcode);
 }
 
+int EXPORT_OUT_API SMO_getElementSeries(SMO_Handle p_handle,
+    SMO_elementType type, const int *elementIndex, int numElements,
+    const int *attrIndex, int numAttrs, int startPeriod, int endPeriod,
+    float *outValueArray, int length)
+//
+//  Purpose: Get time series results for several attributes of several
+//  elements of the same type in one call. Results are written to the
+//  caller's array element by element and then attribute by attribute, each
+//  series of endPeriod - startPeriod + 1 values being contiguous. The system
+//  is treated as a single element (elementIndex may be NULL).
+//
+{
+    int    i, j, k, len, errorcode = 0;
+    int    numVars;
+    F_OFF  lo, hi;
+    F_OFF  *first = NULL;
+    int    *pos = NULL;
+    const REAL4 *values;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+
+    if (type == SMO_sys)
+        numElements = 1;
+    len = endPeriod - startPeriod + 1;
+
+    if (type != SMO_subcatch && type != SMO_node && type != SMO_link &&
+        type != SMO_sys)
+        errorcode = 421;
+    else if (numElements <= 0 || numAttrs <= 0 || attrIndex == NULL ||
+        (type != SMO_sys && elementIndex == NULL))
+        errorcode = 423;
+    else if (startPeriod < 0 || endPeriod < startPeriod ||
+        endPeriod >= p_data->Nperiods)
+        errorcode = 422;
+    else if (outValueArray == NULL ||
+        (F_OFF)numElements * numAttrs * len > length)
+        errorcode = 424;
+    else if (MEMCHECK(first = (F_OFF *)malloc(numElements * sizeof(F_OFF))) ||
+        MEMCHECK(pos = (int *)malloc(numAttrs * sizeof(int))))
+        errorcode = 411;
+    else {
+        // find where each element's results start within a period and the
+        // span of results that covers all of them
+        lo = 0;
+        hi = 0;
+        for (i = 0; i < numElements && !errorcode; i++) {
+            errorcode = getElementInfo(p_data, type,
+                type == SMO_sys ? 0 : elementIndex[i], &first[i], &numVars);
+            if (errorcode)
+                break;
+            if (i == 0 || first[i] < lo)
+                lo = first[i];
+            if (i == 0 || first[i] + numVars > hi)
+                hi = first[i] + numVars;
+        }
+        // find the position of each attribute among an element's results
+        for (j = 0; j < numAttrs && !errorcode; j++)
+            if ((pos[j] = getAttrPos(p_data, type, attrIndex[j])) < 0)
+                errorcode = 421;
+
+        // when blocks hold many periods (or are encoded) each series is
+        // stored in pieces of consecutive values
+        if (p_data->BlockPeriods > 1 || p_data->Encoding != XORCODEC_NONE) {
+            for (i = 0; i < numElements && !errorcode; i++)
+                for (j = 0; j < numAttrs && !errorcode; j++)
+                    if (!readSeries(p_data, first[i] + pos[j],
+                            startPeriod, len, outValueArray +
+                            ((F_OFF)i * numAttrs + j) * len))
+                        errorcode = 411;
+        }
+
+        // otherwise pull each period's results from the span of interest
+        else for (k = 0; k < len && !errorcode; k++) {
+            values = getPeriodValues(p_data, startPeriod + k, lo, hi - lo);
+            if (values == NULL)
+                errorcode = 411;
+            else {
+                for (i = 0; i < numElements; i++)
+                    for (j = 0; j < numAttrs; j++)
+                        outValueArray[((F_OFF)i * numAttrs + j) * len + k] =
+                            values[first[i] - lo + pos[j]];
+            }
+        }
+    }
+
+    free(first);
+    free(pos);
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_transpose(SMO_Handle p_handle, const char *path,
+    int blockPeriods, int compress)
+//
+//  Purpose: Writes a copy of the open output file whose results are saved
+//  in blocks of blockPeriods periods, each holding the series of every
+//  result over its periods (compressed if compress is non-zero). A
+//  blockPeriods of 0 writes the original period-major layout.
+//
+{
+    int    k, b, bp, size, numBlocks, errorcode = 0;
+    INT4   k4, epilogue[6];
+    INT4   *ends = NULL;
+    INT8   pos;
+    F_OFF  n, offset, numResults;
+    F_OFF  *blockPos = NULL;
+    size_t used;
+    unsigned char *encoded = NULL;
+    char   *bytes = NULL;
+    double *dates = NULL;
+    float  *results = NULL, *period = NULL;
+    FILE   *file = NULL;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+
+    if (blockPeriods < 0 || p_data->Nperiods <= 0)
+        errorcode = 422;
+    else if (compress && blockPeriods == 0)
+        errorcode = 421;
+    else if (_fopen(&file, path, "wb") != 0)
+        errorcode = 434;
+    else {
+        if (blockPeriods > p_data->Nperiods)
+            blockPeriods = p_data->Nperiods;
+        bp         = (blockPeriods > 0) ? blockPeriods : 1;
+        numBlocks  = (p_data->Nperiods + bp - 1) / bp;
+        numResults = getResultIndex(p_data, SMO_sys, 0, p_data->SysVars);
+
+        bytes    = (char *)malloc(BUFSIZ);
+        dates    = (double *)malloc(bp * sizeof(double));
+        results  = (float *)malloc((size_t)(numResults * bp) * sizeof(float));
+        period   = (float *)malloc((size_t)numResults * sizeof(float));
+        blockPos = (F_OFF *)calloc((size_t)numBlocks + 1, sizeof(F_OFF));
+        if (!bytes || !dates || !results || !period || !blockPos)
+            errorcode = 411;
+        if (!errorcode && compress) {
+            encoded = (unsigned char *)malloc(xorcodec_maxSize(bp));
+            ends    = (INT4 *)malloc((size_t)numResults * sizeof(INT4));
+            if (!encoded || !ends)
+                errorcode = 411;
+        }
+    }
+
+    // --- copy everything ahead of the results
+    for (offset = 0; !errorcode && offset < p_data->ResultsPos; offset += n) {
+        n = p_data->ResultsPos - offset;
+        if (n > BUFSIZ)
+            n = BUFSIZ;
+        if (readRecords(p_data, offset, 1, (int)n, bytes) != n ||
+            fwrite(bytes, 1, (size_t)n, file) != (size_t)n)
+            errorcode = 435;
+    }
+
+    // --- write each block's dates followed by the series of each result
+    for (b = 0; !errorcode && b < numBlocks; b++) {
+        blockPos[b] = _ftell(file);
+        size = bp;
+        if (p_data->Nperiods - (long)b * bp < bp)
+            size = (int)(p_data->Nperiods - (long)b * bp);
+        for (k = 0; k < size; k++)
+            dates[k] = getTimeValue(p_data, b * bp + k);
+
+        // --- results of a period-major file are read a period at a time
+        if (p_data->BlockPeriods == 1) {
+            for (k = 0; k < size; k++) {
+                readResults(p_data, b * bp + k, 0, (int)numResults,
+                    period);
+                for (n = 0; n < numResults; n++)
+                    results[n * size + k] = period[n];
+            }
+        }
+        else for (n = 0; n < numResults && !errorcode; n++)
+            if (!readSeries(p_data, n, b * bp, size,
+                    results + n * size))
+                errorcode = 435;
+
+        if (fwrite(dates, DATESIZE, size, file) != (size_t)size)
+            errorcode = 434;
+
+        // --- encoded series are followed by where each of them ends
+        if (compress) {
+            for (n = 0, used = 0; n < numResults && !errorcode; n++) {
+                k = (int)xorcodec_encode(results + n * size, size, encoded);
+                used += k;
+                ends[n] = (INT4)used;
+                if (fwrite(encoded, 1, k, file) != (size_t)k)
+                    errorcode = 434;
+            }
+            if (fwrite(ends, RECORDSIZE, (size_t)numResults, file) !=
+                (size_t)numResults)
+                errorcode = 434;
+        }
+        else if (fwrite(results, RECORDSIZE, (size_t)(numResults * size),
+                     file) != (size_t)(numResults * size))
+            errorcode = 434;
+    }
+
+    // --- write the index of blocks and the layout record
+    if (!errorcode && blockPeriods > 0) {
+        blockPos[numBlocks] = _ftell(file);
+        for (b = 0; b <= numBlocks; b++) {
+            pos = (INT8)blockPos[b];
+            fwrite(&pos, sizeof(INT8), 1, file);
+        }
+        k4 = LAYOUT_VERSION;
+        fwrite(&k4, RECORDSIZE, 1, file);
+        fwrite(&blockPeriods, RECORDSIZE, 1, file);
+        fwrite(&numBlocks, RECORDSIZE, 1, file);
+        k4 = compress ? XORCODEC_XOR : XORCODEC_NONE;
+        fwrite(&k4, RECORDSIZE, 1, file);
+        pos = (INT8)blockPos[numBlocks];
+        fwrite(&pos, sizeof(INT8), 1, file);
+    }
+
+    // --- write the epilogue
+    if (!errorcode) {
+        epilogue[0] = (INT4)p_data->IDPos;
+        epilogue[1] = (INT4)p_data->ObjPropPos;
+        epilogue[2] = (INT4)p_data->ResultsPos;
+        epilogue[3] = (INT4)p_data->Nperiods;
+        epilogue[4] = p_data->RunError;
+        epilogue[5] = (blockPeriods > 0) ? BLOCKMAGICNUMBER : MAGICNUMBER;
+        if (fwrite(epilogue, RECORDSIZE, 6, file) != 6)
+            errorcode = 434;
+    }
+
+    if (file != NULL)
+        fclose(file);
+    free(bytes);
+    free(dates);
+    free(results);
+    free(period);
+    free(blockPos);
+    free(encoded);
+    free(ends);
+    return set_error(p_data->error_handle, errorcode);
+}
+
 int EXPORT_OUT_API SMO_getSubcatchAttribute(SMO_Handle p_handle, int periodIndex,
     SMO_subcatchAttribute attr, float **outValueArray, int *length)
 //
@@ -638,6 +1025,8 @@ int EXPORT_OUT_API SMO_getSubcatchAttribute(SMO_Handle p_handle, int periodIndex
         errorcode = -1;
     else if (periodIndex < 0 || periodIndex >= p_data->Nperiods)
         errorcode = 422;
+    else if (getAttrPos(p_data, SMO_subcatch, attr) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(p_data->Nsubcatch)) errorcode = 411;
@@ -669,6 +1058,8 @@ int EXPORT_OUT_API SMO_getNodeAttribute(SMO_Handle p_handle, int periodIndex,
         errorcode = -1;
     else if (periodIndex < 0 || periodIndex >= p_data->Nperiods)
         errorcode = 422;
+    else if (getAttrPos(p_data, SMO_node, attr) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(p_data->Nnodes)) errorcode = 411;
@@ -700,6 +1091,8 @@ int EXPORT_OUT_API SMO_getLinkAttribute(SMO_Handle p_handle, int periodIndex,
         errorcode = -1;
     else if (periodIndex < 0 || periodIndex >= p_data->Nperiods)
         errorcode = 422;
+    else if (getAttrPos(p_data, SMO_link, attr) < 0)
+        errorcode = 421;
     // Check memory for outValues
     else if
         MEMCHECK(temp = newFloatArray(p_data->Nlinks)) errorcode = 411;
@@ -731,6 +1124,8 @@ int EXPORT_OUT_API SMO_getSystemAttribute(SMO_Handle p_handle, int periodIndex,
         errorcode = -1;
     else if (periodIndex < 0 || periodIndex >= p_data->Nperiods)
         errorcode = 422;
+    else if (getAttrPos(p_data, SMO_sys, attr) < 0)
+        errorcode = 421;
     else if
         MEMCHECK(temp = newFloatArray(1)) errorcode = 411;
     else {
@@ -747,12 +1142,12 @@ int EXPORT_OUT_API SMO_getSystemAttribute(SMO_Handle p_handle, int periodIndex,
 int EXPORT_OUT_API SMO_getSubcatchResult(SMO_Handle p_handle, int periodIndex,
     int subcatchIndex, float **outValueArray, int *arrayLength)
 //
-// Purpose: For a subcatchment at given time, get all attributes.
+// Purpose: For a subcatchment at given time, get all attributes (those
+// not saved to the file are returned as 0).
 //
 {
     int    errorcode = 0;
     float  *temp;
-    F_OFF  offset;
     data_t *p_data;
 
     p_data = (data_t *)p_handle;
@@ -764,19 +1159,15 @@ int EXPORT_OUT_API SMO_getSubcatchResult(SMO_Handle p_handle, int periodIndex,
     else if (subcatchIndex < 0 || subcatchIndex > p_data->Nsubcatch)
         errorcode = 423;
     else if
-        MEMCHECK(temp = newFloatArray(p_data->SubcatchVars)) errorcode = 411;
+        MEMCHECK(temp = newFloatArray(p_data->NumAttrs[SMO_subcatch])) errorcode = 411;
     else {
-        // --- compute offset into output file
-        offset = p_data->ResultsPos + (periodIndex)*p_data->BytesPerPeriod +
-                 2 * RECORDSIZE;
-        // add offset for subcatchment
-        offset += (subcatchIndex * p_data->SubcatchVars) * RECORDSIZE;
-
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->SubcatchVars, p_data->file);
+        readResults(p_data, periodIndex,
+            getResultIndex(p_data, SMO_subcatch, subcatchIndex, 0),
+            p_data->SubcatchVars, temp);
+        scatterResults(p_data, SMO_subcatch, temp);
 
         *outValueArray = temp;
-        *arrayLength   = p_data->SubcatchVars;
+        *arrayLength   = p_data->NumAttrs[SMO_subcatch];
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -785,12 +1176,12 @@ int EXPORT_OUT_API SMO_getSubcatchResult(SMO_Handle p_handle, int periodIndex,
 int EXPORT_OUT_API SMO_getNodeResult(SMO_Handle p_handle, int periodIndex,
     int nodeIndex, float **outValueArray, int *arrayLength)
 //
-//	Purpose: For a node at given time, get all attributes.
+//	Purpose: For a node at given time, get all attributes (those not saved
+//	to the file are returned as 0).
 //
 {
     int    errorcode = 0;
     float  *temp;
-    F_OFF  offset;
     data_t *p_data;
 
     p_data = (data_t *)p_handle;
@@ -802,21 +1193,15 @@ int EXPORT_OUT_API SMO_getNodeResult(SMO_Handle p_handle, int periodIndex,
     else if (nodeIndex < 0 || nodeIndex > p_data->Nnodes)
         errorcode = 423;
     else if
-        MEMCHECK(temp = newFloatArray(p_data->NodeVars)) errorcode = 411;
+        MEMCHECK(temp = newFloatArray(p_data->NumAttrs[SMO_node])) errorcode = 411;
     else {
-        // calculate byte offset to start time for series
-        offset = p_data->ResultsPos + (periodIndex)*p_data->BytesPerPeriod +
-                 2 * RECORDSIZE;
-        // add offset for subcatchment and node
-        offset += (p_data->Nsubcatch * p_data->SubcatchVars +
-                   nodeIndex * p_data->NodeVars) *
-                  RECORDSIZE;
-
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->NodeVars, p_data->file);
+        readResults(p_data, periodIndex,
+            getResultIndex(p_data, SMO_node, nodeIndex, 0),
+            p_data->NodeVars, temp);
+        scatterResults(p_data, SMO_node, temp);
 
         *outValueArray = temp;
-        *arrayLength   = p_data->NodeVars;
+        *arrayLength   = p_data->NumAttrs[SMO_node];
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -825,12 +1210,12 @@ int EXPORT_OUT_API SMO_getNodeResult(SMO_Handle p_handle, int periodIndex,
 int EXPORT_OUT_API SMO_getLinkResult(SMO_Handle p_handle, int periodIndex,
     int linkIndex, float **outValueArray, int *arrayLength)
 //
-//	Purpose: For a link at given time, get all attributes.
+//	Purpose: For a link at given time, get all attributes (those not saved
+//	to the file are returned as 0).
 //
 {
     int    errorcode = 0;
     float  *temp;
-    F_OFF  offset;
     data_t *p_data;
 
     p_data = (data_t *)p_handle;
@@ -842,22 +1227,15 @@ int EXPORT_OUT_API SMO_getLinkResult(SMO_Handle p_handle, int periodIndex,
     else if (linkIndex < 0 || linkIndex > p_data->Nlinks)
         errorcode = 423;
     else if
-        MEMCHECK(temp = newFloatArray(p_data->LinkVars)) errorcode = 411;
+        MEMCHECK(temp = newFloatArray(p_data->NumAttrs[SMO_link])) errorcode = 411;
     else {
-        // calculate byte offset to start time for series
-        offset = p_data->ResultsPos + (periodIndex)*p_data->BytesPerPeriod +
-                 2 * RECORDSIZE;
-        // add offset for subcatchment and node and link
-        offset +=
-            (p_data->Nsubcatch * p_data->SubcatchVars +
-             p_data->Nnodes * p_data->NodeVars + linkIndex * p_data->LinkVars) *
-            RECORDSIZE;
-
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->LinkVars, p_data->file);
+        readResults(p_data, periodIndex,
+            getResultIndex(p_data, SMO_link, linkIndex, 0),
+            p_data->LinkVars, temp);
+        scatterResults(p_data, SMO_link, temp);
 
         *outValueArray = temp;
-        *arrayLength   = p_data->LinkVars;
+        *arrayLength   = p_data->NumAttrs[SMO_link];
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -871,7 +1249,6 @@ int EXPORT_OUT_API SMO_getSystemResult(SMO_Handle p_handle, int periodIndex,
 {
     int    errorcode = 0;
     float  *temp;
-    F_OFF  offset;
     data_t *p_data;
 
     p_data = (data_t *)p_handle;
@@ -883,18 +1260,9 @@ int EXPORT_OUT_API SMO_getSystemResult(SMO_Handle p_handle, int periodIndex,
     else if
         MEMCHECK(temp = newFloatArray(p_data->SysVars)) errorcode = 411;
     {
-        // calculate byte offset to start time for series
-        offset = p_data->ResultsPos + (periodIndex)*p_data->BytesPerPeriod +
-                 2 * RECORDSIZE;
-        // add offset for subcatchment and node and link (system starts after
-        // the last link)
-        offset += (p_data->Nsubcatch * p_data->SubcatchVars +
-                   p_data->Nnodes * p_data->NodeVars +
-                   p_data->Nlinks * p_data->LinkVars) *
-                  RECORDSIZE;
-
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->SysVars, p_data->file);
+        readResults(p_data, periodIndex,
+            getResultIndex(p_data, SMO_sys, 0, 0),
+            p_data->SysVars, temp);
 
         *outValueArray = temp;
         *arrayLength   = p_data->SysVars;
@@ -998,10 +1366,20 @@ int validateFile(data_t *p_data) {
     _fseek(p_data->file, 0L, SEEK_SET);
     fread(&magic1, RECORDSIZE, 1, p_data->file);
 
+    p_data->RunError     = errcode;
+    p_data->BlockPeriods = 1;
+    p_data->NumBlocks    = p_data->Nperiods;
+    p_data->BlockPos     = NULL;
+    p_data->Encoding     = XORCODEC_NONE;
+
     // Is this a valid SWMM binary output file?
-    if (magic1 != magic2)
+    if (magic1 == MAGICNUMBER && magic2 == BLOCKMAGICNUMBER)
+        errorcode = readLayout(p_data);
+    else if (magic1 != magic2)
         errorcode = 435;
     // Does the binary file contain results?
+    if (errorcode)
+        ;
     else if (p_data->Nperiods <= 0)
         errorcode = 436;
     // Were there problems with the model run?
@@ -1034,17 +1412,489 @@ void initElementNames(data_t *p_data) {
     }
 }
 
+void mapFile(data_t *p_data)
+//
+//  Purpose: Maps the output file into memory so that results can be read
+//  in place. The file is read with fseek/fread if this fails.
+//
+{
+#ifdef _WIN32
+    HANDLE        hFile;
+    LARGE_INTEGER size;
+
+    p_data->mapHandle = NULL;
+    hFile = (HANDLE)_get_osfhandle(_fileno(p_data->file));
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 ||
+        (unsigned __int64)size.QuadPart > (SIZE_MAX))
+        return;
+    p_data->mapHandle =
+        CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (p_data->mapHandle == NULL)
+        return;
+    p_data->map = (char *)MapViewOfFile(p_data->mapHandle, FILE_MAP_READ,
+                                        0, 0, 0);
+    if (p_data->map == NULL) {
+        CloseHandle(p_data->mapHandle);
+        p_data->mapHandle = NULL;
+        return;
+    }
+    p_data->mapSize = size.QuadPart;
+#else
+    struct stat st;
+    void        *map;
+
+    if (fstat(fileno(p_data->file), &st) != 0 || st.st_size <= 0 ||
+        (unsigned long long)st.st_size > (SIZE_MAX))
+        return;
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+               fileno(p_data->file), 0);
+    if (map == MAP_FAILED)
+        return;
+    p_data->map     = (char *)map;
+    p_data->mapSize = st.st_size;
+#endif
+}
+
+void unmapFile(data_t *p_data)
+//
+//  Purpose: Removes the memory map of the output file.
+//
+{
+    if (p_data->map == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(p_data->map);
+    CloseHandle(p_data->mapHandle);
+    p_data->mapHandle = NULL;
+#else
+    munmap(p_data->map, (size_t)p_data->mapSize);
+#endif
+    p_data->map     = NULL;
+    p_data->mapSize = 0;
+}
+
+int readRecords(data_t *p_data, F_OFF offset, size_t size, int n, void *dest)
+//
+//  Purpose: Reads n records of a given size starting at a file offset,
+//  either from the memory map or from the file itself. Returns the number
+//  of records read.
+//
+{
+    if (p_data->map != NULL) {
+        if (offset < 0 || offset + (F_OFF)(size * n) > p_data->mapSize)
+            return 0;
+        memcpy(dest, p_data->map + offset, size * n);
+        return n;
+    }
+    _fseek(p_data->file, offset, SEEK_SET);
+    return (int)fread(dest, size, n, p_data->file);
+}
+
+const REAL4 *getPeriodValues(data_t *p_data, int timeIndex, F_OFF first,
+    F_OFF count)
+//
+//  Purpose: Returns a pointer to count results of a reporting period,
+//  starting with result number first. Points into the memory map if there
+//  is one, otherwise the results are read into a buffer. Returns NULL if
+//  they can't be read.
+//
+{
+    F_OFF offset;
+
+    offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod +
+             DATESIZE + first * RECORDSIZE;
+
+    if (p_data->map != NULL) {
+        if (offset + count * RECORDSIZE > p_data->mapSize)
+            return NULL;
+        return (const REAL4 *)(p_data->map + offset);
+    }
+
+    if (count > p_data->bufferSize) {
+        free(p_data->buffer);
+        p_data->bufferSize = 0;
+        p_data->buffer = (REAL4 *)malloc((size_t)count * sizeof(REAL4));
+        if (p_data->buffer == NULL)
+            return NULL;
+        p_data->bufferSize = count;
+    }
+    _fseek(p_data->file, offset, SEEK_SET);
+    if (fread(p_data->buffer, RECORDSIZE, (size_t)count, p_data->file) !=
+        (size_t)count)
+        return NULL;
+    return p_data->buffer;
+}
+
+int getElementInfo(data_t *p_data, SMO_elementType type, int elementIndex,
+    F_OFF *first, int *numVars)
+//
+//  Purpose: Finds the number of the first result of an element within a
+//  reporting period and its number of reporting variables.
+//
+{
+    F_OFF nodesPos = (F_OFF)p_data->Nsubcatch * p_data->SubcatchVars;
+    F_OFF linksPos = nodesPos + (F_OFF)p_data->Nnodes * p_data->NodeVars;
+    F_OFF sysPos   = linksPos + (F_OFF)p_data->Nlinks * p_data->LinkVars;
+
+    switch (type) {
+        case SMO_subcatch:
+            if (elementIndex < 0 || elementIndex >= p_data->Nsubcatch)
+                return 423;
+            *first   = (F_OFF)elementIndex * p_data->SubcatchVars;
+            *numVars = p_data->SubcatchVars;
+            break;
+
+        case SMO_node:
+            if (elementIndex < 0 || elementIndex >= p_data->Nnodes)
+                return 423;
+            *first   = nodesPos + (F_OFF)elementIndex * p_data->NodeVars;
+            *numVars = p_data->NodeVars;
+            break;
+
+        case SMO_link:
+            if (elementIndex < 0 || elementIndex >= p_data->Nlinks)
+                return 423;
+            *first   = linksPos + (F_OFF)elementIndex * p_data->LinkVars;
+            *numVars = p_data->LinkVars;
+            break;
+
+        case SMO_sys:
+            *first   = sysPos;
+            *numVars = p_data->SysVars;
+            break;
+
+        default:
+            return 421;
+    }
+    return 0;
+}
+
+int readVarCodes(data_t *p_data, SMO_elementType type, int numVars,
+    int numAttrs)
+//
+//  Purpose: Reads the codes of the variables saved for an element type
+//  and finds the position of each of its attributes among them.
+//
+{
+    int  i;
+    INT4 code, last = -1;
+
+    p_data->NumAttrs[type] = numAttrs;
+    p_data->AttrPos[type]  = (int *)malloc(numAttrs * sizeof(int));
+    if (p_data->AttrPos[type] == NULL)
+        return 411;
+    for (i = 0; i < numAttrs; i++)
+        p_data->AttrPos[type][i] = -1;
+
+    // codes are saved in increasing order
+    for (i = 0; i < numVars; i++) {
+        if (fread(&code, RECORDSIZE, 1, p_data->file) != 1 ||
+            code <= last || code >= numAttrs)
+            return 435;
+        p_data->AttrPos[type][code] = i;
+        last = code;
+    }
+    return 0;
+}
+
+int getAttrPos(data_t *p_data, SMO_elementType type, int attr)
+//
+//  Purpose: Finds the position of an attribute among the results saved for
+//  an element (-1 if the attribute is invalid or wasn't saved).
+//
+{
+    if (type == SMO_sys)
+        return (attr >= 0 && attr < p_data->SysVars) ? attr : -1;
+    if (type < SMO_subcatch || type > SMO_link || attr < 0 ||
+        attr >= p_data->NumAttrs[type])
+        return -1;
+    return p_data->AttrPos[type][attr];
+}
+
+void scatterResults(data_t *p_data, SMO_elementType type, float *values)
+//
+//  Purpose: Spreads the results saved for an element, held at the start of
+//  values, so that each is found at the index of its attribute. Attributes
+//  that weren't saved are given a value of 0.
+//
+{
+    int attr, pos;
+
+    // an attribute's position never exceeds its index so the results can
+    // be moved in place starting from the last attribute
+    for (attr = p_data->NumAttrs[type] - 1; attr >= 0; attr--) {
+        pos = p_data->AttrPos[type][attr];
+        values[attr] = pos < 0 ? 0.0f : values[pos];
+    }
+}
+
+int readLayout(data_t *p_data)
+//
+//  Purpose: Reads the layout record and block index saved ahead of the
+//  epilogue of a file whose results are saved in blocks of periods.
+//
+{
+    INT4 version, blockPeriods, numBlocks, encoding;
+    INT8 indexPos;
+    INT8 *index;
+    int  i;
+
+    _fseek(p_data->file, -6 * RECORDSIZE - 4 * RECORDSIZE - 8, SEEK_END);
+    if (fread(&version, RECORDSIZE, 1, p_data->file) != 1 ||
+        fread(&blockPeriods, RECORDSIZE, 1, p_data->file) != 1 ||
+        fread(&numBlocks, RECORDSIZE, 1, p_data->file) != 1 ||
+        fread(&encoding, RECORDSIZE, 1, p_data->file) != 1 ||
+        fread(&indexPos, 8, 1, p_data->file) != 1)
+        return 435;
+    if (version != LAYOUT_VERSION ||
+        (encoding != XORCODEC_NONE && encoding != XORCODEC_XOR) ||
+        blockPeriods < 1 ||
+        numBlocks < 0 ||
+        (INT8)numBlocks * blockPeriods < p_data->Nperiods)
+        return 435;
+
+    index = (INT8 *)calloc((size_t)numBlocks + 1, sizeof(INT8));
+    p_data->BlockPos = (F_OFF *)calloc((size_t)numBlocks + 1, sizeof(F_OFF));
+    if (index == NULL || p_data->BlockPos == NULL) {
+        free(index);
+        return 411;
+    }
+    _fseek(p_data->file, (F_OFF)indexPos, SEEK_SET);
+    if (fread(index, 8, (size_t)numBlocks + 1, p_data->file) !=
+        (size_t)numBlocks + 1) {
+        free(index);
+        return 435;
+    }
+    for (i = 0; i <= numBlocks; i++)
+        p_data->BlockPos[i] = (F_OFF)index[i];
+    free(index);
+
+    p_data->BlockPeriods = blockPeriods;
+    p_data->NumBlocks    = numBlocks;
+    p_data->Encoding     = encoding;
+    p_data->decodedBlock = -1;
+    return 0;
+}
+
+F_OFF getBlockPos(data_t *p_data, int block)
+//
+//  Purpose: Finds the file position of a block of results.
+//
+{
+    if (p_data->BlockPos != NULL)
+        return p_data->BlockPos[block];
+    return p_data->ResultsPos + block * p_data->BytesPerPeriod;
+}
+
+int getBlockSize(data_t *p_data, int block)
+//
+//  Purpose: Finds the number of periods saved in a block of results.
+//
+{
+    long size = p_data->Nperiods - (long)block * p_data->BlockPeriods;
+
+    return (int)(size < p_data->BlockPeriods ? size : p_data->BlockPeriods);
+}
+
+F_OFF getResultIndex(data_t *p_data, SMO_elementType type, int elementIndex,
+    int attr)
+//
+//  Purpose: Finds the number of a result within a reporting period.
+//
+{
+    F_OFF nodesPos = (F_OFF)p_data->Nsubcatch * p_data->SubcatchVars;
+    F_OFF linksPos = nodesPos + (F_OFF)p_data->Nnodes * p_data->NodeVars;
+    F_OFF sysPos   = linksPos + (F_OFF)p_data->Nlinks * p_data->LinkVars;
+
+    switch (type) {
+        case SMO_subcatch:
+            return (F_OFF)elementIndex * p_data->SubcatchVars + attr;
+        case SMO_node:
+            return nodesPos + (F_OFF)elementIndex * p_data->NodeVars + attr;
+        case SMO_link:
+            return linksPos + (F_OFF)elementIndex * p_data->LinkVars + attr;
+        default:
+            return sysPos + attr;
+    }
+}
+
+F_OFF getResultPos(data_t *p_data, int timeIndex, F_OFF result)
+//
+//  Purpose: Finds the file position of a result in a reporting period.
+//
+{
+    int block = timeIndex / p_data->BlockPeriods;
+    int size  = getBlockSize(p_data, block);
+
+    return getBlockPos(p_data, block) + size * DATESIZE +
+           (result * size + timeIndex % p_data->BlockPeriods) * RECORDSIZE;
+}
+
+void readResults(data_t *p_data, int timeIndex, F_OFF first, int n,
+    float *dest)
+//
+//  Purpose: Reads n consecutive results of a reporting period.
+//
+{
+    int   i;
+    int   block = timeIndex / p_data->BlockPeriods;
+    int   size = getBlockSize(p_data, block);
+    F_OFF offset;
+    const REAL4 *values;
+
+    if (p_data->Encoding != XORCODEC_NONE) {
+        values = decodeResults(p_data, block, first, n);
+        for (i = 0; i < n; i++)
+            dest[i] = values ? values[i * size +
+                timeIndex % p_data->BlockPeriods] : 0.0f;
+        return;
+    }
+
+    offset = getResultPos(p_data, timeIndex, first);
+    if (size == 1)
+        readRecords(p_data, offset, RECORDSIZE, n, dest);
+    else for (i = 0; i < n; i++)
+        readRecords(p_data, offset + (F_OFF)i * size * RECORDSIZE,
+            RECORDSIZE, 1, &dest[i]);
+}
+
+int readSeries(data_t *p_data, F_OFF result, int startPeriod, int n,
+    float *dest)
+//
+//  Purpose: Reads the values of a result over n reporting periods starting
+//  with startPeriod. Returns 0 if they couldn't all be read.
+//
+{
+    int k = 0, m, i, block, size;
+    const REAL4 *values;
+
+    while (k < n) {
+        block = (startPeriod + k) / p_data->BlockPeriods;
+        i     = (startPeriod + k) % p_data->BlockPeriods;
+        size  = getBlockSize(p_data, block);
+        m     = size - i;
+        if (m > n - k)
+            m = n - k;
+        if (p_data->Encoding != XORCODEC_NONE) {
+            if ((values = decodeResults(p_data, block, result, 1)) == NULL)
+                return 0;
+            memcpy(dest + k, values + i, m * sizeof(REAL4));
+        }
+        else if (readRecords(p_data,
+                     getResultPos(p_data, startPeriod + k, result),
+                     RECORDSIZE, m, dest + k) != m)
+            return 0;
+        k += m;
+    }
+    return 1;
+}
+
+const REAL4 *decodeResults(data_t *p_data, int block, F_OFF first, int n)
+//
+//  Purpose: Decodes the series of n consecutive results of an encoded block,
+//  returning the values of each result over the block's periods one result
+//  after another (or NULL if they can't be read).
+//
+{
+    int     i;
+    int     size = getBlockSize(p_data, block);
+    INT4    *ends;
+    size_t  bytes;
+    F_OFF   endsPos;
+    const unsigned char *data;
+
+    // --- check if the series were the last ones decoded
+    if (block == p_data->decodedBlock && first >= p_data->decodedFirst &&
+        first + n <= p_data->decodedFirst + p_data->decodedCount)
+        return p_data->decoded + (first - p_data->decodedFirst) * size;
+    p_data->decodedBlock = -1;
+
+    if ((size_t)n * p_data->BlockPeriods > p_data->decodedSize) {
+        free(p_data->decoded);
+        p_data->decodedSize = 0;
+        p_data->decoded = (REAL4 *)malloc((size_t)n * p_data->BlockPeriods *
+                                          sizeof(REAL4));
+        if (p_data->decoded == NULL)
+            return NULL;
+        p_data->decodedSize = (size_t)n * p_data->BlockPeriods;
+    }
+
+    // --- find where the series start and end (the table of where each
+    //     series ends closes the block)
+    ends = (INT4 *)calloc((size_t)n + 1, sizeof(INT4));
+    if (ends == NULL)
+        return NULL;
+    endsPos = p_data->BlockPos[block + 1] -
+              (getResultIndex(p_data, SMO_sys, 0, p_data->SysVars) - first) *
+              RECORDSIZE;
+    if ((first > 0 &&
+         readRecords(p_data, endsPos - RECORDSIZE, RECORDSIZE, n + 1, ends) !=
+             n + 1) ||
+        (first == 0 &&
+         readRecords(p_data, endsPos, RECORDSIZE, n, ends + 1) != n)) {
+        free(ends);
+        return NULL;
+    }
+
+    // --- decode each series
+    bytes = (size_t)(ends[n] - ends[0]);
+    data  = readBytes(p_data, p_data->BlockPos[block] + size * DATESIZE +
+                      ends[0], bytes);
+    for (i = 0; data != NULL && i < n; i++) {
+        if (xorcodec_decode(data + ends[i] - ends[0], ends[i + 1] - ends[i],
+                size, p_data->decoded + i * size) != 0)
+            data = NULL;
+    }
+    free(ends);
+    if (data == NULL)
+        return NULL;
+
+    p_data->decodedBlock = block;
+    p_data->decodedFirst = first;
+    p_data->decodedCount = n;
+    return p_data->decoded;
+}
+
+const unsigned char *readBytes(data_t *p_data, F_OFF offset, size_t size)
+//
+//  Purpose: Returns a pointer to size bytes of the file starting at offset.
+//  Points into the memory map if there is one, otherwise the bytes are
+//  read into a buffer. Returns NULL if they can't be read.
+//
+{
+    if (p_data->map != NULL) {
+        if (offset < 0 || offset + (F_OFF)size > p_data->mapSize)
+            return NULL;
+        return (const unsigned char *)(p_data->map + offset);
+    }
+
+    if (size > p_data->bytesSize) {
+        free(p_data->bytes);
+        p_data->bytesSize = 0;
+        p_data->bytes = (unsigned char *)malloc(size);
+        if (p_data->bytes == NULL)
+            return NULL;
+        p_data->bytesSize = size;
+    }
+    if (readRecords(p_data, offset, 1, (int)size, p_data->bytes) != (int)size)
+        return NULL;
+    return p_data->bytes;
+}
+
 double getTimeValue(data_t *p_data, int timeIndex) {
 
     F_OFF  offset;
     double value;
+    int    block = timeIndex / p_data->BlockPeriods;
 
     // --- compute offset into output file
-    offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod;
+    offset = getBlockPos(p_data, block) +
+             (timeIndex % p_data->BlockPeriods) * DATESIZE;
 
-    // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE * 2, 1, p_data->file);
+    // --- read the result
+    readRecords(p_data, offset, DATESIZE, 1, &value);
 
     return value;
 }
@@ -1052,18 +1902,11 @@ double getTimeValue(data_t *p_data, int timeIndex) {
 float getSubcatchValue(data_t *p_data, int timeIndex, int subcatchIndex,
     SMO_subcatchAttribute attr) {
 
-    F_OFF offset;
     float value;
 
-    // --- compute offset into output file
-    offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod +
-             2 * RECORDSIZE;
-    // offset for subcatch
-    offset += RECORDSIZE * (subcatchIndex * p_data->SubcatchVars + attr);
-
-    // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, timeIndex,
+        getResultIndex(p_data, SMO_subcatch, subcatchIndex,
+            getAttrPos(p_data, SMO_subcatch, attr)), 1, &value);
 
     return value;
 }
@@ -1071,19 +1914,11 @@ float getSubcatchValue(data_t *p_data, int timeIndex, int subcatchIndex,
 float getNodeValue(data_t *p_data, int timeIndex, int nodeIndex,
     SMO_nodeAttribute attr) {
 
-    F_OFF offset;
     float value;
 
-    // --- compute offset into output file
-    offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod +
-             2 * RECORDSIZE;
-    // offset for node
-    offset += RECORDSIZE * (p_data->Nsubcatch * p_data->SubcatchVars +
-                            nodeIndex * p_data->NodeVars + attr);
-
-    // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, timeIndex,
+        getResultIndex(p_data, SMO_node, nodeIndex,
+            getAttrPos(p_data, SMO_node, attr)), 1, &value);
 
     return value;
 }
@@ -1091,40 +1926,21 @@ float getNodeValue(data_t *p_data, int timeIndex, int nodeIndex,
 float getLinkValue(data_t *p_data, int timeIndex, int linkIndex,
     SMO_linkAttribute attr) {
 
-    F_OFF offset;
     float value;
 
-    // --- compute offset into output file
-    offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod +
-             2 * RECORDSIZE;
-    // offset for link
-    offset += RECORDSIZE * (p_data->Nsubcatch * p_data->SubcatchVars +
-                            p_data->Nnodes * p_data->NodeVars +
-                            linkIndex * p_data->LinkVars + attr);
-
-    // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, timeIndex,
+        getResultIndex(p_data, SMO_link, linkIndex,
+            getAttrPos(p_data, SMO_link, attr)), 1, &value);
 
     return value;
 }
 
 float getSystemValue(data_t *p_data, int timeIndex, SMO_systemAttribute attr) {
 
-    F_OFF offset;
     float value;
 
-    // --- compute offset into output file
-    offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod +
-             2 * RECORDSIZE;
-    //  offset for system
-    offset += RECORDSIZE * (p_data->Nsubcatch * p_data->SubcatchVars +
-                            p_data->Nnodes * p_data->NodeVars +
-                            p_data->Nlinks * p_data->LinkVars + attr);
-
-    // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, timeIndex,
+        getResultIndex(p_data, SMO_sys, 0, attr), 1, &value);
 
     return value;
 }
@@ -0,0 +1,55 @@
+/*
+ * transpose.c - Rewrites a SWMM binary output file in another layout
+ *
+ *      Usage: swmm-transpose [-z] <output file> <new output file> [periods]
+ *
+ *      The results of the new file are saved in blocks of the given number
+ *      of reporting periods (64 by default), each holding the series of
+ *      every result over its periods. The -z option compresses each block.
+ *      A block size of 0 writes the original period-major layout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "swmm_output.h"
+
+
+int main(int argc, char *argv[])
+{
+    int        blockPeriods = 64;
+    int        compress = 0;
+    int        errorcode;
+    char      *msg = NULL;
+    SMO_Handle p_handle = NULL;
+
+    if (argc > 1 && strcmp(argv[1], "-z") == 0) {
+        compress = 1;
+        argc--;
+        argv++;
+    }
+    if (argc < 3 || argc > 4) {
+        printf("\nUsage:\n\tswmm-transpose [-z] <output file> "
+               "<new output file> [periods]\n\n");
+        return 1;
+    }
+    if (argc == 4)
+        blockPeriods = atoi(argv[3]);
+
+    SMO_init(&p_handle);
+    errorcode = SMO_open(p_handle, argv[1]);
+    if (errorcode > 400) {
+        printf("\nError %d: unable to open %s\n\n", errorcode, argv[1]);
+        return 1;
+    }
+
+    errorcode = SMO_transpose(p_handle, argv[2], blockPeriods, compress);
+    if (errorcode > 0) {
+        SMO_checkError(p_handle, &msg);
+        printf("\n%s\n\n", msg);
+        SMO_freeMemory(msg);
+    }
+    SMO_close(p_handle);
+    return errorcode > 0;
+}
@@ -0,0 +1,97 @@
+/*
+ *  shared/xorcodec.c - Lossless compression of series of 4-byte reals
+ *
+ *  Created on: October 18, 2026
+ *
+ *  See xorcodec.h for a description of the encoding.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "xorcodec.h"
+
+
+// Number of leading and trailing zero bytes dropped from a value for each
+// 4-bit code (code 0 is a value equal to the one before it)
+static const unsigned char LeadBytes[11]  = {4, 0, 0, 0, 0, 1, 1, 1, 2, 2, 3};
+static const unsigned char TrailBytes[11] = {0, 0, 1, 2, 3, 0, 1, 2, 0, 1, 0};
+
+// Code for each count of leading zero bytes (with no trailing zero bytes)
+static const unsigned char FirstCode[4] = {1, 5, 8, 10};
+
+
+size_t xorcodec_maxSize(int n)
+// Returns the largest number of bytes a series of n values encodes to
+{
+    if (n <= 0)
+        return 0;
+    return (size_t)(n + 1) / 2 + 4 * (size_t)n;
+}
+
+
+size_t xorcodec_encode(const float *x, int n, unsigned char *dest)
+// Encodes a series of n values into dest, returning the number of bytes
+// used
+{
+    int            i, lead, trail, m;
+    uint32_t       bits, prev = 0, delta;
+    unsigned char *data = dest + (n + 1) / 2;
+
+    memset(dest, 0, (size_t)(n + 1) / 2);
+    for (i = 0; i < n; i++) {
+        memcpy(&bits, &x[i], sizeof(bits));
+        delta = bits ^ prev;
+        prev  = bits;
+        if (delta == 0)
+            continue;
+
+        // count zero bytes at each end of the difference
+        for (lead = 0; (delta >> (24 - 8 * lead)) == 0; lead++)
+            ;
+        for (trail = 0; ((delta >> (8 * trail)) & 0xFF) == 0; trail++)
+            ;
+        dest[i / 2] |= (FirstCode[lead] + trail) << (4 * (i % 2));
+
+        // keep the bytes in between
+        delta >>= 8 * trail;
+        for (m = 4 - lead - trail; m > 0; m--) {
+            *data++ = (unsigned char)(delta & 0xFF);
+            delta >>= 8;
+        }
+    }
+    return (size_t)(data - dest);
+}
+
+
+int xorcodec_decode(const unsigned char *source, size_t size, int n, float *x)
+// Decodes a series of n values from the size bytes of source, returning 0
+// if successful or -1 if source isn't a valid encoding
+{
+    int                  i, code, m, shift;
+    uint32_t             bits = 0, delta;
+    const unsigned char *data = source + (n + 1) / 2;
+    const unsigned char *end  = source + size;
+
+    if (size < (size_t)(n + 1) / 2)
+        return -1;
+    for (i = 0; i < n; i++) {
+        code = (source[i / 2] >> (4 * (i % 2))) & 0x0F;
+        if (code > 10)
+            return -1;
+        if (code > 0) {
+            m = 4 - LeadBytes[code] - TrailBytes[code];
+            if (data + m > end)
+                return -1;
+            delta = 0;
+            shift = 8 * TrailBytes[code];
+            for (; m > 0; m--) {
+                delta |= (uint32_t)(*data++) << shift;
+                shift += 8;
+            }
+            bits ^= delta;
+        }
+        memcpy(&x[i], &bits, sizeof(bits));
+    }
+    return (data == end) ? 0 : -1;
+}
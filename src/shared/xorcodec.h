@@ -0,0 +1,44 @@
+/*
+ *  shared/xorcodec.h - Lossless compression of series of 4-byte reals
+ *
+ *  Created on: October 18, 2026
+ *
+ *  Each value is XORed with the one before it and only the bytes of the
+ *  result that aren't zero at either end are kept. A series of n values is
+ *  encoded as (n+1)/2 control bytes, holding a 4-bit code for each value,
+ *  followed by the bytes kept for each value. Series that are constant or
+ *  change slowly, like most SWMM results, shrink to a fraction of their
+ *  size.
+ */
+
+#ifndef XORCODEC_H_
+#define XORCODEC_H_
+
+
+#include <stddef.h>
+
+
+// Encodings of binary output results (saved in the output file's layout
+// record)
+#define XORCODEC_NONE 0    // results saved as 4-byte reals
+#define XORCODEC_XOR  1    // each series of results encoded by xorcodec
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+size_t xorcodec_maxSize(int n);
+
+size_t xorcodec_encode(const float *x, int n, unsigned char *dest);
+
+int xorcodec_decode(const unsigned char *source, size_t size, int n, float *x);
+
+
+#if defined(__cplusplus)
+}
+#endif
+
+
+#endif /* XORCODEC_H_ */
@@ -19,6 +19,7 @@
 // OWA Version string stored in version.h
 // #define   VERSION            52004
 #define   MAGICNUMBER        516114522
+#define   BLOCKMAGICNUMBER   516114523      // Closes output saved in blocks
 #define   EOFMARK            0x1A           // Use 0x04 for UNIX systems
 #define   MAXTITLE           3              // Max. # title lines
 #define   MAXMSG             1024           // Max. # characters in message text
@@ -27,6 +28,8 @@
 #define   MAXTOKS            40             // Max. items per line of input
 #define   MAXSTATES          10             // Max. # computed hyd. variables
 #define   MAXODES            4              // Max. # ODE's to be solved
+#define   OUTPUT_BLOCK       64             // Default # periods per block of
+                                            //   element-major binary results
 #define   NA                 -1             // NOT APPLICABLE code
 #define   TRUE               1              // Value for TRUE state
 #define   FALSE              0              // Value for FALSE state
@@ -51,6 +51,9 @@
 //  Build 5.2.1:
 //  - A refactoring bug from 5.2.0 causing duplicate actions to be added
 //    to the list of control actions to take was fixed.
+//  Build 5.2.4:
+//  - Function controls_usesRunoffData added to see if any rule depends on
+//    rain gages or on time series that runoff also reads.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -188,6 +191,7 @@ struct  TExpression* Expression;       // array of math expressions
 //     controls_addExpression
 //     controls_addRuleClause
 //     controls_evaluate
+//     controls_usesRunoffData
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -553,6 +557,51 @@ int controls_evaluate(DateTime currentTime, DateTime elapsedTime, double tStep)
 
 //=============================================================================
 
+int controls_usesRunoffData(char tseries[])
+//
+//  Input:   tseries = array of flags for each time series read by runoff
+//  Output:  returns TRUE if any rule uses rain gage data or a flagged
+//           time series
+//  Purpose: checks if control rules depend on data that the runoff
+//           analysis updates.
+//
+{
+    int    i, r;
+    struct TPremise* p;
+    struct TAction*  a;
+
+    // --- check each named variable
+    for (i = 0; i < VariableCount; i++)
+    {
+        if ( NamedVariable[i].variable.object == r_GAGE ) return TRUE;
+    }
+
+    // --- check each rule's premises & actions
+    for (r = 0; r < RuleCount; r++)
+    {
+        p = Rules[r].firstPremise;
+        while (p)
+        {
+            if ( p->lhsVar.object == r_GAGE || p->rhsVar.object == r_GAGE )
+                return TRUE;
+            p = p->next;
+        }
+        for (i = 0; i < 2; i++)
+        {
+            if ( i == 0 ) a = Rules[r].thenActions;
+            else          a = Rules[r].elseActions;
+            while (a)
+            {
+                if ( a->tseries >= 0 && tseries[a->tseries] ) return TRUE;
+                a = a->next;
+            }
+        }
+    }
+    return FALSE;
+}
+
+//=============================================================================
+
 int  addPremise(int r, int type, char* tok[], int nToks)
 //
 //  Input:   r = control rule index
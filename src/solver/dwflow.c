@@ -28,6 +28,10 @@
 //   - Implements the new option to skip checking for normal flow limitations.
 //   Build 5.2.4:
 //   - Arguments to function link_getLossRate changed.
+//   - Node heads & link inverts read from the DwState arrays, which are
+//     also updated with the conduit's new flow state.
+//   - Conduits processed in batches with the momentum equation solved in
+//     a vectorizable loop.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -36,6 +40,50 @@
 
 static const  double MAXVELOCITY =  50.;     // max. allowable velocity (ft/sec)
 
+#define BATCHSIZE 32                         // max. conduits in a batch
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct
+{
+    int    n;                          // number of conduits in batch
+    int    link[BATCHSIZE];            // link index of conduit
+    double h1[BATCHSIZE];              // upstream flow head (ft)
+    double h2[BATCHSIZE];              // downstream flow head (ft)
+    double y1[BATCHSIZE];              // upstream flow depth (ft)
+    double y2[BATCHSIZE];              // downstream flow depth (ft)
+    double a1[BATCHSIZE];              // upstream flow area (ft2)
+    double a2[BATCHSIZE];              // downstream flow area (ft2)
+    double aMid[BATCHSIZE];            // mid-stream flow area (ft2)
+    double aOld[BATCHSIZE];            // area from previous time step (ft2)
+    double r1[BATCHSIZE];              // upstream hyd. radius (ft)
+    double rMid[BATCHSIZE];            // mid-stream hyd. radius (ft)
+    double qOld[BATCHSIZE];            // flow from previous time step (cfs)
+    double qLast[BATCHSIZE];           // flow from previous iteration (cfs)
+    double v[BATCHSIZE];               // velocity (ft/sec)
+    double rho[BATCHSIZE];             // upstream weighting factor
+    double sigma[BATCHSIZE];           // inertial damping factor
+    double length[BATCHSIZE];          // effective conduit length (ft)
+    double roughFactor[BATCHSIZE];     // roughness factor
+    double barrels[BATCHSIZE];         // number of barrels
+    double dq1[BATCHSIZE];             // friction slope term
+    double dq5[BATCHSIZE];             // local losses term
+    double dq6[BATCHSIZE];             // evap. & seepage losses term
+    double q[BATCHSIZE];               // new flow from momentum eqn. (cfs)
+    double dqdh[BATCHSIZE];            // change in flow w.r.t. head (ft2/sec)
+    char   isFull[BATCHSIZE];          // TRUE if conduit flowing full
+    char   isForceMain[BATCHSIZE];     // TRUE if full force main
+} TConduitBatch;
+
+//-----------------------------------------------------------------------------
+//  Function declarations
+//-----------------------------------------------------------------------------
+static void   initConduitFlow(int link, double dt, TConduitBatch* b);
+static void   solveMomentum(TConduitBatch* b, double dt);
+static void   finishConduitFlow(TConduitBatch* b, int i, int steps,
+              double omega);
+
 static int    getFlowClass(int link, double q, double h1, double h2,
               double y1, double y2, double* criticalDepth, double* normalDepth,
               double* fasnh);
@@ -51,6 +99,7 @@ static double getHydRad(TXsect* xsect, double y);
 
 static double checkNormalFlow(int j, double q, double y1, double y2,
               double a1, double r1);
+static void   saveFlowState(int j, int k);
 
 //=============================================================================
 
@@ -60,11 +109,64 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
 //           steps    = number of iteration steps taken
 //           omega    = under-relaxation parameter
 //           dt       = time step (sec)
-//  Output:  returns new flow value (cfs)
+//  Output:  none
 //  Purpose: updates flow in conduit link by solving finite difference
 //           form of continuity and momentum equations.
 //
 {
+    dwflow_findConduitFlows(1, &j, steps, omega, dt);
+}
+
+//=============================================================================
+
+void  dwflow_findConduitFlows(int n, int links[], int steps, double omega,
+      double dt)
+//
+//  Input:   n        = number of conduits
+//           links    = array of conduit link indexes
+//           steps    = number of iteration steps taken
+//           omega    = under-relaxation parameter
+//           dt       = time step (sec)
+//  Output:  none
+//  Purpose: updates flow in a group of conduit links by solving finite
+//           difference form of continuity and momentum equations.
+//
+//  Conduits are processed in batches. The end depths, areas, flow class
+//  and loss terms of each conduit are found one conduit at a time, the
+//  momentum equation is then solved for all of the batch's wet conduits
+//  in a single branch-free loop that the compiler can vectorize, and any
+//  flow limitations are applied one conduit at a time.
+//
+{
+    int i, m;
+    TConduitBatch b;
+
+    for (m = 0; m < n; m += BATCHSIZE)
+    {
+        b.n = 0;
+        for (i = m; i < n && i < m + BATCHSIZE; i++)
+        {
+            initConduitFlow(links[i], dt, &b);
+        }
+        solveMomentum(&b, dt);
+        for (i = 0; i < b.n; i++) finishConduitFlow(&b, i, steps, omega);
+    }
+}
+
+//=============================================================================
+
+void  initConduitFlow(int j, double dt, TConduitBatch* b)
+//
+//  Input:   j        = link index
+//           dt       = time step (sec)
+//           b        = batch of conduits
+//  Output:  none
+//  Purpose: finds the terms of a conduit's momentum equation that depend
+//           on its cross section & flow class, adding the conduit to a
+//           batch if it is not dry.
+//
+{
+    int    i;                          // position in batch
     int    k;                          // index of conduit
     int    n1, n2;                     // indexes of end nodes
     double z1, z2;                     // upstream/downstream invert elev. (ft)
@@ -73,26 +175,19 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     double a1, a2;                     // upstream/downstream flow areas (ft2)
     double r1;                         // upstream hyd. radius (ft)
     double yMid, rMid, aMid;           // mid-stream or avg. values of y, r, & a
-    double aWtd, rWtd;                 // upstream weighted area & hyd. radius
     double qLast;                      // flow from previous iteration (cfs)
     double qOld;                       // flow from previous time step (cfs)
     double aOld;                       // area from previous time step (ft2)
     double v;                          // velocity (ft/sec)
-    double rho;                        // upstream weighting factor
-    double sigma;                      // inertial damping factor
     double length;                     // effective conduit length (ft)
     double wSlot;                      // Preissmann slot width (ft)
-    double dq1, dq2, dq3, dq4, dq5,    // terms in momentum eqn.
-           dq6;                        // term for evap and infil losses
-    double denom;                      // denominator of flow update formula
-    double q;                          // new flow value (cfs)
+    double rho;                        // upstream weighting factor
+    double sigma;                      // inertial damping factor
     double barrels;                    // number of barrels in conduit
     TXsect* xsect = &Link[j].xsect;    // ptr. to conduit's cross section data
     char   isFull = FALSE;             // TRUE if conduit flowing full
     char   isClosed = FALSE;           // TRUE if conduit closed
 
-
-
     // --- adjust isClosed status by any control action
     if ( Link[j].setting == 0 ) isClosed = TRUE;
 
@@ -107,10 +202,10 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     // --- get most current heads at upstream and downstream ends of conduit
     n1 = Link[j].node1;
     n2 = Link[j].node2;
-    z1 = Node[n1].invertElev + Link[j].offset1;
-    z2 = Node[n2].invertElev + Link[j].offset2;
-    h1 = Node[n1].newDepth + Node[n1].invertElev;
-    h2 = Node[n2].newDepth + Node[n2].invertElev;
+    z1 = DwState.z1[j];
+    z2 = DwState.z2[j];
+    h1 = DwState.nodeDepth[n1] + DwState.nodeInvert[n1];
+    h2 = DwState.nodeDepth[n2] + DwState.nodeInvert[n2];
     h1 = MAX(h1, z1);
     h2 = MAX(h2, z2);
 
@@ -176,6 +271,7 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
         Link[j].newDepth = MIN(yMid, Link[j].xsect.yFull);
         Link[j].newVolume = Conduit[k].a1 * link_getLength(j) * barrels;
         Link[j].newFlow = 0.0;
+        saveFlowState(j, k);
         return;
     }
 
@@ -188,17 +284,37 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     if ( Link[j].flowClass == SUBCRITICAL &&
          Link[j].froude > 1.0 ) Link[j].flowClass = SUPCRITICAL;
 
+    // --- add conduit to the batch
+    i = b->n++;
+    b->link[i] = j;
+    b->h1[i] = h1;
+    b->h2[i] = h2;
+    b->y1[i] = y1;
+    b->y2[i] = y2;
+    b->a1[i] = a1;
+    b->a2[i] = a2;
+    b->aMid[i] = aMid;
+    b->aOld[i] = aOld;
+    b->r1[i] = r1;
+    b->rMid[i] = rMid;
+    b->qOld[i] = qOld;
+    b->qLast[i] = qLast;
+    b->v[i] = v;
+    b->length[i] = length;
+    b->roughFactor[i] = Conduit[k].roughFactor;
+    b->barrels[i] = barrels;
+    b->isFull[i] = isFull;
+
     // --- find inertial damping factor (sigma)
     if      ( Link[j].froude <= 0.5 ) sigma = 1.0;
     else if ( Link[j].froude >= 1.0 ) sigma = 0.0;
     else    sigma = 2.0 * (1.0 - Link[j].froude);
 
-    // --- get upstream-weighted area & hyd. radius based on damping factor
+    // --- get upstream weighting factor based on damping factor
     //     (modified version of R. Dickinson's slope weighting)
     rho = 1.0;
     if ( !isFull && qLast > 0.0 && h1 >= h2 ) rho = sigma;
-    aWtd = a1 + (aMid - a1) * rho;
-    rWtd = r1 + (rMid - r1) * rho;
+    b->rho[i] = rho;
 
     // --- determine how much inertial damping to apply
     if      ( InertDamping == NO_DAMPING )   sigma = 1.0;
@@ -206,41 +322,110 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
 
     // --- use full inertial damping if closed conduit is surcharged
     if ( isFull && !xsect_isOpen(xsect->type) ) sigma = 0.0;
+    b->sigma[i] = sigma;
+
+    // --- friction slope term for a full force main
+    b->isForceMain[i] = ( xsect->type == FORCE_MAIN && isFull );
+    b->dq1[i] = 0.0;
+    if ( b->isForceMain[i] )
+        b->dq1[i] = dt * forcemain_getFricSlope(j, fabs(v), rMid);
+
+    // --- local losses term
+    b->dq5[i] = 0.0;
+    if ( Conduit[k].hasLosses )
+    {
+        b->dq5[i] = findLocalLosses(j, a1, a2, aMid, qLast) / 2.0 / length * dt;
+    }
 
-    // --- compute terms of momentum eqn.:
-    // --- 1. friction slope term
-    if ( xsect->type == FORCE_MAIN && isFull )
-         dq1 = dt * forcemain_getFricSlope(j, fabs(v), rMid);
-    else dq1 = dt * Conduit[k].roughFactor / pow(rWtd, 1.33333) * fabs(v);
+    // --- term for evap and seepage losses per unit length
+    b->dq6[i] = link_getLossRate(j, DW, qLast, dt) * 2.5 * dt * v /
+                link_getLength(j);
+}
 
-    // --- 2. energy slope term
-    dq2 = dt * GRAVITY * aWtd * (h2 - h1) / length;
+//=============================================================================
+
+void  solveMomentum(TConduitBatch* b, double dt)
+//
+//  Input:   b        = batch of conduits
+//           dt       = time step (sec)
+//  Output:  none
+//  Purpose: solves the momentum equation for the new flow in each conduit
+//           of a batch.
+//
+//  The friction term is found in a separate loop so that the loop which
+//  combines the terms has no function calls (the friction loop is only
+//  vectorized when the compiler has a vector version of pow()).
+//
+{
+    int    i;
+    double rWtd;                       // upstream weighted hyd. radius (ft)
+    double aWtd;                       // upstream weighted area (ft2)
+    double dq1, dq2, dq3, dq4;         // terms in momentum eqn.
+    double denom;                      // denominator of flow update formula
 
-    // --- 3 & 4. inertial terms
-    dq3 = 0.0;
-    dq4 = 0.0;
-    if ( sigma > 0.0 )
+    // --- 1. friction slope term (found in initConduitFlow for force mains)
+    #pragma omp simd private(rWtd, dq1)
+    for (i = 0; i < b->n; i++)
     {
-        dq3 = 2.0 * v * (aMid - aOld) * sigma;
-        dq4 = dt * v * v * (a2 - a1) / length * sigma;
+        rWtd = b->r1[i] + (b->rMid[i] - b->r1[i]) * b->rho[i];
+        dq1 = dt * b->roughFactor[i] / pow(rWtd, 1.33333) * fabs(b->v[i]);
+        if ( !b->isForceMain[i] ) b->dq1[i] = dq1;
     }
 
-    // --- 5. local losses term
-    dq5 = 0.0;
-    if ( Conduit[k].hasLosses )
+    #pragma omp simd private(aWtd, dq2, dq3, dq4, denom)
+    for (i = 0; i < b->n; i++)
     {
-        dq5 = findLocalLosses(j, a1, a2, aMid, qLast) / 2.0 / length * dt;
+        // --- get upstream-weighted area
+        aWtd = b->a1[i] + (b->aMid[i] - b->a1[i]) * b->rho[i];
+
+        // --- 2. energy slope term
+        dq2 = dt * GRAVITY * aWtd * (b->h2[i] - b->h1[i]) / b->length[i];
+
+        // --- 3 & 4. inertial terms
+        dq3 = 2.0 * b->v[i] * (b->aMid[i] - b->aOld[i]) * b->sigma[i];
+        dq4 = dt * b->v[i] * b->v[i] * (b->a2[i] - b->a1[i]) / b->length[i] *
+              b->sigma[i];
+        if ( b->sigma[i] <= 0.0 )
+        {
+            dq3 = 0.0;
+            dq4 = 0.0;
+        }
+
+        // --- combine terms (including 5. local losses & 6. evap and
+        //     seepage losses) to find new conduit flow
+        denom = 1.0 + b->dq1[i] + b->dq5[i];
+        b->q[i] = (b->qOld[i] - dq2 + dq3 + dq4 + b->dq6[i]) / denom;
+
+        // --- compute derivative of flow w.r.t. head
+        b->dqdh[i] = 1.0 / denom  * GRAVITY * dt * aWtd / b->length[i] *
+                     b->barrels[i];
     }
+}
 
-    // --- 6. term for evap and seepage losses per unit length
-    dq6 = link_getLossRate(j, DW, qLast, dt) * 2.5 * dt * v / link_getLength(j);
+//=============================================================================
 
-    // --- combine terms to find new conduit flow
-    denom = 1.0 + dq1 + dq5;
-    q = (qOld - dq2 + dq3 + dq4 + dq6) / denom;
+void  finishConduitFlow(TConduitBatch* b, int i, int steps, double omega)
+//
+//  Input:   b        = batch of conduits
+//           i        = position of conduit in batch
+//           steps    = number of iteration steps taken
+//           omega    = under-relaxation parameter
+//  Output:  none
+//  Purpose: applies any flow limitations and under-relaxation to the new
+//           flow found for a conduit and saves its new flow state.
+//
+{
+    int    j = b->link[i];             // link index
+    int    k = Link[j].subIndex;       // conduit index
+    int    n1 = Link[j].node1;         // upstream node index
+    int    n2 = Link[j].node2;         // downstream node index
+    double q = b->q[i];                // new flow value (cfs)
+    double qLast = b->qLast[i];        // flow from previous iteration (cfs)
+    double y1 = b->y1[i];              // upstream flow depth (ft)
+    double aMid;                       // average flow area (ft2)
+    TXsect* xsect = &Link[j].xsect;    // ptr. to conduit's cross section data
 
-    // --- compute derivative of flow w.r.t. head
-    Link[j].dqdh = 1.0 / denom  * GRAVITY * dt * aWtd / length * barrels;
+    Link[j].dqdh = b->dqdh[i];
 
     // --- check if any flow limitation applies
     Link[j].inletControl = FALSE;
@@ -248,14 +433,14 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     if ( q > 0.0 )
     {
         // --- check for inlet controlled culvert flow
-        if ( xsect->culvertCode > 0 && !isFull )
-            q = culvert_getInflow(j, q, h1);
+        if ( xsect->culvertCode > 0 && !b->isFull[i] )
+            q = culvert_getInflow(j, q, b->h1[i]);
 
         // --- check for normal flow limitation based on surface slope & Fr
         else if (NormalFlowLtd != NEITHER && y1 < Link[j].xsect.yFull &&
                 ( Link[j].flowClass == SUBCRITICAL || 
                   Link[j].flowClass == SUPCRITICAL ))
-            q = checkNormalFlow(j, q, y1, y2, a1, r1);
+            q = checkNormalFlow(j, q, y1, b->y2[i], b->a1[i], b->r1[i]);
     }
 
     // --- apply under-relaxation weighting between new & old flows;
@@ -277,19 +462,40 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
 
     // --- do not allow flow out of a dry node
     //     (as suggested by R. Dickinson)
-    if( q >  FUDGE && Node[n1].newDepth <= FUDGE ) q =  FUDGE;
-    if( q < -FUDGE && Node[n2].newDepth <= FUDGE ) q = -FUDGE;
+    if( q >  FUDGE && DwState.nodeDepth[n1] <= FUDGE ) q =  FUDGE;
+    if( q < -FUDGE && DwState.nodeDepth[n2] <= FUDGE ) q = -FUDGE;
 
     // --- save new values of area, flow, depth, & volume
-    Conduit[k].a1 = aMid;
+    Conduit[k].a1 = b->aMid[i];
     Conduit[k].q1 = q;
     Conduit[k].q2 = q;
-    Link[j].newDepth  = MIN(yMid, xsect->yFull);
-    aMid = (a1 + a2) / 2.0;
+    Link[j].newDepth  = MIN(0.5 * (y1 + b->y2[i]), xsect->yFull);
+    aMid = (b->a1[i] + b->a2[i]) / 2.0;
 //  aMid = MIN(aMid, xsect->aFull);  //Slot can have aMid > aFull 
-    Conduit[k].fullState = link_getFullState(a1, a2, xsect->aFull);
-    Link[j].newVolume = aMid * link_getLength(j) * barrels;
-    Link[j].newFlow = q * barrels;
+    Conduit[k].fullState = link_getFullState(b->a1[i], b->a2[i],
+                                             xsect->aFull);
+    Link[j].newVolume = aMid * link_getLength(j) * b->barrels[i];
+    Link[j].newFlow = q * b->barrels[i];
+    saveFlowState(j, k);
+}
+
+//=============================================================================
+
+void saveFlowState(int j, int k)
+//
+//  Input:   j = conduit link index
+//           k = conduit index
+//  Output:  none
+//  Purpose: copies a conduit's new flow state into the DwState arrays.
+//
+{
+    DwState.flow[j]     = Link[j].newFlow;
+    DwState.area[j]     = Conduit[k].a1;
+    DwState.volume[j]   = Link[j].newVolume;
+    DwState.froude[j]   = Link[j].froude;
+    DwState.dqdh[j]     = Link[j].dqdh;
+    DwState.lossRate[j] = (Conduit[k].evapLossRate + Conduit[k].seepLossRate) *
+                          Conduit[k].barrels;
 }
 
 //=============================================================================
@@ -378,7 +584,7 @@ int getFlowClass(int j, double q, double h1, double h2, double y1, double y2,
     {
         // --- flow classification is UP_DRY if downstream head <
         //     invert of upstream end of conduit
-        if ( h2 < Node[n1].invertElev + Link[j].offset1 ) flowClass = UP_DRY;
+        if ( h2 < DwState.z1[j] ) flowClass = UP_DRY;
 
         // --- otherwise, the downstream head will be >= upstream
         //     conduit invert creating a flow reversal and upstream end
@@ -397,7 +603,7 @@ int getFlowClass(int j, double q, double h1, double h2, double y1, double y2,
     {
         // --- flow classification is DN_DRY if upstream head <
         //     invert of downstream end of conduit
-        if ( h1 < Node[n2].invertElev + Link[j].offset2 ) flowClass = DN_DRY;
+        if ( h1 < DwState.z2[j] ) flowClass = DN_DRY;
 
         // --- otherwise flow at downstream end should be at critical depth
         //     providing that a downstream offset exists (otherwise
@@ -428,7 +634,6 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
 //  Purpose: assigns surface area of conduit to its up and downstream nodes.
 //
 {
-    int     n1, n2;                    // indexes of upstrm/downstrm nodes
     double  flowDepth1;                // flow depth at upstrm end (ft)
     double  flowDepth2;                // flow depth at downstrm end (ft)
     double  flowDepthMid;              // flow depth at midpt. (ft)
@@ -443,9 +648,7 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
     double  fasnh = 1.0;               // fraction between norm. & crit. depth
     TXsect* xsect = &Link[j].xsect;    // pointer to cross-section data
 
-    // --- get node indexes & current flow depths
-    n1 = Link[j].node1;
-    n2 = Link[j].node2;
+    // --- get current flow depths
     flowDepth1 = *y1;
     flowDepth2 = *y2;
 
@@ -478,7 +681,7 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
         flowDepth1 = criticalDepth;
         if ( normalDepth < criticalDepth ) flowDepth1 = normalDepth;
         flowDepth1 = MAX(flowDepth1, FUDGE);
-        *h1 = Node[n1].invertElev + Link[j].offset1 + flowDepth1;
+        *h1 = DwState.z1[j] + flowDepth1;
         flowDepthMid = 0.5 * (flowDepth1 + flowDepth2);
         if ( flowDepthMid < FUDGE ) flowDepthMid = FUDGE;
         width2   = getWidth(xsect, flowDepth2);
@@ -490,7 +693,7 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
         flowDepth2 = criticalDepth;
         if ( normalDepth < criticalDepth ) flowDepth2 = normalDepth;
         flowDepth2 = MAX(flowDepth2, FUDGE);
-        *h2 = Node[n2].invertElev + Link[j].offset2 + flowDepth2;
+        *h2 = DwState.z2[j] + flowDepth2;
         width1 = getWidth(xsect, flowDepth1);
         flowDepthMid = 0.5 * (flowDepth1 + flowDepth2);
         if ( flowDepthMid < FUDGE ) flowDepthMid = FUDGE;
@@ -545,6 +748,8 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
     }
     Link[j].surfArea1 = surfArea1;
     Link[j].surfArea2 = surfArea2;
+    DwState.surfArea1[j] = surfArea1;
+    DwState.surfArea2[j] = surfArea2;
     *y1 = flowDepth1;
     *y2 = flowDepth2;
 }
@@ -47,6 +47,20 @@
 //   Build 5.2.4:
 //   - Conduit evap+seepage outflow split evenly between outflow from
 //     conduit's upstream and non-outfall downstream nodes.
+//   - Node inflow/outflow accumulation in findLinkFlows() made parallel
+//     and race-free by gathering conduit flows at each node and by
+//     processing non-conduit links in levels that share no nodes.
+//   - All trials of a routing step run within a single OpenMP parallel
+//     region instead of opening new regions for each trial.
+//   - Node depths and conduit flow states used in the solver's inner loops
+//     read from the compact DwState arrays.
+//   - Conduit flows found in batches of conduits.
+//   - Optional skipping of converged nodes whose links are all bypassed
+//     on later trials of a time step.
+//   - Optional solution of hydraulically separate basins in parallel, each
+//     with its own trials on the shared routing time step.
+//   - Parallel reductions kept in a fixed order so that results do not
+//     depend on the number of threads used.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -65,6 +79,8 @@ static const double EXTRAN_CROWN_CUTOFF = 0.96;   // crown cutoff for EXTRAN
 static const double SLOT_CROWN_CUTOFF   = 0.985257; // crown cutoff for SLOT
 static const int    DEFAULT_MAXTRIALS   = 8;      // Max. trials per time step
 
+#define CONDUIT_BATCH 128                 // conduits per call to dwflow
+
 
 //-----------------------------------------------------------------------------
 //  Data Structures
@@ -76,41 +92,92 @@ typedef struct
     double  oldSurfArea;               // previous surface area (ft2)
     double  sumdqdh;                   // sum of dqdh from adjoining links
     double  dYdT;                      // change in depth w.r.t. time (ft/sec)
+    char    active;                    // TRUE if node updated on current trial
 } TXnode;
 
+typedef struct
+{
+    int     nNodes;                    // number of nodes
+    int*    nodes;                     // indexes of the nodes
+    int     nActive;                   // number of nodes updated on a trial
+    int*    active;                    // nodes updated on current trial
+    int     nConduits;                 // number of non-dummy conduits
+    int*    conduits;                  // non-dummy conduits
+    int     nLevels;                   // number of non-conduit link levels
+    int*    levelStart;                // start of a level's links in levelLinks
+    int*    levelLinks;                // non-conduit links ordered by level
+    int     nOutfallLinks;             // number of links attached to outfalls
+    int*    outfallLinks;              // links attached to outfalls
+    int     steps;                     // number of trials used
+    int     converged;                 // TRUE if all node depths converged
+    double  omega;                     // actual under-relaxation parameter
+} TSubnet;
+
 //-----------------------------------------------------------------------------
 //  Shared Variables
 //-----------------------------------------------------------------------------
 static double  VariableStep;           // size of variable time step (sec)
 static TXnode* Xnode;                  // extended nodal information
 
-static double  Omega;                  // actual under-relaxation parameter
-static int     Steps;                  // number of Picard iterations
+static int     NodesConverged;         // TRUE if all node depths converged
+
+static int*    NodeLinkStart;          // start of a node's entries in NodeLinks
+static int*    NodeLinks;              // link ends (2*link + end) at each node
+static int     NumConduitLinks;        // number of non-dummy conduits
+static int*    ConduitLinks;           // link indexes of non-dummy conduits
+static int     NumLinkLevels;          // number of non-conduit link levels
+static int*    LevelStart;             // start of a level's links in LevelLinks
+static int*    LevelLinks;             // non-conduit links ordered by level
+
+static int*    ActiveNodes;            // nodes updated on current trial
+
+static TSubnet Network;                // links & nodes of the whole network
+static int     UseBasins;              // TRUE if basins solved separately
+static int     NumBasins;              // number of hydraulically separate basins
+static TSubnet* Basins;                // links & nodes of each basin
+static int*    BasinNodes;             // nodes grouped by basin
+static int*    BasinLinks;             // conduits & other links grouped by basin
+static int*    BasinLevelStart;        // start & end of each basin's other links
+static int*    OutfallLinks;           // links attached to outfalls by basin
 
 //-----------------------------------------------------------------------------
 //  Function declarations
 //-----------------------------------------------------------------------------
 static void   initRoutingStep(void);
-static void   initNodeStates(void);
-static void   findBypassedLinks();
+static int    executeTrials(double dt);
+static void   solveSubnet(TSubnet* sn, double dt, int nThreads);
+static void   initNodeStates(TSubnet* sn);
+static void   findBypassedLinks(TSubnet* sn);
+static void   initActiveNodes(TSubnet* sn);
+static void   updateActiveNodes(TSubnet* sn);
 static void   findLimitedLinks();
 
-static void   findLinkFlows(double dt);
+static void   findLinkFlows(TSubnet* sn, double dt);
 static int    isTrueConduit(int link);
-static void   findNonConduitFlow(int link, double dt);
+static void   findNonConduitFlow(int link, int steps, double omega,
+              double dt);
 static void   findNonConduitSurfArea(int link);
 static double getModPumpFlow(int link, double q, double dt);
 static void   updateNodeFlows(int link);
+static void   gatherConduitFlows(int node);
+static int    createLinkLists(void);
+static void   freeLinkLists(void);
+static int    createBasins(void);
+static void   freeBasins(void);
+static int    createDwState(void);
+static void   freeDwState(void);
 static void   updateConvergenceStats();
 
-static int    findNodeDepths(double dt);
-static void   setNodeDepth(int node, double dt);
+static void   findNodeDepths(TSubnet* sn, double dt);
+static void   setNodeDepth(int node, int steps, double omega, double dt);
 static double getFloodedDepth(int node, int canPond, double dV, double yNew,
               double yMax, double dt);
 
 static double getVariableStep(double maxStep);
 static double getLinkStep(double tMin, int *minLink);
 static double getNodeStep(double tMin, int *minNode);
+static double getConduitStep(int link);
+static double getNodeDepthStep(int node);
 
 //=============================================================================
 
@@ -158,6 +225,16 @@ void dynwave_init()
     // --- set crown cutoff for finding top width of closed conduits
     if ( SurchargeMethod == SLOT ) CrownCutoff = SLOT_CROWN_CUTOFF;
     else                           CrownCutoff = EXTRAN_CROWN_CUTOFF;
+
+    // --- create node-link adjacency, non-conduit link levels &
+    //     routing state arrays
+    if ( !createLinkLists() || !createBasins() || !createDwState() )
+    {
+        report_writeErrorMsg(ERR_MEMORY,
+            " Not enough memory for dynamic wave routing.");
+        return;
+    }
+    UseBasins = ( SeparateBasins && NumBasins > 1 );
 }
 
 //=============================================================================
@@ -170,6 +247,9 @@ void  dynwave_close()
 //
 {
     FREE(Xnode);
+    freeLinkLists();
+    freeBasins();
+    freeDwState();
 }
 
 //=============================================================================
@@ -209,6 +289,8 @@ double dynwave_getRoutingStep(double fixedStep)
     if ( VariableStep == 0.0 )
     {
         VariableStep = MinRouteStep;
+        VariableStep = floor(1000.0 * VariableStep) / 1000.0;
+        return VariableStep;
     }
 
     // --- otherwise compute variable step based on current flow solution
@@ -223,42 +305,118 @@ double dynwave_getRoutingStep(double fixedStep)
 
 int dynwave_execute(double tStep)
 //
-//  Input:   links = array of topo sorted links indexes
-//           tStep = time step (sec)
+//  Input:   tStep = time step (sec)
 //  Output:  returns number of iterations used
 //  Purpose: routes flows through drainage network over current time step.
 //
 {
-    int converged;
+    int steps;                          // number of trials used
 
     // --- initialize
     if ( ErrorCode ) return 0;
-    Steps = 0;
-    converged = FALSE;
-    Omega = OMEGA;
     initRoutingStep();
 
-    // --- keep iterating until convergence 
-    while ( Steps < MaxTrials )
+    // --- iterate until all node depths converge
+    steps = executeTrials(tStep);
+    if ( !NodesConverged ) updateConvergenceStats();
+
+    //  --- identify any capacity-limited conduits
+    findLimitedLinks();
+    return steps;
+}
+
+//=============================================================================
+
+int executeTrials(double dt)
+//
+//  Input:   dt = time step (sec)
+//  Output:  returns number of trials used
+//  Purpose: iterates the flow & depth solution of the links & nodes
+//           until the node depths converge.
+//
+//  Separate basins are solved in parallel with one thread per basin while
+//  otherwise all threads share the work of solving the whole network. All
+//  basins advance by the same time step; each one only runs the trials its
+//  own nodes need to converge.
+//
+//  Results are bitwise identical for any number of threads. Each node's
+//  inflow & outflow totals are summed in a fixed link order, convergence
+//  is a logical AND of per-node tests, each outfall depth is set from its
+//  own link alone, mass balance & statistics are updated serially after
+//  the step, and conduits are batched from fixed positions in the conduit
+//  lists. New parallel loops must keep their reductions in a fixed order
+//  to preserve this.
+//
+{
+    int b, steps = 0;
+
+    if ( !UseBasins )
+    {
+        solveSubnet(&Network, dt, NumThreads);
+        NodesConverged = Network.converged;
+        return Network.steps;
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(NumThreads)
+    for ( b = 0; b < NumBasins; b++ ) solveSubnet(&Basins[b], dt, 1);
+
+    // --- combine the basins' results
+    NodesConverged = TRUE;
+    for ( b = 0; b < NumBasins; b++ )
+    {
+        steps = MAX(steps, Basins[b].steps);
+        if ( !Basins[b].converged ) NodesConverged = FALSE;
+    }
+    return steps;
+}
+
+//=============================================================================
+
+void solveSubnet(TSubnet* sn, double dt, int nThreads)
+//
+//  Input:   sn = subnetwork of links & nodes
+//           dt = time step (sec)
+//           nThreads = number of threads to use
+//  Output:  none
+//  Purpose: carries out trials of the flow & depth solution of a
+//           subnetwork until its node depths converge.
+//
+{
+    // --- initialize
+    sn->steps = 0;
+    sn->converged = FALSE;
+    sn->omega = OMEGA;
+    initActiveNodes(sn);
+
+    // --- keep iterating until convergence, with the same team of threads
+    //     executing every trial (the functions called below share out
+    //     their loops among the team and end with a barrier)
+#pragma omp parallel num_threads(nThreads)
+{
+    while ( sn->steps < MaxTrials )
     {
         // --- execute a routing step & check for nodal convergence
-        initNodeStates();
-        findLinkFlows(tStep);
-        converged = findNodeDepths(tStep);
-        Steps++;
-        if ( Steps > 1 )
+        initNodeStates(sn);
+        findLinkFlows(sn, dt);
+        findNodeDepths(sn, dt);
+
+        #pragma omp single
+        sn->steps++;
+        if ( sn->steps > 1 )
         {
-            if ( converged ) break;
+            if ( sn->converged ) break;
 
             // --- check if link calculations can be skipped in next step
-            findBypassedLinks();
+            //     (and which nodes need to be updated)
+            if ( SkipConverged )
+            {
+                #pragma omp single
+                updateActiveNodes(sn);
+            }
+            else findBypassedLinks(sn);
         }
     }
-    if ( !converged ) updateConvergenceStats();
-
-    //  --- identify any capacity-limited conduits
-    findLimitedLinks();
-    return Steps;
+}
 }
 
 //=============================================================================
@@ -274,18 +432,35 @@ void updateConvergenceStats()
 //=============================================================================
 
 void   initRoutingStep()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: initializes node & link states at the start of a routing step
+//           and copies their current flow state into the DwState arrays.
+//
 {
-    int i;
+    int i, k;
     for (i = 0; i < Nobjects[NODE]; i++)
     {
         Xnode[i].converged = FALSE;
         Xnode[i].dYdT = 0.0;
+        DwState.nodeDepth[i] = Node[i].newDepth;
     }
     for (i = 0; i < Nobjects[LINK]; i++)
     {
         Link[i].bypassed = FALSE;
         Link[i].surfArea1 = 0.0;
         Link[i].surfArea2 = 0.0;
+        DwState.surfArea1[i] = 0.0;
+        DwState.surfArea2[i] = 0.0;
+        DwState.flow[i] = Link[i].newFlow;
+        DwState.volume[i] = Link[i].newVolume;
+        DwState.froude[i] = Link[i].froude;
+        if ( Link[i].type == CONDUIT )
+        {
+            k = Link[i].subIndex;
+            DwState.area[i] = Conduit[k].a1;
+        }
     }
 
     // --- a2 preserves conduit area from solution at last time step
@@ -294,17 +469,20 @@ void   initRoutingStep()
 
 //=============================================================================
 
-void initNodeStates()
+void initNodeStates(TSubnet* sn)
 //
-//  Input:   none
+//  Input:   sn = subnetwork of links & nodes
 //  Output:  none
 //  Purpose: initializes node's surface area, inflow & outflow
 //
 {
-    int i;
+    int    i, m;
 
-    for (i = 0; i < Nobjects[NODE]; i++)
+    #pragma omp for private(i)
+    for (m = 0; m < sn->nActive; m++)
     {
+        i = sn->active[m];
+
         // --- initialize nodal surface area
         if ( AllowPonding )
         {
@@ -332,11 +510,17 @@ void initNodeStates()
 
 //=============================================================================
 
-void   findBypassedLinks()
+void   findBypassedLinks(TSubnet* sn)
 {
-    int i;
-    for (i = 0; i < Nobjects[LINK]; i++)
+    int i, m;
+    int nConduits = sn->nConduits;
+    int nLinks = nConduits + sn->levelStart[sn->nLevels];
+
+    #pragma omp for private(i)
+    for (m = 0; m < nLinks; m++)
     {
+        if ( m < nConduits ) i = sn->conduits[m];
+        else                 i = sn->levelLinks[m - nConduits];
         if ( Xnode[Link[i].node1].converged &&
              Xnode[Link[i].node2].converged )
              Link[i].bypassed = TRUE;
@@ -346,6 +530,81 @@ void   findBypassedLinks()
 
 //=============================================================================
 
+void initActiveNodes(TSubnet* sn)
+//
+//  Input:   sn = subnetwork of links & nodes
+//  Output:  none
+//  Purpose: lists all nodes as the nodes to update on the first trial.
+//
+{
+    int i, m;
+
+    sn->nActive = sn->nNodes;
+    for (m = 0; m < sn->nNodes; m++)
+    {
+        i = sn->nodes[m];
+        Xnode[i].active = TRUE;
+        sn->active[m] = i;
+    }
+}
+
+//=============================================================================
+
+void updateActiveNodes(TSubnet* sn)
+//
+//  Input:   sn = subnetwork of links & nodes
+//  Output:  none
+//  Purpose: finds the links & nodes to update on the next trial from the
+//           nodes updated on the last one.
+//
+//  A link is bypassed once both of its end nodes have converged and a node
+//  is updated only if it has not converged or is at the end of a link that
+//  is not bypassed. Only nodes on the current list can have changed so the
+//  work done is proportional to the size of the list, not of the network.
+//
+{
+    int i, j, k, m, p, n;
+
+    // --- bypass links whose end nodes have both converged
+    for (m = 0; m < sn->nActive; m++)
+    {
+        i = sn->active[m];
+        for (p = NodeLinkStart[i]; p < NodeLinkStart[i+1]; p++)
+        {
+            k = NodeLinks[p] / 2;
+            Link[k].bypassed = ( Xnode[Link[k].node1].converged &&
+                                 Xnode[Link[k].node2].converged );
+        }
+    }
+
+    // --- keep only the non-converged nodes at the front of the list
+    n = 0;
+    for (m = 0; m < sn->nActive; m++)
+    {
+        i = sn->active[m];
+        Xnode[i].active = !Xnode[i].converged;
+        if ( Xnode[i].active ) sn->active[n++] = i;
+    }
+
+    // --- add the nodes at the other end of their links
+    sn->nActive = n;
+    for (m = 0; m < n; m++)
+    {
+        i = sn->active[m];
+        for (p = NodeLinkStart[i]; p < NodeLinkStart[i+1]; p++)
+        {
+            k = NodeLinks[p] / 2;
+            if ( NodeLinks[p] % 2 == 0 ) j = Link[k].node2;
+            else                         j = Link[k].node1;
+            if ( Xnode[j].active ) continue;
+            Xnode[j].active = TRUE;
+            sn->active[sn->nActive++] = j;
+        }
+    }
+}
+
+//=============================================================================
+
 void  findLimitedLinks()
 //
 //  Input:   none
@@ -379,33 +638,50 @@ void  findLimitedLinks()
 
 //=============================================================================
 
-void findLinkFlows(double dt)
+void findLinkFlows(TSubnet* sn, double dt)
+//
+//  Input:   sn = subnetwork of links & nodes
+//           dt = time step (sec)
+//  Output:  none
+//  Purpose: finds new flows in all links and accumulates them into the
+//           inflow/outflow of their end nodes.
+//
+//  Called by all threads of the routing team (or serially).
+//  Each node gathers the flows of its attached conduits in link order and
+//  non-conduit links are processed level by level, where links in the same
+//  level share no nodes. Every node's totals are therefore summed in the
+//  same order as a serial pass through the links would produce.
+//
 {
-    int i;
+    int i, k, m, n;
+    int batch[CONDUIT_BATCH];
 
-    // --- find new flow in each non-dummy conduit
-#pragma omp parallel num_threads(NumThreads)
-{
+    // --- find new flow in each non-dummy conduit, a batch at a time
     #pragma omp for
-    for ( i = 0; i < Nobjects[LINK]; i++)
+    for ( m = 0; m < sn->nConduits; m += CONDUIT_BATCH )
     {
-        if ( isTrueConduit(i) && !Link[i].bypassed )
-            dwflow_findConduitFlow(i, Steps, Omega, dt);
+        n = 0;
+        for ( k = m; k < sn->nConduits && k < m + CONDUIT_BATCH; k++ )
+        {
+            i = sn->conduits[k];
+            if ( !Link[i].bypassed ) batch[n++] = i;
+        }
+        dwflow_findConduitFlows(n, batch, sn->steps, sn->omega, dt);
     }
-}
 
     // --- update inflow/outflows for nodes attached to non-dummy conduits
-    for ( i = 0; i < Nobjects[LINK]; i++)
-    {
-        if ( isTrueConduit(i) ) updateNodeFlows(i);
-    }
+    #pragma omp for
+    for ( m = 0; m < sn->nActive; m++ ) gatherConduitFlows(sn->active[m]);
 
     // --- find new flows for all dummy conduits, pumps & regulators
-    for ( i = 0; i < Nobjects[LINK]; i++)
+    for ( k = 0; k < sn->nLevels; k++ )
     {
-        if ( !isTrueConduit(i) )
+        #pragma omp for
+        for ( m = sn->levelStart[k]; m < sn->levelStart[k+1]; m++ )
         {
-            if ( !Link[i].bypassed ) findNonConduitFlow(i, dt);
+            i = sn->levelLinks[m];
+            if ( !Link[i].bypassed )
+                findNonConduitFlow(i, sn->steps, sn->omega, dt);
             updateNodeFlows(i);
         }
     }
@@ -420,9 +696,11 @@ int isTrueConduit(int j)
 
 //=============================================================================
 
-void findNonConduitFlow(int i, double dt)
+void findNonConduitFlow(int i, int steps, double omega, double dt)
 //
 //  Input:   i = link index
+//           steps = number of previous trials
+//           omega = under-relaxation parameter
 //           dt = time step (sec)
 //  Output:  none
 //  Purpose: finds new flow in a non-conduit-type link
@@ -445,9 +723,9 @@ void findNonConduitFlow(int i, double dt)
 
     // --- apply under-relaxation with flow from previous iteration;
     // --- do not allow flow to change direction without first being 0
-    if ( Steps > 0 && Link[i].type != PUMP ) 
+    if ( steps > 0 && Link[i].type != PUMP ) 
     {
-        qNew = (1.0 - Omega) * qLast + Omega * qNew;
+        qNew = (1.0 - omega) * qLast + omega * qNew;
         if ( qNew * qLast < 0.0 ) qNew = 0.001 * SGN(qNew);
     }
     Link[i].newFlow = qNew;
@@ -540,102 +818,523 @@ void updateNodeFlows(int i)
     double q = Link[i].newFlow;
     double conduitLossRate = 0.0;
 
-    // --- update total inflow & outflow at upstream/downstream nodes
-    if ( q >= 0.0 )
-    {
-        Node[n1].outflow += q;
-        Node[n2].inflow  += q;
-    }
-    else
-    {
-        Node[n1].inflow   -= q;
-        Node[n2].outflow  -= q;
-    }
- 
-    // --- add any uniform evap & seepage loss from conduit link
+    // --- find any uniform evap & seepage loss from conduit link
     if ( Link[i].type == CONDUIT )
     {
         k = Link[i].subIndex;
         barrels = Conduit[k].barrels;
         conduitLossRate = (Conduit[k].evapLossRate + Conduit[k].seepLossRate) *
                           barrels;
-        if (conduitLossRate > 0.0)
+
+        // --- outfall nodes do not share evap & seepage losses
+        if (Node[n1].type != OUTFALL && Node[n2].type != OUTFALL)
+            conduitLossRate /= 2.0;
+    }
+
+    // --- update upstream node's totals (unless it is not being updated)
+    if ( Xnode[n1].active )
+    {
+        if ( q >= 0.0 ) Node[n1].outflow += q;
+        else            Node[n1].inflow  -= q;
+        if ( conduitLossRate > 0.0 && Node[n1].type != OUTFALL )
+            Node[n1].outflow += conduitLossRate;
+        Xnode[n1].newSurfArea += Link[i].surfArea1 * barrels;
+        Xnode[n1].sumdqdh += Link[i].dqdh;
+    }
+
+    // --- update downstream node's totals
+    if ( Xnode[n2].active )
+    {
+        if ( q >= 0.0 ) Node[n2].inflow  += q;
+        else            Node[n2].outflow -= q;
+        if ( conduitLossRate > 0.0 && Node[n2].type != OUTFALL )
+            Node[n2].outflow += conduitLossRate;
+        Xnode[n2].newSurfArea += Link[i].surfArea2 * barrels;
+        if ( Link[i].type == PUMP )
+        {
+            k = Link[i].subIndex;
+            if ( Pump[k].type != TYPE4_PUMP )
+            {
+                Xnode[n2].sumdqdh += Link[i].dqdh;
+            }
+        }
+        else Xnode[n2].sumdqdh += Link[i].dqdh;
+    }
+}
+
+//=============================================================================
+
+void gatherConduitFlows(int j)
+//
+//  Input:   j = node index
+//  Output:  none
+//  Purpose: adds the flow, loss, surface area & dqdh contributions of all
+//           non-dummy conduits attached to a node to the node's totals.
+//
+{
+    int    i, p, end;
+    double barrels;
+    double q;
+    double conduitLossRate;
+
+    if ( !Xnode[j].active ) return;
+    for (p = NodeLinkStart[j]; p < NodeLinkStart[j+1]; p++)
+    {
+        i = NodeLinks[p] / 2;
+        end = NodeLinks[p] % 2;
+        if ( !isTrueConduit(i) ) continue;
+        barrels = DwState.barrels[i];
+        q = DwState.flow[i];
+
+        // --- update total inflow & outflow at node
+        if ( end == 0 )
+        {
+            if ( q >= 0.0 ) Node[j].outflow += q;
+            else            Node[j].inflow  -= q;
+        }
+        else
+        {
+            if ( q >= 0.0 ) Node[j].inflow  += q;
+            else            Node[j].outflow -= q;
+        }
+
+        // --- add node's share of any uniform evap & seepage loss
+        conduitLossRate = DwState.lossRate[i];
+        if ( conduitLossRate > 0.0 )
         {
             // --- outfall nodes do not share evap & seepage losses
-            if (Node[n1].type != OUTFALL && Node[n2].type != OUTFALL)
-                conduitLossRate /= 2.0;
-            if (Node[n1].type != OUTFALL)
-                Node[n1].outflow += conduitLossRate;
-            if (Node[n2].type != OUTFALL)
-                Node[n2].outflow += conduitLossRate;
+            if ( Node[DwState.node1[i]].type != OUTFALL &&
+                 Node[DwState.node2[i]].type != OUTFALL ) conduitLossRate /= 2.0;
+            if ( Node[j].type != OUTFALL ) Node[j].outflow += conduitLossRate;
         }
+
+        // --- add surf. area & dqdh contributions
+        if ( end == 0 ) Xnode[j].newSurfArea += DwState.surfArea1[i] * barrels;
+        else            Xnode[j].newSurfArea += DwState.surfArea2[i] * barrels;
+        Xnode[j].sumdqdh += DwState.dqdh[i];
     }
-    
-    // --- add surf. area contributions to upstream/downstream nodes
-    Xnode[Link[i].node1].newSurfArea += Link[i].surfArea1 * barrels;
-    Xnode[Link[i].node2].newSurfArea += Link[i].surfArea2 * barrels;
+}
 
-    // --- update summed value of dqdh at each end node
-    Xnode[Link[i].node1].sumdqdh += Link[i].dqdh;
-    if ( Link[i].type == PUMP )
+//=============================================================================
+
+int createLinkLists()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: creates the list of link ends attached to each node, lists
+//           the non-dummy conduits and
+//           groups non-conduit links into levels whose links share no
+//           nodes with each other.
+//
+{
+    int i, j, k, n1, n2;
+    int nNodes = Nobjects[NODE];
+    int nLinks = Nobjects[LINK];
+    int* level;                        // level of each node & link
+    int* count;                        // number of links placed in a level
+
+    NumLinkLevels = 0;
+    NumConduitLinks = 0;
+    NodeLinkStart = (int *) calloc(nNodes + 1, sizeof(int));
+    NodeLinks = (int *) calloc(2 * nLinks + 1, sizeof(int));
+    ConduitLinks = (int *) calloc(nLinks + 1, sizeof(int));
+    LevelStart = (int *) calloc(nLinks + 1, sizeof(int));
+    LevelLinks = (int *) calloc(nLinks + 1, sizeof(int));
+    ActiveNodes = (int *) calloc(nNodes + 1, sizeof(int));
+    level = (int *) calloc(nNodes + 2 * nLinks + 1, sizeof(int));
+    if ( !NodeLinkStart || !NodeLinks || !ConduitLinks || !LevelStart ||
+         !LevelLinks || !ActiveNodes || !level )
     {
-        k = Link[i].subIndex;
-        if ( Pump[k].type != TYPE4_PUMP )
+        FREE(level);
+        return FALSE;
+    }
+
+    // --- list the non-dummy conduits
+    for (i = 0; i < nLinks; i++)
+    {
+        if ( isTrueConduit(i) ) ConduitLinks[NumConduitLinks++] = i;
+    }
+
+    // --- list link ends attached to each node in order of link index
+    //     (with a link's upstream end listed before its downstream end)
+    for (i = 0; i < nLinks; i++)
+    {
+        NodeLinkStart[Link[i].node1+1]++;
+        NodeLinkStart[Link[i].node2+1]++;
+    }
+    for (j = 0; j < nNodes; j++) NodeLinkStart[j+1] += NodeLinkStart[j];
+    for (i = 0; i < nLinks; i++)
+    {
+        n1 = Link[i].node1;
+        n2 = Link[i].node2;
+        NodeLinks[NodeLinkStart[n1] + level[n1]++] = 2*i;
+        NodeLinks[NodeLinkStart[n2] + level[n2]++] = 2*i + 1;
+    }
+
+    // --- place each non-conduit link one level above that of any
+    //     lower indexed non-conduit link it shares a node with
+    //     (level[] now holds the next free level of each node)
+    for (j = 0; j < nNodes; j++) level[j] = 0;
+    for (i = 0; i < nLinks; i++)
+    {
+        if ( isTrueConduit(i) ) continue;
+        n1 = Link[i].node1;
+        n2 = Link[i].node2;
+        k = MAX(level[n1], level[n2]);
+        level[nNodes + i] = k;
+        level[n1] = level[n2] = k + 1;
+        LevelStart[k+1]++;
+        NumLinkLevels = MAX(NumLinkLevels, k + 1);
+    }
+
+    // --- list links by level (in order of link index within a level)
+    for (k = 0; k < NumLinkLevels; k++) LevelStart[k+1] += LevelStart[k];
+    count = level + nNodes + nLinks;
+    for (i = 0; i < nLinks; i++)
+    {
+        if ( isTrueConduit(i) ) continue;
+        k = level[nNodes + i];
+        LevelLinks[LevelStart[k] + count[k]++] = i;
+    }
+    FREE(level);
+    return TRUE;
+}
+
+//=============================================================================
+
+void freeLinkLists()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for the node-link lists.
+//
+{
+    FREE(NodeLinkStart);
+    FREE(NodeLinks);
+    FREE(ConduitLinks);
+    NumConduitLinks = 0;
+    FREE(LevelStart);
+    FREE(LevelLinks);
+    NumLinkLevels = 0;
+    FREE(ActiveNodes);
+}
+
+//=============================================================================
+
+int createBasins()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: groups the nodes & links into basins that share no links with
+//           each other and sets up the subnetworks of the basins & of the
+//           whole network.
+//
+{
+    int b, i, j, k, m, p, n, q;
+    int nNodes = Nobjects[NODE];
+    int nLinks = Nobjects[LINK];
+    int* basin;                        // basin of each node
+    int* count;                        // number of conduits, other links &
+                                       // outfall links in each basin
+    TSubnet* sn;
+
+    NumBasins = 0;
+    Basins = NULL;
+    BasinLevelStart = NULL;
+    BasinNodes = (int *) calloc(nNodes + 1, sizeof(int));
+    BasinLinks = (int *) calloc(nLinks + 1, sizeof(int));
+    OutfallLinks = (int *) calloc(nLinks + 1, sizeof(int));
+    basin = (int *) calloc(nNodes + 1, sizeof(int));
+    if ( !BasinNodes || !BasinLinks || !OutfallLinks || !basin )
+    {
+        FREE(basin);
+        return FALSE;
+    }
+
+    // --- list the nodes reached by a breadth first search from each node
+    //     not yet in a basin (so each basin's nodes are listed together)
+    for (j = 0; j < nNodes; j++) basin[j] = -1;
+    n = 0;
+    for (j = 0; j < nNodes; j++)
+    {
+        if ( basin[j] >= 0 ) continue;
+        basin[j] = NumBasins;
+        BasinNodes[n++] = j;
+        for (m = n - 1; m < n; m++)
         {
-            Xnode[n2].sumdqdh += Link[i].dqdh;
+            i = BasinNodes[m];
+            for (p = NodeLinkStart[i]; p < NodeLinkStart[i+1]; p++)
+            {
+                k = NodeLinks[p] / 2;
+                if ( NodeLinks[p] % 2 == 0 ) q = Link[k].node2;
+                else                         q = Link[k].node1;
+                if ( basin[q] < 0 )
+                {
+                    basin[q] = NumBasins;
+                    BasinNodes[n++] = q;
+                }
+            }
         }
+        NumBasins++;
+    }
+
+    // --- allocate the basins
+    Basins = (TSubnet *) calloc(NumBasins, sizeof(TSubnet));
+    BasinLevelStart = (int *) calloc(2 * NumBasins, sizeof(int));
+    count = (int *) calloc(3 * NumBasins + 1, sizeof(int));
+    if ( !Basins || !BasinLevelStart || !count )
+    {
+        FREE(basin);
+        FREE(count);
+        return FALSE;
+    }
+
+    // --- count each basin's nodes, conduits, other links & outfall links
+    for (j = 0; j < nNodes; j++) Basins[basin[j]].nNodes++;
+    for (i = 0; i < nLinks; i++)
+    {
+        b = basin[Link[i].node1];
+        if ( isTrueConduit(i) ) count[3*b]++;
+        else                    count[3*b+1]++;
+        if ( Node[Link[i].node1].type == OUTFALL ||
+             Node[Link[i].node2].type == OUTFALL ) count[3*b+2]++;
+    }
+
+    // --- assign each basin its portion of the lists
+    n = 0;
+    m = 0;
+    p = 0;
+    for (b = 0; b < NumBasins; b++)
+    {
+        sn = &Basins[b];
+        sn->nodes = BasinNodes + n;
+        sn->active = ActiveNodes + n;
+        n += sn->nNodes;
+        sn->conduits = BasinLinks + m;
+        sn->levelLinks = BasinLinks + m + count[3*b];
+        m += count[3*b] + count[3*b+1];
+        sn->nLevels = 1;
+        sn->levelStart = BasinLevelStart + 2*b;
+        sn->levelStart[1] = count[3*b+1];
+        sn->nConduits = count[3*b];
+        sn->outfallLinks = OutfallLinks + p;
+        p += count[3*b+2];
+        count[3*b] = 0;
+        count[3*b+1] = 0;
+    }
+
+    // --- list each basin's conduits & outfall links in order of link
+    //     index and its other links in the order of their levels
+    for (k = 0; k < NumConduitLinks; k++)
+    {
+        i = ConduitLinks[k];
+        b = basin[Link[i].node1];
+        Basins[b].conduits[count[3*b]++] = i;
+    }
+    for (k = 0; k < LevelStart[NumLinkLevels]; k++)
+    {
+        i = LevelLinks[k];
+        b = basin[Link[i].node1];
+        Basins[b].levelLinks[count[3*b+1]++] = i;
+    }
+    for (i = 0; i < nLinks; i++)
+    {
+        if ( Node[Link[i].node1].type != OUTFALL &&
+             Node[Link[i].node2].type != OUTFALL ) continue;
+        sn = &Basins[basin[Link[i].node1]];
+        sn->outfallLinks[sn->nOutfallLinks++] = i;
     }
-    else Xnode[n2].sumdqdh += Link[i].dqdh;
+
+    // --- the whole network's subnetwork uses the network-wide lists
+    Network.nNodes = nNodes;
+    Network.nodes = BasinNodes;
+    Network.active = ActiveNodes;
+    Network.nConduits = NumConduitLinks;
+    Network.conduits = ConduitLinks;
+    Network.nLevels = NumLinkLevels;
+    Network.levelStart = LevelStart;
+    Network.levelLinks = LevelLinks;
+    Network.nOutfallLinks = p;
+    Network.outfallLinks = OutfallLinks;
+    FREE(basin);
+    FREE(count);
+    return TRUE;
 }
 
 //=============================================================================
 
-int findNodeDepths(double dt)
+void freeBasins()
 //
-//  Input:   dt = time step (sec)
-//  Output:  returns TRUE if depth change at all non-Outfall nodes is 
-//           within the convergence tolerance and FALSE otherwise
-//  Purpose: finds new depth at all nodes and checks if convergence achieved.
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for the basin lists.
 //
 {
-    int i;
+    FREE(Basins);
+    NumBasins = 0;
+    FREE(BasinNodes);
+    FREE(BasinLinks);
+    FREE(BasinLevelStart);
+    FREE(OutfallLinks);
+}
+
+//=============================================================================
+
+int createDwState()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: creates the routing state arrays and fills in their fixed
+//           node & link properties (the flow state is copied into them
+//           by initRoutingStep once flow routing has been initialized).
+//
+{
+    int i, k;
+    int nNodes = Nobjects[NODE];
+    int nLinks = Nobjects[LINK];
+
+    DwState.nodeInvert = (double *) calloc(nNodes, sizeof(double));
+    DwState.nodeDepth  = (double *) calloc(nNodes, sizeof(double));
+    DwState.node1      = (int *) calloc(nLinks, sizeof(int));
+    DwState.node2      = (int *) calloc(nLinks, sizeof(int));
+    DwState.z1         = (double *) calloc(nLinks, sizeof(double));
+    DwState.z2         = (double *) calloc(nLinks, sizeof(double));
+    DwState.barrels    = (double *) calloc(nLinks, sizeof(double));
+    DwState.flow       = (double *) calloc(nLinks, sizeof(double));
+    DwState.area       = (double *) calloc(nLinks, sizeof(double));
+    DwState.volume     = (double *) calloc(nLinks, sizeof(double));
+    DwState.froude     = (double *) calloc(nLinks, sizeof(double));
+    DwState.dqdh       = (double *) calloc(nLinks, sizeof(double));
+    DwState.surfArea1  = (double *) calloc(nLinks, sizeof(double));
+    DwState.surfArea2  = (double *) calloc(nLinks, sizeof(double));
+    DwState.lossRate   = (double *) calloc(nLinks, sizeof(double));
+    if ( !DwState.nodeInvert || !DwState.nodeDepth || !DwState.node1 ||
+         !DwState.node2 || !DwState.z1 || !DwState.z2 || !DwState.barrels ||
+         !DwState.flow || !DwState.area || !DwState.volume ||
+         !DwState.froude || !DwState.dqdh || !DwState.surfArea1 ||
+         !DwState.surfArea2 || !DwState.lossRate ) return FALSE;
+
+    for (i = 0; i < nNodes; i++) DwState.nodeInvert[i] = Node[i].invertElev;
+    for (i = 0; i < nLinks; i++)
+    {
+        DwState.node1[i] = Link[i].node1;
+        DwState.node2[i] = Link[i].node2;
+        DwState.z1[i] = Node[Link[i].node1].invertElev + Link[i].offset1;
+        DwState.z2[i] = Node[Link[i].node2].invertElev + Link[i].offset2;
+        DwState.barrels[i] = 1.0;
+        if ( Link[i].type == CONDUIT )
+        {
+            k = Link[i].subIndex;
+            DwState.barrels[i] = Conduit[k].barrels;
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void freeDwState()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for the routing state arrays.
+//
+{
+    FREE(DwState.nodeInvert);
+    FREE(DwState.nodeDepth);
+    FREE(DwState.node1);
+    FREE(DwState.node2);
+    FREE(DwState.z1);
+    FREE(DwState.z2);
+    FREE(DwState.barrels);
+    FREE(DwState.flow);
+    FREE(DwState.area);
+    FREE(DwState.volume);
+    FREE(DwState.froude);
+    FREE(DwState.dqdh);
+    FREE(DwState.surfArea1);
+    FREE(DwState.surfArea2);
+    FREE(DwState.lossRate);
+}
+
+//=============================================================================
+
+void findNodeDepths(TSubnet* sn, double dt)
+//
+//  Input:   sn = subnetwork of links & nodes
+//           dt = time step (sec)
+//  Output:  none
+//  Purpose: finds new depth at all nodes and checks if convergence achieved
+//           (sn->converged is set to TRUE if depth change at all
+//           non-Outfall nodes is within the convergence tolerance).
+//
+//  Called by all threads of the routing team (or serially).
+//
+{
+    int i, m, n;
+    int steps;               // number of previous trials
+    int converged = TRUE;    // TRUE if this thread's nodes converged
+    double omega;            // under-relaxation parameter
     double yOld = 0.0;       // previous node depth (ft)
 
-    // --- compute outfall depths based on flow in connecting link
-    for ( i = 0; i < Nobjects[LINK]; i++ ) link_setOutfallDepth(i);
+    // --- trial count is read before the barrier below since a thread
+    //     that finishes its nodes early can go on to update it
+    steps = sn->steps;
+    omega = sn->omega;
+
+    #pragma omp single
+    {
+        // --- compute outfall depths based on flow in connecting link
+        //     (outfalls in different basins can share a time series)
+        for ( m = 0; m < sn->nOutfallLinks; m++ )
+        {
+            i = sn->outfallLinks[m];
+            if ( !Xnode[Link[i].node1].active &&
+                 !Xnode[Link[i].node2].active ) continue;
+            #pragma omp critical (outfallDepth)
+            link_setOutfallDepth(i);
+            n = Link[i].node2;
+            if ( Node[n].type != OUTFALL ) n = Link[i].node1;
+            DwState.nodeDepth[n] = Node[n].newDepth;
+        }
+        sn->converged = TRUE;
+    }
 
     // --- compute new depth for all non-outfall nodes and determine if
     //     depth change from previous iteration is below tolerance
-#pragma omp parallel num_threads(NumThreads)
-{
-    #pragma omp for private(yOld)
-    for ( i = 0; i < Nobjects[NODE]; i++ )
+    //     (nodes not being updated have already converged)
+    #pragma omp for nowait
+    for ( m = 0; m < sn->nActive; m++ )
     {
+        i = sn->active[m];
         if ( Node[i].type == OUTFALL ) continue;
         yOld = Node[i].newDepth;
-        setNodeDepth(i, dt);
+        setNodeDepth(i, steps, omega, dt);
         Xnode[i].converged = TRUE;
         if ( fabs(yOld - Node[i].newDepth) > HeadTol )
         {
             Xnode[i].converged = FALSE;
+            converged = FALSE;
         }
     }
-}
 
-   // --- return FALSE if any non-Outfall node failed to converge
-    for (i = 0; i < Nobjects[NODE]; i++)
+    // --- FALSE if any of this thread's nodes failed to converge
+    //     (the barrier ending the caller's next single construct
+    //     completes the update for all threads)
+    if ( !converged )
     {
-        if ( Node[i].type == OUTFALL ) continue;
-        if (Xnode[i].converged == FALSE) return FALSE;
+        #pragma omp atomic
+        sn->converged &= converged;
     }
-    return TRUE;
 }
 
 //=============================================================================
 
-void setNodeDepth(int i, double dt)
+void setNodeDepth(int i, int steps, double omega, double dt)
 //
 //  Input:   i  = node index
+//           steps = number of previous trials
+//           omega = under-relaxation parameter
 //           dt = time step (sec)
 //  Output:  none
 //  Purpose: sets depth at non-outfall node after current time step.
@@ -700,9 +1399,9 @@ void setNodeDepth(int i, double dt)
         if ( !isPonded ) Xnode[i].oldSurfArea = surfArea;
 
         // --- apply under-relaxation to new depth estimate
-        if ( Steps > 0 )
+        if ( steps > 0 )
         {
-            yNew = (1.0 - Omega) * yLast + Omega * yNew;
+            yNew = (1.0 - omega) * yLast + omega * yNew;
         }
 
         // --- don't allow a ponded node to drop much below full depth
@@ -759,6 +1458,7 @@ void setNodeDepth(int i, double dt)
 
     // --- save new depth for node
     Node[i].newDepth = yNew;
+    DwState.nodeDepth[i] = yNew;
 }
 
 //=============================================================================
@@ -842,8 +1542,6 @@ double getLinkStep(double tMin, int *minLink)
 //
 {
     int    i;                           // link index
-    int    k;                           // conduit index
-    double q;                           // conduit flow (cfs)
     double t;                           // time step (sec)
     double tLink = tMin;                // critical link time step (sec)
 
@@ -852,20 +1550,8 @@ double getLinkStep(double tMin, int *minLink)
     {
         if ( Link[i].type == CONDUIT )
         {
-            // --- skip conduits with negligible flow, area or Fr
-            k = Link[i].subIndex;
-            q = fabs(Link[i].newFlow) / Conduit[k].barrels;
-            if ( q <= FUDGE 
-            ||   Conduit[k].a1 <= FUDGE
-            ||   Link[i].froude <= 0.01 
-               ) continue;
-
-            // --- compute time step to satisfy Courant condition
-            t = Link[i].newVolume / Conduit[k].barrels / q;
-            t = t * Conduit[k].modLength / link_getLength(i);
-            t = t * Link[i].froude / (1.0 + Link[i].froude) * CourantFactor;
-
             // --- update critical link time step
+            t = getConduitStep(i);
             if ( t < tLink )
             {
                 tLink = t;
@@ -878,6 +1564,36 @@ double getLinkStep(double tMin, int *minLink)
 
 //=============================================================================
 
+double getConduitStep(int i)
+//
+//  Input:   i = link index of a conduit
+//  Output:  returns conduit's critical time step (sec)
+//  Purpose: finds time step that satisfies the Courant criterion for
+//           a conduit (a big value if conduit has no critical step).
+//
+{
+    int    k;                           // conduit index
+    double q;                           // conduit flow (cfs)
+    double t;                           // time step (sec)
+
+    // --- skip conduits with negligible flow, area or Fr
+    q = fabs(DwState.flow[i]) / DwState.barrels[i];
+    if ( q <= FUDGE
+    ||   DwState.area[i] <= FUDGE
+    ||   DwState.froude[i] <= 0.01
+       ) return BIG;
+
+    // --- compute time step to satisfy Courant condition
+    k = Link[i].subIndex;
+    t = DwState.volume[i] / DwState.barrels[i] / q;
+    t = t * Conduit[k].modLength / link_getLength(i);
+    t = t * DwState.froude[i] / (1.0 + DwState.froude[i]) *
+        CourantFactor;
+    return t;
+}
+
+//=============================================================================
+
 double getNodeStep(double tMin, int *minNode)
 //
 //  Input:   tMin = critical time step found so far (sec)
@@ -888,8 +1604,6 @@ double getNodeStep(double tMin, int *minNode)
 //
 {
     int    i;                           // node index
-    double maxDepth;                    // max. depth allowed at node (ft)
-    double dYdT;                        // change in depth per unit time (ft/sec)
     double t1;                          // time needed to reach depth limit (sec)
     double tNode = tMin;                // critical node time step (sec)
 
@@ -897,20 +1611,8 @@ double getNodeStep(double tMin, int *minNode)
     //     does not exceed safety factor * maxdepth
     for ( i = 0; i < Nobjects[NODE]; i++ )
     {
-        // --- see if node can be skipped
-        if ( Node[i].type == OUTFALL ) continue;
-        if ( Node[i].newDepth <= FUDGE) continue;
-        if ( Node[i].newDepth  + FUDGE >=
-             Node[i].crownElev - Node[i].invertElev ) continue;
-
-        // --- define max. allowable depth change using crown elevation
-        maxDepth = (Node[i].crownElev - Node[i].invertElev) * 0.25;
-        if ( maxDepth < FUDGE ) continue;
-        dYdT = Xnode[i].dYdT;
-        if (dYdT < FUDGE ) continue;
-
-        // --- compute time to reach max. depth & compare with critical time
-        t1 = maxDepth / dYdT;
+        // --- compare time to reach max. depth with critical time
+        t1 = getNodeDepthStep(i);
         if ( t1 < tNode )
         {
             tNode = t1;
@@ -919,3 +1621,32 @@ double getNodeStep(double tMin, int *minNode)
     }
     return tNode;
 }
+
+//=============================================================================
+
+double getNodeDepthStep(int i)
+//
+//  Input:   i = node index
+//  Output:  returns node's critical time step (sec)
+//  Purpose: finds time for a node's depth to change by its max. allowable
+//           amount (a big value if node has no critical step).
+//
+{
+    double maxDepth;                    // max. depth allowed at node (ft)
+    double dYdT;                        // change in depth per unit time (ft/sec)
+
+    // --- see if node can be skipped
+    if ( Node[i].type == OUTFALL ) return BIG;
+    if ( Node[i].newDepth <= FUDGE) return BIG;
+    if ( Node[i].newDepth  + FUDGE >=
+         Node[i].crownElev - Node[i].invertElev ) return BIG;
+
+    // --- define max. allowable depth change using crown elevation
+    maxDepth = (Node[i].crownElev - Node[i].invertElev) * 0.25;
+    if ( maxDepth < FUDGE ) return BIG;
+    dYdT = Xnode[i].dYdT;
+    if (dYdT < FUDGE ) return BIG;
+
+    // --- compute time to reach max. depth
+    return maxDepth / dYdT;
+}
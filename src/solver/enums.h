@@ -33,6 +33,9 @@
 //   - Support added for analytical storage shapes.
 //   Build 5.2.1:
 //   - Adds a NEITHER option to the NormalFlowType enumeration. 
+//   Build 5.2.4:
+//   - OutputLayoutType enumeration added.
+//   - COMPRESSED_LAYOUT added to OutputLayoutType.
 //-----------------------------------------------------------------------------
 
 #ifndef ENUMS_H
@@ -371,6 +374,11 @@ enum  CompatibilityType {
       EXTRAN,                          // original EXTRAN method
       SLOT};                           // Preissmann slot method
 
+ enum  OutputLayoutType {
+      PERIOD_LAYOUT,                   // results saved period by period
+      ELEMENT_LAYOUT,                  // results saved element by element
+      COMPRESSED_LAYOUT};              // element by element and compressed
+
  enum InflowType {
       EXTERNAL_INFLOW,                 // user-supplied external inflow
       DRY_WEATHER_INFLOW,              // user-supplied dry weather inflow
@@ -486,7 +494,8 @@ enum  CompatibilityType {
     IGNORE_SNOWMELT, IGNORE_GWATER, IGNORE_ROUTING,
     IGNORE_QUALITY, MAX_TRIALS, HEAD_TOL,
     SYS_FLOW_TOL, LAT_FLOW_TOL, IGNORE_RDII,
-    MIN_ROUTE_STEP, NUM_THREADS, SURCHARGE_METHOD};
+    MIN_ROUTE_STEP, NUM_THREADS, SURCHARGE_METHOD,
+    SKIP_CONVERGED, SEPARATE_BASINS};
 
 enum  NoYesType {
       NO,
@@ -18,6 +18,8 @@
 //   - Fixed units conversion error for storage units with surface area curves.
 //   Build 5.2.0:
 //   - Support added for analytical storage shapes.
+//   Build 5.2.4:
+//   - Conductivity adjustment factor saved for routing used for exfiltration.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -171,7 +173,7 @@ double exfil_getLoss(TExfil* exfil, double tStep, double depth, double area)
     // --- find infiltration through bottom of unit
     if ( exfil->btmExfil->IMDmax == 0.0 )
     {
-        exfilRate = exfil->btmExfil->Ks * Adjust.hydconFactor;
+        exfilRate = exfil->btmExfil->Ks * RouteHydconFactor;
     }
     else exfilRate = grnampt_getInfil(exfil->btmExfil, tStep, 0.0, depth,
                                       MOD_GREEN_AMPT);
@@ -187,7 +189,7 @@ double exfil_getLoss(TExfil* exfil, double tStep, double depth, double area)
             // --- if infil. rate not a function of depth
             if ( exfil->btmExfil->IMDmax == 0.0 )
             {    
-                exfilRate += area * exfil->btmExfil->Ks * Adjust.hydconFactor;
+                exfilRate += area * exfil->btmExfil->Ks * RouteHydconFactor;
             }
 
             // --- infil. rate depends on depth above bank
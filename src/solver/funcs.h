@@ -31,6 +31,17 @@
 //   - Refactored external inflow code.
 //   Build 5.2.4:
 //   - Additional arguments added to function link_getLossRate.
+//   - Function dwflow_findConduitFlows added.
+//   - Function xsect_setInvIndex added.
+//   - Functions for deferring mass balance updates of parallel runoff
+//     threads added.
+//   - Function routing_saveRunoff added and functions subcatch_getWtdOutflow
+//     and surfqual_getWtdWashoff removed.
+//   - Functions runoff_canRunAhead, controls_usesRunoffData and runSteps added.
+//   - Function landuse_getWashoffLoad replaced by landuse_getWashoffLoads.
+//   - Function report_writeOutputStats added.
+//   - Argument used added to subcatch_getResults, node_getResults and
+//     link_getResults.
 //-----------------------------------------------------------------------------
 
 #ifndef FUNCS_H
@@ -91,6 +102,8 @@ void    report_writeMaxFlowTurns(TMaxStats flowTurns[], int nMaxStats);
 void    report_writeNonconvergedStats(TMaxStats maxNonconverged[],
         int nMaxStats);
 void    report_writeTimeStepStats(TTimeStepStats* timeStepStats);
+void    report_writeOutputStats(double rawBytes, double savedBytes,
+        double writeTime, double waitTime);
 
 void    report_writeErrorMsg(int code, char* msg);
 void    report_writeErrorCode(void);
@@ -133,6 +146,8 @@ void    snow_getState(int subcatch, int subArea, double x[]);
 void    snow_setState(int subcatch, int subArea, double x[]);
 
 void    snow_setMeltCoeffs(int snowIndex, double season);
+void    snow_initMeltTables(void);
+void    snow_setTimeStep(double tStep);
 void    snow_plowSnow(int subcatch, double tStep);
 double  snow_getSnowMelt(int subcatch, double rainfall, double snowfall,
         double tStep, double netPrecip[]);
@@ -144,11 +159,13 @@ double  snow_getSnowCover(int subcatch);
 int     runoff_open(void);
 void    runoff_execute(void);
 void    runoff_close(void);
+int     runoff_canRunAhead(void);
 
 //-----------------------------------------------------------------------------
 //   Conveyance System Routing Methods
 //-----------------------------------------------------------------------------
 int     routing_open(void);
+void    routing_saveRunoff(void);
 double  routing_getRoutingStep(int routingModel, double fixedStep);
 void    routing_execute(int routingModel, double routingStep);
 void    routing_close(int routingModel);
@@ -183,6 +200,7 @@ void    gwater_setState(int subcatch, double x[]);
 
 void    gwater_getGroundwater(int subcatch, double evap, double infil,
         double tStep);
+void    gwater_flushBatch(void);
 double  gwater_getVolume(int subcatch);
 
 //-----------------------------------------------------------------------------
@@ -210,8 +228,9 @@ void    landuse_getInitBuildup(TLandFactor* landFactor,  double* initBuildup,
 double  landuse_getBuildup(int landuse, int pollut, double area, double curb,
         double buildup, double tStep);
 
-double  landuse_getWashoffLoad(int landuse, int p, double area,
-        TLandFactor landFactor[], double runoff, double vOutflow);
+void    landuse_getWashoffLoads(int landuse, double area,
+        TLandFactor* landFactor, double runoff, double vOutflow,
+        double load[]);
 double  landuse_getAvgBmpEffic(int j, int p);
 double  landuse_getCoPollutLoad(int p, double washoff[]);
 
@@ -232,6 +251,8 @@ void    dynwave_close(void);
 double  dynwave_getRoutingStep(double fixedStep);
 int     dynwave_execute(double tStep);
 void    dwflow_findConduitFlow(int j, int steps, double omega, double dt);
+void    dwflow_findConduitFlows(int n, int links[], int steps, double omega,
+        double dt);
 
 void    qualrout_init(void);
 void    qualrout_execute(double tStep);
@@ -259,6 +280,10 @@ void    massbal_updateGwaterTotals(double vInfil, double vUpperEvap,
         double vLowerEvap, double vLowerPerc, double vGwater);
 void    massbal_updateRoutingTotals(double tStep);
 
+int     massbal_openDeferred(int n);
+void    massbal_closeDeferred(void);
+void    massbal_deferTotals(int k);
+void    massbal_addDeferredTotals(void);
 
 void    massbal_initTimeStepTotals(void);
 void    massbal_addInflowFlow(int type, double q);
@@ -326,12 +351,11 @@ double  subcatch_getStorage(int subcatch);
 double  subcatch_getDepth(int subcatch);
 double  subcatch_getBuildup(int subcatch, int pollut); // (OWA addition)
 
-void    subcatch_getRunon(int subcatch);
+void    subcatch_getRunon(int subcatch, int toSubcatch);
 void    subcatch_addRunonFlow(int subcatch, double flow);
 double  subcatch_getRunoff(int subcatch, double tStep);
 
-double  subcatch_getWtdOutflow(int subcatch, double wt);
-void    subcatch_getResults(int subcatch, double wt, float x[]);
+void    subcatch_getResults(int subcatch, double wt, float x[], char used[]);
 
 //-----------------------------------------------------------------------------
 //  Surface Pollutant Buildup/Washoff Methods
@@ -340,7 +364,6 @@ void    surfqual_initState(int subcatch);
 void    surfqual_getWashoff(int subcatch, double runoff, double tStep);
 void    surfqual_getBuildup(int subcatch, double tStep);
 void    surfqual_sweepBuildup(int subcatch, DateTime aDate);
-double  surfqual_getWtdWashoff(int subcatch, int pollut, double wt);
 
 //-----------------------------------------------------------------------------
 //   Conveyance System Node Methods
@@ -363,7 +386,7 @@ double  node_getOutflow(int node, int link);
 double  node_getLosses(int node, double tStep);
 double  node_getMaxOutflow(int node, double q, double tStep);
 double  node_getSystemOutflow(int node, int *isFlooded);
-void    node_getResults(int node, double wt, float x[]);
+void    node_getResults(int node, double wt, float x[], char used[]);
 
 //-----------------------------------------------------------------------------
 //   Conveyance System Inflow Methods
@@ -430,7 +453,7 @@ double  link_getPower(int link);
 double  link_getLossRate(int link, int routeModel, double q, double tstep);
 char    link_getFullState(double a1, double a2, double aFull);
 
-void    link_getResults(int link, double wt, float x[]);
+void    link_getResults(int link, double wt, float x[], char used[]);
 
 //-----------------------------------------------------------------------------
 //   Link Cross-Section Methods
@@ -440,6 +463,7 @@ int     xsect_setParams(TXsect *xsect, int type, double p[], double ucf);
 void    xsect_setIrregXsectParams(TXsect *xsect);
 void    xsect_setCustomXsectParams(TXsect *xsect);
 void    xsect_setStreetXsectParams(TXsect *xsect);
+void    xsect_setInvIndex(TInvIndex* index, double* table, int nItems);
 double  xsect_getAmax(TXsect* xsect);
 
 double  xsect_getSofA(TXsect* xsect, double area);
@@ -500,6 +524,7 @@ int     controls_addExpression(char* tok[], int ntoks);
 int     controls_addRuleClause(int rule, int keyword, char* Tok[], int nTokens);
 int     controls_evaluate(DateTime currentTime, DateTime elapsedTime, 
         double tStep);
+int     controls_usesRunoffData(char tseries[]);
 
 //-----------------------------------------------------------------------------
 //   Table & Time Series Methods
@@ -545,6 +570,7 @@ size_t   sstrcat(char* dest, const char* src,
          size_t destsize);                    // safe string concatenation 
 void     writecon(const char *s);             // writes string to console
 DateTime getDateTime(double elapsedMsec);     // convert elapsed time to date
+void     runSteps(void (*stepCallback)(double)); // run simulation's time steps
 void     getElapsedTime(DateTime aDate,       // convert elapsed date
          int* days, int* hrs, int* mins);
 char*    addAbsolutePath(char *fname);        // add full path to a file name
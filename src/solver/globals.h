@@ -30,6 +30,11 @@
 //   - Fixes bug in summary statistics when Report Start date > Start Date.
 //   Build 5.2.0:
 //   - Support for relative file names added.
+//   Build 5.2.4:
+//   - Dynamic wave routing state arrays added.
+//   - Option to skip converged nodes in dynamic wave trials added.
+//   - Option to solve separate drainage basins independently added.
+//   - Evaporation rate & conductivity factor used by routing added.
 //-----------------------------------------------------------------------------
 
 #ifndef GLOBALS_H
@@ -82,6 +87,8 @@ EXTERN int
                   SlopeWeighting,           // Use slope weighting
                   Compatibility,            // SWMM 5/3/4 compatibility
                   SkipSteadyState,          // Skip over steady state periods
+                  SkipConverged,            // Skip converged nodes in DW trials
+                  SeparateBasins,           // Solve DW basins apart on one step
                   IgnoreRainfall,           // Ignore rainfall/runoff
                   IgnoreRDII,               // Ignore RDII
                   IgnoreSnowmelt,           // Ignore snowmelt
@@ -143,6 +150,8 @@ EXTERN TEvap      Evap;                     // Evaporation data
 EXTERN TWind      Wind;                     // Wind speed data
 EXTERN TSnow      Snow;                     // Snow melt data
 EXTERN TAdjust    Adjust;                   // Climate adjustments
+EXTERN double     RouteEvapRate,            // Evap. rate used in routing (ft/sec)
+                  RouteHydconFactor;        // Hyd. conductivity factor used in routing
 
 EXTERN TSnowmelt* Snowmelt;                 // Array of snow melt objects
 EXTERN TGage*     Gage;                     // Array of rain gages
@@ -168,6 +177,7 @@ EXTERN TTransect* Transect;                 // Array of transect data
 EXTERN TStreet*   Street;                   // Array of defined Street cross-sections
 EXTERN TShape*    Shape;                    // Array of custom conduit shapes
 EXTERN TEvent*    Event;                    // Array of routing events
+EXTERN TDwState   DwState;                  // Dynamic wave routing state
 
 
 #endif //GLOBALS_H
@@ -20,6 +20,12 @@
 //   - Support for collecting GW statistics added.
 //   Build 5.1.010:
 //   - Unsaturated hydraulic conductivity added to GW flow equation variables.
+//   Build 5.2.4:
+//   - Shared flux variables made private to each thread so that groundwater
+//     of several subcatchments can be found in parallel.
+//   - Fluxes kept in a state record for each subcatchment so that the
+//     groundwater equations of a batch of subcatchments can be integrated
+//     together.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -57,33 +63,49 @@ static char* GWVarWords[] = {"HGW", "HSW", "HCB", "HGS", "KS", "K",
                              "THETA", "PHI", "FI", "FU", "A", NULL};
 
 //-----------------------------------------------------------------------------
-//  Shared variables
+//  Data Structures
 //-----------------------------------------------------------------------------
 //  NOTE: all flux rates are in ft/sec, all depths are in ft.
-static double    Area;            // subcatchment area (ft2)
-static double    Infil;           // infiltration rate from surface
-static double    MaxEvap;         // max. evaporation rate
-static double    AvailEvap;       // available evaporation rate
-static double    UpperEvap;       // evaporation rate from upper GW zone
-static double    LowerEvap;       // evaporation rate from lower GW zone
-static double    UpperPerc;       // percolation rate from upper to lower zone
-static double    LowerLoss;       // loss rate from lower GW zone
-static double    GWFlow;          // flow rate from lower zone to conveyance node
-static double    MaxUpperPerc;    // upper limit on UpperPerc
-static double    MaxGWFlowPos;    // upper limit on GWFlow when its positve
-static double    MaxGWFlowNeg;    // upper limit on GWFlow when its negative
-static double    FracPerv;        // fraction of surface that is pervious
-static double    TotalDepth;      // total depth of GW aquifer
-static double    Theta;           // moisture content of upper zone
-static double    HydCon;          // unsaturated hydraulic conductivity (ft/s)
-static double    Hgw;             // ht. of saturated zone
-static double    Hstar;           // ht. from aquifer bottom to node invert
-static double    Hsw;             // ht. from aquifer bottom to water surface
-static double    Tstep;           // current time step (sec)
-static TAquifer  A;               // aquifer being analyzed
-static TGroundwater* GW;          // groundwater object being analyzed
-static MathExpr* LatFlowExpr;     // user-supplied lateral GW flow expression
-static MathExpr* DeepFlowExpr;    // user-supplied deep GW flow expression
+typedef struct
+{
+    int       subcatch;        // subcatchment index
+    double    area;            // subcatchment area (ft2)
+    double    infil;           // infiltration rate from surface
+    double    maxEvap;         // max. evaporation rate
+    double    availEvap;       // available evaporation rate
+    double    upperEvap;       // evaporation rate from upper GW zone
+    double    lowerEvap;       // evaporation rate from lower GW zone
+    double    upperPerc;       // percolation rate from upper to lower zone
+    double    lowerLoss;       // loss rate from lower GW zone
+    double    gwFlow;          // flow rate from lower zone to conveyance node
+    double    maxUpperPerc;    // upper limit on upperPerc
+    double    maxGWFlowPos;    // upper limit on gwFlow when its positve
+    double    maxGWFlowNeg;    // upper limit on gwFlow when its negative
+    double    fracPerv;        // fraction of surface that is pervious
+    double    totalDepth;      // total depth of GW aquifer
+    double    theta;           // moisture content of upper zone
+    double    hydCon;          // unsaturated hydraulic conductivity (ft/s)
+    double    hgw;             // ht. of saturated zone
+    double    hstar;           // ht. from aquifer bottom to node invert
+    double    hsw;             // ht. from aquifer bottom to water surface
+    double    tStep;           // current time step (sec)
+    TAquifer*     a;           // aquifer being analyzed
+    TGroundwater* gw;          // groundwater object being analyzed
+    MathExpr* latFlowExpr;     // user-supplied lateral GW flow expression
+    MathExpr* deepFlowExpr;    // user-supplied deep GW flow expression
+}  TGwState;
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+enum   {GW_BATCH = 32};        // max. number of subcatchments in a batch
+
+static TGwState  Batch[GW_BATCH]; // subcatchments waiting to be integrated
+static int       BatchSize;       // number of subcatchments in Batch
+static TGwState* ExprState;       // state used by a custom flow expression
+
+// --- each thread finding groundwater flows has its own batch
+#pragma omp threadprivate(Batch, BatchSize, ExprState)
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
@@ -96,19 +118,23 @@ static MathExpr* DeepFlowExpr;    // user-supplied deep GW flow expression
 //  gwater_validate              (called by subcatch_validate) 
 //  gwater_initState             (called by subcatch_initState)
 //  gwater_getVolume             (called by massbal_open & massbal_getGwaterError)
-//  gwater_getGroundwater        (called by getSubareaRunoff in subcatch.c)
+//  gwater_getGroundwater        (called by subcatch_getRunoff)
+//  gwater_flushBatch            (called by runoff_execute)
 //  gwater_getState              (called by saveRunoff in hotstart.c)
 //  gwater_setState              (called by readRunoff in hotstart.c)
 
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
-static void   getDxDt(double t, double* x, double* dxdt);
-static void   getFluxes(double upperVolume, double lowerDepth);
-static void   getEvapRates(double theta, double upperDepth);
-static double getUpperPerc(double theta, double upperDepth);
-static double getGWFlow(double lowerDepth);
-static void   updateMassBal(double area,  double tStep);
+static void   startGroundwater(TGwState* s, int j, double evap,
+              double infil, double tStep);
+static void   finishGroundwater(TGwState* s, double x[]);
+static void   getDxDt(void* data, int lane, double t, double* x, double* dxdt);
+static void   getFluxes(TGwState* s, double upperVolume, double lowerDepth);
+static void   getEvapRates(TGwState* s, double theta, double upperDepth);
+static double getUpperPerc(TGwState* s, double theta, double upperDepth);
+static double getGWFlow(TGwState* s, double lowerDepth);
+static void   updateMassBal(TGwState* s);
 
 // Used to process custom GW outflow equations
 static int    getVariableIndex(char* s);
@@ -483,129 +509,205 @@ void gwater_getGroundwater(int j, double evap, double infil, double tStep)
 //           tStep = time step (sec)
 //  Output:  none
 //
+//  NOTE: the subcatchment is added to a batch whose groundwater equations
+//        are integrated together once the batch is full or when
+//        gwater_flushBatch is called. Its groundwater results are not
+//        available until then.
+//
+{
+    TGwState* s;
+
+    // --- check that subcatchment has an aquifer with pervious area
+    //     and a non-zero depth
+    if ( Subcatch[j].groundwater == NULL ) return;
+    if ( subcatch_getFracPerv(j) <= 0.0 ) return;
+    if ( Subcatch[j].groundwater->surfElev -
+         Subcatch[j].groundwater->bottomElev <= 0.0 ) return;
+
+    // --- add subcatchment to the batch
+    s = &Batch[BatchSize];
+    startGroundwater(s, j, evap, infil, tStep);
+    BatchSize++;
+    if ( BatchSize == GW_BATCH ) gwater_flushBatch();
+}
+
+//=============================================================================
+
+void gwater_flushBatch()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: integrates the groundwater equations of all subcatchments added
+//           to the current thread's batch and saves their results.
+//
+{
+    int    k;
+    double x[2*GW_BATCH];              // moisture content & lower depth
+                                       // of each subcatchment in batch
+
+    if ( BatchSize == 0 ) return;
+
+    // --- store state variables (upper zone moisture content, lower zone
+    //     depth) of each subcatchment in work vector x
+    for (k = 0; k < BatchSize; k++)
+    {
+        x[2*k+THETA] = Batch[k].gw->theta;
+        x[2*k+LOWERDEPTH] = Batch[k].gw->lowerDepth;
+    }
+
+    // --- integrate eqns. for d(Theta)/dt and d(LowerDepth)/dt of all
+    //     subcatchments together (they share the same time step)
+    //     NOTE: ODE solver must have been initialized previously
+    odesolve_integrateBatch(x, BatchSize, 2, 0, Batch[0].tStep, GWTOL,
+                            Batch[0].tStep, Batch, getDxDt);
+
+    // --- save new states & flows in subcatchment order
+    for (k = 0; k < BatchSize; k++) finishGroundwater(&Batch[k], &x[2*k]);
+    BatchSize = 0;
+}
+
+//=============================================================================
+
+void startGroundwater(TGwState* s, int j, double evap, double infil,
+                      double tStep)
+//
+//  Input:   s     = groundwater state of a subcatchment
+//           j     = subcatchment index
+//           evap  = pervious surface evaporation volume consumed (ft3)
+//           infil = surface infiltration volume (ft3)
+//           tStep = time step (sec)
+//  Output:  none
+//  Purpose: sets the rates and limits that apply to a subcatchment's
+//           groundwater during the current time step.
+//
 {
     int    n;                          // node exchanging groundwater
-    double x[2];                       // upper moisture content & lower depth 
+    double theta, lowerDepth;          // current state of aquifer
     double vUpper;                     // upper vol. available for percolation
     double nodeFlow;                   // max. possible GW flow from node
+    TGroundwater* gw;
+    TAquifer* a;
 
-    // --- save subcatchment's groundwater and aquifer objects to 
-    //     shared variables
-    GW = Subcatch[j].groundwater;
-    if ( GW == NULL ) return;
-    LatFlowExpr = Subcatch[j].gwLatFlowExpr;
-    DeepFlowExpr = Subcatch[j].gwDeepFlowExpr;
-    A = Aquifer[GW->aquifer];
+    // --- save subcatchment's groundwater and aquifer objects
+    s->subcatch = j;
+    gw = s->gw = Subcatch[j].groundwater;
+    s->latFlowExpr = Subcatch[j].gwLatFlowExpr;
+    s->deepFlowExpr = Subcatch[j].gwDeepFlowExpr;
+    a = s->a = &Aquifer[gw->aquifer];
+    s->hydCon = 0.0;
 
     // --- get fraction of total area that is pervious
-    FracPerv = subcatch_getFracPerv(j);
-    if ( FracPerv <= 0.0 ) return;
-    Area = Subcatch[j].area;
+    s->fracPerv = subcatch_getFracPerv(j);
+    s->area = Subcatch[j].area;
 
     // --- convert infiltration volume (ft3) to equivalent rate
     //     over entire GW (subcatchment) area
-    infil = infil / Area / tStep;
-    Infil = infil;
-    Tstep = tStep;
+    s->infil = infil / s->area / tStep;
+    s->tStep = tStep;
 
     // --- convert pervious surface evaporation already exerted (ft3)
     //     to equivalent rate over entire GW (subcatchment) area
-    evap = evap / Area / tStep;
+    evap = evap / s->area / tStep;
 
     // --- convert max. surface evap rate (ft/sec) to a rate
     //     that applies to GW evap (GW evap can only occur
     //     through the pervious land surface area)
-    MaxEvap = Evap.rate * FracPerv;
+    s->maxEvap = Evap.rate * s->fracPerv;
 
     // --- available subsurface evaporation is difference between max.
     //     rate and pervious surface evap already exerted
-    AvailEvap = MAX((MaxEvap - evap), 0.0);
+    s->availEvap = MAX((s->maxEvap - evap), 0.0);
 
-    // --- save total depth & outlet node properties to shared variables
-    TotalDepth = GW->surfElev - GW->bottomElev;
-    if ( TotalDepth <= 0.0 ) return;
-    n = GW->node;
+    // --- save total depth & outlet node properties
+    s->totalDepth = gw->surfElev - gw->bottomElev;
+    n = gw->node;
 
     // --- establish min. water table height above aquifer bottom at which
     //     GW flow can occur (override node's invert if a value was provided
     //     in the GW object)
-    if ( GW->nodeElev != MISSING ) Hstar = GW->nodeElev - GW->bottomElev;
-    else Hstar = Node[n].invertElev - GW->bottomElev;
+    if ( gw->nodeElev != MISSING ) s->hstar = gw->nodeElev - gw->bottomElev;
+    else s->hstar = Node[n].invertElev - gw->bottomElev;
     
     // --- establish surface water height (relative to aquifer bottom)
     //     for drainage system node connected to the GW aquifer
-    if ( GW->fixedDepth > 0.0 )
+    if ( gw->fixedDepth > 0.0 )
     {
-        Hsw = GW->fixedDepth + Node[n].invertElev - GW->bottomElev;
+        s->hsw = gw->fixedDepth + Node[n].invertElev - gw->bottomElev;
     }
-    else Hsw = Node[n].newDepth + Node[n].invertElev - GW->bottomElev;
-
-    // --- store state variables (upper zone moisture content, lower zone
-    //     depth) in work vector x
-    x[THETA] = GW->theta;
-    x[LOWERDEPTH] = GW->lowerDepth;
+    else s->hsw = Node[n].newDepth + Node[n].invertElev - gw->bottomElev;
 
     // --- set limit on percolation rate from upper to lower GW zone
-    vUpper = (TotalDepth - x[LOWERDEPTH]) * (x[THETA] - A.fieldCapacity);
+    theta = gw->theta;
+    lowerDepth = gw->lowerDepth;
+    vUpper = (s->totalDepth - lowerDepth) * (theta - a->fieldCapacity);
     vUpper = MAX(0.0, vUpper); 
-    MaxUpperPerc = vUpper / tStep;
+    s->maxUpperPerc = vUpper / tStep;
 
     // --- set limit on GW flow out of aquifer based on volume of lower zone
-    MaxGWFlowPos = x[LOWERDEPTH]*A.porosity / tStep;
+    s->maxGWFlowPos = lowerDepth*a->porosity / tStep;
 
     // --- set limit on GW flow into aquifer from drainage system node
     //     based on min. of capacity of upper zone and drainage system
     //     inflow to the node
-    MaxGWFlowNeg = (TotalDepth - x[LOWERDEPTH]) * (A.porosity - x[THETA])
-                   / tStep;
-    nodeFlow = (Node[n].inflow + Node[n].newVolume/tStep) / Area;
-    MaxGWFlowNeg = -MIN(MaxGWFlowNeg, nodeFlow);
-    
-    // --- integrate eqns. for d(Theta)/dt and d(LowerDepth)/dt
-    //     NOTE: ODE solver must have been initialized previously
-    odesolve_integrate(x, 2, 0, tStep, GWTOL, tStep, getDxDt);
-    
+    s->maxGWFlowNeg = (s->totalDepth - lowerDepth) * (a->porosity - theta)
+                      / tStep;
+    nodeFlow = (Node[n].inflow + Node[n].newVolume/tStep) / s->area;
+    s->maxGWFlowNeg = -MIN(s->maxGWFlowNeg, nodeFlow);
+}
+
+//=============================================================================
+
+void finishGroundwater(TGwState* s, double x[])
+//
+//  Input:   s = groundwater state of a subcatchment
+//           x = integrated moisture content & lower depth
+//  Output:  none
+//  Purpose: saves a subcatchment's new groundwater state and flows.
+//
+{
+    TGroundwater* gw = s->gw;
+    TAquifer* a = s->a;
+
     // --- keep state variables within allowable bounds
-    x[THETA] = MAX(x[THETA], A.wiltingPoint);
-    if ( x[THETA] >= A.porosity )
+    x[THETA] = MAX(x[THETA], a->wiltingPoint);
+    if ( x[THETA] >= a->porosity )
     {
-        x[THETA] = A.porosity - XTOL;
-        x[LOWERDEPTH] = TotalDepth - XTOL;
+        x[THETA] = a->porosity - XTOL;
+        x[LOWERDEPTH] = s->totalDepth - XTOL;
     }
     x[LOWERDEPTH] = MAX(x[LOWERDEPTH],  0.0);
-    if ( x[LOWERDEPTH] >= TotalDepth )
+    if ( x[LOWERDEPTH] >= s->totalDepth )
     {
-        x[LOWERDEPTH] = TotalDepth - XTOL;
+        x[LOWERDEPTH] = s->totalDepth - XTOL;
     }
 
     // --- save new values of state values
-    GW->theta = x[THETA];
-    GW->lowerDepth  = x[LOWERDEPTH];
-    getFluxes(GW->theta, GW->lowerDepth);
-    GW->oldFlow = GW->newFlow;
-    GW->newFlow = GWFlow;
-    GW->evapLoss = UpperEvap + LowerEvap;
+    gw->theta = x[THETA];
+    gw->lowerDepth  = x[LOWERDEPTH];
+    getFluxes(s, gw->theta, gw->lowerDepth);
+    gw->oldFlow = gw->newFlow;
+    gw->newFlow = s->gwFlow;
+    gw->evapLoss = s->upperEvap + s->lowerEvap;
 
     //--- find max. infiltration volume (as depth over
     //    the pervious portion of the subcatchment)
     //    that upper zone can support in next time step
-    GW->maxInfilVol = (TotalDepth - x[LOWERDEPTH]) *
-                      (A.porosity - x[THETA]) / FracPerv;
+    gw->maxInfilVol = (s->totalDepth - x[LOWERDEPTH]) *
+                      (a->porosity - x[THETA]) / s->fracPerv;
 
     // --- update GW mass balance
-    updateMassBal(Area, tStep);
+    updateMassBal(s);
 
     // --- update GW statistics 
-    stats_updateGwaterStats(j, infil, GW->evapLoss, GWFlow, LowerLoss,
-        GW->theta, GW->lowerDepth + GW->bottomElev, tStep);
+    stats_updateGwaterStats(s->subcatch, s->infil, gw->evapLoss, s->gwFlow,
+        s->lowerLoss, gw->theta, gw->lowerDepth + gw->bottomElev, s->tStep);
 }
 
 //=============================================================================
 
-void updateMassBal(double area, double tStep)
+void updateMassBal(TGwState* s)
 //
-//  Input:   area  = subcatchment area (ft2)
-//           tStep = time step (sec)
+//  Input:   s = groundwater state of a subcatchment
 //  Output:  none
 //  Purpose: updates GW mass balance with volumes of water fluxes.
 //
@@ -615,23 +717,24 @@ void updateMassBal(double area, double tStep)
     double vLowerEvap;                 // lower zone evap. volume
     double vLowerPerc;                 // lower zone deep perc. volume
     double vGwater;                    // volume of exchanged groundwater
-    double ft2sec = area * tStep;
+    double ft2sec = s->area * s->tStep;
 
-    vInfil     = Infil * ft2sec;
-    vUpperEvap = UpperEvap * ft2sec;
-    vLowerEvap = LowerEvap * ft2sec;
-    vLowerPerc = LowerLoss * ft2sec;
-    vGwater    = 0.5 * (GW->oldFlow + GW->newFlow) * ft2sec;
+    vInfil     = s->infil * ft2sec;
+    vUpperEvap = s->upperEvap * ft2sec;
+    vLowerEvap = s->lowerEvap * ft2sec;
+    vLowerPerc = s->lowerLoss * ft2sec;
+    vGwater    = 0.5 * (s->gw->oldFlow + s->gw->newFlow) * ft2sec;
     massbal_updateGwaterTotals(vInfil, vUpperEvap, vLowerEvap, vLowerPerc,
                                vGwater);
 }
 
 //=============================================================================
 
-void  getFluxes(double theta, double lowerDepth)
+void  getFluxes(TGwState* s, double theta, double lowerDepth)
 //
-//  Input:   upperVolume = vol. depth of upper zone (ft)
-//           upperDepth  = depth of upper zone (ft)
+//  Input:   s          = groundwater state of a subcatchment
+//           theta      = moisture content of upper zone
+//           lowerDepth = depth of lower zone (ft)
 //  Output:  none
 //  Purpose: computes water fluxes into/out of upper/lower GW zones.
 //
@@ -640,43 +743,47 @@ void  getFluxes(double theta, double lowerDepth)
 
     // --- find upper zone depth
     lowerDepth = MAX(lowerDepth, 0.0);
-    lowerDepth = MIN(lowerDepth, TotalDepth);
-    upperDepth = TotalDepth - lowerDepth;
+    lowerDepth = MIN(lowerDepth, s->totalDepth);
+    upperDepth = s->totalDepth - lowerDepth;
 
-    // --- save lower depth and theta to global variables
-    Hgw = lowerDepth;
-    Theta = theta;
+    // --- save lower depth and theta for use in flow expressions
+    s->hgw = lowerDepth;
+    s->theta = theta;
 
     // --- find evaporation rate from both zones
-    getEvapRates(theta, upperDepth);
+    getEvapRates(s, theta, upperDepth);
 
     // --- find percolation rate from upper to lower zone
-    UpperPerc = getUpperPerc(theta, upperDepth);
-    UpperPerc = MIN(UpperPerc, MaxUpperPerc);
+    s->upperPerc = getUpperPerc(s, theta, upperDepth);
+    s->upperPerc = MIN(s->upperPerc, s->maxUpperPerc);
 
     // --- find loss rate to deep GW
-    if ( DeepFlowExpr != NULL )
-        LowerLoss = mathexpr_eval(DeepFlowExpr, getVariableValue) /
-                    UCF(RAINFALL);
+    ExprState = s;
+    if ( s->deepFlowExpr != NULL )
+        s->lowerLoss = mathexpr_eval(s->deepFlowExpr, getVariableValue) /
+                       UCF(RAINFALL);
     else
-        LowerLoss = A.lowerLossCoeff * lowerDepth / TotalDepth;
-    LowerLoss = MIN(LowerLoss, lowerDepth/Tstep);
+        s->lowerLoss = s->a->lowerLossCoeff * lowerDepth / s->totalDepth;
+    s->lowerLoss = MIN(s->lowerLoss, lowerDepth/s->tStep);
 
     // --- find GW flow rate from lower zone to drainage system node
-    GWFlow = getGWFlow(lowerDepth);
-    if ( LatFlowExpr != NULL )
+    s->gwFlow = getGWFlow(s, lowerDepth);
+    if ( s->latFlowExpr != NULL )
     {
-        GWFlow += mathexpr_eval(LatFlowExpr, getVariableValue) / UCF(GWFLOW);
+        s->gwFlow += mathexpr_eval(s->latFlowExpr, getVariableValue) /
+                     UCF(GWFLOW);
     }
-    if ( GWFlow >= 0.0 ) GWFlow = MIN(GWFlow, MaxGWFlowPos);
-    else GWFlow = MAX(GWFlow, MaxGWFlowNeg);
+    if ( s->gwFlow >= 0.0 ) s->gwFlow = MIN(s->gwFlow, s->maxGWFlowPos);
+    else s->gwFlow = MAX(s->gwFlow, s->maxGWFlowNeg);
 }
 
 //=============================================================================
 
-void  getDxDt(double t, double* x, double* dxdt)
+void  getDxDt(void* data, int lane, double t, double* x, double* dxdt)
 //
-//  Input:   t    = current time (not used)
+//  Input:   data = array of groundwater states being integrated
+//           lane = index of the subcatchment's state in data
+//           t    = current time (not used)
 //           x    = array of state variables
 //  Output:  dxdt = array of time derivatives of state variables
 //  Purpose: computes time derivatives of upper moisture content 
@@ -686,14 +793,15 @@ void  getDxDt(double t, double* x, double* dxdt)
     double qUpper;    // inflow - outflow for upper zone (ft/sec)
     double qLower;    // inflow - outflow for lower zone (ft/sec)
     double denom;
+    TGwState* s = (TGwState *)data + lane;
 
-    getFluxes(x[THETA], x[LOWERDEPTH]);
-    qUpper = Infil - UpperEvap - UpperPerc;
-    qLower = UpperPerc - LowerLoss - LowerEvap - GWFlow;
+    getFluxes(s, x[THETA], x[LOWERDEPTH]);
+    qUpper = s->infil - s->upperEvap - s->upperPerc;
+    qLower = s->upperPerc - s->lowerLoss - s->lowerEvap - s->gwFlow;
 
     // --- d(upper zone moisture)/dt = (net upper zone flow) /
     //                                 (upper zone depth)
-    denom = TotalDepth - x[LOWERDEPTH];
+    denom = s->totalDepth - x[LOWERDEPTH];
     if (denom > 0.0)
         dxdt[THETA] = qUpper / denom;
     else
@@ -701,7 +809,7 @@ void  getDxDt(double t, double* x, double* dxdt)
 
     // --- d(lower zone depth)/dt = (net lower zone flow) /
     //                              (upper zone moisture deficit)
-    denom = A.porosity - x[THETA];
+    denom = s->a->porosity - x[THETA];
     if (denom > 0.0)
         dxdt[LOWERDEPTH] = qLower / denom;
     else
@@ -710,9 +818,10 @@ void  getDxDt(double t, double* x, double* dxdt)
 
 //=============================================================================
 
-void getEvapRates(double theta, double upperDepth)
+void getEvapRates(TGwState* s, double theta, double upperDepth)
 //
-//  Input:   theta      = moisture content of upper zone
+//  Input:   s          = groundwater state of a subcatchment
+//           theta      = moisture content of upper zone
 //           upperDepth = depth of upper zone (ft)
 //  Output:  none
 //  Purpose: computes evapotranspiration out of upper & lower zones.
@@ -721,16 +830,17 @@ void getEvapRates(double theta, double upperDepth)
     int    p, month;
     double f;
     double lowerFrac, upperFrac;
+    TAquifer* a = s->a;
 
     // --- no GW evaporation when infiltration is occurring
-    UpperEvap = 0.0;
-    LowerEvap = 0.0;
-    if ( Infil > 0.0 ) return;
+    s->upperEvap = 0.0;
+    s->lowerEvap = 0.0;
+    if ( s->infil > 0.0 ) return;
 
     // --- get monthly-adjusted upper zone evap fraction
-    upperFrac = A.upperEvapFrac;
+    upperFrac = a->upperEvapFrac;
     f = 1.0;
-    p = A.upperEvapPat;
+    p = a->upperEvapPat;
     if ( p >= 0 )
     {
         month = datetime_monthOfYear(getDateTime(NewRunoffTime));
@@ -740,35 +850,36 @@ void getEvapRates(double theta, double upperDepth)
 
     // --- upper zone evaporation requires that soil moisture
     //     be above the wilting point
-    if ( theta > A.wiltingPoint )
+    if ( theta > a->wiltingPoint )
     {
         // --- actual evap is upper zone fraction applied to max. potential
         //     rate, limited by the available rate after any surface evap 
-        UpperEvap = upperFrac * MaxEvap;
-        UpperEvap = MIN(UpperEvap, AvailEvap);
+        s->upperEvap = upperFrac * s->maxEvap;
+        s->upperEvap = MIN(s->upperEvap, s->availEvap);
     }
 
     // --- check if lower zone evaporation is possible
-    if ( A.lowerEvapDepth > 0.0 )
+    if ( a->lowerEvapDepth > 0.0 )
     {
         // --- find the fraction of the lower evaporation depth that
         //     extends into the saturated lower zone
-        lowerFrac = (A.lowerEvapDepth - upperDepth) / A.lowerEvapDepth;
+        lowerFrac = (a->lowerEvapDepth - upperDepth) / a->lowerEvapDepth;
         lowerFrac = MAX(0.0, lowerFrac);
         lowerFrac = MIN(lowerFrac, 1.0);
 
         // --- make the lower zone evap rate proportional to this fraction
         //     and the evap not used in the upper zone
-        LowerEvap = lowerFrac * (1.0 - upperFrac) * MaxEvap;
-        LowerEvap = MIN(LowerEvap, (AvailEvap - UpperEvap));
+        s->lowerEvap = lowerFrac * (1.0 - upperFrac) * s->maxEvap;
+        s->lowerEvap = MIN(s->lowerEvap, (s->availEvap - s->upperEvap));
     }
 }
 
 //=============================================================================
 
-double getUpperPerc(double theta, double upperDepth)
+double getUpperPerc(TGwState* s, double theta, double upperDepth)
 //
-//  Input:   theta      = moisture content of upper zone
+//  Input:   s          = groundwater state of a subcatchment
+//           theta      = moisture content of upper zone
 //           upperDepth = depth of upper zone (ft)
 //  Output:  returns percolation rate (ft/sec)
 //  Purpose: finds percolation rate from upper to lower zone.
@@ -777,55 +888,58 @@ double getUpperPerc(double theta, double upperDepth)
     double delta;                       // unfilled water content of upper zone
     double dhdz;                        // avg. change in head with depth
     double hydcon;                      // unsaturated hydraulic conductivity
+    TAquifer* a = s->a;
 
     // --- no perc. from upper zone if no depth or moisture content too low    
-    if ( upperDepth <= 0.0 || theta <= A.fieldCapacity ) return 0.0;
+    if ( upperDepth <= 0.0 || theta <= a->fieldCapacity ) return 0.0;
 
     // --- compute hyd. conductivity as function of moisture content
-    delta = theta - A.porosity;
-    hydcon = A.conductivity * exp(delta * A.conductSlope);
+    delta = theta - a->porosity;
+    hydcon = a->conductivity * exp(delta * a->conductSlope);
 
     // --- compute integral of dh/dz term
-    delta = theta - A.fieldCapacity;
-    dhdz = 1.0 + A.tensionSlope * 2.0 * delta / upperDepth;
+    delta = theta - a->fieldCapacity;
+    dhdz = 1.0 + a->tensionSlope * 2.0 * delta / upperDepth;
 
     // --- compute upper zone percolation rate
-    HydCon = hydcon;
+    s->hydCon = hydcon;
     return hydcon * dhdz;
 }
 
 //=============================================================================
 
-double getGWFlow(double lowerDepth)
+double getGWFlow(TGwState* s, double lowerDepth)
 //
-//  Input:   lowerDepth = depth of lower zone (ft)
+//  Input:   s          = groundwater state of a subcatchment
+//           lowerDepth = depth of lower zone (ft)
 //  Output:  returns groundwater flow rate (ft/sec)
 //  Purpose: finds groundwater outflow from lower saturated zone.
 //
 {
     double q, t1, t2, t3;
+    TGroundwater* gw = s->gw;
 
-    // --- water table must be above Hstar for flow to occur
-    if ( lowerDepth <= Hstar ) return 0.0;
+    // --- water table must be above hstar for flow to occur
+    if ( lowerDepth <= s->hstar ) return 0.0;
 
     // --- compute groundwater component of flow
-    if ( GW->b1 == 0.0 ) t1 = GW->a1;
-    else t1 = GW->a1 * pow( (lowerDepth - Hstar)*UCF(LENGTH), GW->b1);
+    if ( gw->b1 == 0.0 ) t1 = gw->a1;
+    else t1 = gw->a1 * pow( (lowerDepth - s->hstar)*UCF(LENGTH), gw->b1);
 
     // --- compute surface water component of flow
-    if ( GW->b2 == 0.0 ) t2 = GW->a2;
-    else if (Hsw > Hstar)
+    if ( gw->b2 == 0.0 ) t2 = gw->a2;
+    else if (s->hsw > s->hstar)
     {
-        t2 = GW->a2 * pow( (Hsw - Hstar)*UCF(LENGTH), GW->b2);
+        t2 = gw->a2 * pow( (s->hsw - s->hstar)*UCF(LENGTH), gw->b2);
     }
     else t2 = 0.0;
 
     // --- compute groundwater/surface water interaction term
-    t3 = GW->a3 * lowerDepth * Hsw * UCF(LENGTH) * UCF(LENGTH);
+    t3 = gw->a3 * lowerDepth * s->hsw * UCF(LENGTH) * UCF(LENGTH);
 
     // --- compute total groundwater flow
     q = (t1 - t2 + t3) / UCF(GWFLOW); 
-    if ( q < 0.0 && GW->a3 != 0.0 ) q = 0.0;
+    if ( q < 0.0 && gw->a3 != 0.0 ) q = 0.0;
     return q;
 }
 
@@ -851,22 +965,24 @@ double getVariableValue(int varIndex)
 //
 //  Input:   varIndex = index of a GW variable
 //  Output:  returns current value of GW variable
-//  Purpose: finds current value of a GW variable.
+//  Purpose: finds current value of a GW variable for the subcatchment
+//           whose flow expression is being evaluated.
 //
 {
+    TGwState* s = ExprState;
     switch (varIndex)
     {
-    case gwvHGW:  return Hgw * UCF(LENGTH);
-    case gwvHSW:  return Hsw * UCF(LENGTH);
-    case gwvHCB:  return Hstar * UCF(LENGTH);
-    case gwvHGS:  return TotalDepth * UCF(LENGTH);
-    case gwvKS:   return A.conductivity * UCF(RAINFALL);
-    case gwvK:    return HydCon * UCF(RAINFALL);
-    case gwvTHETA:return Theta;
-    case gwvPHI:  return A.porosity;
-    case gwvFI:   return Infil * UCF(RAINFALL); 
-    case gwvFU:   return UpperPerc * UCF(RAINFALL);
-    case gwvA:    return Area * UCF(LANDAREA);
+    case gwvHGW:  return s->hgw * UCF(LENGTH);
+    case gwvHSW:  return s->hsw * UCF(LENGTH);
+    case gwvHCB:  return s->hstar * UCF(LENGTH);
+    case gwvHGS:  return s->totalDepth * UCF(LENGTH);
+    case gwvKS:   return s->a->conductivity * UCF(RAINFALL);
+    case gwvK:    return s->hydCon * UCF(RAINFALL);
+    case gwvTHETA:return s->theta;
+    case gwvPHI:  return s->a->porosity;
+    case gwvFI:   return s->infil * UCF(RAINFALL); 
+    case gwvFU:   return s->upperPerc * UCF(RAINFALL);
+    case gwvA:    return s->area * UCF(LANDAREA);
     default:      return 0.0;
     }
 }
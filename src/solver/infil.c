@@ -32,6 +32,9 @@
 //   - Additional validity check for G-A initial deficit added.
 //   - New error message 235 added for invalid infiltration parameters.
 //   - Conversion of runon to ponded depth fixed for Curve Number infiltration.
+//   Build 5.2.4:
+//   - Infiltration adjustment factor made private to each thread.
+//   - Factor used for storage unit seepage taken from routing's copy.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -52,6 +55,7 @@ TInfil *Infil;
 
 static double Fumax;   // saturated water volume in upper soil zone (ft)
 static double InfilFactor;
+#pragma omp threadprivate(Fumax, InfilFactor)
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in infil.h)
@@ -269,7 +273,9 @@ void infil_setInfilFactor(int j)
     int p;
 
     // ... set factor to the global conductivity adjustment factor
-    InfilFactor = Adjust.hydconFactor;
+    //     (storage unit seepage uses the factor saved for routing)
+    if (j >= 0) InfilFactor = Adjust.hydconFactor;
+    else InfilFactor = RouteHydconFactor;
 
     // ... override global factor with subcatchment's adjustment if assigned 
     if (j >= 0)
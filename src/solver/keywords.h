@@ -14,6 +14,9 @@
 //   - Keyword arrays listed in alphabetical order.
 //   Build 5.1.013:
 //   - New keyword array defined for surcharge method.
+//   Build 5.2.4:
+//   - New keyword array defined for binary results layout.
+//   - New keyword arrays defined for binary results variables.
 //-----------------------------------------------------------------------------
 
 #ifndef KEYWORDS_H
@@ -23,7 +26,6 @@
 extern char* BuildupTypeWords[];
 extern char* CurveTypeWords[];
 extern char* DividerTypeWords[];
-extern char* DynWaveMethodWords[];
 extern char* EvapTypeWords[];
 extern char* FileModeWords[];
 extern char* FileTypeWords[];
@@ -34,11 +36,14 @@ extern char* InertDampingWords[];
 extern char* InfilModelWords[];
 extern char* LinkOffsetWords[];
 extern char* LinkTypeWords[];
+extern char* LinkVarWords[];
 extern char* LoadUnitsWords[];
 extern char* NodeTypeWords[];
+extern char* NodeVarWords[];
 extern char* NoneAllWords[];
 extern char* NormalFlowWords[];
 extern char* NormalizerWords[];
+extern char* LayoutWords[];
 extern char* NoYesWords[];
 extern char* OldRouteModelWords[];
 extern char* OffOnWords[];
@@ -58,6 +63,7 @@ extern char* RouteModelWords[];
 extern char* RuleKeyWords[];
 extern char* SectWords[];
 extern char* SnowmeltWords[];
+extern char* SubcatchVarWords[];
 extern char* SurchargeWords[];
 extern char* TempKeyWords[];
 extern char* TransectKeyWords[];
@@ -15,6 +15,12 @@
 //     modified to return concentration instead of mass load.
 //   - landuse_getRunoffLoad() re-named to landuse_getWashoffLoad() and
 //     modified to work with landuse_getWashoffQual().
+//   Build 5.2.4:
+//   - External buildup time series lookups serialized for parallel runoff.
+//   - landuse_getWashoffLoad() replaced by landuse_getWashoffLoads() that
+//     finds the loads of all pollutants washed off a land use at once.
+//   - Buildup that has reached its maximum no longer converted to an
+//     equivalent number of days.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -32,9 +38,9 @@
 
 //  landuse_getInitBuildup    (called by subcatch_initState)
 //  landuse_getBuildup        (called by surfqual_getBuildup)
-//  landuse_getWashoffLoad    (called by surfqual_getWashoff)
+//  landuse_getWashoffLoads   (called by findWashoffLoads in surfqual.c)
 //  landuse_getCoPollutLoad   (called by surfqual_getwashoff));
-//  landuse_getAvgBMPEffic    (called by updatePondedQual in surfqual.c)
+//  landuse_getAvgBMPEffic    (called by surfqual_initState)
 
 //-----------------------------------------------------------------------------
 // Function declarations
@@ -445,6 +451,13 @@ double  landuse_getBuildup(int i, int p, double area, double curb, double buildu
                perUnit;
     }
 
+    // --- buildup already at its maximum stays there
+    if ( buildup/perUnit > 0.0 &&
+         buildup/perUnit >= Landuse[i].buildupFunc[p].coeff[0] )
+    {
+        return Landuse[i].buildupFunc[p].coeff[0] * perUnit;
+    }
+
     // --- determine equivalent days of current buildup
     days = landuse_getBuildupDays(i, p, buildup/perUnit);
 
@@ -550,61 +563,73 @@ double landuse_getAvgBmpEffic(int j, int p)
 
 //=============================================================================
 
-double landuse_getWashoffLoad(int i, int p, double area,
-    TLandFactor landFactor[], double runoff, double vOutflow)
+void landuse_getWashoffLoads(int i, double area, TLandFactor* landFactor,
+    double runoff, double vOutflow, double load[])
 //
 //  Input:   i = land use index
-//           p = pollut. index
 //           area = sucatchment area (ft2)
-//           landFactor[] = array of land use data for subcatchment
+//           landFactor = subcatchment's data for the land use
 //           runoff = runoff flow generated by subcatchment (ft/sec)
 //           vOutflow = runoff volume leaving the subcatchment (ft3)
-//  Output:  returns pollutant runoff load (mass)
-//  Purpose: computes pollutant load generated by a land use over a time step.
+//           load[] = pollutant runoff loads (mass)
+//  Output:  updates load[] and the land use's buildup
+//  Purpose: adds the pollutant loads generated by a land use over a time
+//           step to a subcatchment's runoff loads.
 //
 {
+    int    p;                // pollutant index
     double landuseArea;      // area of current land use (ft2)
     double buildup;          // current pollutant buildup (lb or kg)
     double washoffQual;      // pollutant concentration in washoff (mass/ft3)
     double washoffLoad;      // pollutant washoff load over time step (lb or kg)
     double bmpRemoval;       // pollutant load removed by BMP treatment (lb or kg)
+    double* buildups = landFactor->buildup;
+    TBuildup* buildupFunc = Landuse[i].buildupFunc;
+    TWashoff* washoffFunc = Landuse[i].washoffFunc;
 
-    // --- compute concen. of pollutant in washoff (mass/ft3)
-    buildup = landFactor[i].buildup[p];
-    landuseArea = landFactor[i].fraction * area;
-    washoffQual = landuse_getWashoffQual(i, p, buildup, runoff, landuseArea);
+    landuseArea = landFactor->fraction * area;
+    for (p = 0; p < Nobjects[POLLUT]; p++)
+    {
+        // --- no washoff function produces no load
+        if ( washoffFunc[p].funcType == NO_WASHOFF ) continue;
 
-    // --- compute washoff load exported (lbs or kg) from landuse
-    //     (Pollut[].mcf converts from mg (or ug) mass units to lbs (or kg)
-    washoffLoad = washoffQual * vOutflow * landuseArea / area * Pollut[p].mcf;
+        // --- compute concen. of pollutant in washoff (mass/ft3)
+        buildup = buildups[p];
+        washoffQual = landuse_getWashoffQual(i, p, buildup, runoff,
+                                             landuseArea);
 
-    // --- if buildup modelled, reduce it by amount of washoff
-    if ( Landuse[i].buildupFunc[p].funcType != NO_BUILDUP ||
-         buildup > washoffLoad )
-    {
-        washoffLoad = MIN(washoffLoad, buildup);
-        buildup -= washoffLoad;
-        landFactor[i].buildup[p] = buildup;
-    }
+        // --- compute washoff load exported (lbs or kg) from landuse
+        //     (Pollut[].mcf converts from mg (or ug) mass units to lbs (or kg)
+        washoffLoad = washoffQual * vOutflow * landuseArea / area *
+                      Pollut[p].mcf;
 
-    // --- otherwise add washoff to buildup mass balance totals
-    //     so that things will balance
-    else
-    {
-        massbal_updateLoadingTotals(BUILDUP_LOAD, p, washoffLoad);
-        landFactor[i].buildup[p] = 0.0;
-    }
-	
-    // --- apply any BMP removal to washoff
-    bmpRemoval = Landuse[i].washoffFunc[p].bmpEffic * washoffLoad;
-    if ( bmpRemoval > 0.0 )
-    {
-        massbal_updateLoadingTotals(BMP_REMOVAL_LOAD, p, bmpRemoval);
-        washoffLoad -= bmpRemoval;
-    }
+        // --- if buildup modelled, reduce it by amount of washoff
+        if ( buildupFunc[p].funcType != NO_BUILDUP || buildup > washoffLoad )
+        {
+            washoffLoad = MIN(washoffLoad, buildup);
+            buildup -= washoffLoad;
+            buildups[p] = buildup;
+        }
+
+        // --- otherwise add washoff to buildup mass balance totals
+        //     so that things will balance
+        else
+        {
+            massbal_updateLoadingTotals(BUILDUP_LOAD, p, washoffLoad);
+            buildups[p] = 0.0;
+        }
 
-    // --- return washoff load converted back to mass (mg or ug)
-    return washoffLoad / Pollut[p].mcf;
+        // --- apply any BMP removal to washoff
+        bmpRemoval = washoffFunc[p].bmpEffic * washoffLoad;
+        if ( bmpRemoval > 0.0 )
+        {
+            massbal_updateLoadingTotals(BMP_REMOVAL_LOAD, p, bmpRemoval);
+            washoffLoad -= bmpRemoval;
+        }
+
+        // --- add washoff load converted back to mass (mg or ug)
+        load[p] += washoffLoad / Pollut[p].mcf;
+    }
 }
 
 //=============================================================================
@@ -710,8 +735,11 @@ double landuse_getExternalBuildup(int i, int p, double buildup, double tStep)
     if (NewRunoffTime == 0.0) return 0.0;
 
     // --- get buildup rate (mass/unit/day) over the interval
+    //     (time series lookups move the series' current position so
+    //     subcatchments analyzed in parallel take turns doing them)
     if ( ts >= 0 )
     {        
+        #pragma omp critical (buildupSeries)
         rate = sf * table_tseriesLookup(&Tseries[ts],
                getDateTime(NewRunoffTime), FALSE);
     }
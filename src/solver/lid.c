@@ -72,6 +72,10 @@
 //   - Fixed double counting of initial water volume in green roof drain mat.
 //   Build 5.2.4
 //   - Fixed test for invalid data in readDrainData function.
+//   - Imported water balance volumes & local evaporation/infiltration
+//     rates made private to each thread for parallel runoff analysis.
+//   - LID drain runon added for one receiving subcatchment at a time.
+//   - Drain inflows to nodes computed from drain flows saved for routing.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -134,6 +138,7 @@ static int        GroupCount;          // number of LID groups (subcatchments)
 static double     EvapRate;            // evaporation rate (ft/s)
 static double     NativeInfil;         // native soil infil. rate (ft/s)
 static double     MaxNativeInfil;      // native soil infil. rate limit (ft/s)
+#pragma omp threadprivate(EvapRate, NativeInfil, MaxNativeInfil)
 
 //-----------------------------------------------------------------------------
 //  Imported Variables (from SUBCATCH.C)
@@ -149,6 +154,8 @@ extern double     VlidDrain;           // drain outflow from LID units
 extern double     VlidReturn;          // LID outflow returned to pervious area
 extern char       HasWetLids;          // TRUE if any LIDs are wet
                                        // (from RUNOFF.C)
+#pragma omp threadprivate(Vevap, Vpevap, Vinfil, VlidInfil, VlidIn, VlidOut, \
+                          VlidDrain, VlidReturn, HasWetLids)
 
 //-----------------------------------------------------------------------------
 //  External Functions (prototyped in lid.h)
@@ -174,7 +181,9 @@ extern char       HasWetLids;          // TRUE if any LIDs are wet
 //  lid_getRunoff            called by subcatch_getRunoff
 
 //  lid_addDrainRunon        called by subcatch_getRunon
+//  lid_getDrainSubcatch     called by runoff_getRunonSources
 //  lid_addDrainLoads        called by surfqual_getWashoff
+//  lid_saveDrainFlows       called by routing_saveRunoff in routing.c
 //  lid_addDrainInflow       called by addLidDrainInflows in routing.c
 
 //  lid_writeSummary         called by inputrpt_writeInput
@@ -1510,16 +1519,16 @@ void  lid_addDrainLoads(int j, double c[], double tStep)
 
 //=============================================================================
 
-void lid_addDrainRunon(int j)
+void lid_addDrainRunon(int j, int k)
 //
-//  Purpose: adds drain flows from LIDs in a given subcatchment to the
-//           subcatchments that were designated to receive them 
+//  Purpose: adds drain flows from LIDs in a given subcatchment to another
+//           subcatchment that was designated to receive them 
 //  Input:   j = index of subcatchment contributing underdrain flows
+//           k = index of subcatchment receiving underdrain flows
 //  Output:  none.
 //
 {
     int i;                   // index of an LID unit's LID process
-    int k;                   // index of subcatchment receiving LID drain flow
     int p;                   // pollutant index
     double q;                // drain flow rate (cfs)
     double w;                // mass of polllutant from drain flow
@@ -1529,17 +1538,16 @@ void lid_addDrainRunon(int j)
 
     //... check if LID group exists
     lidGroup = LidGroups[j];
-    if ( lidGroup != NULL )
+    if ( lidGroup != NULL && k != j )
     {
         //... examine each LID in the group
         lidList = lidGroup->lidList;
         while ( lidList )
         {
-            //... see if LID's drain discharges to another subcatchment
+            //... see if LID's drain discharges to subcatchment k
             lidUnit = lidList->lidUnit;
             i = lidUnit->lidIndex;
-            k = lidUnit->drainSubcatch;
-            if ( k >= 0 && k != j )
+            if ( lidUnit->drainSubcatch == k )
             {
                 //... distribute drain flow across subcatchment's areas
                 q = lidUnit->oldDrainFlow;
@@ -1562,22 +1570,85 @@ void lid_addDrainRunon(int j)
 
 //=============================================================================
 
-void  lid_addDrainInflow(int j, double f)
+int lid_getDrainSubcatch(int j, int n)
+//
+//  Purpose: finds the subcatchment that receives underdrain flow from an
+//           LID unit in a given subcatchment.
+//  Input:   j = subcatchment index
+//           n = position of the LID unit in the subcatchment's LID group
+//  Output:  returns index of subcatchment receiving the unit's drain flow
+//           (or -1 if the unit does not drain to another subcatchment).
+//
+{
+    TLidList*  lidList;
+    TLidGroup  lidGroup;
+
+    lidGroup = LidGroups[j];
+    if ( lidGroup == NULL ) return -1;
+    lidList = lidGroup->lidList;
+    while ( lidList && n > 0 )
+    {
+        lidList = lidList->nextLidUnit;
+        n--;
+    }
+    if ( lidList == NULL ) return -1;
+    if ( lidList->lidUnit->drainSubcatch == j ) return -1;
+    return lidList->lidUnit->drainSubcatch;
+}
+
+//=============================================================================
+
+int  lid_saveDrainFlows(int j, double drainFlow[])
+//
+//  Purpose: saves the drain flows of the LID units in a subcatchment for use
+//           in routing.
+//  Input:   j = subcatchment index
+//  Output:  drainFlow = previous & current drain flow of each LID unit (cfs);
+//           returns the number of LID units in the subcatchment.
+//
+{
+    int        n = 0;        // number of LID units
+    TLidList*  lidList;
+    TLidGroup  lidGroup;
+
+    lidGroup = LidGroups[j];
+    if ( lidGroup == NULL ) return 0;
+    lidList = lidGroup->lidList;
+    while ( lidList )
+    {
+        drainFlow[2*n] = lidList->lidUnit->oldDrainFlow;
+        drainFlow[2*n+1] = lidList->lidUnit->newDrainFlow;
+        n++;
+        lidList = lidList->nextLidUnit;
+    }
+    return n;
+}
+
+//=============================================================================
+
+int  lid_addDrainInflow(int j, double f, double drainFlow[], double qual[])
 //
 //  Purpose: adds LID drain flow to conveyance system nodes 
 //  Input:   j = subcatchment index
 //           f = time interval weighting factor
-//  Output:  none.
+//           drainFlow = previous & current drain flow of each LID unit (cfs)
+//           qual = previous & current runoff quality of the subcatchment
+//  Output:  returns the number of LID units in the subcatchment.
 //
 //  Note:    this function updates the total lateral flow (Node[].newLatFlow)
 //           and pollutant mass (Node[].newQual[]) inflow seen by nodes that
-//           receive drain flow from the LID units in subcatchment j.
+//           receive drain flow from the LID units in subcatchment j, using
+//           the flows and quality saved by lid_saveDrainFlows and
+//           routing_saveRunoff.
 {
     int        i,            // LID process index
                k,            // node index
+               n = 0,        // LID unit index
                p;            // pollutant index
     double     q,            // drain flow (cfs)
                w, w1, w2;    // pollutant mass loads (mass/sec)
+    double*    oldQual = qual;
+    double*    newQual = qual + Nobjects[POLLUT];
     TLidUnit*  lidUnit;
     TLidList*  lidList;
     TLidGroup  lidGroup;
@@ -1597,7 +1668,7 @@ void  lid_addDrainInflow(int j, double f)
             if ( k >= 0 )
             {
                 //... add drain flow to node's wet weather inflow
-                q = (1.0 - f) * lidUnit->oldDrainFlow + f * lidUnit->newDrainFlow;
+                q = (1.0 - f) * drainFlow[2*n] + f * drainFlow[2*n+1];
                 Node[k].newLatFlow += q;
                 massbal_addInflowFlow(WET_WEATHER_INFLOW, q);
 
@@ -1605,8 +1676,8 @@ void  lid_addDrainInflow(int j, double f)
                 for (p = 0; p < Nobjects[POLLUT]; p++)
                 {
                     //... get previous & current drain loads
-                    w1 = lidUnit->oldDrainFlow * Subcatch[j].oldQual[p];
-                    w2 = lidUnit->newDrainFlow * Subcatch[j].newQual[p]; 
+                    w1 = drainFlow[2*n] * oldQual[p];
+                    w2 = drainFlow[2*n+1] * newQual[p]; 
 
                     //... add interpolated load to node's wet weather loading
                     w = (1.0 - f) * w1 + f * w2;
@@ -1615,9 +1686,11 @@ void  lid_addDrainInflow(int j, double f)
                     massbal_addInflowQual(WET_WEATHER_INFLOW, p, w);
                 }
             }
+            n++;
             lidList = lidList->nextLidUnit;
         }
     }
+    return n;
 }
 
 //=============================================================================
@@ -263,8 +263,11 @@ double   lid_getFlowToPerv(int subcatch);
 double   lid_getDrainFlow(int subcatch, int timePeriod);
 double   lid_getStoredVolume(int subcatch);
 void     lid_addDrainLoads(int subcatch, double c[], double tStep);
-void     lid_addDrainRunon(int subcatch);
-void     lid_addDrainInflow(int subcatch, double f);
+void     lid_addDrainRunon(int subcatch, int toSubcatch);
+int      lid_getDrainSubcatch(int subcatch, int unit);
+int      lid_saveDrainFlows(int subcatch, double drainFlow[]);
+int      lid_addDrainInflow(int subcatch, double f, double drainFlow[],
+         double qual[]);
 void     lid_getRunoff(int subcatch, double tStep);
 void     lid_writeSummary(void);
 void     lid_writeWaterBalance(void);
@@ -58,6 +58,9 @@
 //     trenchFluxRates.
 //   - Corrected head calculation in getStorageDrainRate when unit has both
 //     a soil and pavement layer.
+//   - Layer flux & volume variables moved into a work space local to each
+//     call of lidproc_getOutflow, which now also updates the unit's water
+//     balance, so that LID units can be analyzed concurrently.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -102,38 +105,43 @@ enum LidRptVars {
 //  Imported variables 
 //-----------------------------------------------------------------------------
 extern char HasWetLids;      // TRUE if any LIDs are wet (declared in runoff.c)
+#pragma omp threadprivate(HasWetLids)
 
 //-----------------------------------------------------------------------------
-//  Local Variables
+//  Data Structures
 //-----------------------------------------------------------------------------
-static TLidUnit*  theLidUnit;     // ptr. to a subcatchment's LID unit
-static TLidProc*  theLidProc;     // ptr. to a LID process
-
-static double     Tstep;          // current time step (sec)
-static double     EvapRate;       // evaporation rate (ft/s)
-static double     MaxNativeInfil; // native soil infil. rate limit (ft/s)
-
-static double     SurfaceInflow;  // precip. + runon to LID unit (ft/s)
-static double     SurfaceInfil;   // infil. rate from surface layer (ft/s)
-static double     SurfaceEvap;    // evap. rate from surface layer (ft/s)
-static double     SurfaceOutflow; // outflow from surface layer (ft/s)
-static double     SurfaceVolume;  // volume in surface storage (ft)
-
-static double     PaveEvap;       // evap. from pavement layer (ft/s)
-static double     PavePerc;       // percolation from pavement layer (ft/s)
-static double     PaveVolume;     // volume stored in pavement layer  (ft)
-
-static double     SoilEvap;       // evap. from soil layer (ft/s)
-static double     SoilPerc;       // percolation from soil layer (ft/s)
-static double     SoilVolume;     // volume in soil/pavement storage (ft)
-
-static double     StorageInflow;  // inflow rate to storage layer (ft/s)
-static double     StorageExfil;   // exfil. rate from storage layer (ft/s)
-static double     StorageEvap;    // evap.rate from storage layer (ft/s)
-static double     StorageDrain;   // underdrain flow rate layer (ft/s)
-static double     StorageVolume;  // volume in storage layer (ft)
-
-static double     Xold[MAX_LAYERS];  // previous moisture level in LID layers
+// Work space used while computing the performance of a single LID unit
+// (each call to lidproc_getOutflow has its own copy, so LID units can be
+// analyzed concurrently)
+typedef struct
+{
+    TLidUnit*  lidUnit;        // ptr. to a subcatchment's LID unit
+    TLidProc*  lidProc;        // ptr. to a LID process
+
+    double     tStep;          // current time step (sec)
+    double     evapRate;       // evaporation rate (ft/s)
+    double     maxNativeInfil; // native soil infil. rate limit (ft/s)
+
+    double     surfaceInflow;  // precip. + runon to LID unit (ft/s)
+    double     surfaceInfil;   // infil. rate from surface layer (ft/s)
+    double     surfaceEvap;    // evap. rate from surface layer (ft/s)
+    double     surfaceOutflow; // outflow from surface layer (ft/s)
+    double     surfaceVolume;  // volume in surface storage (ft)
+
+    double     paveEvap;       // evap. from pavement layer (ft/s)
+    double     pavePerc;       // percolation from pavement layer (ft/s)
+    double     paveVolume;     // volume stored in pavement layer  (ft)
+
+    double     soilEvap;       // evap. from soil layer (ft/s)
+    double     soilPerc;       // percolation from soil layer (ft/s)
+    double     soilVolume;     // volume in soil/pavement storage (ft)
+
+    double     storageInflow;  // inflow rate to storage layer (ft/s)
+    double     storageExfil;   // exfil. rate from storage layer (ft/s)
+    double     storageEvap;    // evap.rate from storage layer (ft/s)
+    double     storageDrain;   // underdrain flow rate layer (ft/s)
+    double     storageVolume;  // volume in storage layer (ft)
+}  TLidWork;
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in lid.h)
@@ -146,28 +154,29 @@ static double     Xold[MAX_LAYERS];  // previous moisture level in LID layers
 //-----------------------------------------------------------------------------
 // Local Functions
 //-----------------------------------------------------------------------------
-static void   barrelFluxRates(double x[], double f[]);
-static void   biocellFluxRates(double x[], double f[]);
-static void   greenRoofFluxRates(double x[], double f[]);
-static void   pavementFluxRates(double x[], double f[]);
-static void   trenchFluxRates(double x[], double f[]);
-static void   swaleFluxRates(double x[], double f[]);
-static void   roofFluxRates(double x[], double f[]);
-
-static double getSurfaceOutflowRate(double depth);
-static double getSurfaceOverflowRate(double* surfaceDepth);
-static double getPavementPermRate(void);
-static double getSoilPercRate(double theta);
-static double getStorageExfilRate(void);
-static double getStorageDrainRate(double storageDepth, double soilTheta,
-              double paveDepth, double surfaceDepth);
-static double getDrainMatOutflow(double depth);
-static void   getEvapRates(double surfaceVol, double paveVol,
+static void   barrelFluxRates(TLidWork* w, double x[], double f[]);
+static void   biocellFluxRates(TLidWork* w, double x[], double f[]);
+static void   greenRoofFluxRates(TLidWork* w, double x[], double f[]);
+static void   pavementFluxRates(TLidWork* w, double x[], double f[]);
+static void   trenchFluxRates(TLidWork* w, double x[], double f[]);
+static void   swaleFluxRates(TLidWork* w, double x[], double f[]);
+static void   roofFluxRates(TLidWork* w, double x[], double f[]);
+
+static double getSurfaceOutflowRate(TLidWork* w, double depth);
+static double getSurfaceOverflowRate(TLidWork* w, double* surfaceDepth);
+static double getPavementPermRate(TLidWork* w);
+static double getSoilPercRate(TLidWork* w, double theta);
+static double getStorageExfilRate(TLidWork* w);
+static double getStorageDrainRate(TLidWork* w, double storageDepth,
+              double soilTheta, double paveDepth, double surfaceDepth);
+static double getDrainMatOutflow(TLidWork* w, double depth);
+static void   getEvapRates(TLidWork* w, double surfaceVol, double paveVol,
               double soilVol, double storageVol, double pervFrac);
 
 static void   updateWaterBalance(TLidUnit *lidUnit, double inflow,
                                  double evap, double infil, double surfFlow,
-                                 double drainFlow, double storage);
+                                 double drainFlow, double storage,
+                                 double tStep);
 
 // OWA EDIT ##################################################################################
 // function to store additional data variables used to compute the water balance of LID Units.
@@ -178,10 +187,11 @@ static void updateWaterRate(TLidUnit *lidUnit, double evap, double maxNativeInfi
                             double storageExfil, double storageEvap, double storageDrain);
 // ###########################################################################################
 
-static int    modpuls_solve(int n, double* x, double* xOld, double* xPrev,
-                            double* xMin, double* xMax, double* xTol,
-                            double* qOld, double* q, double dt, double omega,
-                            void (*derivs)(double*, double*));
+static int    modpuls_solve(TLidWork* w, int n, double* x, double* xOld,
+                            double* xPrev, double* xMin, double* xMax,
+                            double* xTol, double* qOld, double* q, double dt,
+                            double omega,
+                            void (*derivs)(TLidWork*, double*, double*));
 
 //=============================================================================
 
@@ -264,83 +274,88 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
     double xTol[MAX_LAYERS] = {STOPTOL, STOPTOL, STOPTOL, STOPTOL};
 
     double omega = 0.0;          // integration time weighting
+    double totalEvap;            // total evaporation rate (ft/s)
+    double totalVolume;          // total volume stored in LID (ft)
+
+    //... work space for the flux rate functions
+    TLidWork  work;
+    TLidWork* w = &work;
 
     //... define a pointer to function that computes flux rates through the LID
-    void (*fluxRates) (double *, double *) = NULL;
+    void (*fluxRates) (TLidWork *, double *, double *) = NULL;
 
     //... save references to the LID process and LID unit
-    theLidProc = lidProc;
-    theLidUnit = lidUnit;
+    w->lidProc = lidProc;
+    w->lidUnit = lidUnit;
 
-    //... save evap, max. infil. & time step to shared variables
-    EvapRate = evap;
-    MaxNativeInfil = maxInfil;
-    Tstep = tStep;
+    //... save evap, max. infil. & time step to work space
+    w->evapRate = evap;
+    w->maxNativeInfil = maxInfil;
+    w->tStep = tStep;
 
     //... store current moisture levels in vector x
-    x[SURF] = theLidUnit->surfaceDepth;
-    x[SOIL] = theLidUnit->soilMoisture;
-    x[STOR] = theLidUnit->storageDepth;
-    x[PAVE] = theLidUnit->paveDepth;
+    x[SURF] = w->lidUnit->surfaceDepth;
+    x[SOIL] = w->lidUnit->soilMoisture;
+    x[STOR] = w->lidUnit->storageDepth;
+    x[PAVE] = w->lidUnit->paveDepth;
 
     //... initialize layer moisture volumes, flux rates and moisture limits
-    SurfaceVolume  = 0.0;
-    PaveVolume     = 0.0;
-    SoilVolume     = 0.0;
-    StorageVolume  = 0.0;
-    SurfaceInflow  = inflow;
-    SurfaceInfil   = 0.0;
-    SurfaceEvap    = 0.0;
-    SurfaceOutflow = 0.0;
-    PaveEvap       = 0.0;
-    PavePerc       = 0.0;
-    SoilEvap       = 0.0;
-    SoilPerc       = 0.0;
-    StorageInflow  = 0.0;
-    StorageExfil   = 0.0;
-    StorageEvap    = 0.0;
-    StorageDrain   = 0.0;
+    w->surfaceVolume  = 0.0;
+    w->paveVolume     = 0.0;
+    w->soilVolume     = 0.0;
+    w->storageVolume  = 0.0;
+    w->surfaceInflow  = inflow;
+    w->surfaceInfil   = 0.0;
+    w->surfaceEvap    = 0.0;
+    w->surfaceOutflow = 0.0;
+    w->paveEvap       = 0.0;
+    w->pavePerc       = 0.0;
+    w->soilEvap       = 0.0;
+    w->soilPerc       = 0.0;
+    w->storageInflow  = 0.0;
+    w->storageExfil   = 0.0;
+    w->storageEvap    = 0.0;
+    w->storageDrain   = 0.0;
     for (i = 0; i < MAX_LAYERS; i++)
     {
         f[i] = 0.0;
-        fOld[i] = theLidUnit->oldFluxRates[i];
+        fOld[i] = w->lidUnit->oldFluxRates[i];
         xMin[i] = 0.0;
         xMax[i] = BIG;
-        Xold[i] = x[i];
     }
 
     //... find Green-Ampt infiltration from surface layer
-    if ( theLidProc->lidType == POROUS_PAVEMENT ) SurfaceInfil = 0.0;
-    else if ( theLidUnit->soilInfil.Ks > 0.0 )
+    if ( w->lidProc->lidType == POROUS_PAVEMENT ) w->surfaceInfil = 0.0;
+    else if ( w->lidUnit->soilInfil.Ks > 0.0 )
     {
-        SurfaceInfil =
-            grnampt_getInfil(&theLidUnit->soilInfil, Tstep,
-                             SurfaceInflow, theLidUnit->surfaceDepth,
+        w->surfaceInfil =
+            grnampt_getInfil(&w->lidUnit->soilInfil, w->tStep,
+                             w->surfaceInflow, w->lidUnit->surfaceDepth,
                              MOD_GREEN_AMPT);
     }
-    else SurfaceInfil = infil;
+    else w->surfaceInfil = infil;
 
     //... set moisture limits for soil & storage layers
-    if ( theLidProc->soil.thickness > 0.0 )
+    if ( w->lidProc->soil.thickness > 0.0 )
     {
-        xMin[SOIL] = theLidProc->soil.wiltPoint;
-        xMax[SOIL] = theLidProc->soil.porosity;
+        xMin[SOIL] = w->lidProc->soil.wiltPoint;
+        xMax[SOIL] = w->lidProc->soil.porosity;
     }
-    if ( theLidProc->pavement.thickness > 0.0 )
+    if ( w->lidProc->pavement.thickness > 0.0 )
     {
-        xMax[PAVE] = theLidProc->pavement.thickness;
+        xMax[PAVE] = w->lidProc->pavement.thickness;
     }
-    if ( theLidProc->storage.thickness > 0.0 )
+    if ( w->lidProc->storage.thickness > 0.0 )
     {
-        xMax[STOR] = theLidProc->storage.thickness;
+        xMax[STOR] = w->lidProc->storage.thickness;
     }
-    if ( theLidProc->lidType == GREEN_ROOF )
+    if ( w->lidProc->lidType == GREEN_ROOF )
     {
-        xMax[STOR] = theLidProc->drainMat.thickness;
+        xMax[STOR] = w->lidProc->drainMat.thickness;
     }
 
     //... determine which flux rate function to use
-    switch (theLidProc->lidType)
+    switch (w->lidProc->lidType)
     {
     case BIO_CELL:
     case RAIN_GARDEN:     fluxRates = &biocellFluxRates;   break;
@@ -356,7 +371,7 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
     }
 
     //... update moisture levels and flux rates over the time step
-    i = modpuls_solve(MAX_LAYERS, x, xOld, xPrev, xMin, xMax, xTol,
+    i = modpuls_solve(w, MAX_LAYERS, x, xOld, xPrev, xMin, xMax, xTol,
                      fOld, f, tStep, omega, fluxRates);
 
 /** For debugging only ********************************************
@@ -367,74 +382,83 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
             theDate, theTime);
         fprintf(Frpt.file,
         "\n              for LID %s placed in subcatchment %s.",
-            theLidProc->ID, theSubcatch->ID);
+            w->lidProc->ID, theSubcatch->ID);
     }
 *******************************************************************/
 
     //... add any surface overflow to surface outflow
-    if ( theLidProc->surface.canOverflow || theLidUnit->fullWidth == 0.0 )
+    if ( w->lidProc->surface.canOverflow || w->lidUnit->fullWidth == 0.0 )
     {
-        SurfaceOutflow += getSurfaceOverflowRate(&x[SURF]);
+        w->surfaceOutflow += getSurfaceOverflowRate(w, &x[SURF]);
     }
 
     //... save updated results
-    theLidUnit->surfaceDepth = x[SURF];
-    theLidUnit->paveDepth    = x[PAVE];
-    theLidUnit->soilMoisture = x[SOIL];
-    theLidUnit->storageDepth = x[STOR];
-    for (i = 0; i < MAX_LAYERS; i++) theLidUnit->oldFluxRates[i] = f[i];
+    w->lidUnit->surfaceDepth = x[SURF];
+    w->lidUnit->paveDepth    = x[PAVE];
+    w->lidUnit->soilMoisture = x[SOIL];
+    w->lidUnit->storageDepth = x[STOR];
+    for (i = 0; i < MAX_LAYERS; i++) w->lidUnit->oldFluxRates[i] = f[i];
+
+    //... find total evap. rate and stored volume
+    totalEvap = w->surfaceEvap + w->paveEvap + w->soilEvap + w->storageEvap;
+    totalVolume = w->surfaceVolume + w->paveVolume + w->soilVolume +
+                  w->storageVolume;
+
+    //... update mass balance totals
+    updateWaterBalance(lidUnit, w->surfaceInflow, totalEvap, w->storageExfil,
+                       w->surfaceOutflow, w->storageDrain, totalVolume, tStep);
+
+    // OWA EDIT ###############################################################
+    //... update water rate structs
+    updateWaterRate(lidUnit, w->evapRate, w->maxNativeInfil, w->surfaceInflow,
+                    w->surfaceInfil, w->surfaceEvap, w->surfaceOutflow,
+                    w->paveEvap, w->pavePerc, w->soilEvap, w->soilPerc,
+                    w->storageInflow, w->storageExfil, w->storageEvap,
+                    w->storageDrain);
+    // ########################################################################
 
     //... assign values to LID unit evaporation, infiltration & drain flow
-    *lidEvap = SurfaceEvap + PaveEvap + SoilEvap + StorageEvap;
-    *lidInfil = StorageExfil;
-    *lidDrain = StorageDrain;
+    *lidEvap = totalEvap;
+    *lidInfil = w->storageExfil;
+    *lidDrain = w->storageDrain;
 
     //... return surface outflow (per unit area) from unit
-    return SurfaceOutflow;
+    return w->surfaceOutflow;
 }
 
 //=============================================================================
 
 void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDepth)
 //
-//  Purpose: updates the mass balance for an LID unit and saves
+//  Purpose: updates the wet/dry status of an LID unit and saves its
 //           current flux rates to the LID report file.
 //  Input:   lidUnit = ptr. to LID unit
 //           ucfRainfall = units conversion factor for rainfall rate
 //           ucfDepth = units conversion factor for rainfall depth
 //  Output:  none
 //
+//  Note:    uses the flux rates saved to the unit's waterRate structure
+//           by the last call to lidproc_getOutflow.
+//
 {
     double ucf;                        // units conversion factor
     double totalEvap;                  // total evaporation rate (ft/s)
-    double totalVolume;                // total volume stored in LID (ft)
     double rptVars[MAX_RPT_VARS];      // array of reporting variables
     int    isDry = FALSE;              // true if current state of LID is dry
     char   timeStamp[TIME_STAMP_SIZE + 1]; // date/time stamp
     double elapsedHrs;                 // elapsed hours
+    TWaterRate* rate = &lidUnit->waterRate;
 
-    //... find total evap. rate and stored volume
-    totalEvap = SurfaceEvap + PaveEvap + SoilEvap + StorageEvap; 
-    totalVolume = SurfaceVolume + PaveVolume + SoilVolume + StorageVolume;
-
-    //... update mass balance totals
-    updateWaterBalance(theLidUnit, SurfaceInflow, totalEvap, StorageExfil,
-                       SurfaceOutflow, StorageDrain, totalVolume);
-    
-    // OWA EDIT ###############################################################
-    //... update water rate structs
-    updateWaterRate(theLidUnit, EvapRate, MaxNativeInfil, SurfaceInflow, 
-                    SurfaceInfil, SurfaceEvap, SurfaceOutflow, PaveEvap, 
-                    PavePerc, SoilEvap, SoilPerc, StorageInflow, StorageExfil,
-                    StorageEvap, StorageDrain);
-    // ########################################################################
+    //... find total evap. rate
+    totalEvap = rate->surfaceEvap + rate->paveEvap + rate->soilEvap +
+                rate->storageEvap;
 
     //... check if dry-weather conditions hold
-    if ( SurfaceInflow  < MINFLOW &&
-         SurfaceOutflow < MINFLOW &&
-         StorageDrain   < MINFLOW &&
-         StorageExfil   < MINFLOW &&
-         totalEvap      < MINFLOW
+    if ( rate->surfaceInflow  < MINFLOW &&
+         rate->surfaceOutflow < MINFLOW &&
+         rate->storageDrain   < MINFLOW &&
+         rate->storageExfil   < MINFLOW &&
+         totalEvap            < MINFLOW
        ) isDry = TRUE;
 
     //... update status of HasWetLids
@@ -445,29 +469,29 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
     {
         //... convert rate results to original units (in/hr or mm/hr)
         ucf = ucfRainfall;
-        rptVars[SURF_INFLOW]  = SurfaceInflow*ucf;
+        rptVars[SURF_INFLOW]  = rate->surfaceInflow*ucf;
         rptVars[TOTAL_EVAP]   = totalEvap*ucf;
-        rptVars[SURF_INFIL]   = SurfaceInfil*ucf;
-        rptVars[PAVE_PERC]    = PavePerc*ucf;
-        rptVars[SOIL_PERC]    = SoilPerc*ucf;
-        rptVars[STOR_EXFIL]   = StorageExfil*ucf;
-        rptVars[SURF_OUTFLOW] = SurfaceOutflow*ucf;
-        rptVars[STOR_DRAIN]   = StorageDrain*ucf;
+        rptVars[SURF_INFIL]   = rate->surfaceInfil*ucf;
+        rptVars[PAVE_PERC]    = rate->pavePerc*ucf;
+        rptVars[SOIL_PERC]    = rate->soilPerc*ucf;
+        rptVars[STOR_EXFIL]   = rate->storageExfil*ucf;
+        rptVars[SURF_OUTFLOW] = rate->surfaceOutflow*ucf;
+        rptVars[STOR_DRAIN]   = rate->storageDrain*ucf;
 
         //... convert storage results to original units (in or mm)
         ucf = ucfRainDepth;
-        rptVars[SURF_DEPTH] = theLidUnit->surfaceDepth*ucf;
-        rptVars[PAVE_DEPTH] = theLidUnit->paveDepth*ucf;
-        rptVars[SOIL_MOIST] = theLidUnit->soilMoisture;
-        rptVars[STOR_DEPTH] = theLidUnit->storageDepth*ucf;
+        rptVars[SURF_DEPTH] = lidUnit->surfaceDepth*ucf;
+        rptVars[PAVE_DEPTH] = lidUnit->paveDepth*ucf;
+        rptVars[SOIL_MOIST] = lidUnit->soilMoisture;
+        rptVars[STOR_DEPTH] = lidUnit->storageDepth*ucf;
 
         //... if the current LID state is wet but the previous state was dry
         //    for more than one period then write the saved previous results
         //    to the report file thus marking the end of a dry period
-        if ( !isDry && theLidUnit->rptFile->wasDry > 1)
+        if ( !isDry && lidUnit->rptFile->wasDry > 1)
         {
-            fprintf(theLidUnit->rptFile->file, "%s",
-                theLidUnit->rptFile->results);
+            fprintf(lidUnit->rptFile->file, "%s",
+                lidUnit->rptFile->results);
         }
 
         //... write the current results to a string which is saved between
@@ -475,7 +499,7 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
         elapsedHrs = NewRunoffTime / 1000.0 / 3600.0;
         datetime_getTimeStamp(
             M_D_Y, getDateTime(NewRunoffTime), TIME_STAMP_SIZE, timeStamp);
-        snprintf(theLidUnit->rptFile->results, sizeof(theLidUnit->rptFile->results),
+        snprintf(lidUnit->rptFile->results, sizeof(lidUnit->rptFile->results),
              "\n%20s\t %8.3f\t %8.3f\t %8.4f\t %8.3f\t %8.3f\t %8.3f\t %8.3f\t"
              "%8.3f\t %8.3f\t %8.3f\t %8.3f\t %8.3f\t %8.3f",
              timeStamp, elapsedHrs, rptVars[0], rptVars[1], rptVars[2],
@@ -487,32 +511,32 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
         {
             //... if the previous state was wet then write the current
             //    results to file marking the start of a dry period
-            if ( theLidUnit->rptFile->wasDry == 0 )
+            if ( lidUnit->rptFile->wasDry == 0 )
             {
-                fprintf(theLidUnit->rptFile->file, "%s",
-                    theLidUnit->rptFile->results);
+                fprintf(lidUnit->rptFile->file, "%s",
+                    lidUnit->rptFile->results);
             }
 
             //... increment the number of successive dry periods
-            theLidUnit->rptFile->wasDry++;
+            lidUnit->rptFile->wasDry++;
         }
 
         //... if the current LID state is wet
         else
         {
             //... write the current results to the report file
-            fprintf(theLidUnit->rptFile->file, "%s",
-                theLidUnit->rptFile->results);
+            fprintf(lidUnit->rptFile->file, "%s",
+                lidUnit->rptFile->results);
 
             //... re-set the number of successive dry periods to 0
-            theLidUnit->rptFile->wasDry = 0; 
+            lidUnit->rptFile->wasDry = 0; 
         }
     }
 }
 
 //=============================================================================
 
-void roofFluxRates(double x[], double f[])
+void roofFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates for roof disconnection.
 //  Input:   x = vector of storage levels
@@ -521,20 +545,22 @@ void roofFluxRates(double x[], double f[])
 {
     double surfaceDepth = x[SURF];
 
-    getEvapRates(surfaceDepth, 0.0, 0.0, 0.0, 1.0);
-    SurfaceVolume = surfaceDepth;
-    SurfaceInfil = 0.0;
-    if ( theLidProc->surface.alpha > 0.0 )
-      SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
-    else getSurfaceOverflowRate(&surfaceDepth);
-    StorageDrain = MIN(theLidProc->drain.coeff/UCF(RAINFALL), SurfaceOutflow);
-    SurfaceOutflow -= StorageDrain;
-    f[SURF] = (SurfaceInflow - SurfaceEvap - StorageDrain - SurfaceOutflow);
+    getEvapRates(w, surfaceDepth, 0.0, 0.0, 0.0, 1.0);
+    w->surfaceVolume = surfaceDepth;
+    w->surfaceInfil = 0.0;
+    if ( w->lidProc->surface.alpha > 0.0 )
+      w->surfaceOutflow = getSurfaceOutflowRate(w, surfaceDepth);
+    else getSurfaceOverflowRate(w, &surfaceDepth);
+    w->storageDrain = MIN(w->lidProc->drain.coeff/UCF(RAINFALL),
+                          w->surfaceOutflow);
+    w->surfaceOutflow -= w->storageDrain;
+    f[SURF] = (w->surfaceInflow - w->surfaceEvap - w->storageDrain -
+               w->surfaceOutflow);
 }
 
 //=============================================================================
 
-void greenRoofFluxRates(double x[], double f[])
+void greenRoofFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates from the layers of a green roof.
 //  Input:   x = vector of storage levels
@@ -551,12 +577,12 @@ void greenRoofFluxRates(double x[], double f[])
     double maxRate;
 
     // Green roof properties
-    double soilThickness    = theLidProc->soil.thickness;
-    double storageThickness = theLidProc->storage.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double storageVoidFrac  = theLidProc->storage.voidFrac;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double soilWiltPoint    = theLidProc->soil.wiltPoint;
+    double soilThickness    = w->lidProc->soil.thickness;
+    double storageThickness = w->lidProc->storage.thickness;
+    double soilPorosity     = w->lidProc->soil.porosity;
+    double storageVoidFrac  = w->lidProc->storage.voidFrac;
+    double soilFieldCap     = w->lidProc->soil.fieldCap;
+    double soilWiltPoint    = w->lidProc->soil.wiltPoint;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
@@ -564,75 +590,75 @@ void greenRoofFluxRates(double x[], double f[])
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    SoilVolume = soilTheta * soilThickness;
-    StorageVolume = storageDepth * storageVoidFrac;
+    w->surfaceVolume = surfaceDepth * w->lidProc->surface.voidFrac;
+    w->soilVolume = soilTheta * soilThickness;
+    w->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
-    availVolume = SoilVolume - soilWiltPoint * soilThickness;
-    getEvapRates(SurfaceVolume, 0.0, availVolume, StorageVolume, 1.0);
-    if ( soilTheta >= soilPorosity ) StorageEvap = 0.0;
+    availVolume = w->soilVolume - soilWiltPoint * soilThickness;
+    getEvapRates(w, w->surfaceVolume, 0.0, availVolume, w->storageVolume, 1.0);
+    if ( soilTheta >= soilPorosity ) w->storageEvap = 0.0;
 
     //... soil layer perc rate
-    SoilPerc = getSoilPercRate(soilTheta);
+    w->soilPerc = getSoilPercRate(w, soilTheta);
 
     //... limit perc rate by available water
     availVolume = (soilTheta - soilFieldCap) * soilThickness;
-    maxRate = MAX(availVolume, 0.0) / Tstep - SoilEvap;
-    SoilPerc = MIN(SoilPerc, maxRate);
-    SoilPerc = MAX(SoilPerc, 0.0);
+    maxRate = MAX(availVolume, 0.0) / w->tStep - w->soilEvap;
+    w->soilPerc = MIN(w->soilPerc, maxRate);
+    w->soilPerc = MAX(w->soilPerc, 0.0);
 
     //... storage (drain mat) outflow rate
-    StorageExfil = 0.0;
-    StorageDrain = getDrainMatOutflow(storageDepth);
+    w->storageExfil = 0.0;
+    w->storageDrain = getDrainMatOutflow(w, storageDepth);
 
     //... unit is full
     if ( soilTheta >= soilPorosity && storageDepth >= storageThickness )
     {
         //... outflow from both layers equals limiting rate
-        maxRate = MIN(SoilPerc, StorageDrain);
-        SoilPerc = maxRate;
-        StorageDrain = maxRate;
+        maxRate = MIN(w->soilPerc, w->storageDrain);
+        w->soilPerc = maxRate;
+        w->storageDrain = maxRate;
 
         //... adjust inflow rate to soil layer
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
     }
 
     //... unit not full
     else
     {
         //... limit drainmat outflow by available storage volume
-        maxRate = storageDepth * storageVoidFrac / Tstep - StorageEvap;
-        if ( storageDepth >= storageThickness ) maxRate += SoilPerc;
+        maxRate = storageDepth * storageVoidFrac / w->tStep - w->storageEvap;
+        if ( storageDepth >= storageThickness ) maxRate += w->soilPerc;
         maxRate = MAX(maxRate, 0.0);
-        StorageDrain = MIN(StorageDrain, maxRate);
+        w->storageDrain = MIN(w->storageDrain, maxRate);
 
         //... limit soil perc inflow by unused storage volume
-        maxRate = (storageThickness - storageDepth) * storageVoidFrac / Tstep +
-                  StorageDrain + StorageEvap;
-        SoilPerc = MIN(SoilPerc, maxRate);
+        maxRate = (storageThickness - storageDepth) * storageVoidFrac /
+                  w->tStep + w->storageDrain + w->storageEvap;
+        w->soilPerc = MIN(w->soilPerc, maxRate);
                 
         //... adjust surface infil. so soil porosity not exceeded
-        maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                  SoilPerc + SoilEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = (soilPorosity - soilTheta) * soilThickness / w->tStep +
+                  w->soilPerc + w->soilEvap;
+        w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
     }
 
     // ... find surface outflow rate
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    w->surfaceOutflow = getSurfaceOutflowRate(w, surfaceDepth);
 
     // ... compute overall layer flux rates
-    f[SURF] = (SurfaceInflow - SurfaceEvap - SurfaceInfil - SurfaceOutflow) /
-              theLidProc->surface.voidFrac;
-    f[SOIL] = (SurfaceInfil - SoilEvap - SoilPerc) /
-              theLidProc->soil.thickness;
-    f[STOR] = (SoilPerc - StorageEvap - StorageDrain) /
-              theLidProc->storage.voidFrac;
+    f[SURF] = (w->surfaceInflow - w->surfaceEvap - w->surfaceInfil -
+               w->surfaceOutflow) / w->lidProc->surface.voidFrac;
+    f[SOIL] = (w->surfaceInfil - w->soilEvap - w->soilPerc) /
+              w->lidProc->soil.thickness;
+    f[STOR] = (w->soilPerc - w->storageEvap - w->storageDrain) /
+              w->lidProc->storage.voidFrac;
 }
 
 //=============================================================================
 
-void biocellFluxRates(double x[], double f[])
+void biocellFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates from the layers of a bio-retention cell LID.
 //  Input:   x = vector of storage levels
@@ -649,12 +675,12 @@ void biocellFluxRates(double x[], double f[])
     double maxRate;
 
     // LID layer properties
-    double soilThickness    = theLidProc->soil.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double soilWiltPoint    = theLidProc->soil.wiltPoint;
-    double storageThickness = theLidProc->storage.thickness;
-    double storageVoidFrac  = theLidProc->storage.voidFrac;
+    double soilThickness    = w->lidProc->soil.thickness;
+    double soilPorosity     = w->lidProc->soil.porosity;
+    double soilFieldCap     = w->lidProc->soil.fieldCap;
+    double soilWiltPoint    = w->lidProc->soil.wiltPoint;
+    double storageThickness = w->lidProc->storage.thickness;
+    double storageVoidFrac  = w->lidProc->storage.voidFrac;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
@@ -662,47 +688,47 @@ void biocellFluxRates(double x[], double f[])
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    SoilVolume    = soilTheta * soilThickness;
-    StorageVolume = storageDepth * storageVoidFrac;
+    w->surfaceVolume = surfaceDepth * w->lidProc->surface.voidFrac;
+    w->soilVolume    = soilTheta * soilThickness;
+    w->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
-    availVolume = SoilVolume - soilWiltPoint * soilThickness;
-    getEvapRates(SurfaceVolume, 0.0, availVolume, StorageVolume, 1.0);
-    if ( soilTheta >= soilPorosity ) StorageEvap = 0.0;
+    availVolume = w->soilVolume - soilWiltPoint * soilThickness;
+    getEvapRates(w, w->surfaceVolume, 0.0, availVolume, w->storageVolume, 1.0);
+    if ( soilTheta >= soilPorosity ) w->storageEvap = 0.0;
 
     //... soil layer perc rate
-    SoilPerc = getSoilPercRate(soilTheta);
+    w->soilPerc = getSoilPercRate(w, soilTheta);
 
     //... limit perc rate by available water
     availVolume =  (soilTheta - soilFieldCap) * soilThickness;
-    maxRate = MAX(availVolume, 0.0) / Tstep - SoilEvap;
-    SoilPerc = MIN(SoilPerc, maxRate);
-    SoilPerc = MAX(SoilPerc, 0.0);
+    maxRate = MAX(availVolume, 0.0) / w->tStep - w->soilEvap;
+    w->soilPerc = MIN(w->soilPerc, maxRate);
+    w->soilPerc = MAX(w->soilPerc, 0.0);
 
     //... exfiltration rate out of storage layer
-    StorageExfil = getStorageExfilRate();
+    w->storageExfil = getStorageExfilRate(w);
 
     //... underdrain flow rate
-    StorageDrain = 0.0;
-    if ( theLidProc->drain.coeff > 0.0 )
+    w->storageDrain = 0.0;
+    if ( w->lidProc->drain.coeff > 0.0 )
     {
-        StorageDrain = getStorageDrainRate(storageDepth, soilTheta, 0.0,
+        w->storageDrain = getStorageDrainRate(w, storageDepth, soilTheta, 0.0,
                                            surfaceDepth);
     }
 
     //... special case of no storage layer present
     if ( storageThickness == 0.0 )
     {
-        StorageEvap = 0.0;
-        maxRate = MIN(SoilPerc, StorageExfil);
-        SoilPerc = maxRate;
-        StorageExfil = maxRate;
+        w->storageEvap = 0.0;
+        maxRate = MIN(w->soilPerc, w->storageExfil);
+        w->soilPerc = maxRate;
+        w->storageExfil = maxRate;
 
         //... limit surface infil. by unused soil volume
-        maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                  SoilPerc + SoilEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = (soilPorosity - soilTheta) * soilThickness / w->tStep +
+                  w->soilPerc + w->soilEvap;
+        w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
     }
 
     else
@@ -711,74 +737,76 @@ void biocellFluxRates(double x[], double f[])
         if ( soilTheta >= soilPorosity && storageDepth >= storageThickness )
         {
             //... limiting rate is smaller of soil perc and storage outflow
-            maxRate = StorageExfil + StorageDrain;
-            if ( SoilPerc < maxRate )
+            maxRate = w->storageExfil + w->storageDrain;
+            if ( w->soilPerc < maxRate )
             {
-                maxRate = SoilPerc;
-                if ( maxRate > StorageExfil ) StorageDrain = maxRate - StorageExfil;
+                maxRate = w->soilPerc;
+                if ( maxRate > w->storageExfil )
+                    w->storageDrain = maxRate - w->storageExfil;
                 else
                 {
-                    StorageExfil = maxRate;
-                    StorageDrain = 0.0;
+                    w->storageExfil = maxRate;
+                    w->storageDrain = 0.0;
                 }
             }
-            else SoilPerc = maxRate;
+            else w->soilPerc = maxRate;
 
             //... apply limiting rate to surface infil.
-            SurfaceInfil = MIN(SurfaceInfil, maxRate);
+            w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
         }
 
         //... either layer not full
         else
         {
             //... limit storage exfiltration by available storage volume
-            maxRate = SoilPerc - StorageEvap + storageDepth*storageVoidFrac/Tstep;
-            StorageExfil = MIN(StorageExfil, maxRate);
-            StorageExfil = MAX(StorageExfil, 0.0);
+            maxRate = w->soilPerc - w->storageEvap +
+                      storageDepth*storageVoidFrac/w->tStep;
+            w->storageExfil = MIN(w->storageExfil, maxRate);
+            w->storageExfil = MAX(w->storageExfil, 0.0);
 
             //... limit underdrain flow by volume above drain offset
-            if ( StorageDrain > 0.0 )
+            if ( w->storageDrain > 0.0 )
             {
-                maxRate = -StorageExfil - StorageEvap;
-                if ( storageDepth >= storageThickness) maxRate += SoilPerc;
-                if ( theLidProc->drain.offset <= storageDepth )
+                maxRate = -w->storageExfil - w->storageEvap;
+                if ( storageDepth >= storageThickness) maxRate += w->soilPerc;
+                if ( w->lidProc->drain.offset <= storageDepth )
                 {
-                    maxRate += (storageDepth - theLidProc->drain.offset) *
-                               storageVoidFrac/Tstep;
+                    maxRate += (storageDepth - w->lidProc->drain.offset) *
+                               storageVoidFrac/w->tStep;
                 }
                 maxRate = MAX(maxRate, 0.0);
-                StorageDrain = MIN(StorageDrain, maxRate);
+                w->storageDrain = MIN(w->storageDrain, maxRate);
             }
         
             //... limit soil perc by unused storage volume
-            maxRate = StorageExfil + StorageDrain + StorageEvap +
+            maxRate = w->storageExfil + w->storageDrain + w->storageEvap +
                       (storageThickness - storageDepth) *
-                      storageVoidFrac/Tstep;
-            SoilPerc = MIN(SoilPerc, maxRate);
+                      storageVoidFrac/w->tStep;
+            w->soilPerc = MIN(w->soilPerc, maxRate);
 
             //... limit surface infil. by unused soil volume
-            maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                      SoilPerc + SoilEvap;
-            SurfaceInfil = MIN(SurfaceInfil, maxRate);
+            maxRate = (soilPorosity - soilTheta) * soilThickness / w->tStep +
+                      w->soilPerc + w->soilEvap;
+            w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
         }
     }
     
     //... find surface layer outflow rate
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    w->surfaceOutflow = getSurfaceOutflowRate(w, surfaceDepth);
 
     //... compute overall layer flux rates
-    f[SURF] = (SurfaceInflow - SurfaceEvap - SurfaceInfil - SurfaceOutflow) /
-              theLidProc->surface.voidFrac;
-    f[SOIL] = (SurfaceInfil - SoilEvap - SoilPerc) / 
-              theLidProc->soil.thickness;
+    f[SURF] = (w->surfaceInflow - w->surfaceEvap - w->surfaceInfil -
+               w->surfaceOutflow) / w->lidProc->surface.voidFrac;
+    f[SOIL] = (w->surfaceInfil - w->soilEvap - w->soilPerc) / 
+              w->lidProc->soil.thickness;
     if ( storageThickness == 0.0 ) f[STOR] = 0.0;
-    else f[STOR] = (SoilPerc - StorageEvap - StorageExfil - StorageDrain) /
-                   theLidProc->storage.voidFrac;
+    else f[STOR] = (w->soilPerc - w->storageEvap - w->storageExfil -
+                    w->storageDrain) / w->lidProc->storage.voidFrac;
 }
 
 //=============================================================================
 
-void trenchFluxRates(double x[], double f[])
+void trenchFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates from the layers of an infiltration trench LID.
 //  Input:   x = vector of storage levels
@@ -794,79 +822,81 @@ void trenchFluxRates(double x[], double f[])
     double maxRate;
 
     // Storage layer properties
-    double storageThickness = theLidProc->storage.thickness;
-    double storageVoidFrac = theLidProc->storage.voidFrac;
+    double storageThickness = w->lidProc->storage.thickness;
+    double storageVoidFrac = w->lidProc->storage.voidFrac;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    SoilVolume = 0.0;
-    StorageVolume = storageDepth * storageVoidFrac;
+    w->surfaceVolume = surfaceDepth * w->lidProc->surface.voidFrac;
+    w->soilVolume = 0.0;
+    w->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
     availVolume = (storageThickness - storageDepth) * storageVoidFrac;
-    getEvapRates(SurfaceVolume, 0.0, 0.0, StorageVolume, 1.0);
+    getEvapRates(w, w->surfaceVolume, 0.0, 0.0, w->storageVolume, 1.0);
 
     //... no storage evap if surface ponded
-    if ( surfaceDepth > 0.0 ) StorageEvap = 0.0;
+    if ( surfaceDepth > 0.0 ) w->storageEvap = 0.0;
 
     //... nominal storage inflow
-    StorageInflow = SurfaceInflow + SurfaceVolume / Tstep;
+    w->storageInflow = w->surfaceInflow + w->surfaceVolume / w->tStep;
 
     //... exfiltration rate out of storage layer
-   StorageExfil = getStorageExfilRate();
+   w->storageExfil = getStorageExfilRate(w);
 
     //... underdrain flow rate
-    StorageDrain = 0.0;
-    if ( theLidProc->drain.coeff > 0.0 )
+    w->storageDrain = 0.0;
+    if ( w->lidProc->drain.coeff > 0.0 )
     {
-        StorageDrain = getStorageDrainRate(storageDepth, 0.0, 0.0, surfaceDepth);
+        w->storageDrain = getStorageDrainRate(w, storageDepth, 0.0, 0.0,
+                                              surfaceDepth);
     }
 
     //... limit storage exfiltration by available storage volume
-    maxRate = StorageInflow - StorageEvap + storageDepth*storageVoidFrac/Tstep;
-    StorageExfil = MIN(StorageExfil, maxRate);
-    StorageExfil = MAX(StorageExfil, 0.0);
+    maxRate = w->storageInflow - w->storageEvap +
+              storageDepth*storageVoidFrac/w->tStep;
+    w->storageExfil = MIN(w->storageExfil, maxRate);
+    w->storageExfil = MAX(w->storageExfil, 0.0);
 
     //... limit underdrain flow by volume above drain offset
-    if ( StorageDrain > 0.0 )
+    if ( w->storageDrain > 0.0 )
     {
-        maxRate = -StorageExfil - StorageEvap;
-        if (storageDepth >= storageThickness ) maxRate += StorageInflow;
-        if ( theLidProc->drain.offset <= storageDepth )
+        maxRate = -w->storageExfil - w->storageEvap;
+        if (storageDepth >= storageThickness ) maxRate += w->storageInflow;
+        if ( w->lidProc->drain.offset <= storageDepth )
         {
-            maxRate += (storageDepth - theLidProc->drain.offset) *
-                       storageVoidFrac/Tstep;
+            maxRate += (storageDepth - w->lidProc->drain.offset) *
+                       storageVoidFrac/w->tStep;
         }
         maxRate = MAX(maxRate, 0.0);
-        StorageDrain = MIN(StorageDrain, maxRate);
+        w->storageDrain = MIN(w->storageDrain, maxRate);
     }
 
     //... limit storage inflow to not exceed storage layer capacity
-    maxRate = (storageThickness - storageDepth)*storageVoidFrac/Tstep +
-              StorageExfil + StorageEvap + StorageDrain;
-    StorageInflow = MIN(StorageInflow, maxRate);
+    maxRate = (storageThickness - storageDepth)*storageVoidFrac/w->tStep +
+              w->storageExfil + w->storageEvap + w->storageDrain;
+    w->storageInflow = MIN(w->storageInflow, maxRate);
 
     //... equate surface infil to storage inflow
-    SurfaceInfil = StorageInflow;
+    w->surfaceInfil = w->storageInflow;
 
     //... find surface outflow rate
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    w->surfaceOutflow = getSurfaceOutflowRate(w, surfaceDepth);
 
     // ... find net fluxes for each layer
-    f[SURF] = (SurfaceInflow - SurfaceEvap - StorageInflow - SurfaceOutflow) /
-              theLidProc->surface.voidFrac;;
-    f[STOR] = (StorageInflow - StorageEvap - StorageExfil - StorageDrain) /
-              theLidProc->storage.voidFrac;
+    f[SURF] = (w->surfaceInflow - w->surfaceEvap - w->storageInflow -
+               w->surfaceOutflow) / w->lidProc->surface.voidFrac;;
+    f[STOR] = (w->storageInflow - w->storageEvap - w->storageExfil -
+               w->storageDrain) / w->lidProc->storage.voidFrac;
     f[SOIL] = 0.0;
 }
 
 //=============================================================================
 
-void pavementFluxRates(double x[], double f[])
+void pavementFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates for the layers of a porous pavement LID.
 //  Input:   x = vector of storage levels
@@ -880,20 +910,20 @@ void pavementFluxRates(double x[], double f[])
     double storageDepth;
 
     //... Intermediate variables
-    double pervFrac = (1.0 - theLidProc->pavement.impervFrac);
+    double pervFrac = (1.0 - w->lidProc->pavement.impervFrac);
     double storageInflow;    // inflow rate to storage layer (ft/s)
     double availVolume;
     double maxRate;
 
     //... LID layer properties
-    double paveVoidFrac     = theLidProc->pavement.voidFrac * pervFrac;
-    double paveThickness    = theLidProc->pavement.thickness;
-    double soilThickness    = theLidProc->soil.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double soilWiltPoint    = theLidProc->soil.wiltPoint;
-    double storageThickness = theLidProc->storage.thickness;
-    double storageVoidFrac  = theLidProc->storage.voidFrac;
+    double paveVoidFrac     = w->lidProc->pavement.voidFrac * pervFrac;
+    double paveThickness    = w->lidProc->pavement.thickness;
+    double soilThickness    = w->lidProc->soil.thickness;
+    double soilPorosity     = w->lidProc->soil.porosity;
+    double soilFieldCap     = w->lidProc->soil.fieldCap;
+    double soilWiltPoint    = w->lidProc->soil.wiltPoint;
+    double storageThickness = w->lidProc->storage.thickness;
+    double storageVoidFrac  = w->lidProc->storage.voidFrac;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
@@ -902,55 +932,55 @@ void pavementFluxRates(double x[], double f[])
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    PaveVolume = paveDepth * paveVoidFrac;
-    SoilVolume = soilTheta * soilThickness;
-    StorageVolume = storageDepth * storageVoidFrac;
+    w->surfaceVolume = surfaceDepth * w->lidProc->surface.voidFrac;
+    w->paveVolume = paveDepth * paveVoidFrac;
+    w->soilVolume = soilTheta * soilThickness;
+    w->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
-    availVolume = SoilVolume - soilWiltPoint * soilThickness;
-    getEvapRates(SurfaceVolume, PaveVolume, availVolume, StorageVolume,
-                 pervFrac);
+    availVolume = w->soilVolume - soilWiltPoint * soilThickness;
+    getEvapRates(w, w->surfaceVolume, w->paveVolume, availVolume,
+                 w->storageVolume, pervFrac);
 
     //... no storage evap if soil or pavement layer saturated
     if ( paveDepth >= paveThickness ||
        ( soilThickness > 0.0 && soilTheta >= soilPorosity )
-       ) StorageEvap = 0.0;
+       ) w->storageEvap = 0.0;
 
     //... find nominal rate of surface infiltration into pavement layer
-    SurfaceInfil = SurfaceInflow + (SurfaceVolume / Tstep);
+    w->surfaceInfil = w->surfaceInflow + (w->surfaceVolume / w->tStep);
 
     //... find perc rate out of pavement layer
-    PavePerc = getPavementPermRate() * pervFrac;
+    w->pavePerc = getPavementPermRate(w) * pervFrac;
 
     //... surface infiltration can't exceed pavement permeability
-    SurfaceInfil = MIN(SurfaceInfil, PavePerc);
+    w->surfaceInfil = MIN(w->surfaceInfil, w->pavePerc);
 
     //... limit pavement perc by available water
-    maxRate = PaveVolume/Tstep + SurfaceInfil - PaveEvap;
+    maxRate = w->paveVolume/w->tStep + w->surfaceInfil - w->paveEvap;
     maxRate = MAX(maxRate, 0.0);
-    PavePerc = MIN(PavePerc, maxRate);
+    w->pavePerc = MIN(w->pavePerc, maxRate);
 
     //... find soil layer perc rate
     if ( soilThickness > 0.0 )
     {
-        SoilPerc = getSoilPercRate(soilTheta);
+        w->soilPerc = getSoilPercRate(w, soilTheta);
         availVolume = (soilTheta - soilFieldCap) * soilThickness;
-        maxRate = MAX(availVolume, 0.0) / Tstep - SoilEvap;
-        SoilPerc = MIN(SoilPerc, maxRate);
-        SoilPerc = MAX(SoilPerc, 0.0);
+        maxRate = MAX(availVolume, 0.0) / w->tStep - w->soilEvap;
+        w->soilPerc = MIN(w->soilPerc, maxRate);
+        w->soilPerc = MAX(w->soilPerc, 0.0);
     }
-    else SoilPerc = PavePerc;
+    else w->soilPerc = w->pavePerc;
 
     //... exfiltration rate out of storage layer
-    StorageExfil = getStorageExfilRate();
+    w->storageExfil = getStorageExfilRate(w);
 
     //... underdrain flow rate
-    StorageDrain = 0.0;
-    if ( theLidProc->drain.coeff > 0.0 )
+    w->storageDrain = 0.0;
+    if ( w->lidProc->drain.coeff > 0.0 )
     {
-        StorageDrain = getStorageDrainRate(storageDepth, soilTheta, paveDepth,
-                                           surfaceDepth);
+        w->storageDrain = getStorageDrainRate(w, storageDepth, soilTheta,
+                                              paveDepth, surfaceDepth);
     }
 
     //... check for adjacent saturated layers
@@ -961,22 +991,22 @@ void pavementFluxRates(double x[], double f[])
          paveDepth >= paveThickness )
     {
         //... pavement outflow can't exceed storage outflow
-        maxRate = StorageEvap + StorageDrain + StorageExfil;
-        if ( PavePerc > maxRate ) PavePerc = maxRate;
+        maxRate = w->storageEvap + w->storageDrain + w->storageExfil;
+        if ( w->pavePerc > maxRate ) w->pavePerc = maxRate;
 
         //... storage outflow can't exceed pavement outflow
         else
         {
             //... use up available exfiltration capacity first
-            StorageExfil = MIN(StorageExfil, PavePerc);
-            StorageDrain = PavePerc - StorageExfil;
+            w->storageExfil = MIN(w->storageExfil, w->pavePerc);
+            w->storageDrain = w->pavePerc - w->storageExfil;
         }
 
         //... set soil perc to pavement perc
-        SoilPerc = PavePerc;
+        w->soilPerc = w->pavePerc;
 
         //... limit surface infil. by pavement perc
-        SurfaceInfil = MIN(SurfaceInfil, PavePerc);
+        w->surfaceInfil = MIN(w->surfaceInfil, w->pavePerc);
     }
 
     //... pavement, soil & storage layers are full
@@ -986,22 +1016,23 @@ void pavementFluxRates(double x[], double f[])
               paveDepth >= paveThickness )
     {
         //... find which layer has limiting flux rate
-        maxRate = StorageExfil + StorageDrain;
-        if ( SoilPerc < maxRate) maxRate = SoilPerc;
-        else maxRate = MIN(maxRate, PavePerc);
+        maxRate = w->storageExfil + w->storageDrain;
+        if ( w->soilPerc < maxRate) maxRate = w->soilPerc;
+        else maxRate = MIN(maxRate, w->pavePerc);
 
         //... use up available storage exfiltration capacity first
-        if ( maxRate > StorageExfil ) StorageDrain = maxRate - StorageExfil;
+        if ( maxRate > w->storageExfil )
+            w->storageDrain = maxRate - w->storageExfil;
         else
         {
-            StorageExfil = maxRate;
-            StorageDrain = 0.0;
+            w->storageExfil = maxRate;
+            w->storageDrain = 0.0;
         }
-        SoilPerc = maxRate;
-        PavePerc = maxRate;
+        w->soilPerc = maxRate;
+        w->pavePerc = maxRate;
 
         //... limit surface infil. by pavement perc
-        SurfaceInfil = MIN(SurfaceInfil, PavePerc);
+        w->surfaceInfil = MIN(w->surfaceInfil, w->pavePerc);
     }
 
     //... storage & soil layers are full
@@ -1010,22 +1041,22 @@ void pavementFluxRates(double x[], double f[])
               soilTheta >= soilPorosity )
     {
         //... soil perc can't exceed storage outflow
-        maxRate = StorageDrain + StorageExfil;
-        if ( SoilPerc > maxRate ) SoilPerc = maxRate;
+        maxRate = w->storageDrain + w->storageExfil;
+        if ( w->soilPerc > maxRate ) w->soilPerc = maxRate;
 
         //... storage outflow can't exceed soil perc
         else
         {
             //... use up available exfiltration capacity first
-            StorageExfil = MIN(StorageExfil, SoilPerc);
-            StorageDrain = SoilPerc - StorageExfil;
+            w->storageExfil = MIN(w->storageExfil, w->soilPerc);
+            w->storageDrain = w->soilPerc - w->storageExfil;
         }
-        PavePerc = MIN(PavePerc, SoilPerc);        
+        w->pavePerc = MIN(w->pavePerc, w->soilPerc);        
 
         //... limit surface infil. by available pavement volume
         availVolume = (paveThickness - paveDepth) * paveVoidFrac;
-        maxRate = availVolume / Tstep + PavePerc + PaveEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = availVolume / w->tStep + w->pavePerc + w->paveEvap;
+        w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
     }
 
     //... soil and pavement layers are full
@@ -1033,78 +1064,81 @@ void pavementFluxRates(double x[], double f[])
               paveDepth >= paveThickness &&
               soilTheta >= soilPorosity )
     {
-        PavePerc = MIN(PavePerc, SoilPerc);
-        SoilPerc = PavePerc;
-        SurfaceInfil = MIN(SurfaceInfil,PavePerc); 
-        maxRate = MAX(StorageVolume / Tstep + SoilPerc - StorageEvap, 0.0);
-	    StorageExfil = MIN(StorageExfil, maxRate); 
+        w->pavePerc = MIN(w->pavePerc, w->soilPerc);
+        w->soilPerc = w->pavePerc;
+        w->surfaceInfil = MIN(w->surfaceInfil,w->pavePerc); 
+        maxRate = w->storageVolume / w->tStep + w->soilPerc - w->storageEvap;
+        maxRate = MAX(maxRate, 0.0);
+	    w->storageExfil = MIN(w->storageExfil, maxRate); 
     }
 
     //... no adjoining layers are full
     else
     {
         //... limit storage exfiltration by available storage volume
-        //    (if no soil layer, SoilPerc is same as PavePerc)
-        maxRate = SoilPerc - StorageEvap + StorageVolume / Tstep;
+        //    (if no soil layer, soil perc is same as pavement perc)
+        maxRate = w->soilPerc - w->storageEvap + w->storageVolume / w->tStep;
         maxRate = MAX(0.0, maxRate);
-        StorageExfil = MIN(StorageExfil, maxRate);
+        w->storageExfil = MIN(w->storageExfil, maxRate);
 
         //... limit underdrain flow by volume above drain offset
-        if ( StorageDrain > 0.0 )
+        if ( w->storageDrain > 0.0 )
         {
-            maxRate = -StorageExfil - StorageEvap;
-            if (storageDepth >= storageThickness ) maxRate += SoilPerc;
-            if ( theLidProc->drain.offset <= storageDepth ) 
+            maxRate = -w->storageExfil - w->storageEvap;
+            if (storageDepth >= storageThickness ) maxRate += w->soilPerc;
+            if ( w->lidProc->drain.offset <= storageDepth ) 
             {
-                maxRate += (storageDepth - theLidProc->drain.offset) *
-                           storageVoidFrac/Tstep;
+                maxRate += (storageDepth - w->lidProc->drain.offset) *
+                           storageVoidFrac/w->tStep;
             }
             maxRate = MAX(maxRate, 0.0);
-            StorageDrain = MIN(StorageDrain, maxRate);
+            w->storageDrain = MIN(w->storageDrain, maxRate);
         }
 
         //... limit soil & pavement outflow by unused storage volume
         availVolume = (storageThickness - storageDepth) * storageVoidFrac;
-        maxRate = availVolume/Tstep + StorageEvap + StorageDrain + StorageExfil;
+        maxRate = availVolume/w->tStep + w->storageEvap + w->storageDrain +
+                  w->storageExfil;
         maxRate = MAX(maxRate, 0.0);
         if ( soilThickness > 0.0 )
         {
-            SoilPerc = MIN(SoilPerc, maxRate);
-            maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                      SoilPerc;
+            w->soilPerc = MIN(w->soilPerc, maxRate);
+            maxRate = (soilPorosity - soilTheta) * soilThickness / w->tStep +
+                      w->soilPerc;
         }
-        PavePerc = MIN(PavePerc, maxRate);
+        w->pavePerc = MIN(w->pavePerc, maxRate);
 
         //... limit surface infil. by available pavement volume
         availVolume = (paveThickness - paveDepth) * paveVoidFrac;
-        maxRate = availVolume / Tstep + PavePerc + PaveEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = availVolume / w->tStep + w->pavePerc + w->paveEvap;
+        w->surfaceInfil = MIN(w->surfaceInfil, maxRate);
     }
 
     //... surface outflow
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    w->surfaceOutflow = getSurfaceOutflowRate(w, surfaceDepth);
 
     //... compute overall layer flux rates
-    f[SURF] = SurfaceInflow - SurfaceEvap - SurfaceInfil - SurfaceOutflow;
-    f[PAVE] = (SurfaceInfil - PaveEvap - PavePerc) / paveVoidFrac;
-    if ( theLidProc->soil.thickness > 0.0)
+    f[SURF] = w->surfaceInflow - w->surfaceEvap - w->surfaceInfil -
+              w->surfaceOutflow;
+    f[PAVE] = (w->surfaceInfil - w->paveEvap - w->pavePerc) / paveVoidFrac;
+    if ( w->lidProc->soil.thickness > 0.0)
     {
-        f[SOIL] = (PavePerc - SoilEvap - SoilPerc) / soilThickness;
-        storageInflow = SoilPerc;
+        f[SOIL] = (w->pavePerc - w->soilEvap - w->soilPerc) / soilThickness;
+        storageInflow = w->soilPerc;
     }
     else
     {
         f[SOIL] = 0.0;
-        storageInflow = PavePerc;
-        SoilPerc = 0.0;
+        storageInflow = w->pavePerc;
+        w->soilPerc = 0.0;
     }
-    f[STOR] = (storageInflow - StorageEvap - StorageExfil - StorageDrain) /
-              storageVoidFrac;
+    f[STOR] = (storageInflow - w->storageEvap - w->storageExfil -
+               w->storageDrain) / storageVoidFrac;
 }
 
 //=============================================================================
 
-void swaleFluxRates(double x[], double f[])
+void swaleFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates from a vegetative swale LID.
 //  Input:   x = vector of storage levels
@@ -1129,57 +1163,57 @@ void swaleFluxRates(double x[], double f[])
 
     //... retrieve state variable from work vector
     depth = x[SURF];
-    depth = MIN(depth, theLidProc->surface.thickness);
+    depth = MIN(depth, w->lidProc->surface.thickness);
 
     //... depression storage depth
     dStore = 0.0;
 
     //... get swale's bottom width
     //    (0.5 ft minimum to avoid numerical problems)
-    slope = theLidProc->surface.sideSlope;
-    topWidth = theLidUnit->fullWidth;
+    slope = w->lidProc->surface.sideSlope;
+    topWidth = w->lidUnit->fullWidth;
     topWidth = MAX(topWidth, 0.5);
-    botWidth = topWidth - 2.0 * slope * theLidProc->surface.thickness;
+    botWidth = topWidth - 2.0 * slope * w->lidProc->surface.thickness;
     if ( botWidth < 0.5 )
     {
         botWidth = 0.5;
-        slope = 0.5 * (topWidth - 0.5) / theLidProc->surface.thickness;
+        slope = 0.5 * (topWidth - 0.5) / w->lidProc->surface.thickness;
     }
 
     //... swale's length
-    lidArea = theLidUnit->area;
+    lidArea = w->lidUnit->area;
     length = lidArea / topWidth;
 
     //... top width, surface area and flow area of current ponded depth
     surfWidth = botWidth + 2.0 * slope * depth;
     surfArea = length * surfWidth;
     flowArea = (depth * (botWidth + slope * depth)) *
-               theLidProc->surface.voidFrac;
+               w->lidProc->surface.voidFrac;
 
     //... wet volume and effective depth
     volume = length * flowArea;
 
     //... surface inflow into swale (cfs)
-    surfInflow = SurfaceInflow * lidArea;
+    surfInflow = w->surfaceInflow * lidArea;
 
     //... ET rate in cfs
-    SurfaceEvap = EvapRate * surfArea;
-    SurfaceEvap = MIN(SurfaceEvap, volume/Tstep);
+    w->surfaceEvap = w->evapRate * surfArea;
+    w->surfaceEvap = MIN(w->surfaceEvap, volume/w->tStep);
 
     //... infiltration rate to native soil in cfs
-    StorageExfil = SurfaceInfil * surfArea;
+    w->storageExfil = w->surfaceInfil * surfArea;
 
     //... no surface outflow if depth below depression storage
     xDepth = depth - dStore;
-    if ( xDepth <= ZERO ) SurfaceOutflow = 0.0;
+    if ( xDepth <= ZERO ) w->surfaceOutflow = 0.0;
 
     //... otherwise compute a surface outflow
     else
     {
         //... modify flow area to remove depression storage,
         flowArea -= (dStore * (botWidth + slope * dStore)) *
-                     theLidProc->surface.voidFrac;
-        if ( flowArea < ZERO ) SurfaceOutflow = 0.0;
+                     w->lidProc->surface.voidFrac;
+        if ( flowArea < ZERO ) w->surfaceOutflow = 0.0;
         else
         {
             //... compute hydraulic radius
@@ -1188,38 +1222,38 @@ void swaleFluxRates(double x[], double f[])
             hydRadius = flowArea / hydRadius;
 
             //... use Manning Eqn. to find outflow rate in cfs
-            SurfaceOutflow = theLidProc->surface.alpha * flowArea *
+            w->surfaceOutflow = w->lidProc->surface.alpha * flowArea *
                              pow(hydRadius, 2./3.);
         }
     }
 
     //... net flux rate (dV/dt) in cfs
-    dVdT = surfInflow - SurfaceEvap - StorageExfil - SurfaceOutflow;
+    dVdT = surfInflow - w->surfaceEvap - w->storageExfil - w->surfaceOutflow;
 
     //... when full, any net positive inflow becomes spillage
-    if ( depth == theLidProc->surface.thickness && dVdT > 0.0 )
+    if ( depth == w->lidProc->surface.thickness && dVdT > 0.0 )
     {
-        SurfaceOutflow += dVdT;
+        w->surfaceOutflow += dVdT;
         dVdT = 0.0;
     }
 
     //... convert flux rates to ft/s
-    SurfaceEvap /= lidArea;
-    StorageExfil /= lidArea;
-    SurfaceOutflow /= lidArea;
+    w->surfaceEvap /= lidArea;
+    w->storageExfil /= lidArea;
+    w->surfaceOutflow /= lidArea;
     f[SURF] = dVdT / surfArea;
     f[SOIL] = 0.0;
     f[STOR] = 0.0;
 
     //... assign values to layer volumes
-    SurfaceVolume = volume / lidArea;
-    SoilVolume = 0.0;
-    StorageVolume = 0.0;
+    w->surfaceVolume = volume / lidArea;
+    w->soilVolume = 0.0;
+    w->storageVolume = 0.0;
 }
 
 //=============================================================================
 
-void barrelFluxRates(double x[], double f[])
+void barrelFluxRates(TLidWork* w, double x[], double f[])
 //
 //  Purpose: computes flux rates for a rain barrel LID.
 //  Input:   x = vector of storage levels
@@ -1231,45 +1265,46 @@ void barrelFluxRates(double x[], double f[])
     double maxValue;
 
     //... assign values to layer volumes
-    SurfaceVolume = 0.0;
-    SoilVolume = 0.0;
-    StorageVolume = storageDepth;
+    w->surfaceVolume = 0.0;
+    w->soilVolume = 0.0;
+    w->storageVolume = storageDepth;
 
     //... initialize flows
-    SurfaceInfil = 0.0;
-    SurfaceOutflow = 0.0;
-    StorageDrain = 0.0;
+    w->surfaceInfil = 0.0;
+    w->surfaceOutflow = 0.0;
+    w->storageDrain = 0.0;
 
     //... compute outflow if time since last rain exceeds drain delay
     //    (dryTime is updated in lid.evalLidUnit at each time step)
-    if ( theLidProc->drain.delay == 0.0 ||
-        theLidUnit->dryTime >= theLidProc->drain.delay )
+    if ( w->lidProc->drain.delay == 0.0 ||
+        w->lidUnit->dryTime >= w->lidProc->drain.delay )
     {
-        head = storageDepth - theLidProc->drain.offset;
+        head = storageDepth - w->lidProc->drain.offset;
         if ( head > 0.0 )
         {
-            StorageDrain = getStorageDrainRate(storageDepth, 0.0, 0.0, 0.0);
-            maxValue = (head/Tstep);
-            StorageDrain = MIN(StorageDrain, maxValue);
+            w->storageDrain = getStorageDrainRate(w, storageDepth, 0.0, 0.0,
+                                                  0.0);
+            maxValue = (head/w->tStep);
+            w->storageDrain = MIN(w->storageDrain, maxValue);
         }
     }
 
     //... limit inflow to available storage
-    StorageInflow = SurfaceInflow;
-    maxValue = (theLidProc->storage.thickness - storageDepth) / Tstep +
-        StorageDrain;
-    StorageInflow = MIN(StorageInflow, maxValue);
-    SurfaceInfil = StorageInflow;
+    w->storageInflow = w->surfaceInflow;
+    maxValue = (w->lidProc->storage.thickness - storageDepth) / w->tStep +
+        w->storageDrain;
+    w->storageInflow = MIN(w->storageInflow, maxValue);
+    w->surfaceInfil = w->storageInflow;
 
     //... assign values to layer flux rates
-    f[SURF] = SurfaceInflow - StorageInflow;
-    f[STOR] = StorageInflow - StorageDrain;
+    f[SURF] = w->surfaceInflow - w->storageInflow;
+    f[STOR] = w->storageInflow - w->storageDrain;
     f[SOIL] = 0.0;
 }
 
 //=============================================================================
 
-double getSurfaceOutflowRate(double depth)
+double getSurfaceOutflowRate(TLidWork* w, double depth)
 //
 //  Purpose: computes outflow rate from a LID's surface layer.
 //  Input:   depth = depth of ponded water on surface layer (ft)
@@ -1282,19 +1317,19 @@ double getSurfaceOutflowRate(double depth)
     double outflow;
 
     //... no outflow if ponded depth below storage depth
-    delta = depth - theLidProc->surface.thickness;
+    delta = depth - w->lidProc->surface.thickness;
     if ( delta < 0.0 ) return 0.0;
 
     //... compute outflow from overland flow Manning equation
-    outflow = theLidProc->surface.alpha * pow(delta, 5.0/3.0) *
-              theLidUnit->fullWidth / theLidUnit->area;
-    outflow = MIN(outflow, delta / Tstep);
+    outflow = w->lidProc->surface.alpha * pow(delta, 5.0/3.0) *
+              w->lidUnit->fullWidth / w->lidUnit->area;
+    outflow = MIN(outflow, delta / w->tStep);
     return outflow;
 }
 
 //=============================================================================
 
-double getPavementPermRate()
+double getPavementPermRate(TLidWork* w)
 //
 //  Purpose: computes reduced permeability of a pavement layer due to
 //           clogging.
@@ -1303,8 +1338,8 @@ double getPavementPermRate()
 //
 {
     double permReduction = 0.0;
-    double clogFactor= theLidProc->pavement.clogFactor;
-    double regenDays = theLidProc->pavement.regenDays;
+    double clogFactor= w->lidProc->pavement.clogFactor;
+    double regenDays = w->lidProc->pavement.regenDays;
 
     // ... find permeability reduction due to clogging     
     if ( clogFactor > 0.0 )
@@ -1314,29 +1349,30 @@ double getPavementPermRate()
         //      volumetric loading that the pavement has received)
         if ( regenDays > 0.0 )
         {
-            if ( OldRunoffTime / 1000.0 / SECperDAY >= theLidUnit->nextRegenDay )
+            if ( OldRunoffTime / 1000.0 / SECperDAY >=
+                 w->lidUnit->nextRegenDay )
             {
                 // ... reduce total volume treated by degree of regeneration
-                theLidUnit->volTreated *= 
-                    (1.0 - theLidProc->pavement.regenDegree);
+                w->lidUnit->volTreated *= 
+                    (1.0 - w->lidProc->pavement.regenDegree);
 
                 // ... update next day that regenration occurs
-                theLidUnit->nextRegenDay += regenDays;
+                w->lidUnit->nextRegenDay += regenDays;
             }
         }
 
         // ... find permeabiity reduction factor
-        permReduction = theLidUnit->volTreated / clogFactor;
+        permReduction = w->lidUnit->volTreated / clogFactor;
         permReduction = MIN(permReduction, 1.0);
     }
 
     // ... return the effective pavement permeability
-    return theLidProc->pavement.kSat * (1.0 - permReduction);
+    return w->lidProc->pavement.kSat * (1.0 - permReduction);
 }
 
 //=============================================================================
 
-double getSoilPercRate(double theta)
+double getSoilPercRate(TLidWork* w, double theta)
 //
 //  Purpose: computes percolation rate of water through a LID's soil layer.
 //  Input:   theta = moisture content (fraction)
@@ -1346,17 +1382,17 @@ double getSoilPercRate(double theta)
     double delta;            // moisture deficit
 
     // ... no percolation if soil moisture <= field capacity
-    if ( theta <= theLidProc->soil.fieldCap ) return 0.0;
+    if ( theta <= w->lidProc->soil.fieldCap ) return 0.0;
 
     // ... perc rate = unsaturated hydraulic conductivity
-    delta = theLidProc->soil.porosity - theta;
-    return theLidProc->soil.kSat * exp(-delta * theLidProc->soil.kSlope);
+    delta = w->lidProc->soil.porosity - theta;
+    return w->lidProc->soil.kSat * exp(-delta * w->lidProc->soil.kSlope);
 
 }
 
 //=============================================================================
 
-double getStorageExfilRate()
+double getStorageExfilRate(TLidWork* w)
 //
 //  Purpose: computes exfiltration rate from storage zone into
 //           native soil beneath a LID.
@@ -1367,27 +1403,27 @@ double getStorageExfilRate()
     double infil = 0.0;
     double clogFactor = 0.0;
 
-    if ( theLidProc->storage.kSat == 0.0 ) return 0.0;
-    if ( MaxNativeInfil == 0.0 ) return 0.0;
+    if ( w->lidProc->storage.kSat == 0.0 ) return 0.0;
+    if ( w->maxNativeInfil == 0.0 ) return 0.0;
 
     //... reduction due to clogging
-    clogFactor = theLidProc->storage.clogFactor;
+    clogFactor = w->lidProc->storage.clogFactor;
     if ( clogFactor > 0.0 )
     {
-        clogFactor = theLidUnit->waterBalance.inflow / clogFactor;
+        clogFactor = w->lidUnit->waterBalance.inflow / clogFactor;
         clogFactor = MIN(clogFactor, 1.0);
     }
 
     //... infiltration rate = storage Ksat reduced by any clogging
-    infil = theLidProc->storage.kSat * (1.0 - clogFactor);
+    infil = w->lidProc->storage.kSat * (1.0 - clogFactor);
 
     //... limit infiltration rate by any groundwater-imposed limit
-    return MIN(infil, MaxNativeInfil);
+    return MIN(infil, w->maxNativeInfil);
 }
 
 //=============================================================================
 
-double  getStorageDrainRate(double storageDepth, double soilTheta, 
+double  getStorageDrainRate(TLidWork* w, double storageDepth, double soilTheta, 
                             double paveDepth, double surfaceDepth)
 //
 //  Purpose: computes underdrain flow rate in a LID's storage layer.
@@ -1402,14 +1438,14 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
 //           layers above it (soil, pavement, and surface in that order)
 //           minus the drain outlet offset.
 {
-    int    curve = theLidProc->drain.qCurve;
+    int    curve = w->lidProc->drain.qCurve;
     double head = storageDepth;
     double outflow = 0.0;
-    double paveThickness    = theLidProc->pavement.thickness;
-    double soilThickness    = theLidProc->soil.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double storageThickness = theLidProc->storage.thickness;
+    double paveThickness    = w->lidProc->pavement.thickness;
+    double soilThickness    = w->lidProc->soil.thickness;
+    double soilPorosity     = w->lidProc->soil.porosity;
+    double soilFieldCap     = w->lidProc->soil.fieldCap;
+    double storageThickness = w->lidProc->storage.thickness;
 
     // --- storage layer is full
     if ( storageDepth >= storageThickness )
@@ -1449,13 +1485,13 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
     // --- no outflow if:
     //     a) no prior outflow and head below open threshold
     //     b) prior outflow and head below closed threshold
-    if ( theLidUnit->oldDrainFlow == 0.0 &&
-         head <= theLidProc->drain.hOpen ) return 0.0;
-    if ( theLidUnit->oldDrainFlow > 0.0 &&
-         head <= theLidProc->drain.hClose ) return 0.0;
+    if ( w->lidUnit->oldDrainFlow == 0.0 &&
+         head <= w->lidProc->drain.hOpen ) return 0.0;
+    if ( w->lidUnit->oldDrainFlow > 0.0 &&
+         head <= w->lidProc->drain.hClose ) return 0.0;
 
     // --- make head relative to drain offset
-    head -= theLidProc->drain.offset;
+    head -= w->lidProc->drain.offset;
 
     // --- compute drain outflow from underdrain flow equation in user units
     //     (head in inches or mm, flow rate in in/hr or mm/hr)
@@ -1465,8 +1501,8 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
         head *= UCF(RAINDEPTH);
 
         // --- compute drain outflow in user units
-        outflow = theLidProc->drain.coeff *
-                  pow(head, theLidProc->drain.expon);
+        outflow = w->lidProc->drain.coeff *
+                  pow(head, w->lidProc->drain.expon);
 
         // --- apply user-supplied control curve to outflow
         if (curve >= 0)  outflow *= table_lookup(&Curve[curve], head);
@@ -1479,7 +1515,7 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
 
 //=============================================================================
 
-double getDrainMatOutflow(double depth)
+double getDrainMatOutflow(TLidWork* w, double depth)
 //
 //  Purpose: computes flow rate through a green roof's drainage mat.
 //  Input:   depth = depth of water in drainage mat (ft)
@@ -1487,22 +1523,22 @@ double getDrainMatOutflow(double depth)
 //
 {
     //... default is to pass all inflow
-    double result = SoilPerc;
+    double result = w->soilPerc;
 
     //... otherwise use Manning eqn. if its parameters were supplied
-    if ( theLidProc->drainMat.alpha > 0.0 )
+    if ( w->lidProc->drainMat.alpha > 0.0 )
     {
-        result = theLidProc->drainMat.alpha * pow(depth, 5.0/3.0) *
-                 theLidUnit->fullWidth / theLidUnit->area *
-                 theLidProc->drainMat.voidFrac;
+        result = w->lidProc->drainMat.alpha * pow(depth, 5.0/3.0) *
+                 w->lidUnit->fullWidth / w->lidUnit->area *
+                 w->lidProc->drainMat.voidFrac;
     }
     return result;
 }
 
 //=============================================================================
 
-void getEvapRates(double surfaceVol, double paveVol, double soilVol,
-    double storageVol, double pervFrac)
+void getEvapRates(TLidWork* w, double surfaceVol, double paveVol,
+    double soilVol, double storageVol, double pervFrac)
 //
 //  Purpose: computes surface, pavement, soil, and storage evaporation rates.
 //  Input:   surfaceVol = volume/area of ponded water on surface layer (ft)
@@ -1516,53 +1552,54 @@ void getEvapRates(double surfaceVol, double paveVol, double soilVol,
     double availEvap;
 
     //... surface evaporation flux
-    availEvap = EvapRate;
-    SurfaceEvap = MIN(availEvap, surfaceVol/Tstep);
-    SurfaceEvap = MAX(0.0, SurfaceEvap);
-    availEvap = MAX(0.0, (availEvap - SurfaceEvap));
+    availEvap = w->evapRate;
+    w->surfaceEvap = MIN(availEvap, surfaceVol/w->tStep);
+    w->surfaceEvap = MAX(0.0, w->surfaceEvap);
+    availEvap = MAX(0.0, (availEvap - w->surfaceEvap));
     availEvap *= pervFrac;
 
     //... no subsurface evap if water is infiltrating
-    if ( SurfaceInfil > 0.0 )
+    if ( w->surfaceInfil > 0.0 )
     {
-        PaveEvap = 0.0;
-        SoilEvap = 0.0;
-        StorageEvap = 0.0;
+        w->paveEvap = 0.0;
+        w->soilEvap = 0.0;
+        w->storageEvap = 0.0;
     }
     else
     {
         //... pavement evaporation flux
-        PaveEvap = MIN(availEvap, paveVol / Tstep);
-        availEvap = MAX(0.0, (availEvap - PaveEvap));
+        w->paveEvap = MIN(availEvap, paveVol / w->tStep);
+        availEvap = MAX(0.0, (availEvap - w->paveEvap));
 
         //... soil evaporation flux
-        SoilEvap = MIN(availEvap, soilVol / Tstep);
-        availEvap = MAX(0.0, (availEvap - SoilEvap));
+        w->soilEvap = MIN(availEvap, soilVol / w->tStep);
+        availEvap = MAX(0.0, (availEvap - w->soilEvap));
 
         //... storage evaporation flux
-        StorageEvap = MIN(availEvap, storageVol / Tstep);
+        w->storageEvap = MIN(availEvap, storageVol / w->tStep);
     }
 }
 
 //=============================================================================
 
-double getSurfaceOverflowRate(double* surfaceDepth)
+double getSurfaceOverflowRate(TLidWork* w, double* surfaceDepth)
 //
 //  Purpose: finds surface overflow rate from a LID unit.
 //  Input:   surfaceDepth = depth of water stored in surface layer (ft)
 //  Output:  returns the overflow rate (ft/s)
 //
 {
-    double delta = *surfaceDepth - theLidProc->surface.thickness;
+    double delta = *surfaceDepth - w->lidProc->surface.thickness;
     if (  delta <= 0.0 ) return 0.0;
-    *surfaceDepth = theLidProc->surface.thickness;
-    return delta * theLidProc->surface.voidFrac / Tstep;
+    *surfaceDepth = w->lidProc->surface.thickness;
+    return delta * w->lidProc->surface.voidFrac / w->tStep;
 }
 
 //=============================================================================
 
 void updateWaterBalance(TLidUnit *lidUnit, double inflow, double evap,
-    double infil, double surfFlow, double drainFlow, double storage)
+    double infil, double surfFlow, double drainFlow, double storage,
+    double tStep)
 //
 //  Purpose: updates components of the water mass balance for a LID unit
 //           over the current time step.
@@ -1573,15 +1610,16 @@ void updateWaterBalance(TLidUnit *lidUnit, double inflow, double evap,
 //           surfFlow  = surface runoff from the unit (ft/s)
 //           drainFlow = underdrain flow from the unit
 //           storage   = volume of water stored in the unit (ft)
+//           tStep     = time step (sec)
 //  Output:  none
 //
 {
-    lidUnit->volTreated += inflow * Tstep;
-    lidUnit->waterBalance.inflow += inflow * Tstep;
-    lidUnit->waterBalance.evap += evap * Tstep;
-    lidUnit->waterBalance.infil += infil * Tstep;
-    lidUnit->waterBalance.surfFlow += surfFlow * Tstep;
-    lidUnit->waterBalance.drainFlow += drainFlow * Tstep;
+    lidUnit->volTreated += inflow * tStep;
+    lidUnit->waterBalance.inflow += inflow * tStep;
+    lidUnit->waterBalance.evap += evap * tStep;
+    lidUnit->waterBalance.infil += infil * tStep;
+    lidUnit->waterBalance.surfFlow += surfFlow * tStep;
+    lidUnit->waterBalance.drainFlow += drainFlow * tStep;
     lidUnit->waterBalance.finalVol = storage;
 }
 // OWA EDIT ##################################################################################
@@ -1629,14 +1667,15 @@ void updateWaterRate(TLidUnit *lidUnit, double evap, double maxNativeInfil,
 
 //=============================================================================
 
-int modpuls_solve(int n, double* x, double* xOld, double* xPrev,
+int modpuls_solve(TLidWork* w, int n, double* x, double* xOld, double* xPrev,
                   double* xMin, double* xMax, double* xTol,
                   double* qOld, double* q, double dt, double omega,
-                  void (*derivs)(double*, double*))
+                  void (*derivs)(TLidWork*, double*, double*))
 //
 //  Purpose: solves system of equations dx/dt = q(x) for x at end of time step
 //           dt using a modified Puls method.
-//  Input:   n = number of state variables
+//  Input:   w = work space passed on to derivs
+//           n = number of state variables
 //           x = vector of state variables
 //           xOld = state variable values at start of time step
 //           xPrev = state variable values from previous iteration
@@ -1671,7 +1710,7 @@ int modpuls_solve(int n, double* x, double* xOld, double* xPrev,
     {
         //... compute flux rates for current state levels
         canStop = 1;
-        derivs(x, q);
+        derivs(w, x, q);
 
         //... update state levels based on current flux rates
         for (i=0; i<n; i++)
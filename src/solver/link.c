@@ -48,6 +48,8 @@
 //   - Warning for conduit elevation drop < MIN_DELTA_Z restored.
 //   Build 5.2.4:
 //   - Conduit evap+seepage loss under DW routing limited by conduit volume.
+//   - Evap. rate & conductivity factor saved for routing used for losses.
+//   - link_getResults only computes the results asked for.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -671,10 +673,11 @@ int link_setFlapGate(int j, int n1, int n2, double q)
 
 //=============================================================================
 
-void link_getResults(int j, double f, float x[])
+void link_getResults(int j, double f, float x[], char used[])
 //
 //  Input:   j = link index
 //           f = time weighting factor
+//           used = TRUE for each result to compute (NULL if all)
 //  Output:  x = array of weighted results
 //  Purpose: retrieves time-weighted average of old and new results for a link.
 //
@@ -690,14 +693,18 @@ void link_getResults(int j, double f, float x[])
     y = f1*Link[j].oldDepth + f*Link[j].newDepth;
     q = f1*Link[j].oldFlow + f*Link[j].newFlow;
     v = f1*Link[j].oldVolume + f*Link[j].newVolume;
-    u = link_getVelocity(j, q, y);
+    u = 0.0;
     c = 0.0;
-    if (Link[j].type == CONDUIT)
+    if ( !used || used[LINK_VELOCITY] ) u = link_getVelocity(j, q, y);
+    if ( !used || used[LINK_CAPACITY] )
     {
-        if (Link[j].xsect.type != DUMMY)
-            c = xsect_getAofY(&Link[j].xsect, y) / Link[j].xsect.aFull;
+        if (Link[j].type == CONDUIT)
+        {
+            if (Link[j].xsect.type != DUMMY)
+                c = xsect_getAofY(&Link[j].xsect, y) / Link[j].xsect.aFull;
+        }
+        else c = Link[j].setting;
     }
-    else c = Link[j].setting;
 
     // --- override time weighting for pump flow between on/off states
     if (Link[j].type == PUMP && Link[j].oldFlow*Link[j].newFlow == 0.0)
@@ -718,6 +725,7 @@ void link_getResults(int j, double f, float x[])
 
     if ( !IgnoreQuality ) for (p = 0; p < Nobjects[POLLUT]; p++)
     {
+        if ( used && !used[LINK_QUAL+p] ) continue;
         c = f1*Link[j].oldQual[p] + f*Link[j].newQual[p];
         x[LINK_QUAL+p] = (float)c;
     }
@@ -1356,10 +1364,10 @@ double conduit_getLossRate(int j, int routeModel, double q, double tstep)
         length = conduit_getLength(j);
 
         // --- find evaporation rate for open conduits
-        if ( xsect_isOpen(xsect->type) && Evap.rate > 0.0 )
+        if ( xsect_isOpen(xsect->type) && RouteEvapRate > 0.0 )
         {
             topWidth = xsect_getWofY(xsect, depth);
-            evapLossRate = topWidth * length * Evap.rate;
+            evapLossRate = topWidth * length * RouteEvapRate;
         }
 
         // --- compute seepage loss rate
@@ -1375,7 +1383,7 @@ double conduit_getLossRate(int j, int routeModel, double q, double tstep)
 			
             // compute seepage loss rate across length of conduit
             seepLossRate = Link[j].seepRate * width * length;
-            seepLossRate *= Adjust.hydconFactor;
+            seepLossRate *= RouteHydconFactor;
         }
 
         // --- compute total loss rate
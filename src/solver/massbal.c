@@ -28,6 +28,9 @@
 //     nodes are when updating total outflow volume.
 //   Build 5.1.013:
 //   - Volume from MinSurfArea no longer included in initial & final storage.
+//   Build 5.2.4:
+//   - Runoff, groundwater and loading total updates made by parallel runoff
+//     threads can be deferred to logs that are applied in a fixed order.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -41,6 +44,27 @@
 //-----------------------------------------------------------------------------
 static const double MAX_RUNOFF_BALANCE_ERR = 10.0;
 static const double MAX_FLOW_BALANCE_ERR   = 10.0;
+static const int    DEFERRED_LOG_SIZE      = 256;
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+enum DeferredTotalType {RUNOFF_TOTAL, GWATER_TOTAL, LOADING_TOTAL};
+
+typedef struct
+{
+    char   totalType;             // runoff, groundwater or loading total
+    char   type;                  // component of the total updated
+    int    pollut;                // pollutant index (loading totals only)
+    double v;                     // amount added to the component
+}  TDeferredTotal;
+
+typedef struct
+{
+    int    count;                 // number of updates logged
+    int    size;                  // capacity of the log
+    TDeferredTotal* items;        // logged updates
+}  TDeferredLog;
 
 //-----------------------------------------------------------------------------
 //  Shared variables   
@@ -61,6 +85,19 @@ double*  NodeInflow;              // total inflow volume to each node (ft3)
 double*  NodeOutflow;             // total outflow volume from each node (ft3)
 double   TotalArea;               // total drainage area (ft2)
 
+//-----------------------------------------------------------------------------
+//  Deferred updates
+//-----------------------------------------------------------------------------
+//  Parallel runoff threads log their updates to the runoff, groundwater and
+//  loading totals, one log per block of subcatchments. The logs are applied
+//  in block order so the totals are summed in the same order as a serial
+//  pass through the subcatchments and do not depend on the thread count.
+static TDeferredLog* DeferredLogs;     // update logs for blocks of objects
+static int           DeferredCount;    // number of update logs
+static char          DeferredError;    // TRUE if a log could not grow
+static TDeferredLog* DeferredLog;      // log the calling thread writes to
+#pragma omp threadprivate(DeferredLog)
+
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
@@ -83,6 +120,10 @@ double   TotalArea;               // total drainage area (ft2)
 //  massbal_addSeepageLoss      (called from routing.c)
 //  massbal_addToFinalStorage   (called from qualrout.c)
 //  massbal_getStepFlowError    (called from routing.c)
+//  massbal_openDeferred        (called from runoff_open)
+//  massbal_closeDeferred       (called from runoff_close)
+//  massbal_deferTotals         (called from runoff_execute)
+//  massbal_addDeferredTotals   (called from runoff_execute)
 
 //-----------------------------------------------------------------------------
 //  Local Functions   
@@ -93,6 +134,7 @@ double massbal_getStoredMass(int pollut);
 double massbal_getLoadingError(void);
 double massbal_getGwaterError(void);
 double massbal_getQualError(void);
+static void deferTotal(int totalType, int type, int pollut, double v);
 
 
 //=============================================================================
@@ -259,6 +301,109 @@ void massbal_close()
 
 //=============================================================================
 
+int massbal_openDeferred(int n)
+//
+//  Input:   n = number of update logs
+//  Output:  returns error code
+//  Purpose: allocates logs used to defer updates of runoff, groundwater
+//           and loading totals made by parallel threads.
+//
+{
+    DeferredCount = 0;
+    DeferredError = FALSE;
+    DeferredLogs = (TDeferredLog *) calloc(n, sizeof(TDeferredLog));
+    if ( DeferredLogs == NULL )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return ErrorCode;
+    }
+    DeferredCount = n;
+    return ErrorCode;
+}
+
+//=============================================================================
+
+void massbal_closeDeferred()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees the logs of deferred total updates.
+//
+{
+    int k;
+
+    if ( DeferredLogs )
+    {
+        for (k = 0; k < DeferredCount; k++) FREE(DeferredLogs[k].items);
+        FREE(DeferredLogs);
+    }
+    DeferredCount = 0;
+}
+
+//=============================================================================
+
+void massbal_deferTotals(int k)
+//
+//  Input:   k = index of an update log (or -1)
+//  Output:  none
+//  Purpose: sends later runoff, groundwater and loading total updates
+//           made by the calling thread to log k, or applies them directly
+//           if k is out of range.
+//
+{
+    if ( k >= 0 && k < DeferredCount ) DeferredLog = &DeferredLogs[k];
+    else DeferredLog = NULL;
+}
+
+//=============================================================================
+
+void massbal_addDeferredTotals()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: adds the updates saved in each log to the runoff, groundwater
+//           and loading totals, taking the logs in order, and empties them.
+//
+{
+    int k, m;
+    TDeferredTotal* item;
+
+    for (k = 0; k < DeferredCount; k++)
+    {
+        for (m = 0; m < DeferredLogs[k].count; m++)
+        {
+            item = &DeferredLogs[k].items[m];
+            switch (item->totalType)
+            {
+            case RUNOFF_TOTAL:
+                massbal_updateRunoffTotals(item->type, item->v);
+                break;
+            case LOADING_TOTAL:
+                massbal_updateLoadingTotals(item->type, item->pollut, item->v);
+                break;
+            case GWATER_TOTAL:
+                switch (item->type)
+                {
+                case 0: GwaterTotals.infil     += item->v; break;
+                case 1: GwaterTotals.upperEvap += item->v; break;
+                case 2: GwaterTotals.lowerEvap += item->v; break;
+                case 3: GwaterTotals.lowerPerc += item->v; break;
+                case 4: GwaterTotals.gwater    += item->v; break;
+                }
+                break;
+            }
+        }
+        DeferredLogs[k].count = 0;
+    }
+    if ( DeferredError )
+    {
+        DeferredError = FALSE;
+        report_writeErrorMsg(ERR_MEMORY, "");
+    }
+}
+
+//=============================================================================
+
 void massbal_report()
 //
 //  Input:   none
@@ -344,6 +489,11 @@ void massbal_updateRunoffTotals(int flowType, double v)
 //  Purpose: updates runoff totals after current time step.
 //
 {
+    if ( DeferredLog )
+    {
+        deferTotal(RUNOFF_TOTAL, flowType, 0, v);
+        return;
+    }
     switch(flowType)
     {
     case RUNOFF_RAINFALL: RunoffTotals.rainfall += v; break;
@@ -369,6 +519,15 @@ void massbal_updateGwaterTotals(double vInfil, double vUpperEvap, double vLowerE
 //  Purpose: updates groundwater totals after current time step.
 //
 {
+    if ( DeferredLog )
+    {
+        deferTotal(GWATER_TOTAL, 0, 0, vInfil);
+        deferTotal(GWATER_TOTAL, 1, 0, vUpperEvap);
+        deferTotal(GWATER_TOTAL, 2, 0, vLowerEvap);
+        deferTotal(GWATER_TOTAL, 3, 0, vLowerPerc);
+        deferTotal(GWATER_TOTAL, 4, 0, vGwater);
+        return;
+    }
     GwaterTotals.infil     += vInfil;
     GwaterTotals.upperEvap += vUpperEvap;
     GwaterTotals.lowerEvap += vLowerEvap;
@@ -444,6 +603,11 @@ void massbal_updateLoadingTotals(int type, int p, double w)
 //  Purpose: adds inflow mass loading to loading totals for current time step.
 //
 {
+    if ( DeferredLog )
+    {
+        deferTotal(LOADING_TOTAL, type, p, w);
+        return;
+    }
     switch (type)
     {
       case BUILDUP_LOAD:     LoadingTotals[p].buildup    += w; break;
@@ -1134,3 +1298,40 @@ int massbal_getNodeTotalInflow(int index, double *value)
 }
 
 // ###################################################################################
+
+//=============================================================================
+
+void deferTotal(int totalType, int type, int pollut, double v)
+//
+//  Input:   totalType = runoff, groundwater or loading total
+//           type = component of the total
+//           pollut = pollutant index
+//           v = amount added to the component
+//  Output:  none
+//  Purpose: appends an update of a mass balance total to the calling
+//           thread's log.
+//
+{
+    int n;
+    TDeferredLog*   log = DeferredLog;
+    TDeferredTotal* items;
+
+    if ( log->count == log->size )
+    {
+        n = (log->size == 0) ? DEFERRED_LOG_SIZE : 2 * log->size;
+        items = (TDeferredTotal *) realloc(log->items,
+                                           n * sizeof(TDeferredTotal));
+        if ( items == NULL )
+        {
+            DeferredError = TRUE;
+            return;
+        }
+        log->items = items;
+        log->size = n;
+    }
+    items = &log->items[log->count++];
+    items->totalType = (char)totalType;
+    items->type = (char)type;
+    items->pollut = pollut;
+    items->v = v;
+}
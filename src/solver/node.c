@@ -37,6 +37,9 @@
 //   Build 5.2.2:
 //   - Warning restored for node full depth being increased to crown of highest
 //     connecting link.
+//   Build 5.2.4:
+//   - Storage evaporation uses the evaporation rate saved for routing.
+//   - node_getResults only computes the results asked for.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -494,11 +497,12 @@ double node_getSystemOutflow(int j, int *isFlooded)
 
 //=============================================================================
 
-void node_getResults(int j, double f, float x[])
+void node_getResults(int j, double f, float x[], char used[])
 //
 //  Input:   j = node index
 //           f = weighting factor
 //           x[] = array of nodal reporting variables
+//           used = TRUE for each variable to compute (NULL if all)
 //  Output:  none
 //  Purpose: computes weighted average of old and new results at a node.
 //
@@ -522,6 +526,7 @@ void node_getResults(int j, double f, float x[])
 
     if ( !IgnoreQuality ) for (p = 0; p < Nobjects[POLLUT]; p++)
     {
+        if ( used && !used[NODE_QUAL+p] ) continue;
         z = f1*Node[j].oldQual[p] + f*Node[j].newQual[p];
         x[NODE_QUAL+p] = (float)z;
     }
@@ -1069,7 +1074,7 @@ double storage_getLosses(int j, double tStep)
 
         // --- get node's evap. rate (ft/s) &  exfiltration object
         k = Node[j].subIndex;
-        evapRate = Evap.rate * Storage[k].fEvap;
+        evapRate = RouteEvapRate * Storage[k].fEvap;
         exfil = Storage[k].exfil;
 
         // --- if either of these apply
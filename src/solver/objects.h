@@ -56,6 +56,14 @@
 //  - Support added for tracking a gage's prior n-hour rainfall total.
 //  - Removed extIfaceInflow member from ExtInflow struct.
 //  - Refactored TRptFlags struct.
+//  Build 5.2.4:
+//  - Dynamic wave routing state arrays (TDwState) added.
+//  - Inverse lookup index (TInvIndex) added to Transect and Shape objects.
+//  - Average BMP removal of each pollutant (avgBmpEffic) added to TSubcatch.
+//  - Binary results block size (outputBlock) added to TRptFlags.
+//  - Binary results compression flag (outputCompressed) added to TRptFlags.
+//  - Selections of binary results variables (subcatchVars, nodeVars &
+//    linkVars) added to TRptFlags.
 //-----------------------------------------------------------------------------
 
 #ifndef OBJECTS_H
@@ -415,6 +423,7 @@ typedef struct
    double*       pondedQual;      // ponded surface water quality (mass)
    double*       concPonded;      // ponded surface water quality concentration (mass/L) (OWA addition)
    double*       totalLoad;       // total washoff load (lbs or kg)
+   double*       avgBmpEffic;     // average BMP removal of each pollutant
    double*       surfaceBuildup;  // current surface buildup (mass) (OWA addition)
 }  TSubcatch;
 
@@ -609,6 +618,17 @@ typedef struct
    double        rBot;            // radius of bottom section
 }  TXsect;
 
+//-------------------------------------
+// GEOMETRY TABLE INVERSE LOOKUP INDEX
+//-------------------------------------
+#define  N_INV_BINS  128          // number of bins in an inverse lookup index
+typedef struct
+{
+    double        yMin;                     // table value at start of 1st bin
+    double        binsPerY;                 // bins per unit of table value
+    unsigned char start[N_INV_BINS];        // table interval at start of bin
+}   TInvIndex;
+
 //--------------------------------------
 // CROSS SECTION TRANSECT DATA STRUCTURE
 //--------------------------------------
@@ -630,6 +650,7 @@ typedef struct
     double       hradTbl[N_TRANSECT_TBL];   // table of hyd. radius v. depth
     double       widthTbl[N_TRANSECT_TBL];  // table of top width v. depth
     int          nTbl;                      // size of geometry tables
+    TInvIndex    areaIndex;                 // inverse lookup index of areaTbl
 }   TTransect;
 
 //-------------------------------
@@ -667,6 +688,7 @@ typedef struct
     double       areaTbl[N_SHAPE_TBL];      // table of area v. depth
     double       hradTbl[N_SHAPE_TBL];      // table of hyd. radius v. depth
     double       widthTbl[N_SHAPE_TBL];     // table of top width v. depth
+    TInvIndex    areaIndex;                 // inverse lookup index of areaTbl
 }   TShape;
 
 //------------
@@ -744,6 +766,32 @@ typedef struct
    char          fullState;       // determines if either or both ends full
 }  TConduit;
 
+//---------------------------
+// DYNAMIC WAVE ROUTING STATE
+//---------------------------
+// Copies of the node and link properties used most often by the dynamic
+// wave solver, held in separate arrays (indexed by node or link) so that
+// its loops read contiguous memory rather than whole object structures.
+// The copies are updated whenever the properties themselves change.
+typedef struct
+{
+   double*       nodeInvert;      // node invert elevation (ft)
+   double*       nodeDepth;       // node water depth (ft)
+   int*          node1;           // link's upstream node index
+   int*          node2;           // link's downstream node index
+   double*       z1;              // elev. of link invert at upstream node (ft)
+   double*       z2;              // elev. of link invert at downstream node (ft)
+   double*       barrels;         // number of barrels in link
+   double*       flow;            // link flow (cfs)
+   double*       area;            // conduit mid-length flow area (ft2)
+   double*       volume;          // link flow volume (ft3)
+   double*       froude;          // link Froude number
+   double*       dqdh;            // change in link flow w.r.t. head (ft2/sec)
+   double*       surfArea1;       // link's upstream surface area (ft2)
+   double*       surfArea2;       // link's downstream surface area (ft2)
+   double*       lossRate;        // conduit evap. + seepage loss rate (cfs)
+}  TDwState;
+
 //------------
 // PUMP OBJECT
 //------------
@@ -877,6 +925,13 @@ typedef struct
    char          controls;        // TRUE if control actions reported
    char          averages;        // TRUE if report step averaged results used
    int           linesPerPage;    // number of lines printed per page
+   int           outputBlock;     // periods per element-major block of
+                                  // binary results (0 if period-major)
+   char          outputCompressed; // TRUE if blocks of binary results are
+                                   // compressed
+   char*         subcatchVars;    // TRUE for each subcatchment, node or
+   char*         nodeVars;        // link variable (including pollutants)
+   char*         linkVars;        // saved to binary file (NULL if all are)
 }  TRptFlags;
 
 // OWA EDIT #############################################################################
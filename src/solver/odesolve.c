@@ -7,6 +7,14 @@
 //
 //   Date:     11/15/06
 //   Author:   L. Rossman
+//
+//   Update History
+//   ==============
+//   Build 5.2.4:
+//   - Work arrays moved onto the caller's stack so that the solver can be
+//     used by several threads at once.
+//   - Batch integrator added that advances several independent systems
+//     of equations together, each with its own step size control.
 //-----------------------------------------------------------------------------
 
 #include <stdlib.h>
@@ -19,26 +27,52 @@
 #define PGROW  -0.2
 #define PSHRNK -0.25
 #define ERRCON 1.89e-4    // = (5/SAFETY)^(1/PGROW)
-
+#define MAXEQN 8          // max. number of equations
+#define MAXLANES 32       // max. number of systems advanced together
 
 //-----------------------------------------------------------------------------
 //    Local declarations
 //-----------------------------------------------------------------------------
-int      nmax;      // max. number of equations
-double*  y;         // dependent variable
-double*  yscal;     // scaling factors
-double*  yerr;      // integration errors
-double*  ytemp;     // temporary values of y
-double*  dydx;      // derivatives of y
-double*  ak;        // derivatives at intermediate points
+typedef struct
+{
+    double y[MAXEQN];       // dependent variable
+    double yscal[MAXEQN];   // scaling factors
+    double yerr[MAXEQN];    // integration errors
+    double ytemp[MAXEQN];   // temporary values of y
+    double dydx[MAXEQN];    // derivatives of y
+    double ak[5*MAXEQN];    // derivatives at intermediate points
+} TOdeWork;
+
+// state of one system of equations being integrated in a batch
+typedef struct
+{
+    TOdeWork w;             // work arrays
+    int      lane;          // index of system in the batch
+    int      nstp;          // number of steps taken
+    int      status;        // integration result (-1 if still active)
+    char     newStep;       // 1 if a new step is being started
+    double   x;             // current value of independent variable
+    double   h;             // step size to try when a new step starts
+    double   htry;          // step size currently being tried
+} TOdeLane;
+
+static int nmax;            // max. number of equations
 
 
 // function that integrates over an error-controlled stepsize
-int rkqs(double* x, int n, double htry, double eps, double* hdid,
+int rkqs(TOdeWork* w, double* x, int n, double htry, double eps, double* hdid,
          double* hnext, void (*derivs)(double, double*, double*));
 
 // function that performs the Runge-Kutta integration step
-void rkck(double x, int n, double h, void (*derivs)(double, double*, double*));
+void rkck(TOdeWork* w, double x, int n, double h,
+          void (*derivs)(double, double*, double*));
+
+// functions that advance a batch of systems of equations together
+int  integrateLanes(double ystart[], int first, int nLanes, int n, double x1,
+     double x2, double eps, double h1, void* data,
+     void (*derivs)(void*, int, double, double*, double*));
+void rkckLanes(TOdeLane* active[], int nActive, int n, void* data,
+     void (*derivs)(void*, int, double, double*, double*));
 
 
 //-----------------------------------------------------------------------------
@@ -47,15 +81,8 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*));
 //-----------------------------------------------------------------------------
 int odesolve_open(int n)
 {
-    int n5 = n*5;
-    nmax  = 0;
-    y     = (double *) calloc(n, sizeof(double));
-    yscal = (double *) calloc(n, sizeof(double));
-    dydx  = (double *) calloc(n, sizeof(double));
-    yerr  = (double *) calloc(n, sizeof(double));
-    ytemp = (double *) calloc(n, sizeof(double));
-    ak    = (double *) calloc(n5, sizeof(double));
-    if ( !y || !yscal || !dydx || !yerr || !ytemp || !ak ) return 0;
+    nmax = 0;
+    if ( n > MAXEQN ) return 0;
     nmax = n;
     return 1;
 }
@@ -66,18 +93,6 @@ int odesolve_open(int n)
 //-----------------------------------------------------------------------------
 void odesolve_close()
 {
-    if ( y ) free(y);
-    y = NULL;
-    if ( yscal ) free(yscal);
-    yscal = NULL;
-    if ( dydx ) free(dydx);
-    dydx = NULL;
-    if ( yerr ) free(yerr);
-    yerr = NULL;
-    if ( ytemp ) free(ytemp);
-    ytemp = NULL;
-    if ( ak ) free(ak);
-    ak = NULL;
     nmax = 0;
 }
 
@@ -97,6 +112,9 @@ int odesolve_integrate(double ystart[], int n, double x1, double x2,
     double hdid, hnext;
     double x = x1;
     double h = h1;
+    TOdeWork work;
+    TOdeWork* w = &work;
+    double *y = w->y, *yscal = w->yscal, *dydx = w->dydx;
     if (nmax < n) return 1;
     for (i=0; i<n; i++) y[i] = ystart[i];
     for (nstp=1; nstp<=MAXSTP; nstp++)
@@ -105,7 +123,7 @@ int odesolve_integrate(double ystart[], int n, double x1, double x2,
         for (i=0; i<n; i++)
             yscal[i] = fabs(y[i]) + fabs(dydx[i]*h) + TINY;
         if ((x+h-x2)*(x+h-x1) > 0.0) h = x2 - x;
-        errcode = rkqs(&x,n,h,eps,&hdid,&hnext,derivs);
+        errcode = rkqs(w,&x,n,h,eps,&hdid,&hnext,derivs);
         if (errcode) break;
         if ((x-x2)*(x2-x1) >= 0.0)
         {
@@ -119,7 +137,146 @@ int odesolve_integrate(double ystart[], int n, double x1, double x2,
 }
 
 
-int rkqs(double* x, int n, double htry, double eps, double* hdid,
+int odesolve_integrateBatch(double ystart[], int nLanes, int n, double x1,
+      double x2, double eps, double h1, void* data,
+      void (*derivs)(void*, int, double, double*, double*))
+//---------------------------------------------------------------
+//   Integrates nLanes independent systems of n equations each from
+//   x1 to x2. ystart[] holds the starting values of each system one
+//   after another and receives their values at x2. derivs computes
+//   the derivatives of the system in a given lane, with data being
+//   passed through to it. Each system follows exactly the same
+//   sequence of adaptive steps that odesolve_integrate would take
+//   for it, but all systems take their steps together, one Runge-
+//   Kutta stage at a time. Returns the number of systems that could
+//   not be integrated (whose starting values are left unchanged).
+//---------------------------------------------------------------
+{
+    int k, m, nFailed = 0;
+    if (nmax < n) return nLanes;
+    for (k=0; k<nLanes; k+=MAXLANES)
+    {
+        m = nLanes - k;
+        if (m > MAXLANES) m = MAXLANES;
+        nFailed += integrateLanes(ystart, k, m, n, x1, x2, eps, h1, data,
+                                  derivs);
+    }
+    return nFailed;
+}
+
+
+int integrateLanes(double ystart[], int first, int nLanes, int n, double x1,
+      double x2, double eps, double h1, void* data,
+      void (*derivs)(void*, int, double, double*, double*))
+//---------------------------------------------------------------
+//   Batch version of odesolve_integrate (and rkqs) for the nLanes
+//   systems that start at lane first.
+//---------------------------------------------------------------
+{
+    int    i, k, nActive, nFailed = 0;
+    double err, errmax, htemp, xnew;
+    double *y, *yscal, *yerr, *ytemp, *dydx;
+    TOdeLane  lanes[MAXLANES];
+    TOdeLane* active[MAXLANES];
+    TOdeLane* ln;
+
+    // --- start every lane at x1 with initial stepsize h1
+    for (k=0; k<nLanes; k++)
+    {
+        ln = &lanes[k];
+        ln->lane = first + k;
+        ln->nstp = 1;
+        ln->status = -1;
+        ln->newStep = 1;
+        ln->x = x1;
+        ln->h = h1;
+        for (i=0; i<n; i++) ln->w.y[i] = ystart[ln->lane*n + i];
+        active[k] = ln;
+    }
+    nActive = nLanes;
+
+    while (nActive > 0)
+    {
+        // --- lanes starting a new step find their derivatives,
+        //     scaling factors and the stepsize to try
+        for (k=0; k<nActive; k++)
+        {
+            ln = active[k];
+            if (!ln->newStep) continue;
+            y = ln->w.y; yscal = ln->w.yscal; dydx = ln->w.dydx;
+            derivs(data, ln->lane, ln->x, y, dydx);
+            for (i=0; i<n; i++)
+                yscal[i] = fabs(y[i]) + fabs(dydx[i]*ln->h) + TINY;
+            if ((ln->x+ln->h-x2)*(ln->x+ln->h-x1) > 0.0) ln->h = x2 - ln->x;
+            ln->htry = ln->h;
+            ln->newStep = 0;
+        }
+
+        // --- take a Runge-Kutta-Cash-Karp step in all active lanes
+        rkckLanes(active, nActive, n, data, derivs);
+
+        // --- check the error of each lane's step
+        for (k=0; k<nActive; k++)
+        {
+            ln = active[k];
+            yerr = ln->w.yerr; yscal = ln->w.yscal; ytemp = ln->w.ytemp;
+            errmax = 0.0;
+            for (i=0; i<n; i++)
+            {
+                err = fabs(yerr[i]/yscal[i]);
+                if (err > errmax) errmax = err;
+            }
+            errmax /= eps;
+
+            // --- error too large; reduce stepsize & repeat
+            if (errmax > 1.0)
+            {
+                htemp = SAFETY*ln->htry*pow(errmax,PSHRNK);
+                if (ln->htry >= 0)
+                {
+                    if (htemp > 0.1*ln->htry) ln->htry = htemp;
+                    else ln->htry = 0.1*ln->htry;
+                }
+                else
+                {
+                    if (htemp < 0.1*ln->htry) ln->htry = htemp;
+                    else ln->htry = 0.1*ln->htry;
+                }
+                xnew = ln->x + ln->htry;
+                if (xnew == ln->x) ln->status = 3;
+                continue;
+            }
+
+            // --- step succeeded; find size of next step
+            if (errmax > ERRCON) ln->h = SAFETY*ln->htry*pow(errmax,PGROW);
+            else ln->h = 5.0*ln->htry;
+            ln->x += ln->htry;
+            for (i=0; i<n; i++) ln->w.y[i] = ytemp[i];
+            if ((ln->x-x2)*(x2-x1) >= 0.0)
+            {
+                for (i=0; i<n; i++) ystart[ln->lane*n + i] = ln->w.y[i];
+                ln->status = 0;
+            }
+            else if (fabs(ln->h) <= 0.0) ln->status = 2;
+            else if (++ln->nstp > MAXSTP) ln->status = 3;
+            else ln->newStep = 1;
+        }
+
+        // --- drop lanes that have finished from the active list
+        i = 0;
+        for (k=0; k<nActive; k++)
+        {
+            ln = active[k];
+            if (ln->status < 0) active[i++] = ln;
+            else if (ln->status > 0) nFailed++;
+        }
+        nActive = i;
+    }
+    return nFailed;
+}
+
+
+int rkqs(TOdeWork* w, double* x, int n, double htry, double eps, double* hdid,
          double* hnext, void (*derivs)(double, double*, double*))
 //---------------------------------------------------------------
 //   Fifth-order Runge-Kutta integration step with monitoring of
@@ -131,13 +288,14 @@ int rkqs(double* x, int n, double htry, double eps, double* hdid,
 {
     int i;
     double err, errmax, h, htemp, xnew, xold = *x;
+    double *y = w->y, *yscal = w->yscal, *yerr = w->yerr, *ytemp = w->ytemp;
 
     // --- set initial stepsize
     h = htry;
     for (;;)
     {
         // --- take a Runge-Kutta-Cash-Karp step
-        rkck(xold, n, h, derivs);
+        rkck(w, xold, n, h, derivs);
 
         // --- compute scaled maximum error
         errmax = 0.0;
@@ -180,7 +338,8 @@ int rkqs(double* x, int n, double htry, double eps, double* hdid,
 }
 
 
-void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
+void rkck(TOdeWork* w, double x, int n, double h,
+          void (*derivs)(double, double*, double*))
 //----------------------------------------------------------------------
 //   Uses the Runge-Kutta-Cash-Karp method to advance y[] at x
 //   over stepsize h.
@@ -196,6 +355,8 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
     double dc1=c1-2825.0/27648.0, dc3=c3-18575.0/48384.0,
            dc4=c4-13525.0/55296.0, dc6=c6-0.25;
     int i;
+    double *y = w->y, *yerr = w->yerr, *ytemp = w->ytemp, *dydx = w->dydx;
+    double *ak = w->ak;
     int n2 = n*2;
     int n3 = n*3;
     int n4 = n*4;
@@ -232,3 +393,86 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
     for (i=0; i<n; i++)
         yerr[i] = h*(dc1*dydx[i] +dc3*ak3[i] + dc4*ak4[i] + dc5*ak5[i] + dc6*ak6[i]);
 }
+
+
+void rkckLanes(TOdeLane* active[], int nActive, int n, void* data,
+     void (*derivs)(void*, int, double, double*, double*))
+//----------------------------------------------------------------------
+//   Batch version of rkck that completes each stage for all active
+//   lanes before moving on to the next one.
+//----------------------------------------------------------------------
+{
+    double a2=0.2, a3=0.3, a4=0.6, a5=1.0, a6=0.875,
+           b21=0.2, b31=3.0/40.0, b32=9.0/40.0, b41=0.3, b42= -0.9, b43=1.2,
+           b51= -11.0/54.0, b52=2.5, b53= -70.0/27.0, b54=35.0/27.0,
+           b61=1631.0/55296.0, b62=175.0/512.0, b63=575.0/13824.0,
+           b64=44275.0/110592.0, b65=253.0/4096.0, c1=37.0/378.0,
+           c3=250.0/621.0, c4=125.0/594.0, c6=512.0/1771.0,
+           dc5= -277.0/14336.0;
+    double dc1=c1-2825.0/27648.0, dc3=c3-18575.0/48384.0,
+           dc4=c4-13525.0/55296.0, dc6=c6-0.25;
+    int i, k;
+    double h, x;
+    double *y, *ytemp, *dydx, *ak2, *ak3, *ak4, *ak5, *ak6;
+    TOdeLane* ln;
+
+    #define LANE_ARRAYS \
+        ln = active[k]; x = ln->x; h = ln->htry; \
+        y = ln->w.y; ytemp = ln->w.ytemp; dydx = ln->w.dydx; \
+        ak2 = ln->w.ak; ak3 = ak2 + n; ak4 = ak3 + n; ak5 = ak4 + n; \
+        ak6 = ak5 + n
+
+    for (k=0; k<nActive; k++)
+    {
+        LANE_ARRAYS;
+        for (i=0; i<n; i++)
+            ytemp[i] = y[i] + b21*h*dydx[i];
+        derivs(data, ln->lane, x+a2*h, ytemp, ak2);
+    }
+
+    for (k=0; k<nActive; k++)
+    {
+        LANE_ARRAYS;
+        for (i=0; i<n; i++)
+            ytemp[i] = y[i] + h*(b31*dydx[i]+b32*ak2[i]);
+        derivs(data, ln->lane, x+a3*h, ytemp, ak3);
+    }
+
+    for (k=0; k<nActive; k++)
+    {
+        LANE_ARRAYS;
+        for (i=0; i<n; i++)
+            ytemp[i] = y[i] + h*(b41*dydx[i]+b42*ak2[i] + b43*ak3[i]);
+        derivs(data, ln->lane, x+a4*h, ytemp, ak4);
+    }
+
+    for (k=0; k<nActive; k++)
+    {
+        LANE_ARRAYS;
+        for (i=0; i<n; i++)
+            ytemp[i] = y[i] + h*(b51*dydx[i]+b52*ak2[i] + b53*ak3[i] +
+                       b54*ak4[i]);
+        derivs(data, ln->lane, x+a5*h, ytemp, ak5);
+    }
+
+    for (k=0; k<nActive; k++)
+    {
+        LANE_ARRAYS;
+        for (i=0; i<n; i++)
+            ytemp[i] = y[i] + h*(b61*dydx[i]+b62*ak2[i] + b63*ak3[i] +
+                       b64*ak4[i] + b65*ak5[i]);
+        derivs(data, ln->lane, x+a6*h, ytemp, ak6);
+    }
+
+    for (k=0; k<nActive; k++)
+    {
+        LANE_ARRAYS;
+        for (i=0; i<n; i++)
+            ytemp[i] = y[i] + h*(c1*dydx[i] + c3*ak3[i] + c4*ak4[i] +
+                       c6*ak6[i]);
+        for (i=0; i<n; i++)
+            ln->w.yerr[i] = h*(dc1*dydx[i] +dc3*ak3[i] + dc4*ak4[i] +
+                            dc5*ak5[i] + dc6*ak6[i]);
+    }
+    #undef LANE_ARRAYS
+}
@@ -14,6 +14,9 @@ int  odesolve_open(int n);
 void odesolve_close(void);
 int  odesolve_integrate(double ystart[], int n, double x1, double x2,
      double eps, double h1, void (*derivs)(double, double*, double*));
+int  odesolve_integrateBatch(double ystart[], int nLanes, int n, double x1,
+     double x2, double eps, double h1, void* data,
+     void (*derivs)(void*, int, double, double*, double*));
 
 
 #endif //ODESOLVE_H
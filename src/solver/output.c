@@ -28,6 +28,16 @@
 //   - Large file support added.
 //   Build5.2.1:
 //   - Corrects the definition of F_OFF for non-Microsoft C/C++ compilers.
+//   Build 5.2.4:
+//   - Results of each reporting period gathered in memory and saved in
+//     blocks of periods, which can be transposed into element-major order
+//     with an index of block positions.
+//   - Blocks of element-major results can be compressed (see
+//     shared/xorcodec.h).
+//   - Blocks of results saved to file by a writer thread when more than
+//     one thread is used.
+//   - Only the variables selected for each type of object are computed and
+//     saved to file.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -35,22 +45,53 @@
 #ifdef _MSC_VER    // Windows (32-bit and 64-bit)
   #define F_OFF __int64
   #define F_SEEK _fseeki64
+  #define F_TELL _ftelli64
 #else              // Other platforms
   #define F_OFF off_t
   #define F_SEEK fseeko
+  #define F_TELL ftello
 #endif
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <math.h>
+#include <time.h>
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
 #include "headers.h"
+#include "shared/xorcodec.h"
 #include "version.h" // OWA manages model version differently from EPA SWMM
 
-// Definition of 4-byte integer, 4-byte real and 8-byte real types
+// Definition of 4-byte integer, 8-byte integer, 4-byte real and 8-byte
+// real types
 #define INT4  int
+#define INT8  long long
 #define REAL4 float
 #define REAL8 double
 
+// Version of the layout record that ends a file saved in blocks
+#define LAYOUT_VERSION 1
+
+// Number of blocks of results in the ring shared with the writer thread
+#define RING_SIZE 2
+
+// Locking & signalling of the ring of blocks
+#ifdef _WIN32
+  #define LOCK_RING()    EnterCriticalSection(&RingLock)
+  #define UNLOCK_RING()  LeaveCriticalSection(&RingLock)
+  #define WAIT_RING(c)   SleepConditionVariableCS(&(c), &RingLock, INFINITE)
+  #define SIGNAL_RING(c) WakeAllConditionVariable(&(c))
+#else
+  #define LOCK_RING()    pthread_mutex_lock(&RingLock)
+  #define UNLOCK_RING()  pthread_mutex_unlock(&RingLock)
+  #define WAIT_RING(c)   pthread_cond_wait(&(c), &RingLock)
+  #define SIGNAL_RING(c) pthread_cond_broadcast(&(c))
+#endif
+
 enum InputDataType {INPUT_TYPE_CODE, INPUT_AREA, INPUT_INVERT, INPUT_MAX_DEPTH,
                     INPUT_OFFSET, INPUT_LENGTH};
 
@@ -59,6 +100,31 @@ typedef struct
     REAL4* xAvg;
 }   TAvgResults;
 
+typedef struct
+{
+    int    block;                      // block the results were read from
+    F_OFF  first;                      // index of first result
+    int    n;                          // number of results
+    REAL4* x;                          // each result's values over the block
+}   TDecodedResults;
+
+typedef struct
+{
+    int    size;                       // number of the object type's variables
+    INT4*  codes;                      // code of each variable saved
+    char*  used;                       // TRUE for each variable computed for
+                                       // a reported object (NULL if all are)
+    char*  sysUsed;                    // TRUE for each variable computed for
+                                       // an object not reported on
+}   TOutputVars;
+
+typedef struct
+{
+    REAL8* dates;                      // dates of the block's periods
+    REAL4* results;                    // results of the block's periods
+    int    size;                       // number of periods in the block
+}   TResultsBlock;
+
 //-----------------------------------------------------------------------------
 //  Shared variables    
 //-----------------------------------------------------------------------------
@@ -76,6 +142,70 @@ static INT4      NumPolluts;           // number of pollutants reported on
 
 static REAL4     SysResults[MAX_SYS_RESULTS];    // values of system output vars.
 
+//  Only the variables selected for each type of object in the [REPORT]
+//  section are saved to file (NumSubcatchVars, NumNodeVars & NumLinkVars
+//  count just those). A reported object's results are computed for them
+//  alone (along with those needed for system-wide results) and gathered
+//  into the period's results, while an object not reported on only has
+//  the results needed for system-wide results computed.
+static TOutputVars OutputVars[LINK+1]; // variables of each type of object
+
+//  Results are saved in blocks of BlockPeriods reporting periods. A block
+//  holds the dates of its periods followed by its results, with the values
+//  of each result for all of the block's periods stored together (i.e., the
+//  block's periods are transposed into element-major order). A block of a
+//  single period is the original period-major layout. When larger blocks
+//  are used the file ends with an index of block positions and a layout
+//  record, and closes with BLOCKMAGICNUMBER instead of MAGICNUMBER.
+static F_OFF     NumResults;           // number of results saved per period
+static int       BlockPeriods;         // reporting periods saved per block
+static int       BlockSize;            // periods held in current block
+static REAL8*    BlockDates;           // dates of periods in current block
+static REAL4*    BlockResults;         // results of periods in current block
+static REAL4*    PeriodResults;        // results of current period
+static F_OFF*    BlockPos;             // file position of each saved block
+static int       NumBlocks;            // number of blocks saved
+static int       MaxBlocks;            // size of BlockPos array
+static int       FileWasRead;          // TRUE if results read back from file
+
+//  Blocks can also be compressed, with each result's series of values for
+//  the block's periods encoded separately. The encoded series follow the
+//  block's dates and are followed by the offset (from the first series)
+//  where each of them ends.
+static int       Encoding;             // encoding of results (xorcodec.h)
+static unsigned char* EncodedResults;  // encoded series of results
+static size_t    EncodedSize;          // size of EncodedResults (bytes)
+static INT4*     SeriesEnds;           // where each encoded series ends
+static TDecodedResults Decoded[2];     // results last read back from file
+static int       LastDecoded;          // index of last Decoded entry used
+static double    RawBytes;             // size of results as 4-byte reals
+static double    SavedBytes;           // size of results saved to file
+static double    WriteTime;            // time spent saving blocks (sec)
+
+//  When more than one thread is used, full blocks are handed to a writer
+//  thread through a ring of blocks so that the solver only has to wait
+//  for the file when every other block of the ring is still being saved.
+//  The writer thread alone touches the file until the ring is drained.
+static TResultsBlock Ring[RING_SIZE];  // blocks of results
+static int       RingSlot;             // block being filled by solver
+static int       WriteSlot;            // next block to be saved by writer
+static int       QueuedBlocks;         // number of full blocks not yet saved
+static int       WriterRunning;        // TRUE if writer thread is running
+static int       StopWriter;           // TRUE if writer thread should stop
+static int       WriteError;           // error code from saving a block
+static double    WaitTime;             // time solver waited on writer (sec)
+#ifdef _WIN32
+static HANDLE             WriterThread;
+static CRITICAL_SECTION   RingLock;
+static CONDITION_VARIABLE BlockQueued; // signalled when a block is queued
+static CONDITION_VARIABLE BlockSaved;  // signalled when a block is saved
+#else
+static pthread_t          WriterThread;
+static pthread_mutex_t    RingLock;
+static pthread_cond_t     BlockQueued; // signalled when a block is queued
+static pthread_cond_t     BlockSaved;  // signalled when a block is saved
+#endif
+
 static TAvgResults* AvgLinkResults;
 static TAvgResults* AvgNodeResults;
 static int          Nsteps;
@@ -93,14 +223,35 @@ REAL4*           LinkResults;
 //-----------------------------------------------------------------------------
 static void output_openOutFile(void);
 static void output_saveID(char* id, FILE* file);
-static void output_saveSubcatchResults(double reportTime, FILE* file);
-static void output_saveNodeResults(double reportTime, FILE* file);
-static void output_saveLinkResults(double reportTime, FILE* file);
+static void output_saveSubcatchResults(double reportTime, REAL4* x);
+static void output_saveNodeResults(double reportTime, REAL4* x);
+static void output_saveLinkResults(double reportTime, REAL4* x);
+static int  output_openVars(int type, int size, char* selected);
+static void output_closeVars(void);
+static void output_scatterResults(int type, int n, REAL4* x);
+static int  output_openBlocks(void);
+static void output_closeBlocks(void);
+static void output_savePeriod(REAL8 date);
+static void output_saveBlock(void);
+static void output_writeBlock(TResultsBlock* block);
+static void output_saveLayout(void);
+static void output_saveEncodedBlock(TResultsBlock* block);
+static REAL4* output_decodeResults(int b, int size, F_OFF first, int n);
+static void output_readResults(long period, F_OFF first, int n, REAL4* x);
+static void output_startWriter(void);
+static void output_stopWriter(void);
+static void output_waitForWriter(void);
+static double output_getTime(void);
+#ifdef _WIN32
+static DWORD WINAPI output_runWriter(LPVOID arg);
+#else
+static void* output_runWriter(void* arg);
+#endif
 
 static int  output_openAvgResults(void);
 static void output_closeAvgResults(void);
 static void output_initAvgResults(void);
-static void output_saveAvgResults(FILE* file);
+static void output_saveAvgResults(REAL4* x);
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -143,15 +294,23 @@ int output_open()
 
     // --- subcatchment results consist of Rainfall, Snowdepth, Evap, 
     //     Infil, Runoff, GW Flow, GW Elev, GW Sat, and Washoff
-    NumSubcatchVars = MAX_SUBCATCH_RESULTS - 1 + NumPolluts;
+    NumSubcatchVars = output_openVars(SUBCATCH,
+        MAX_SUBCATCH_RESULTS - 1 + NumPolluts, RptFlags.subcatchVars);
 
     // --- node results consist of Depth, Head, Volume, Lateral Inflow,
     //     Total Inflow, Overflow and Quality
-    NumNodeVars = MAX_NODE_RESULTS - 1 + NumPolluts;
+    NumNodeVars = output_openVars(NODE,
+        MAX_NODE_RESULTS - 1 + NumPolluts, RptFlags.nodeVars);
 
     // --- link results consist of Depth, Flow, Velocity, Volume,
     //     Capacity and Quality
-    NumLinkVars = MAX_LINK_RESULTS - 1 + NumPolluts;
+    NumLinkVars = output_openVars(LINK,
+        MAX_LINK_RESULTS - 1 + NumPolluts, RptFlags.linkVars);
+    if ( NumSubcatchVars < 0 || NumNodeVars < 0 || NumLinkVars < 0 )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return ErrorCode;
+    }
 
     // --- get number of objects reported on
     NumSubcatch = 0;
@@ -166,20 +325,29 @@ int output_open()
         + ((F_OFF)NumNodes * (F_OFF)NumNodeVars)
         + ((F_OFF)NumLinks * (F_OFF)NumLinkVars) + MAX_SYS_RESULTS;
     BytesPerPeriod = sizeof(REAL8) + (numResults * sizeof(REAL4));
+    NumResults = numResults;
     Nperiods = 0;
 
     SubcatchResults = NULL;
     NodeResults = NULL;
     LinkResults = NULL;
-    SubcatchResults = (REAL4 *) calloc(NumSubcatchVars, sizeof(REAL4));
-    NodeResults = (REAL4 *) calloc(NumNodeVars, sizeof(REAL4));
-    LinkResults = (REAL4 *) calloc(NumLinkVars, sizeof(REAL4));
+    SubcatchResults = (REAL4 *) calloc(OutputVars[SUBCATCH].size,
+                                       sizeof(REAL4));
+    NodeResults = (REAL4 *) calloc(OutputVars[NODE].size, sizeof(REAL4));
+    LinkResults = (REAL4 *) calloc(OutputVars[LINK].size, sizeof(REAL4));
     if ( !SubcatchResults || !NodeResults || !LinkResults )
     {
         report_writeErrorMsg(ERR_MEMORY, "");
         return ErrorCode;
     }
 
+    // --- allocate memory to hold a block of reporting periods
+    if ( !output_openBlocks() )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return ErrorCode;
+    }
+
     // --- allocate memory to store average node & link results per period
     AvgNodeResults = NULL;
     AvgLinkResults = NULL;
@@ -315,68 +483,18 @@ int output_open()
     // --- save number & codes of subcatchment result variables
     k = NumSubcatchVars;
     fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_RAINFALL;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_SNOWDEPTH;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_EVAP;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_INFIL;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_RUNOFF;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_GW_FLOW;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_GW_ELEV;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = SUBCATCH_SOIL_MOIST;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-
-    for (j=0; j<NumPolluts; j++) 
-    {
-        k = SUBCATCH_WASHOFF + j;
-        fwrite(&k, sizeof(INT4), 1, Fout.file);
-    }
+    fwrite(OutputVars[SUBCATCH].codes, sizeof(INT4), NumSubcatchVars,
+           Fout.file);
 
     // --- save number & codes of node result variables
     k = NumNodeVars;
     fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = NODE_DEPTH;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = NODE_HEAD;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = NODE_VOLUME;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = NODE_LATFLOW;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = NODE_INFLOW;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = NODE_OVERFLOW;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    for (j=0; j<NumPolluts; j++)
-    {
-        k = NODE_QUAL + j;
-        fwrite(&k, sizeof(INT4), 1, Fout.file);
-    }
+    fwrite(OutputVars[NODE].codes, sizeof(INT4), NumNodeVars, Fout.file);
 
     // --- save number & codes of link result variables
     k = NumLinkVars;
     fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = LINK_FLOW;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = LINK_DEPTH;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = LINK_VELOCITY;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = LINK_VOLUME;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = LINK_CAPACITY;
-    fwrite(&k, sizeof(INT4), 1, Fout.file);
-    for (j=0; j<NumPolluts; j++)
-    {
-        k = LINK_QUAL + j;
-        fwrite(&k, sizeof(INT4), 1, Fout.file);
-    }
+    fwrite(OutputVars[LINK].codes, sizeof(INT4), NumLinkVars, Fout.file);
 
     // --- save number & codes of system result variables
     k = MAX_SYS_RESULTS;
@@ -402,6 +520,9 @@ int output_open()
         return ErrorCode;
     }
     OutputStartPos = ftell(Fout.file);
+
+    // --- save blocks of results on a separate thread
+    if ( NumThreads > 1 ) output_startWriter();
     return ErrorCode;
 }
 
@@ -471,30 +592,31 @@ void output_saveResults(double reportTime)
     int i;
     extern TRoutingTotals StepFlowTotals;  // defined in massbal.c
     DateTime reportDate = getDateTime(reportTime);
-    REAL8 date;
+    REAL4* nodeResults;
+    REAL4* linkResults;
 
     // --- initialize system-wide results
     if ( reportDate < ReportStart ) return;
     for (i=0; i<MAX_SYS_RESULTS; i++) SysResults[i] = 0.0f;
 
-    // --- save date corresponding to this elapsed reporting time
-    date = reportDate;
-    fwrite(&date, sizeof(REAL8), 1, Fout.file);
+    // --- locate each object type's results within the period's results
+    nodeResults = PeriodResults + (F_OFF)NumSubcatch * NumSubcatchVars;
+    linkResults = nodeResults + (F_OFF)NumNodes * NumNodeVars;
 
     // --- save subcatchment results
     if (Nobjects[SUBCATCH] > 0)
-        output_saveSubcatchResults(reportTime, Fout.file);
+        output_saveSubcatchResults(reportTime, PeriodResults);
 
     // --- save average routing results over reporting period if called for
-    if ( RptFlags.averages ) output_saveAvgResults(Fout.file);
+    if ( RptFlags.averages ) output_saveAvgResults(nodeResults);
 
     // --- otherwise save interpolated point routing results
     else
     {
         if (Nobjects[NODE] > 0)
-            output_saveNodeResults(reportTime, Fout.file);
+            output_saveNodeResults(reportTime, nodeResults);
         if (Nobjects[LINK] > 0)
-            output_saveLinkResults(reportTime, Fout.file);
+            output_saveLinkResults(reportTime, linkResults);
     }
 
     // --- update & save system-wide flows 
@@ -509,12 +631,15 @@ void output_saveResults(double reportTime)
                              SysResults[SYS_GWFLOW] +
                              SysResults[SYS_IIFLOW] +
                              SysResults[SYS_EXFLOW];
-    fwrite(SysResults, sizeof(REAL4), MAX_SYS_RESULTS, Fout.file);
+    memcpy(PeriodResults + NumResults - MAX_SYS_RESULTS, SysResults,
+           MAX_SYS_RESULTS * sizeof(REAL4));
+
+    // --- add the period to the current block of results
+    output_savePeriod(reportDate);
 
     // --- save outfall flows to interface file if called for
     if ( Foutflows.mode == SAVE_FILE && !IgnoreRouting ) 
         iface_saveOutletResults(reportDate, Foutflows.file);
-    Nperiods++;
 }
 
 //=============================================================================
@@ -527,6 +652,22 @@ void output_end()
 //
 {
     INT4 k;
+
+    // --- wait for the writer thread to save all full blocks
+    output_stopWriter();
+
+    // --- resume writing at the end of the results if any were read back
+    if ( FileWasRead )
+    {
+        F_SEEK(Fout.file, 0, SEEK_END);
+        FileWasRead = FALSE;
+    }
+
+    // --- save any partly filled block of results along with the
+    //     index of blocks if the file is saved in blocks of periods
+    if ( BlockSize > 0 ) output_saveBlock();
+    if ( RptFlags.outputBlock > 0 ) output_saveLayout();
+
     fwrite(&IDStartPos, sizeof(INT4), 1, Fout.file);
     fwrite(&InputStartPos, sizeof(INT4), 1, Fout.file);
     fwrite(&OutputStartPos, sizeof(INT4), 1, Fout.file);
@@ -534,11 +675,17 @@ void output_end()
     fwrite(&k, sizeof(INT4), 1, Fout.file);
     k = (INT4)ErrorCode;
     fwrite(&k, sizeof(INT4), 1, Fout.file);
-    k = MAGICNUMBER;
+    if ( RptFlags.outputBlock > 0 ) k = BLOCKMAGICNUMBER;
+    else k = MAGICNUMBER;
     if (fwrite(&k, sizeof(INT4), 1, Fout.file) < 1)
     {
         report_writeErrorMsg(ERR_OUT_WRITE, "");
     }
+
+    // --- report how well compressed results were saved
+    if ( Encoding != XORCODEC_NONE && !ErrorCode && !RptFlags.disabled )
+        report_writeOutputStats(RawBytes, SavedBytes, WriteTime,
+                                NumThreads > 1 ? WaitTime : -1.0);
 }
 
 //=============================================================================
@@ -553,6 +700,9 @@ void output_close()
     FREE(SubcatchResults);
     FREE(NodeResults);
     FREE(LinkResults);
+    output_stopWriter();
+    output_closeBlocks();
+    output_closeVars();
     output_closeAvgResults();
 }
 
@@ -573,19 +723,21 @@ void output_saveID(char* id, FILE* file)
 
 //=============================================================================
 
-void output_saveSubcatchResults(double reportTime, FILE* file)
+void output_saveSubcatchResults(double reportTime, REAL4* x)
 //
 //  Input:   reportTime = elapsed simulation time (millisec)
-//           file = ptr. to binary output file
+//           x = start of subcatchment results in the period's results
 //  Output:  none
-//  Purpose: writes computed subcatchment results to binary file.
+//  Purpose: saves computed subcatchment results for the reporting period.
 //
 {
-    int      j;
+    int      j, k;
     double   f;
     double   area;
     REAL4    totalArea = 0.0f; 
+    REAL4*   results;
     DateTime reportDate = getDateTime(reportTime);
+    TOutputVars* vars = &OutputVars[SUBCATCH];
 
     // --- update reported rainfall at each rain gage
     for ( j=0; j<Nobjects[GAGE]; j++ )
@@ -596,28 +748,45 @@ void output_saveSubcatchResults(double reportTime, FILE* file)
     // --- find where current reporting time lies between latest runoff times
     f = (reportTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
 
-    // --- write subcatchment results to file
+    // --- save subcatchment results
     for ( j=0; j<Nobjects[SUBCATCH]; j++)
     {
-        // --- retrieve interpolated results for reporting time & write to file
-        subcatch_getResults(j, f, SubcatchResults);
-        if ( Subcatch[j].rptFlag )
-            fwrite(SubcatchResults, sizeof(REAL4), NumSubcatchVars, file);
+        // --- retrieve interpolated results for reporting time (placing
+        //     them in the period's results if subcatchment is reported on
+        //     with all of its variables saved)
+        if ( !Subcatch[j].rptFlag )
+        {
+            results = SubcatchResults;
+            subcatch_getResults(j, f, results, vars->sysUsed);
+        }
+        else if ( vars->used == NULL )
+        {
+            results = x;
+            subcatch_getResults(j, f, results, NULL);
+            x += NumSubcatchVars;
+        }
+        else
+        {
+            results = SubcatchResults;
+            subcatch_getResults(j, f, results, vars->used);
+            for (k = 0; k < NumSubcatchVars; k++) x[k] = results[vars->codes[k]];
+            x += NumSubcatchVars;
+        }
 
         // --- update system-wide results
         area = Subcatch[j].area * UCF(LANDAREA);
         totalArea += (REAL4)area;
         SysResults[SYS_RAINFALL] +=
-            (REAL4)(SubcatchResults[SUBCATCH_RAINFALL] * area);
+            (REAL4)(results[SUBCATCH_RAINFALL] * area);
         SysResults[SYS_SNOWDEPTH] +=
-            (REAL4)(SubcatchResults[SUBCATCH_SNOWDEPTH] * area);
+            (REAL4)(results[SUBCATCH_SNOWDEPTH] * area);
         SysResults[SYS_EVAP] +=
-            (REAL4)(SubcatchResults[SUBCATCH_EVAP] * area);
+            (REAL4)(results[SUBCATCH_EVAP] * area);
         if ( Subcatch[j].groundwater ) SysResults[SYS_EVAP] += 
             (REAL4)(Subcatch[j].groundwater->evapLoss * UCF(EVAPRATE) * area);
         SysResults[SYS_INFIL] +=
-            (REAL4)(SubcatchResults[SUBCATCH_INFIL] * area);
-        SysResults[SYS_RUNOFF] += (REAL4)SubcatchResults[SUBCATCH_RUNOFF];
+            (REAL4)(results[SUBCATCH_INFIL] * area);
+        SysResults[SYS_RUNOFF] += (REAL4)results[SUBCATCH_RUNOFF];
     }
 
     // --- normalize system-wide results to catchment area
@@ -640,59 +809,86 @@ void output_saveSubcatchResults(double reportTime, FILE* file)
 
 //=============================================================================
 
-void output_saveNodeResults(double reportTime, FILE* file)
+void output_saveNodeResults(double reportTime, REAL4* x)
 //
 //  Input:   reportTime = elapsed simulation time (millisec)
-//           file = ptr. to binary output file
+//           x = start of node results in the period's results
 //  Output:  none
-//  Purpose: writes computed node results to binary file.
+//  Purpose: saves computed node results for the reporting period.
 //
 {
-    int j;
+    int j, k;
+    REAL4* results;
+    TOutputVars* vars = &OutputVars[NODE];
 
     // --- find where current reporting time lies between latest routing times
     double f = (reportTime - OldRoutingTime) /
                (NewRoutingTime - OldRoutingTime);
 
-    // --- write node results to file
+    // --- save node results
     for (j=0; j<Nobjects[NODE]; j++)
     {
-        // --- retrieve interpolated results for reporting time & write to file
-        node_getResults(j, f, NodeResults);
-        if ( Node[j].rptFlag )
-            fwrite(NodeResults, sizeof(REAL4), NumNodeVars, file);
-        stats_updateMaxNodeDepth(j, NodeResults[NODE_DEPTH]);
+        // --- retrieve interpolated results for reporting time (placing
+        //     them in the period's results if node is reported on with
+        //     all of its variables saved)
+        if ( !Node[j].rptFlag )
+        {
+            results = NodeResults;
+            node_getResults(j, f, results, vars->sysUsed);
+        }
+        else if ( vars->used == NULL )
+        {
+            results = x;
+            node_getResults(j, f, results, NULL);
+            x += NumNodeVars;
+        }
+        else
+        {
+            results = NodeResults;
+            node_getResults(j, f, results, vars->used);
+            for (k = 0; k < NumNodeVars; k++) x[k] = results[vars->codes[k]];
+            x += NumNodeVars;
+        }
+        stats_updateMaxNodeDepth(j, results[NODE_DEPTH]);
 
         // --- update system-wide storage volume 
-        SysResults[SYS_STORAGE] += NodeResults[NODE_VOLUME];
+        SysResults[SYS_STORAGE] += results[NODE_VOLUME];
     }
 }
 
 //=============================================================================
 
-void output_saveLinkResults(double reportTime, FILE* file)
+void output_saveLinkResults(double reportTime, REAL4* x)
 //
 //  Input:   reportTime = elapsed simulation time (millisec)
-//           file = ptr. to binary output file
+//           x = start of link results in the period's results
 //  Output:  none
-//  Purpose: writes computed link results to binary file.
+//  Purpose: saves computed link results for the reporting period.
 //
 {
-    int j;
+    int j, k;
     double f;
     double z;
+    TOutputVars* vars = &OutputVars[LINK];
 
     // --- find where current reporting time lies between latest routing times
     f = (reportTime - OldRoutingTime) / (NewRoutingTime - OldRoutingTime);
 
-    // --- write link results to file
+    // --- save link results
     for (j=0; j<Nobjects[LINK]; j++)
     {
-        // --- retrieve interpolated results for reporting time & write to file
+        // --- retrieve interpolated results for reporting time (gathering
+        //     those saved if not all of them are)
         if (Link[j].rptFlag )
         {
-            link_getResults(j, f, LinkResults);
-            fwrite(LinkResults, sizeof(REAL4), NumLinkVars, file);
+            if ( vars->used == NULL ) link_getResults(j, f, x, NULL);
+            else
+            {
+                link_getResults(j, f, LinkResults, vars->used);
+                for (k = 0; k < NumLinkVars; k++)
+                    x[k] = LinkResults[vars->codes[k]];
+            }
+            x += NumLinkVars;
         }
 
         // --- update system-wide results
@@ -711,10 +907,20 @@ void output_readDateTime(long period, DateTime* days)
 //           from the binary output file.
 //
 {
-    F_OFF p = period;
-    F_OFF bytePos = OutputStartPos + (p-1)*BytesPerPeriod;
-    F_SEEK(Fout.file, bytePos, SEEK_SET);
+    int   b = (period - 1) / BlockPeriods;
+    int   i = (period - 1) % BlockPeriods;
+
     *days = NO_DATE;
+    output_waitForWriter();
+
+    // --- date may still be held in the current block of results
+    if ( b >= NumBlocks )
+    {
+        if ( i < BlockSize ) *days = BlockDates[i];
+        return;
+    }
+    F_SEEK(Fout.file, BlockPos[b] + i * sizeof(REAL8), SEEK_SET);
+    FileWasRead = TRUE;
     fread(days, sizeof(REAL8), 1, Fout.file);
 }
 
@@ -729,12 +935,9 @@ void output_readSubcatchResults(long period, int index)
 //           period.
 //
 {
-    long offset = index*NumSubcatchVars;
-    F_OFF p = period;
-    F_OFF bytePos = OutputStartPos + (p-1)*BytesPerPeriod +
-        sizeof(REAL8) + (F_OFF)offset * sizeof(REAL4);
-    F_SEEK(Fout.file, bytePos, SEEK_SET);
-    fread(SubcatchResults, sizeof(REAL4), NumSubcatchVars, Fout.file);
+    F_OFF first = (F_OFF)index * NumSubcatchVars;
+    output_readResults(period, first, NumSubcatchVars, SubcatchResults);
+    output_scatterResults(SUBCATCH, NumSubcatchVars, SubcatchResults);
 }
 
 //=============================================================================
@@ -747,12 +950,10 @@ void output_readNodeResults(long period, int index)
 //  Purpose: reads computed results for a node at a specific time period.
 //
 {
-    long offset = NumSubcatch*NumSubcatchVars + index*NumNodeVars;
-    F_OFF p = period;
-    F_OFF bytePos = OutputStartPos + (p-1)*BytesPerPeriod +
-        sizeof(REAL8) + (F_OFF)offset * sizeof(REAL4);
-    F_SEEK(Fout.file, bytePos, SEEK_SET);
-    fread(NodeResults, sizeof(REAL4), NumNodeVars, Fout.file);
+    F_OFF first = (F_OFF)NumSubcatch * NumSubcatchVars +
+                  (F_OFF)index * NumNodeVars;
+    output_readResults(period, first, NumNodeVars, NodeResults);
+    output_scatterResults(NODE, NumNodeVars, NodeResults);
 }
 
 //=============================================================================
@@ -765,13 +966,695 @@ void output_readLinkResults(long period, int index)
 //  Purpose: reads computed results for a link at a specific time period.
 //
 {
-    long offset = (NumSubcatch*NumSubcatchVars + NumNodes*NumNodeVars + index*NumLinkVars);
-    F_OFF p = period;
-    F_OFF bytePos = OutputStartPos + (p-1)*BytesPerPeriod +
-        sizeof(REAL8) + (F_OFF)offset * sizeof(REAL4);
-    F_SEEK(Fout.file, bytePos, SEEK_SET);
-    fread(LinkResults, sizeof(REAL4), NumLinkVars, Fout.file);
-    fread(SysResults, sizeof(REAL4), MAX_SYS_RESULTS, Fout.file);
+    F_OFF first = (F_OFF)NumSubcatch * NumSubcatchVars +
+                  (F_OFF)NumNodes * NumNodeVars + (F_OFF)index * NumLinkVars;
+    output_readResults(period, first, NumLinkVars, LinkResults);
+    output_scatterResults(LINK, NumLinkVars, LinkResults);
+    output_readResults(period, NumResults - MAX_SYS_RESULTS, MAX_SYS_RESULTS,
+                       SysResults);
+}
+
+//=============================================================================
+
+void output_readResults(long period, F_OFF first, int n, REAL4* x)
+//
+//  Input:   period = index of reporting time period
+//           first = index of first result to read within the period
+//           n = number of results to read
+//  Output:  x = results read
+//  Purpose: reads a consecutive set of results saved for a reporting period.
+//
+{
+    int   j;
+    int   b = (period - 1) / BlockPeriods;
+    int   i = (period - 1) % BlockPeriods;
+    int   size;
+    F_OFF bytePos;
+    REAL4* y;
+
+    // --- results of full blocks must all be saved before reading them
+    output_waitForWriter();
+
+    // --- results may still be held in the current block
+    if ( b >= NumBlocks )
+    {
+        if ( i >= BlockSize ) return;
+        for (j = 0; j < n; j++)
+            x[j] = BlockResults[(first + j) * BlockPeriods + i];
+        return;
+    }
+
+    // --- find number of periods in the block
+    size = (int)MIN(BlockPeriods, Nperiods - (long)b * BlockPeriods);
+
+    // --- decode the series of compressed results
+    if ( Encoding != XORCODEC_NONE )
+    {
+        y = output_decodeResults(b, size, first, n);
+        if ( y == NULL ) return;
+        for (j = 0; j < n; j++) x[j] = y[j * size + i];
+        return;
+    }
+
+    // --- find position of the first result in the block (each result's
+    //     values for the block's periods are stored together)
+    bytePos = BlockPos[b] + size * sizeof(REAL8) +
+              (first * size + i) * sizeof(REAL4);
+    FileWasRead = TRUE;
+
+    // --- read the results in one piece for a block of a single period
+    if ( size == 1 )
+    {
+        F_SEEK(Fout.file, bytePos, SEEK_SET);
+        fread(x, sizeof(REAL4), n, Fout.file);
+        return;
+    }
+    for (j = 0; j < n; j++)
+    {
+        F_SEEK(Fout.file, bytePos, SEEK_SET);
+        fread(&x[j], sizeof(REAL4), 1, Fout.file);
+        bytePos += size * sizeof(REAL4);
+    }
+}
+
+//=============================================================================
+//  Functions for selecting the variables saved for each type of object.
+//=============================================================================
+
+int output_openVars(int type, int size, char* selected)
+//
+//  Input:   type = SUBCATCH, NODE or LINK
+//           size = number of the object type's variables
+//           selected = TRUE for each variable to save (NULL if all)
+//  Output:  returns number of variables saved (or -1 if out of memory)
+//  Purpose: lists the codes of the variables saved for a type of object
+//           and marks those that need to be computed.
+//
+{
+    int v, n = 0;
+    TOutputVars* vars = &OutputVars[type];
+
+    vars->size = size;
+    vars->codes = (INT4 *) calloc(size, sizeof(INT4));
+    vars->sysUsed = (char *) calloc(size, sizeof(char));
+    vars->used = NULL;
+    if ( !vars->codes || !vars->sysUsed ) return -1;
+    for (v = 0; v < size; v++)
+    {
+        if ( selected == NULL || selected[v] ) vars->codes[n++] = v;
+    }
+
+    // --- results that contribute to system-wide results
+    switch ( type )
+    {
+      case SUBCATCH:
+        for (v = SUBCATCH_RAINFALL; v <= SUBCATCH_RUNOFF; v++)
+            vars->sysUsed[v] = TRUE;
+        break;
+      case NODE:
+        vars->sysUsed[NODE_DEPTH] = TRUE;
+        vars->sysUsed[NODE_VOLUME] = TRUE;
+        break;
+    }
+
+    // --- a reported object computes these along with those saved
+    if ( n < size )
+    {
+        vars->used = (char *) calloc(size, sizeof(char));
+        if ( !vars->used ) return -1;
+        for (v = 0; v < size; v++)
+            vars->used[v] = (char)(vars->sysUsed[v] || selected[v]);
+    }
+    return n;
+}
+
+//=============================================================================
+
+void output_closeVars()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for the variables saved for each type of
+//           object.
+//
+{
+    int type;
+
+    for (type = SUBCATCH; type <= LINK; type++)
+    {
+        FREE(OutputVars[type].codes);
+        FREE(OutputVars[type].used);
+        FREE(OutputVars[type].sysUsed);
+    }
+}
+
+//=============================================================================
+
+void output_scatterResults(int type, int n, REAL4* x)
+//
+//  Input:   type = SUBCATCH, NODE or LINK
+//           n = number of variables saved for the type of object
+//           x = an object's saved results followed by room for the rest
+//  Output:  x = the object's results placed by variable code
+//  Purpose: spreads the results read back for an object to the positions
+//           of their variables, zeroing those of variables not saved.
+//
+{
+    int   j;
+    int   v = OutputVars[type].size - 1;
+    INT4* codes = OutputVars[type].codes;
+
+    if ( n == OutputVars[type].size ) return;
+
+    // --- codes are in increasing order so results can be moved in place
+    //     starting from the last one
+    for (j = n - 1; j >= 0; j--)
+    {
+        while ( v > codes[j] ) x[v--] = 0.0f;
+        x[v--] = x[j];
+    }
+    while ( v >= 0 ) x[v--] = 0.0f;
+}
+
+//=============================================================================
+//  Functions for saving results in blocks of reporting periods.
+//=============================================================================
+
+int output_openBlocks()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful
+//  Purpose: allocates memory for holding a block of reporting periods.
+//
+{
+    int j, maxVars, numSlots;
+
+    BlockPeriods = 1;
+    if ( RptFlags.outputBlock > 0 ) BlockPeriods = RptFlags.outputBlock;
+    Encoding = XORCODEC_NONE;
+    if ( RptFlags.outputCompressed ) Encoding = XORCODEC_XOR;
+    RawBytes = 0.0;
+    SavedBytes = 0.0;
+    WriteTime = 0.0;
+    WaitTime = 0.0;
+    WriteError = 0;
+
+    // --- keep the end of each encoded series within reach of a 4-byte
+    //     offset
+    if ( Encoding != XORCODEC_NONE )
+    {
+        while ( BlockPeriods > 1 &&
+                (double)NumResults * xorcodec_maxSize(BlockPeriods) > INT_MAX )
+            BlockPeriods /= 2;
+    }
+    BlockSize = 0;
+    NumBlocks = 0;
+    MaxBlocks = 16;
+    FileWasRead = FALSE;
+    BlockPos = (F_OFF *) calloc(MaxBlocks, sizeof(F_OFF));
+
+    // --- a writer thread needs a ring of blocks to work with
+    numSlots = 1;
+    if ( NumThreads > 1 ) numSlots = RING_SIZE;
+    for (j = 0; j < numSlots; j++)
+    {
+        Ring[j].dates = (REAL8 *) calloc(BlockPeriods, sizeof(REAL8));
+        Ring[j].results = (REAL4 *) calloc((size_t)(BlockPeriods * NumResults),
+                                           sizeof(REAL4));
+        if ( !Ring[j].dates || !Ring[j].results ) return FALSE;
+    }
+    RingSlot = 0;
+    BlockDates = Ring[0].dates;
+    BlockResults = Ring[0].results;
+
+    // --- a single period's results can be placed directly in the block
+    if ( BlockPeriods == 1 ) PeriodResults = BlockResults;
+    else PeriodResults = (REAL4 *) calloc((size_t)NumResults, sizeof(REAL4));
+    if ( !BlockDates || !BlockResults || !BlockPos || !PeriodResults )
+        return FALSE;
+
+    // --- allocate room to encode series of results or decode those of an
+    //     object read back from file
+    if ( Encoding != XORCODEC_NONE )
+    {
+        maxVars = MAX(MAX(NumSubcatchVars, NumNodeVars),
+                      MAX(NumLinkVars, MAX_SYS_RESULTS));
+        EncodedSize = maxVars * xorcodec_maxSize(BlockPeriods);
+        EncodedResults = (unsigned char *) calloc(EncodedSize, 1);
+        SeriesEnds = (INT4 *) calloc((size_t)NumResults, sizeof(INT4));
+        if ( !EncodedResults || !SeriesEnds ) return FALSE;
+        LastDecoded = 0;
+        for (j = 0; j < 2; j++)
+        {
+            Decoded[j].block = -1;
+            Decoded[j].x = (REAL4 *) calloc(maxVars * BlockPeriods,
+                                            sizeof(REAL4));
+            if ( !Decoded[j].x ) return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void output_closeBlocks()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for holding a block of reporting periods.
+//
+{
+    int j;
+
+    if ( PeriodResults != BlockResults ) FREE(PeriodResults);
+    PeriodResults = NULL;
+    BlockResults = NULL;
+    BlockDates = NULL;
+    for (j = 0; j < RING_SIZE; j++)
+    {
+        FREE(Ring[j].results);
+        FREE(Ring[j].dates);
+    }
+    FREE(BlockPos);
+    FREE(EncodedResults);
+    FREE(SeriesEnds);
+    FREE(Decoded[0].x);
+    FREE(Decoded[1].x);
+}
+
+//=============================================================================
+
+void output_savePeriod(REAL8 date)
+//
+//  Input:   date = date/time of the reporting period
+//  Output:  none
+//  Purpose: adds the current period's results to the block of results
+//           being assembled, saving the block to file once it's full.
+//
+{
+    F_OFF r;
+    REAL4* x;
+
+    BlockDates[BlockSize] = date;
+    if ( BlockPeriods > 1 )
+    {
+        x = BlockResults + BlockSize;
+        for (r = 0; r < NumResults; r++) x[r * BlockPeriods] = PeriodResults[r];
+    }
+    BlockSize++;
+    Nperiods++;
+    if ( BlockSize == BlockPeriods ) output_saveBlock();
+}
+
+//=============================================================================
+
+void output_saveBlock()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: saves the current block of reporting periods to file, or hands
+//           it to the writer thread and moves on to the next block of the
+//           ring.
+//
+{
+    int    errcode;
+    double startTime;
+
+    Ring[RingSlot].size = BlockSize;
+    BlockSize = 0;
+    if ( !WriterRunning )
+    {
+        output_writeBlock(&Ring[RingSlot]);
+        errcode = WriteError;
+    }
+    else
+    {
+        LOCK_RING();
+        QueuedBlocks++;
+        SIGNAL_RING(BlockQueued);
+        RingSlot = (RingSlot + 1) % RING_SIZE;
+
+        // --- wait while the next block is still being saved
+        if ( QueuedBlocks == RING_SIZE )
+        {
+            startTime = output_getTime();
+            while ( QueuedBlocks == RING_SIZE ) WAIT_RING(BlockSaved);
+            WaitTime += output_getTime() - startTime;
+        }
+        errcode = WriteError;
+        UNLOCK_RING();
+        BlockDates = Ring[RingSlot].dates;
+        BlockResults = Ring[RingSlot].results;
+        if ( BlockPeriods == 1 ) PeriodResults = BlockResults;
+    }
+    if ( errcode && !ErrorCode ) report_writeErrorMsg(errcode, "");
+}
+
+//=============================================================================
+
+void output_writeBlock(TResultsBlock* block)
+//
+//  Input:   block = a full or partly filled block of reporting periods
+//  Output:  none
+//  Purpose: writes a block of reporting periods to file.
+//
+{
+    F_OFF r;
+    F_OFF* pos;
+    int    size = block->size;
+    double startTime = output_getTime();
+
+    if ( WriteError ) return;
+
+    // --- resume writing at the end of the results if any were read back
+    if ( FileWasRead )
+    {
+        F_SEEK(Fout.file, 0, SEEK_END);
+        FileWasRead = FALSE;
+    }
+
+    // --- record the block's position in the file (along with where it
+    //     ends)
+    if ( NumBlocks + 1 == MaxBlocks )
+    {
+        pos = (F_OFF *) realloc(BlockPos, 2 * MaxBlocks * sizeof(F_OFF));
+        if ( pos == NULL )
+        {
+            WriteError = ERR_MEMORY;
+            return;
+        }
+        BlockPos = pos;
+        MaxBlocks *= 2;
+    }
+    BlockPos[NumBlocks] = F_TELL(Fout.file);
+
+    // --- pack the results of a partly filled block together
+    if ( size < BlockPeriods )
+    {
+        for (r = 1; r < NumResults; r++)
+        {
+            memmove(block->results + r * size,
+                    block->results + r * BlockPeriods,
+                    size * sizeof(REAL4));
+        }
+    }
+
+    // --- write the block's dates and results
+    if ( fwrite(block->dates, sizeof(REAL8), size, Fout.file) < (size_t)size )
+        WriteError = ERR_OUT_WRITE;
+    else if ( Encoding == XORCODEC_NONE )
+    {
+        if ( fwrite(block->results, sizeof(REAL4), (size_t)(size * NumResults),
+                    Fout.file) < (size_t)(size * NumResults) )
+            WriteError = ERR_OUT_WRITE;
+    }
+    else output_saveEncodedBlock(block);
+    NumBlocks++;
+    BlockPos[NumBlocks] = F_TELL(Fout.file);
+
+    // --- update the size of results before and after encoding
+    RawBytes += (double)size * (sizeof(REAL8) + NumResults * sizeof(REAL4));
+    SavedBytes += (double)(BlockPos[NumBlocks] - BlockPos[NumBlocks-1]);
+    WriteTime += output_getTime() - startTime;
+}
+
+//=============================================================================
+
+void output_saveEncodedBlock(TResultsBlock* block)
+//
+//  Input:   block = a block of reporting periods
+//  Output:  none
+//  Purpose: writes the encoded series of each result of a block of
+//           reporting periods to file, followed by where each ends.
+//
+{
+    F_OFF  r;
+    size_t n;
+    size_t used = 0;
+    size_t maxSize = xorcodec_maxSize(block->size);
+    INT4   end = 0;
+
+    for (r = 0; r < NumResults; r++)
+    {
+        // --- write out the series encoded so far when there's no room left
+        if ( used + maxSize > EncodedSize )
+        {
+            if ( fwrite(EncodedResults, 1, used, Fout.file) < used )
+                WriteError = ERR_OUT_WRITE;
+            used = 0;
+        }
+        n = xorcodec_encode(block->results + r * block->size, block->size,
+                            EncodedResults + used);
+        used += n;
+        end += (INT4)n;
+        SeriesEnds[r] = end;
+    }
+    if ( fwrite(EncodedResults, 1, used, Fout.file) < used ||
+         fwrite(SeriesEnds, sizeof(INT4), (size_t)NumResults, Fout.file) <
+         (size_t)NumResults ) WriteError = ERR_OUT_WRITE;
+}
+
+//=============================================================================
+
+REAL4* output_decodeResults(int b, int size, F_OFF first, int n)
+//
+//  Input:   b = index of a compressed block of results saved to file
+//           size = number of periods in the block
+//           first = index of first result to read
+//           n = number of results to read
+//  Output:  returns each result's values over the block's periods
+//           (or NULL if they can't be read)
+//  Purpose: reads and decodes the series of a set of consecutive results
+//           of a compressed block.
+//
+{
+    int    j;
+    size_t bytes;
+    F_OFF  bytePos;
+    TDecodedResults* d;
+
+    // --- check if the results were decoded recently
+    for (j = 0; j < 2; j++)
+    {
+        d = &Decoded[j];
+        if ( d->block == b && d->first == first && d->n == n ) return d->x;
+    }
+
+    // --- otherwise replace the results decoded least recently
+    LastDecoded = 1 - LastDecoded;
+    d = &Decoded[LastDecoded];
+    d->block = -1;
+    FileWasRead = TRUE;
+
+    // --- read where the results' series start and end
+    bytePos = BlockPos[b+1] - (NumResults - first) * sizeof(INT4);
+    SeriesEnds[0] = 0;
+    if ( first > 0 )
+    {
+        F_SEEK(Fout.file, bytePos - sizeof(INT4), SEEK_SET);
+        if ( fread(SeriesEnds, sizeof(INT4), n + 1, Fout.file) < (size_t)n + 1 )
+            return NULL;
+    }
+    else
+    {
+        F_SEEK(Fout.file, bytePos, SEEK_SET);
+        if ( fread(SeriesEnds + 1, sizeof(INT4), n, Fout.file) < (size_t)n )
+            return NULL;
+    }
+
+    // --- read and decode the series
+    bytes = SeriesEnds[n] - SeriesEnds[0];
+    if ( bytes > EncodedSize ) return NULL;
+    F_SEEK(Fout.file, BlockPos[b] + size * sizeof(REAL8) + SeriesEnds[0],
+           SEEK_SET);
+    if ( fread(EncodedResults, 1, bytes, Fout.file) < bytes ) return NULL;
+    for (j = 0; j < n; j++)
+    {
+        if ( xorcodec_decode(EncodedResults + SeriesEnds[j] - SeriesEnds[0],
+                             SeriesEnds[j+1] - SeriesEnds[j], size,
+                             d->x + j * size) != 0 ) return NULL;
+    }
+    d->block = b;
+    d->first = first;
+    d->n = n;
+    return d->x;
+}
+
+//=============================================================================
+
+void output_saveLayout()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: writes the index of block positions and the layout record that
+//           end a file saved in blocks of reporting periods.
+//
+{
+    int  j;
+    INT4 k;
+    INT8 pos;
+    INT8 indexPos = F_TELL(Fout.file);
+
+    // --- the index includes the position where the last block ends
+    for (j = 0; j < NumBlocks; j++)
+    {
+        pos = BlockPos[j];
+        fwrite(&pos, sizeof(INT8), 1, Fout.file);
+    }
+    fwrite(&indexPos, sizeof(INT8), 1, Fout.file);
+
+    // --- layout record
+    k = LAYOUT_VERSION;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = BlockPeriods;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = NumBlocks;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = Encoding;                      // how results were encoded
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    fwrite(&indexPos, sizeof(INT8), 1, Fout.file);
+}
+
+//=============================================================================
+//  Functions for saving blocks of results on a writer thread.
+//=============================================================================
+
+void output_startWriter()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: starts the thread that saves full blocks of results to file
+//           (blocks are saved by the solver's thread if it can't start).
+//
+{
+    RingSlot = 0;
+    WriteSlot = 0;
+    QueuedBlocks = 0;
+    StopWriter = FALSE;
+#ifdef _WIN32
+    InitializeCriticalSection(&RingLock);
+    InitializeConditionVariable(&BlockQueued);
+    InitializeConditionVariable(&BlockSaved);
+    WriterThread = CreateThread(NULL, 0, output_runWriter, NULL, 0, NULL);
+    WriterRunning = (WriterThread != NULL);
+    if ( !WriterRunning ) DeleteCriticalSection(&RingLock);
+#else
+    pthread_mutex_init(&RingLock, NULL);
+    pthread_cond_init(&BlockQueued, NULL);
+    pthread_cond_init(&BlockSaved, NULL);
+    WriterRunning =
+        (pthread_create(&WriterThread, NULL, output_runWriter, NULL) == 0);
+    if ( !WriterRunning )
+    {
+        pthread_cond_destroy(&BlockSaved);
+        pthread_cond_destroy(&BlockQueued);
+        pthread_mutex_destroy(&RingLock);
+    }
+#endif
+}
+
+//=============================================================================
+
+void output_stopWriter()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: stops the writer thread once it has saved all full blocks.
+//
+{
+    int errcode;
+
+    if ( !WriterRunning ) return;
+    LOCK_RING();
+    StopWriter = TRUE;
+    SIGNAL_RING(BlockQueued);
+    UNLOCK_RING();
+#ifdef _WIN32
+    WaitForSingleObject(WriterThread, INFINITE);
+    CloseHandle(WriterThread);
+    DeleteCriticalSection(&RingLock);
+#else
+    pthread_join(WriterThread, NULL);
+    pthread_cond_destroy(&BlockSaved);
+    pthread_cond_destroy(&BlockQueued);
+    pthread_mutex_destroy(&RingLock);
+#endif
+    WriterRunning = FALSE;
+    errcode = WriteError;
+    if ( errcode && !ErrorCode ) report_writeErrorMsg(errcode, "");
+}
+
+//=============================================================================
+
+void output_waitForWriter()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: waits for the writer thread to save all full blocks so that
+//           the file can be read.
+//
+{
+    if ( !WriterRunning ) return;
+    LOCK_RING();
+    while ( QueuedBlocks > 0 ) WAIT_RING(BlockSaved);
+    UNLOCK_RING();
+}
+
+//=============================================================================
+
+#ifdef _WIN32
+DWORD WINAPI output_runWriter(LPVOID arg)
+#else
+void* output_runWriter(void* arg)
+#endif
+//
+//  Input:   arg = not used
+//  Output:  none
+//  Purpose: saves each block of results queued in the ring to file until
+//           asked to stop.
+//
+{
+    TResultsBlock* block;
+
+    (void)arg;
+
+    LOCK_RING();
+    for (;;)
+    {
+        while ( QueuedBlocks == 0 && !StopWriter ) WAIT_RING(BlockQueued);
+        if ( QueuedBlocks == 0 ) break;
+        block = &Ring[WriteSlot];
+        UNLOCK_RING();
+        output_writeBlock(block);
+        LOCK_RING();
+        WriteSlot = (WriteSlot + 1) % RING_SIZE;
+        QueuedBlocks--;
+        SIGNAL_RING(BlockSaved);
+    }
+    UNLOCK_RING();
+    return 0;
+}
+
+//=============================================================================
+
+double output_getTime()
+//
+//  Input:   none
+//  Output:  returns elapsed time from a fixed starting point (sec)
+//  Purpose: reads a monotonic wall clock for timing how long results take
+//           to save.
+//
+{
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + 1.0e-9 * (double)t.tv_nsec;
+#endif
 }
 
 //=============================================================================
@@ -863,17 +1746,18 @@ void output_initAvgResults()
 
 void output_updateAvgResults()
 {
-    int i, j, k, sign;
+    int i, j, k, v, sign;
 
     // --- update average accumulations for nodes
     k = 0;
     for (i = 0; i < Nobjects[NODE]; i++)
     {
         if ( !Node[i].rptFlag ) continue;
-        node_getResults(i, 1.0, NodeResults);
+        node_getResults(i, 1.0, NodeResults, OutputVars[NODE].used);
         for (j = 0; j < NumNodeVars; j++)
         {
-            AvgNodeResults[k].xAvg[j] += NodeResults[j];
+            AvgNodeResults[k].xAvg[j] +=
+                NodeResults[OutputVars[NODE].codes[j]];
         }
         k++;
     }
@@ -883,7 +1767,7 @@ void output_updateAvgResults()
     for (i = 0; i < Nobjects[LINK]; i++)
     {
         if ( !Link[i].rptFlag ) continue;
-        link_getResults(i, 1.0, LinkResults);
+        link_getResults(i, 1.0, LinkResults, OutputVars[LINK].used);
 
         // --- save sign of current flow rate
         sign = SGN(LinkResults[LINK_FLOW]);
@@ -891,22 +1775,23 @@ void output_updateAvgResults()
         // --- add current results to average accumulation
         for (j = 0; j < NumLinkVars; j++)
         {
-            if (j == LINK_CAPACITY)
+            v = OutputVars[LINK].codes[j];
+            if (v == LINK_CAPACITY)
             {
                 // --- accumulate capacity (fraction full) for conduits 
                 if ( Link[i].type == CONDUIT )
-                    AvgLinkResults[k].xAvg[j] += LinkResults[j];
+                    AvgLinkResults[k].xAvg[j] += LinkResults[v];
 
                 // --- for other links capacity is pump speed or regulator
                 //     opening fraction which shouldn't be averaged
                 //     (multiplying by Nsteps+1 will preserve last value
                 //     when average results are taken in saveAvgResults())
                 else  
-                    AvgLinkResults[k].xAvg[j] = LinkResults[j] * (Nsteps+1);
+                    AvgLinkResults[k].xAvg[j] = LinkResults[v] * (Nsteps+1);
             }
 
             // --- accumulation for all other reported results
-            else AvgLinkResults[k].xAvg[j] += LinkResults[j];
+            else AvgLinkResults[k].xAvg[j] += LinkResults[v];
         }
         k++;
     }
@@ -915,21 +1800,19 @@ void output_updateAvgResults()
 
 //=============================================================================
 
-void output_saveAvgResults(FILE* file)
+void output_saveAvgResults(REAL4* x)
 {
     int i, j;
 
     // --- examine each reportable node
     for (i = 0; i < NumNodes; i++)
     {
-        // --- determine the node's average results
+        // --- save the node's average results
         for (j = 0; j < NumNodeVars; j++)
         {
-            NodeResults[j] = AvgNodeResults[i].xAvg[j] / Nsteps;
+            x[j] = AvgNodeResults[i].xAvg[j] / Nsteps;
         }
-
-        // --- save average results to file
-        fwrite(NodeResults, sizeof(REAL4), NumNodeVars, file);
+        x += NumNodeVars;
     }
 
     // --- update each node's max depth and contribution to system storage
@@ -942,14 +1825,12 @@ void output_saveAvgResults(FILE* file)
     // --- examine each reportable link
     for (i = 0; i < NumLinks; i++)
     {
-        // --- determine the link's average results
+        // --- save the link's average results
         for (j = 0; j < NumLinkVars; j++)
         {
-            LinkResults[j] = AvgLinkResults[i].xAvg[j] / Nsteps;
+            x[j] = AvgLinkResults[i].xAvg[j] / Nsteps;
         }
-
-        // --- save average results to file
-        fwrite(LinkResults, sizeof(REAL4), NumLinkVars, file);
+        x += NumLinkVars;
     }
  
     // --- add each link's volume to total system storage
@@ -56,6 +56,10 @@
 //   - Default Inertial Damping changed from SOME to PARTIAL_DAMPING.
 //   - Default CourantFactor changed from 0 (fixed routing time step)
 //   - to 0.75 (variable time step)
+//   - Pollutant buildup for all subcatchment land uses held in a single
+//     contiguous array.
+//   - Binary results saved period by period by default.
+//   - All binary results variables saved by default.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -80,6 +84,8 @@
 //-----------------------------------------------------------------------------
 static HTtable* Htable[MAX_OBJ_TYPES]; // Hash tables for object ID names
 static char     MemPoolAllocated;      // TRUE if memory pool allocated 
+static double*  LandBuildup;           // pollutant buildup on each land use
+                                       //    of each subcatchment
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
@@ -611,6 +617,8 @@ int project_readOption(char* s1, char* s2)
       case ALLOW_PONDING:
       case SLOPE_WEIGHTING:
       case SKIP_STEADY_STATE:
+      case SKIP_CONVERGED:
+      case SEPARATE_BASINS:
       case IGNORE_RAINFALL:
       case IGNORE_SNOWMELT:
       case IGNORE_GWATER:
@@ -624,6 +632,8 @@ int project_readOption(char* s1, char* s2)
           case ALLOW_PONDING:     AllowPonding    = m;  break;
           case SLOPE_WEIGHTING:   SlopeWeighting  = m;  break;
           case SKIP_STEADY_STATE: SkipSteadyState = m;  break;
+          case SKIP_CONVERGED:    SkipConverged   = m;  break;
+          case SEPARATE_BASINS:   SeparateBasins  = m;  break;
           case IGNORE_RAINFALL:   IgnoreRainfall  = m;  break;
           case IGNORE_SNOWMELT:   IgnoreSnowmelt  = m;  break;
           case IGNORE_GWATER:     IgnoreGwater    = m;  break;
@@ -808,6 +818,7 @@ void initPointers()
     UnitHyd  = NULL;
     Snowmelt = NULL;
     Event    = NULL;
+    LandBuildup = NULL;
     MemPoolAllocated = FALSE;
 }
 
@@ -863,6 +874,8 @@ void setDefaults()
    MinSurfArea     = 0.0;              // Force use of default min. surface area
    MinSlope        = 0.0;              // No user supplied minimum conduit slope
    SkipSteadyState = FALSE;            // Do flow routing in steady state periods 
+   SkipConverged   = FALSE;            // Update all nodes on every DW trial
+   SeparateBasins  = FALSE;            // Solve all DW basins together
    IgnoreRainfall  = FALSE;            // Analyze rainfall/runoff
    IgnoreRDII      = FALSE;            // Analyze RDII
    IgnoreSnowmelt  = FALSE;            // Analyze snowmelt 
@@ -908,6 +921,11 @@ void setDefaults()
    RptFlags.nodes         = FALSE;
    RptFlags.links         = FALSE;
    RptFlags.averages      = FALSE;
+   RptFlags.outputBlock   = 0;
+   RptFlags.outputCompressed = FALSE;
+   RptFlags.subcatchVars  = NULL;
+   RptFlags.nodeVars      = NULL;
+   RptFlags.linkVars      = NULL;
 
    // Temperature data
    Temp.dataSource  = NO_TEMP;
@@ -1075,6 +1093,7 @@ void createObjects()
         Subcatch[j].pondedQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
         Subcatch[j].concPonded = (double *) calloc(Nobjects[POLLUT], sizeof(double));      // (OWA addition)
         Subcatch[j].totalLoad  = (double *) calloc(Nobjects[POLLUT], sizeof(double));
+        Subcatch[j].avgBmpEffic = (double *) calloc(Nobjects[POLLUT], sizeof(double));
         Subcatch[j].surfaceBuildup = (double *) calloc(Nobjects[POLLUT], sizeof(double));  // (OWA addition)
     }
     for (j = 0; j < Nobjects[NODE]; j++)
@@ -1111,14 +1130,23 @@ void createObjects()
     }
 
     // --- allocate memory for subcatchment landuse factors
+    //     (buildups are stored by subcatchment, then land use, then
+    //     pollutant in a single array)
+    LandBuildup = (double *) calloc((size_t)Nobjects[SUBCATCH] *
+                  Nobjects[LANDUSE] * Nobjects[POLLUT] + 1, sizeof(double));
+    if ( LandBuildup == NULL )
+    {
+        ErrorCode = ERR_MEMORY;
+        return;
+    }
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
         Subcatch[j].landFactor =
             (TLandFactor *) calloc(Nobjects[LANDUSE], sizeof(TLandFactor));
         for (k = 0; k < Nobjects[LANDUSE]; k++)
         {
-            Subcatch[j].landFactor[k].buildup =
-                (double *) calloc(Nobjects[POLLUT], sizeof(double));
+            Subcatch[j].landFactor[k].buildup = LandBuildup +
+                ((size_t)j * Nobjects[LANDUSE] + k) * Nobjects[POLLUT];
         }
     }
 
@@ -1201,15 +1229,11 @@ void deleteObjects()
 //        subcatchment's land use factors before freeing the subcatchment).
 //
 {
-    int j, k;
+    int j;
 
     // --- free memory for landuse factors & groundwater
     if ( Subcatch ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
-        for (k = 0; k < Nobjects[LANDUSE]; k++)
-        {
-            FREE(Subcatch[j].landFactor[k].buildup);
-        }
         FREE(Subcatch[j].landFactor);
         FREE(Subcatch[j].groundwater);
         gwater_deleteFlowExpression(j);
@@ -1231,7 +1255,9 @@ void deleteObjects()
         FREE(Subcatch[j].newQual);
         FREE(Subcatch[j].pondedQual);
         FREE(Subcatch[j].totalLoad);
+        FREE(Subcatch[j].avgBmpEffic);
     }
+    FREE(LandBuildup);
     if ( Node ) for (j = 0; j < Nobjects[NODE]; j++)
     {
         FREE(Node[j].oldQual);
@@ -1314,6 +1340,11 @@ void deleteObjects()
     FREE(Snowmelt);
     FREE(Shape);
     FREE(Event);
+
+    // --- free selections of binary results variables
+    FREE(RptFlags.subcatchVars);
+    FREE(RptFlags.nodeVars);
+    FREE(RptFlags.linkVars);
 }
 
 //=============================================================================
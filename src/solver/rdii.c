@@ -19,12 +19,17 @@
 //   - Rainfall climate adjustment implemented.
 //   Build 5.1.014:
 //   - Fixes bug related to isUsed property of a unit hydrograph's rain gage.
+//   Build 5.2.4:
+//   - Only past periods with rainfall are kept for each UH and UH ordinates
+//     are tabulated in advance, so that convolutions skip dry periods.
+//   - Convolutions for different UH groups carried out in parallel.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "headers.h"
 
 //-----------------------------------------------------------------------------
@@ -48,13 +53,19 @@ enum FileTypes {BINARY, TEXT};         // File mode types
 
 typedef struct                         // Data for a single unit hydrograph
 {                                      // -------------------------------------
-   double*   pastRain;                 // array of past rainfall values
+   double*   pastRain;                 // past nonzero rainfall values
    char*     pastMonth;                // month in which past rainfall occurred
+   int*      pastPeriod;               // period in which past rainfall occurred
+   int       firstRain;                // index of oldest past rainfall value
+   int       numRain;                  // number of past rainfall values
    int       period;                   // current UH time period
    int       hasPastRain;              // true if > 0 past periods with rain
    int       maxPeriods;               // max. past rainfall periods
    long      drySeconds;               // time since last nonzero rainfall
    double    iaUsed;                   // initial abstraction used (in or mm)
+   double*   ordinate;                 // UH ordinates for each set of monthly
+                                       // UH parameters & past period
+   char      monthSet[12];             // set of UH parameters used in a month
 }  TUHData;
 
 typedef struct                         // Data for a unit hydrograph group
@@ -82,6 +93,7 @@ static DateTime   RdiiEndDate;         // end date of RDII inflow period
 static double     TotalRainVol;        // total rainfall volume (ft3)
 static double     TotalRdiiVol;        // total RDII volume (ft3)
 static int        RdiiFileType;        // type (binary/text) of RDII file
+static int        RdiiThreads;         // number of threads used for UH groups
 
 //-----------------------------------------------------------------------------
 // Imported Variables
@@ -120,6 +132,7 @@ static void   openRdiiProcessor(void);
 static int    allocRdiiMemory(void);
 static int    getRainInterval(int i);
 static int    getMaxPeriods(int i, int k);
+static int    initUnitHydOrds(int i, int k);
 static void   initGageData(void);
 static void   initUnitHydData(void);
 static int    openNewRdiiFile(void);
@@ -128,8 +141,9 @@ static void   getRainfall(DateTime currentDate);
 static double applyIA(int j, int k, DateTime aDate, double dt,
               double rainDepth);
 static void   updateDryPeriod(int j, int k, double rain, int gageInterval);
+static void   addPastRain(int j, int k, double rain, int month);
 static void   getUnitHydRdii(DateTime currentDate);
-static double getUnitHydConvol(int j, int k, int gageInterval);
+static double getUnitHydConvol(int j, int k);
 static double getUnitHydOrd(int j, int m, int k, double t);
 
 static int    getNodeRdii(void);
@@ -930,19 +944,28 @@ int  allocRdiiMemory()
     int i;                             // UH group index
     int k;                             // UH index
     int n;                             // number of past rain periods
+    int nGroups = Nobjects[UNITHYD];   // number of UH groups
+
+    // --- no UH groups means no nodes with RDII to process
+    if ( nGroups <= 0 ) return TRUE;
+
+    // --- UH groups are shared out among threads when there are several
+    RdiiThreads = (nGroups > 1) ? NumThreads : 1;
 
     // --- allocate memory for RDII processing data for UH groups
-    UHGroup = (TUHGroup *) calloc(Nobjects[UNITHYD], sizeof(TUHGroup));
+    UHGroup = (TUHGroup *) calloc((size_t)nGroups, sizeof(TUHGroup));
     if ( !UHGroup ) return FALSE;
 
     // --- allocate memory for past rainfall data for each UH in each group
-    for (i=0; i<Nobjects[UNITHYD]; i++)
+    for (i=0; i<nGroups; i++)
     {
         UHGroup[i].rainInterval = getRainInterval(i);
         for (k=0; k<3; k++)
         {
             UHGroup[i].uh[k].pastRain = NULL;
             UHGroup[i].uh[k].pastMonth = NULL;
+            UHGroup[i].uh[k].pastPeriod = NULL;
+            UHGroup[i].uh[k].ordinate = NULL;
             UHGroup[i].uh[k].maxPeriods = getMaxPeriods(i, k);
             n = UHGroup[i].uh[k].maxPeriods;
             if ( n > 0 )
@@ -953,6 +976,10 @@ int  allocRdiiMemory()
                 UHGroup[i].uh[k].pastMonth =
                     (char *) calloc(n, sizeof(char));
                 if ( !UHGroup[i].uh[k].pastMonth ) return FALSE;
+                UHGroup[i].uh[k].pastPeriod =
+                    (int *) calloc(n, sizeof(int));
+                if ( !UHGroup[i].uh[k].pastPeriod ) return FALSE;
+                if ( !initUnitHydOrds(i, k) ) return FALSE;
             }
         }
     }
@@ -1031,6 +1058,62 @@ int  getMaxPeriods(int i, int k)
 
 //=============================================================================
 
+int  initUnitHydOrds(int i, int k)
+//
+//  Input:   i = UH group index
+//           k = UH index
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: tabulates the ordinates of a UH at the mid-point of each past
+//           rainfall period for each distinct set of monthly UH parameters.
+//
+{
+    int    m, m2,                      // month indexes
+           p,                          // UH time period index
+           n,                          // number of time periods
+           s,                          // UH parameter set index
+           nSets;                      // number of distinct UH parameter sets
+    double t;                          // UH time value (sec)
+    double* ord;                       // ordinates for a parameter set
+    TUHData* uh = &UHGroup[i].uh[k];
+
+    // --- assign each month to the set of UH parameters it uses
+    nSets = 0;
+    for (m=0; m<12; m++)
+    {
+        for (m2=0; m2<m; m2++)
+        {
+            if ( UnitHyd[i].tBase[m2][k] == UnitHyd[i].tBase[m][k] &&
+                 UnitHyd[i].tPeak[m2][k] == UnitHyd[i].tPeak[m][k] &&
+                 UnitHyd[i].r[m2][k] == UnitHyd[i].r[m][k] ) break;
+        }
+        if ( m2 < m ) uh->monthSet[m] = uh->monthSet[m2];
+        else uh->monthSet[m] = (char)(nSets++);
+    }
+
+    // --- find the UH ordinate (times its R-value) of each set at each period
+    n = uh->maxPeriods;
+    if ( n > 0 && (size_t)nSets > SIZE_MAX / sizeof(double) / (size_t)n )
+        return FALSE;
+    uh->ordinate = (double *) calloc((size_t)nSets * n, sizeof(double));
+    if ( !uh->ordinate ) return FALSE;
+    s = 0;
+    for (m=0; m<12; m++)
+    {
+        // --- sets are numbered in order of the first month that uses them
+        if ( uh->monthSet[m] != s ) continue;
+        ord = uh->ordinate + (size_t)s * n;
+        s++;
+        for (p=1; p<n; p++)
+        {
+            t = ((double)(p) - 0.5) * (double)UHGroup[i].rainInterval;
+            ord[p] = getUnitHydOrd(i, m, k, t) * UnitHyd[i].r[m][k];
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
 void initGageData()
 //
 //  Input:   none
@@ -1095,6 +1178,8 @@ void initUnitHydData()
                 (UHGroup[i].uh[k].maxPeriods * UHGroup[i].rainInterval) + 1;
             UHGroup[i].uh[k].period = UHGroup[i].uh[k].maxPeriods + 1;
             UHGroup[i].uh[k].hasPastRain = FALSE;
+            UHGroup[i].uh[k].firstRain = 0;
+            UHGroup[i].uh[k].numRain = 0;
 
             // --- assign initial abstraction used
             UHGroup[i].uh[k].iaUsed = UnitHyd[i].iaInit[month][k];
@@ -1171,7 +1256,6 @@ void getRainfall(DateTime currentDate)
     int      j;                        // UH group index
     int      k;                        // UH index
     int      g;                        // rain gage index
-    int      i;                        // past rainfall index
     int      month;                    // month of current date
     int      rainInterval;             // rainfall interval (sec)
     double   rainDepth;                // rainfall depth (inches or mm)
@@ -1211,13 +1295,8 @@ void getRainfall(DateTime currentDate)
                 // --- adjust extent of dry period for the UH
                 updateDryPeriod(j, k, excessDepth, rainInterval);
 
-                // --- add rainfall to list of past values,
-                //     wrapping array index if necessary
-                i = UHGroup[j].uh[k].period;
-                if ( i >= UHGroup[j].uh[k].maxPeriods ) i = 0;
-                UHGroup[j].uh[k].pastRain[i] = excessDepth;
-                UHGroup[j].uh[k].pastMonth[i] = (char)month;
-                UHGroup[j].uh[k].period = i + 1;
+                // --- add rainfall to list of past values
+                addPastRain(j, k, excessDepth, month);
             }
 
             // --- advance rain date by gage recording interval
@@ -1283,8 +1362,6 @@ void updateDryPeriod(int j, int k, double rainDepth, int rainInterval)
 //  Purpose: adjusts the length of the dry period between rainfall events.
 //
 {
-    int i;
-
     // --- if rainfall occurs
     if ( rainDepth > 0.0 )
     {
@@ -1293,10 +1370,8 @@ void updateDryPeriod(int j, int k, double rainDepth, int rainInterval)
         if ( UHGroup[j].uh[k].drySeconds >= rainInterval *
             UHGroup[j].uh[k].maxPeriods )
         {
-            for (i=0; i<UHGroup[j].uh[k].maxPeriods; i++)
-            {
-                UHGroup[j].uh[k].pastRain[i] = 0.0;
-            }
+            UHGroup[j].uh[k].firstRain = 0;
+            UHGroup[j].uh[k].numRain = 0;
             UHGroup[j].uh[k].period = 0;
         }
         UHGroup[j].uh[k].drySeconds = 0;
@@ -1318,6 +1393,47 @@ void updateDryPeriod(int j, int k, double rainDepth, int rainInterval)
 
 //=============================================================================
 
+void addPastRain(int j, int k, double rainDepth, int month)
+//
+//  Input:   j = UH group index
+//           k = unit hydrograph index
+//           rainDepth = excess rain depth (in or mm)
+//           month = month index of current date
+//  Output:  none
+//  Purpose: adds the current period's rainfall to the list of past periods
+//           with rainfall, dropping periods that are past the UH's base.
+//
+{
+    int i;
+    TUHData* uh = &UHGroup[j].uh[k];
+
+    // --- advance to next UH time period
+    uh->period++;
+
+    // --- drop the oldest rainfall values that no longer contribute
+    while ( uh->numRain > 0 &&
+            uh->period - uh->pastPeriod[uh->firstRain] >= uh->maxPeriods )
+    {
+        uh->firstRain++;
+        if ( uh->firstRain >= uh->maxPeriods ) uh->firstRain = 0;
+        uh->numRain--;
+    }
+
+    // --- add any rainfall to the end of the list,
+    //     wrapping array index if necessary
+    if ( rainDepth > 0.0 )
+    {
+        i = uh->firstRain + uh->numRain;
+        if ( i >= uh->maxPeriods ) i -= uh->maxPeriods;
+        uh->pastRain[i] = rainDepth;
+        uh->pastMonth[i] = (char)month;
+        uh->pastPeriod[i] = uh->period - 1;
+        uh->numRain++;
+    }
+}
+
+//=============================================================================
+
 void getUnitHydRdii(DateTime currentDate)
 //
 //  Input:   currentDate = current calendar date/time
@@ -1327,9 +1443,10 @@ void getUnitHydRdii(DateTime currentDate)
 {
     int   j;                           // UH group index
     int   k;                           // UH index
-    int   rainInterval;                // rainfall time interval (sec)
 
-    // --- examine each UH group
+    // --- examine each UH group (groups are independent of one another
+    //     so they can be examined in parallel)
+#pragma omp parallel for num_threads(RdiiThreads) private(k) schedule(dynamic)
     for (j=0; j<Nobjects[UNITHYD]; j++)
     {
         // --- skip calculation if group not used by any RDII node or if
@@ -1341,13 +1458,12 @@ void getUnitHydRdii(DateTime currentDate)
         UHGroup[j].lastDate = UHGroup[j].gageDate;
 
         // --- perform convolution for each UH in the group
-        rainInterval = UHGroup[j].rainInterval;
         UHGroup[j].rdii = 0.0;
         for (k=0; k<3; k++)
         {
             if ( UHGroup[j].uh[k].hasPastRain )
             {
-                UHGroup[j].rdii += getUnitHydConvol(j, k, rainInterval);
+                UHGroup[j].rdii += getUnitHydConvol(j, k);
             }
         }
     }
@@ -1355,53 +1471,47 @@ void getUnitHydRdii(DateTime currentDate)
 
 //=============================================================================
 
-double getUnitHydConvol(int j, int k, int rainInterval)
+double getUnitHydConvol(int j, int k)
 //
 //  Input:   j = UH group index
 //           k = UH index
-//           rainInterval = rainfall time interval (sec)
 //  Output:  returns a RDII flow value
 //  Purpose: computes convolution of Unit Hydrographs with past rainfall.
 //
 {
     int    i;                          // previous rainfall period index
-    int    m;                          // month of year index
+    int    n;                          // count of past rainfall values
     int    p;                          // UH time period index
     int    pMax;                       // max. number of periods
-    double t;                          // UH time value (sec)
     double u;                          // UH ordinate
     double v;                          // rainfall volume
     double rdii;                       // RDII flow
     TUHData* uh;                       // UH data
 
-    // --- initialize RDII, rain period index and UH period index
+    // --- initialize RDII and index of most recent rainfall
     rdii = 0.0;
     uh = &UHGroup[j].uh[k];
-    i = uh->period - 1;
-    if ( i < 0 ) i = uh->maxPeriods - 1;
     pMax = uh->maxPeriods;
-    p = 1;
+    i = uh->firstRain + uh->numRain - 1;
+    if ( i >= pMax ) i -= pMax;
 
-    // --- evaluate each time period of UH's
-    while ( p < pMax )
+    // --- evaluate each past period with rainfall, from the most recent
+    //     one back (the UH ordinates were tabulated at the group's
+    //     rainfall interval)
+    for (n = 0; n < uh->numRain; n++)
     {
-        // --- if rain period has rainfall
-        v = uh->pastRain[i];
-        m = uh->pastMonth[i];
-        if ( v > 0.0 )
-        {
-            // --- find mid-point time of UH period in seconds
-            t = ((double)(p) - 0.5) * (double)rainInterval;
+        // --- find UH time period of the rainfall
+        p = uh->period - uh->pastPeriod[i];
+        if ( p >= pMax ) break;
 
-            // --- convolute rain volume with UH ordinate
-            u = getUnitHydOrd(j, m, k, t) * UnitHyd[j].r[m][k];
-            rdii += u * v;
-        }
+        // --- convolute rain volume with UH ordinate
+        v = uh->pastRain[i];
+        u = uh->ordinate[uh->monthSet[(int)uh->pastMonth[i]] * pMax + p];
+        rdii += u * v;
 
-        // --- move to next UH period & previous rainfall period
-        p = p + 1;
+        // --- move to previous rainfall period
         i = i - 1;
-        if ( i < 0 ) i = uh->maxPeriods - 1;
+        if ( i < 0 ) i = pMax - 1;
     }
     return rdii;
 }
@@ -1530,6 +1640,8 @@ void freeRdiiMemory()
             {
                 FREE(UHGroup[i].uh[k].pastRain);
                 FREE(UHGroup[i].uh[k].pastMonth);
+                FREE(UHGroup[i].uh[k].pastPeriod);
+                FREE(UHGroup[i].uh[k].ordinate);
             }
         }
         FREE(UHGroup);
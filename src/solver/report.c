@@ -39,6 +39,14 @@
 //   - Support added for reporting most frequent non-converging links.
 //   - Support added for RptFlags.disabled flag.
 //   - Refactored report_readOptions().
+//   Build 5.2.4:
+//   - Parsing of LAYOUT report option added to report_readOptions().
+//   - Summary of compressed binary results added (report_writeOutputStats).
+//   - Time the solver waited on the output writer thread added to the
+//     summary of compressed binary results.
+//   - Parsing of VARIABLES report option added (report_readVariables).
+//   - Time series tables list only the variables saved to the binary
+//     output file (isSavedVar).
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -53,10 +61,8 @@
 #define WRITE(x) (report_writeLine((x)))
 #define LINE_10 "----------"
 #define LINE_12 "------------"
-#define LINE_51 \
-"---------------------------------------------------"
-#define LINE_64 \
-"----------------------------------------------------------------"
+#define LINE_21 "---------------------"
+#define LINE_24 "------------------------"
 
 
 //-----------------------------------------------------------------------------
@@ -80,6 +86,7 @@ extern TNodeStats*     NodeStats;
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
+static int  report_readVariables(char* tok[], int ntoks);
 static void report_LoadingErrors(int p1, int p2, TLoadingTotals* totals);
 static void report_QualErrors(int p1, int p2, TRoutingTotals* totals);
 static void report_Subcatchments(void);
@@ -88,6 +95,7 @@ static void report_Nodes(void);
 static void report_NodeHeader(char *id);
 static void report_Links(void);
 static void report_LinkHeader(char *id);
+static int  isSavedVar(char* vars, int v);
 static void report_RouteStepFreq(TTimeStepStats* timeStepStats);
 
 //=============================================================================
@@ -106,6 +114,32 @@ int report_readOptions(char* tok[], int ntoks)
     k = (char)findmatch(tok[0], ReportWords);
     if ( k < 0 ) return error_setInpError(ERR_KEYWORD, tok[0]);
 
+    // --- LAYOUT keyword (PERIOD, ELEMENT or COMPRESSED with optional
+    //     block size)
+    if (k == 10)
+    {
+        m = findmatch(tok[1], LayoutWords);
+        if (m < 0) return error_setInpError(ERR_KEYWORD, tok[1]);
+        RptFlags.outputCompressed = (m == COMPRESSED_LAYOUT);
+        if (m == PERIOD_LAYOUT)
+        {
+            RptFlags.outputBlock = 0;
+            return 0;
+        }
+        RptFlags.outputBlock = OUTPUT_BLOCK;
+        if (ntoks > 2)
+        {
+            if (!getInt(tok[2], &t) || t < 1)
+                return error_setInpError(ERR_NUMBER, tok[2]);
+            RptFlags.outputBlock = t;
+        }
+        return 0;
+    }
+
+    // --- VARIABLES keyword (object type followed by its variables and
+    //     pollutants to save to binary file)
+    if (k == 11) return report_readVariables(tok, ntoks);
+
     // --- keyword not SUBCATCHMENT, NODE, or LINK
     if (k < 2 || k > 4)
     {
@@ -170,6 +204,76 @@ int report_readOptions(char* tok[], int ntoks)
 
 //=============================================================================
 
+int report_readVariables(char* tok[], int ntoks)
+//
+//  Input:   tok[] = array of string tokens
+//           ntoks = number of tokens
+//  Output:  returns an error code
+//  Purpose: reads the variables of a type of object whose results are
+//           saved to the binary output file.
+//
+//  Format of data line is:
+//     VARIABLES  SUBCATCHMENTS/NODES/LINKS  name1  name2 ...
+//  where each name is a variable or pollutant and several names can be
+//  separated by commas.
+//
+{
+    int    i, t, numVars;
+    char   *s, *name;
+    char** vars;
+    char** words;
+
+    if ( ntoks < 3 ) return error_setInpError(ERR_ITEMS, "");
+    switch ( findmatch(tok[1], ReportWords) )
+    {
+      case 2:                                     // Subcatchments
+        vars = &RptFlags.subcatchVars;
+        words = SubcatchVarWords;
+        numVars = MAX_SUBCATCH_RESULTS - 1;
+        break;
+      case 3:                                     // Nodes
+        vars = &RptFlags.nodeVars;
+        words = NodeVarWords;
+        numVars = MAX_NODE_RESULTS - 1;
+        break;
+      case 4:                                     // Links
+        vars = &RptFlags.linkVars;
+        words = LinkVarWords;
+        numVars = MAX_LINK_RESULTS - 1;
+        break;
+      default: return error_setInpError(ERR_KEYWORD, tok[1]);
+    }
+
+    // --- the first selection of the object type's variables replaces
+    //     saving all of them
+    if ( *vars == NULL )
+    {
+        *vars = (char *) calloc(numVars + Nobjects[POLLUT], sizeof(char));
+        if ( *vars == NULL ) return error_setInpError(ERR_MEMORY, "");
+    }
+
+    // --- select each named pollutant or variable
+    for (t = 2; t < ntoks; t++)
+    {
+        s = tok[t];
+        while ( *s )
+        {
+            name = s;
+            while ( *s && *s != ',' ) s++;
+            if ( *s ) *s++ = '\0';
+            if ( *name == '\0' ) continue;
+            i = project_findObject(POLLUT, name);
+            if ( i >= 0 ) i += numVars;
+            else i = findmatch(name, words);
+            if ( i < 0 ) return error_setInpError(ERR_KEYWORD, name);
+            (*vars)[i] = TRUE;
+        }
+    }
+    return 0;
+}
+
+//=============================================================================
+
 void report_writeLine(const char *line)
 //
 //  Input:   line = line of text
@@ -346,6 +450,11 @@ void report_writeOptions()
             else                       fprintf(Frpt.file, "NO");
             fprintf(Frpt.file, "\n  Maximum Trials ........... %d", MaxTrials);
             fprintf(Frpt.file, "\n  Number of Threads ........ %d", NumThreads);
+            if ( SkipConverged )
+                fprintf(Frpt.file, "\n  Skip Converged Nodes ..... YES");
+            if ( SeparateBasins )
+                fprintf(Frpt.file,
+                    "\n  Separate Basins .......... YES (common time step)");
             fprintf(Frpt.file, "\n  Head Tolerance ........... %.6f ",
                 HeadTol*UCF(LENGTH));
             if ( UnitSystem == US ) fprintf(Frpt.file, "ft");
@@ -1114,6 +1223,45 @@ void report_RouteStepFreq(TTimeStepStats* timeStepStats)
 }
 
 
+//=============================================================================
+
+void report_writeOutputStats(double rawBytes, double savedBytes,
+                             double writeTime, double waitTime)
+//
+//  Input:   rawBytes = size of results when saved as 4-byte reals (bytes)
+//           savedBytes = size of compressed results saved to file (bytes)
+//           writeTime = time spent compressing & saving (sec)
+//           waitTime = time solver waited on the output writer thread
+//                      (sec, or < 0 if no writer thread was used)
+//  Output:  none
+//  Purpose: writes the size reduction and write rate of compressed binary
+//           results to report file.
+//
+{
+    const double MB = 1048576.0;
+
+    if ( savedBytes <= 0.0 ) return;
+    WRITE("");
+    WRITE("**************************");
+    WRITE("Binary Output File Summary");
+    WRITE("**************************");
+    fprintf(Frpt.file,
+        "\n  Results Before Compression  :  %9.3f MB", rawBytes / MB);
+    fprintf(Frpt.file,
+        "\n  Results Saved to File       :  %9.3f MB", savedBytes / MB);
+    fprintf(Frpt.file,
+        "\n  Compression Ratio           :  %9.2f", rawBytes / savedBytes);
+    fprintf(Frpt.file,
+        "\n  Time Spent Saving Results   :  %9.3f sec", writeTime);
+    if ( writeTime > 0.0 ) fprintf(Frpt.file,
+        "\n  Write Throughput            :  %9.1f MB/sec",
+        rawBytes / MB / writeTime);
+    if ( waitTime >= 0.0 ) fprintf(Frpt.file,
+        "\n  Time Solver Waited on Writer:  %9.3f sec", waitTime);
+    WRITE("");
+}
+
+
 //=============================================================================
 //      SIMULATION RESULTS REPORTING
 //=============================================================================
@@ -1146,15 +1294,21 @@ void report_Subcatchments()
 //  Output:  none
 //  Purpose: writes results for selected subcatchments to report file.
 //
+//  Only the results saved to the binary output file are listed (losses
+//  need both evaporation and infiltration to have been saved).
+//
 {
     int      j, p, k;
     int      period;
     DateTime days;
     char     theDate[DATE_STR_SIZE];
     char     theTime[TIME_STR_SIZE];
+    char*    vars = RptFlags.subcatchVars;
     int      hasSnowmelt = (Nobjects[SNOWMELT] > 0 && !IgnoreSnowmelt);
     int      hasGwater   = (Nobjects[AQUIFER] > 0  && !IgnoreGwater);
     int      hasQuality  = (Nobjects[POLLUT] > 0 && !IgnoreQuality);
+    int      hasLosses   = isSavedVar(vars, SUBCATCH_EVAP) &&
+                           isSavedVar(vars, SUBCATCH_INFIL);
 
     if ( Nobjects[SUBCATCH] == 0 ) return;
     WRITE("");
@@ -1173,22 +1327,31 @@ void report_Subcatchments()
                 datetime_dateToStr(days, theDate);
                 datetime_timeToStr(days, theTime);
                 output_readSubcatchResults(period, k);
-                fprintf(Frpt.file, "\n  %11s %8s %10.3f%10.3f%10.4f",
-                    theDate, theTime, SubcatchResults[SUBCATCH_RAINFALL],
-                    SubcatchResults[SUBCATCH_EVAP]/24.0 +
-                    SubcatchResults[SUBCATCH_INFIL],
-                    SubcatchResults[SUBCATCH_RUNOFF]);
-                if ( hasSnowmelt )
+                fprintf(Frpt.file, "\n  %11s %8s ", theDate, theTime);
+                if ( isSavedVar(vars, SUBCATCH_RAINFALL) )
+                    fprintf(Frpt.file, "%10.3f",
+                        SubcatchResults[SUBCATCH_RAINFALL]);
+                if ( hasLosses )
+                    fprintf(Frpt.file, "%10.3f",
+                        SubcatchResults[SUBCATCH_EVAP]/24.0 +
+                        SubcatchResults[SUBCATCH_INFIL]);
+                if ( isSavedVar(vars, SUBCATCH_RUNOFF) )
+                    fprintf(Frpt.file, "%10.4f",
+                        SubcatchResults[SUBCATCH_RUNOFF]);
+                if ( hasSnowmelt && isSavedVar(vars, SUBCATCH_SNOWDEPTH) )
                     fprintf(Frpt.file, "  %10.3f",
                         SubcatchResults[SUBCATCH_SNOWDEPTH]);
-                if ( hasGwater )
-                    fprintf(Frpt.file, "%10.3f%10.4f",
-                        SubcatchResults[SUBCATCH_GW_ELEV],
+                if ( hasGwater && isSavedVar(vars, SUBCATCH_GW_ELEV) )
+                    fprintf(Frpt.file, "%10.3f",
+                        SubcatchResults[SUBCATCH_GW_ELEV]);
+                if ( hasGwater && isSavedVar(vars, SUBCATCH_GW_FLOW) )
+                    fprintf(Frpt.file, "%10.4f",
                         SubcatchResults[SUBCATCH_GW_FLOW]);
                 if ( hasQuality )
                     for (p = 0; p < Nobjects[POLLUT]; p++)
-                        fprintf(Frpt.file, "%10.3f",
-                            SubcatchResults[SUBCATCH_WASHOFF+p]);
+                        if ( isSavedVar(vars, SUBCATCH_WASHOFF+p) )
+                            fprintf(Frpt.file, "%10.3f",
+                                SubcatchResults[SUBCATCH_WASHOFF+p]);
             }
             WRITE("");
         }
@@ -1205,63 +1368,76 @@ void  report_SubcatchHeader(char *id)
 //
 {
     int i;
-    int hasSnowmelt = (Nobjects[SNOWMELT] > 0 && !IgnoreSnowmelt);
-    int hasGwater   = (Nobjects[AQUIFER] > 0  && !IgnoreGwater);
+    int n;
+    char* vars = RptFlags.subcatchVars;
+    int hasSnowmelt = (Nobjects[SNOWMELT] > 0 && !IgnoreSnowmelt) &&
+                      isSavedVar(vars, SUBCATCH_SNOWDEPTH);
+    int hasGwElev   = (Nobjects[AQUIFER] > 0  && !IgnoreGwater) &&
+                      isSavedVar(vars, SUBCATCH_GW_ELEV);
+    int hasGwFlow   = (Nobjects[AQUIFER] > 0  && !IgnoreGwater) &&
+                      isSavedVar(vars, SUBCATCH_GW_FLOW);
     int hasQuality  = (Nobjects[POLLUT] > 0 && !IgnoreQuality);
+    int hasRain     = isSavedVar(vars, SUBCATCH_RAINFALL);
+    int hasLosses   = isSavedVar(vars, SUBCATCH_EVAP) &&
+                      isSavedVar(vars, SUBCATCH_INFIL);
+    int hasRunoff   = isSavedVar(vars, SUBCATCH_RUNOFF);
+
+    // --- count the 10 character columns
+    n = hasRain + hasLosses + hasRunoff + hasGwElev + hasGwFlow;
+    if ( hasQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
+        n += isSavedVar(vars, SUBCATCH_WASHOFF+i);
 
     // --- print top border of header
     WRITE("");
     fprintf(Frpt.file,"\n  <<< Subcatchment %s >>>", id);
-    WRITE(LINE_51);
-    if ( hasSnowmelt  > 0 ) fprintf(Frpt.file, LINE_12);
-    if ( hasGwater )
-    {
-        fprintf(Frpt.file, LINE_10);
-        fprintf(Frpt.file, LINE_10);
-    }
-    if ( hasQuality )
-    {
-        for (i = 0; i < Nobjects[POLLUT]; i++) fprintf(Frpt.file, LINE_10);
-    }
+    WRITE(LINE_21);
+    for (i = 0; i < n; i++) fprintf(Frpt.file, LINE_10);
+    if ( hasSnowmelt ) fprintf(Frpt.file, LINE_12);
 
     // --- print first line of column headings
-    fprintf(Frpt.file,
-    "\n  Date        Time        Precip.    Losses    Runoff");
+    fprintf(Frpt.file, "\n  Date        Time     ");
+    if ( hasRain )     fprintf(Frpt.file, "   Precip.");
+    if ( hasLosses )   fprintf(Frpt.file, "    Losses");
+    if ( hasRunoff )   fprintf(Frpt.file, "    Runoff");
     if ( hasSnowmelt ) fprintf(Frpt.file, "  Snow Depth");
-    if ( hasGwater   ) fprintf(Frpt.file, "  GW Elev.   GW Flow");
+    if ( hasGwElev )   fprintf(Frpt.file, "  GW Elev.");
+    if ( hasGwFlow )   fprintf(Frpt.file, "   GW Flow");
     if ( hasQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, "%10s", Pollut[i].ID);
+        if ( isSavedVar(vars, SUBCATCH_WASHOFF+i) )
+            fprintf(Frpt.file, "%10s", Pollut[i].ID);
 
     // --- print second line of column headings
-    if ( UnitSystem == US ) fprintf(Frpt.file,
-    "\n                            in/hr     in/hr %9s", FlowUnitWords[FlowUnits]);
-    else fprintf(Frpt.file,
-    "\n                            mm/hr     mm/hr %9s", FlowUnitWords[FlowUnits]);
+    fprintf(Frpt.file, "\n                       ");
+    if ( UnitSystem == US )
+    {
+        if ( hasRain )   fprintf(Frpt.file, "     in/hr");
+        if ( hasLosses ) fprintf(Frpt.file, "     in/hr");
+    }
+    else
+    {
+        if ( hasRain )   fprintf(Frpt.file, "     mm/hr");
+        if ( hasLosses ) fprintf(Frpt.file, "     mm/hr");
+    }
+    if ( hasRunoff ) fprintf(Frpt.file, " %9s", FlowUnitWords[FlowUnits]);
     if ( hasSnowmelt )
     {
         if ( UnitSystem == US ) fprintf(Frpt.file, "      inches");
         else                    fprintf(Frpt.file, "     mmeters");
     }
-    if ( hasGwater )
+    if ( hasGwElev )
     {
-        if ( UnitSystem == US )
-            fprintf(Frpt.file, "      feet %9s", FlowUnitWords[FlowUnits]);
-        else
-            fprintf(Frpt.file, "    meters %9s", FlowUnitWords[FlowUnits]);
+        if ( UnitSystem == US ) fprintf(Frpt.file, "      feet");
+        else                    fprintf(Frpt.file, "    meters");
     }
+    if ( hasGwFlow ) fprintf(Frpt.file, " %9s", FlowUnitWords[FlowUnits]);
     if ( hasQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, "%10s", QualUnitsWords[Pollut[i].units]);
+        if ( isSavedVar(vars, SUBCATCH_WASHOFF+i) )
+            fprintf(Frpt.file, "%10s", QualUnitsWords[Pollut[i].units]);
 
     // --- print lower border of header
-    WRITE(LINE_51);
+    WRITE(LINE_21);
+    for (i = 0; i < n; i++) fprintf(Frpt.file, LINE_10);
     if ( hasSnowmelt ) fprintf(Frpt.file, LINE_12);
-    if ( hasGwater )
-    {
-        fprintf(Frpt.file, LINE_10);
-        fprintf(Frpt.file, LINE_10);
-    }
-    if ( hasQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, LINE_10);
 }
 
 //=============================================================================
@@ -1273,11 +1449,13 @@ void report_Nodes()
 //  Purpose: writes results for selected nodes to report file.
 //
 {
-    int      j, p, k;
+    int      j, p, k, v;
     int      period;
     DateTime days;
     char     theDate[DATE_STR_SIZE];
     char     theTime[TIME_STR_SIZE];
+    char*    vars = RptFlags.nodeVars;
+    int      nodeVars[] = {NODE_INFLOW, NODE_OVERFLOW, NODE_DEPTH, NODE_HEAD};
 
     if ( Nobjects[NODE] == 0 ) return;
     WRITE("");
@@ -1296,12 +1474,14 @@ void report_Nodes()
                 datetime_dateToStr(days, theDate);
                 datetime_timeToStr(days, theTime);
                 output_readNodeResults(period, k);
-                fprintf(Frpt.file, "\n  %11s %8s  %9.3f %9.3f %9.3f %9.3f",
-                    theDate, theTime, NodeResults[NODE_INFLOW],
-                    NodeResults[NODE_OVERFLOW], NodeResults[NODE_DEPTH],
-                    NodeResults[NODE_HEAD]);
+                fprintf(Frpt.file, "\n  %11s %8s ", theDate, theTime);
+                for (v = 0; v < 4; v++)
+                    if ( isSavedVar(vars, nodeVars[v]) )
+                        fprintf(Frpt.file, " %9.3f", NodeResults[nodeVars[v]]);
                 if ( !IgnoreQuality ) for (p = 0; p < Nobjects[POLLUT]; p++)
-                    fprintf(Frpt.file, " %9.3f", NodeResults[NODE_QUAL + p]);
+                    if ( isSavedVar(vars, NODE_QUAL+p) )
+                        fprintf(Frpt.file, " %9.3f",
+                            NodeResults[NODE_QUAL + p]);
             }
             WRITE("");
         }
@@ -1319,27 +1499,45 @@ void  report_NodeHeader(char *id)
 {
     int i;
     char lengthUnits[9];
+    char* vars = RptFlags.nodeVars;
+    int hasInflow = isSavedVar(vars, NODE_INFLOW);
+    int hasFlooding = isSavedVar(vars, NODE_OVERFLOW);
+    int hasDepth = isSavedVar(vars, NODE_DEPTH);
+    int hasHead = isSavedVar(vars, NODE_HEAD);
+    int n = hasInflow + hasFlooding + hasDepth + hasHead;
+
     WRITE("");
     fprintf(Frpt.file,"\n  <<< Node %s >>>", id);
-    WRITE(LINE_64);
-    for (i = 0; i < Nobjects[POLLUT]; i++) fprintf(Frpt.file, LINE_10);
-
-    fprintf(Frpt.file,
-    "\n                           Inflow  Flooding     Depth      Head");
+    WRITE(LINE_24);
+    for (i = 0; i < n; i++) fprintf(Frpt.file, LINE_10);
+    for (i = 0; i < Nobjects[POLLUT]; i++)
+        if ( isSavedVar(vars, NODE_QUAL+i) ) fprintf(Frpt.file, LINE_10);
+
+    fprintf(Frpt.file, "\n                       ");
+    if ( hasInflow )   fprintf(Frpt.file, "    Inflow");
+    if ( hasFlooding ) fprintf(Frpt.file, "  Flooding");
+    if ( hasDepth )    fprintf(Frpt.file, "     Depth");
+    if ( hasHead )     fprintf(Frpt.file, "      Head");
     if ( !IgnoreQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, "%10s", Pollut[i].ID);
+        if ( isSavedVar(vars, NODE_QUAL+i) )
+            fprintf(Frpt.file, "%10s", Pollut[i].ID);
     if ( UnitSystem == US) sstrncpy(lengthUnits, "feet", 8);
     else sstrncpy(lengthUnits, "meters", 8);
-    fprintf(Frpt.file,
-    "\n  Date        Time      %9s %9s %9s %9s",
-        FlowUnitWords[FlowUnits], FlowUnitWords[FlowUnits],
-        lengthUnits, lengthUnits);
+    fprintf(Frpt.file, "\n  Date        Time     ");
+    if ( hasInflow )
+        fprintf(Frpt.file, " %9s", FlowUnitWords[FlowUnits]);
+    if ( hasFlooding )
+        fprintf(Frpt.file, " %9s", FlowUnitWords[FlowUnits]);
+    if ( hasDepth ) fprintf(Frpt.file, " %9s", lengthUnits);
+    if ( hasHead )  fprintf(Frpt.file, " %9s", lengthUnits);
     if ( !IgnoreQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, "%10s", QualUnitsWords[Pollut[i].units]);
+        if ( isSavedVar(vars, NODE_QUAL+i) )
+            fprintf(Frpt.file, "%10s", QualUnitsWords[Pollut[i].units]);
 
-    WRITE(LINE_64);
-    if ( !IgnoreQuality )
-        for (i = 0; i < Nobjects[POLLUT]; i++) fprintf(Frpt.file, LINE_10);
+    WRITE(LINE_24);
+    for (i = 0; i < n; i++) fprintf(Frpt.file, LINE_10);
+    if ( !IgnoreQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
+        if ( isSavedVar(vars, NODE_QUAL+i) ) fprintf(Frpt.file, LINE_10);
 }
 
 //=============================================================================
@@ -1351,11 +1549,13 @@ void report_Links()
 //  Purpose: writes results for selected links to report file.
 //
 {
-    int      j, p, k;
+    int      j, p, k, v;
     int      period;
     DateTime days;
     char     theDate[DATE_STR_SIZE];
     char     theTime[TIME_STR_SIZE];
+    char*    vars = RptFlags.linkVars;
+    int      linkVars[] = {LINK_FLOW, LINK_VELOCITY, LINK_DEPTH, LINK_CAPACITY};
 
     if ( Nobjects[LINK] == 0 ) return;
     WRITE("");
@@ -1374,12 +1574,14 @@ void report_Links()
                 datetime_dateToStr(days, theDate);
                 datetime_timeToStr(days, theTime);
                 output_readLinkResults(period, k);
-                fprintf(Frpt.file, "\n  %11s %8s  %9.3f %9.3f %9.3f %9.3f",
-                    theDate, theTime, LinkResults[LINK_FLOW],
-                    LinkResults[LINK_VELOCITY], LinkResults[LINK_DEPTH],
-                    LinkResults[LINK_CAPACITY]);
+                fprintf(Frpt.file, "\n  %11s %8s ", theDate, theTime);
+                for (v = 0; v < 4; v++)
+                    if ( isSavedVar(vars, linkVars[v]) )
+                        fprintf(Frpt.file, " %9.3f", LinkResults[linkVars[v]]);
                 if ( !IgnoreQuality ) for (p = 0; p < Nobjects[POLLUT]; p++)
-                    fprintf(Frpt.file, " %9.3f", LinkResults[LINK_QUAL + p]);
+                    if ( isSavedVar(vars, LINK_QUAL+p) )
+                        fprintf(Frpt.file, " %9.3f",
+                            LinkResults[LINK_QUAL + p]);
             }
             WRITE("");
         }
@@ -1396,30 +1598,64 @@ void  report_LinkHeader(char *id)
 //
 {
     int i;
+    char* vars = RptFlags.linkVars;
+    int hasFlow = isSavedVar(vars, LINK_FLOW);
+    int hasVelocity = isSavedVar(vars, LINK_VELOCITY);
+    int hasDepth = isSavedVar(vars, LINK_DEPTH);
+    int hasCapacity = isSavedVar(vars, LINK_CAPACITY);
+    int n = hasFlow + hasVelocity + hasDepth + hasCapacity;
+
     WRITE("");
     fprintf(Frpt.file,"\n  <<< Link %s >>>", id);
-    WRITE(LINE_64);
-    for (i = 0; i < Nobjects[POLLUT]; i++) fprintf(Frpt.file, LINE_10);
-
-    fprintf(Frpt.file,
-    "\n                             Flow  Velocity     Depth  Capacity/");
+    WRITE(LINE_24);
+    for (i = 0; i < n; i++) fprintf(Frpt.file, LINE_10);
+    for (i = 0; i < Nobjects[POLLUT]; i++)
+        if ( isSavedVar(vars, LINK_QUAL+i) ) fprintf(Frpt.file, LINE_10);
+
+    fprintf(Frpt.file, "\n                       ");
+    if ( hasFlow )     fprintf(Frpt.file, "      Flow");
+    if ( hasVelocity ) fprintf(Frpt.file, "  Velocity");
+    if ( hasDepth )    fprintf(Frpt.file, "     Depth");
+    if ( hasCapacity ) fprintf(Frpt.file, "  Capacity/");
     if ( !IgnoreQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, "%10s", Pollut[i].ID);
+        if ( isSavedVar(vars, LINK_QUAL+i) )
+            fprintf(Frpt.file, "%10s", Pollut[i].ID);
 
+    fprintf(Frpt.file, "\n  Date        Time     ");
+    if ( hasFlow ) fprintf(Frpt.file, "%10s", FlowUnitWords[FlowUnits]);
     if ( UnitSystem == US )
-        fprintf(Frpt.file,
-        "\n  Date        Time     %10s    ft/sec      feet   Setting ",
-        FlowUnitWords[FlowUnits]);
+    {
+        if ( hasVelocity ) fprintf(Frpt.file, "    ft/sec");
+        if ( hasDepth )    fprintf(Frpt.file, "      feet");
+    }
     else
-        fprintf(Frpt.file,
-        "\n  Date        Time     %10s     m/sec    meters   Setting ",
-        FlowUnitWords[FlowUnits]);
+    {
+        if ( hasVelocity ) fprintf(Frpt.file, "     m/sec");
+        if ( hasDepth )    fprintf(Frpt.file, "    meters");
+    }
+    if ( hasCapacity ) fprintf(Frpt.file, "   Setting ");
     if ( !IgnoreQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
-        fprintf(Frpt.file, " %9s", QualUnitsWords[Pollut[i].units]);
+        if ( isSavedVar(vars, LINK_QUAL+i) )
+            fprintf(Frpt.file, " %9s", QualUnitsWords[Pollut[i].units]);
+
+    WRITE(LINE_24);
+    for (i = 0; i < n; i++) fprintf(Frpt.file, LINE_10);
+    if ( !IgnoreQuality ) for (i = 0; i < Nobjects[POLLUT]; i++)
+        if ( isSavedVar(vars, LINK_QUAL+i) ) fprintf(Frpt.file, LINE_10);
+}
 
-    WRITE(LINE_64);
-    if ( !IgnoreQuality )
-        for (i = 0; i < Nobjects[POLLUT]; i++) fprintf(Frpt.file, LINE_10);
+//=============================================================================
+
+int isSavedVar(char* vars, int v)
+//
+//  Input:   vars = TRUE for each variable saved to the binary output file
+//                  (NULL if all are)
+//           v = index of a subcatchment, node or link variable
+//  Output:  returns TRUE if the variable's results were saved
+//  Purpose: checks if a variable can be listed in the time series tables.
+//
+{
+    return ( vars == NULL || vars[v] );
 }
 
 
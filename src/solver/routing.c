@@ -37,6 +37,9 @@
 //   Build 5.2.0:
 //   - Support added for street flow capture and sewer backflow thru inlets.
 //   - Shell sort replaces insertion sort for sorting Event array.
+//   Build 5.2.4:
+//   - Wet weather inflows computed from a saved copy of the latest runoff
+//     results so that the next runoff time step can be found concurrently.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -53,11 +56,16 @@ static int* SortedLinks;
 static int  NextEvent;
 static int  BetweenEvents;
 static double NewRuleTime;
+static double  RunoffTime[2];          // start & end of latest runoff step (msec)
+static double* RunoffFlow;             // subcatch. runoff at start & end (cfs)
+static double* RunoffQual;             // subcatch. runoff quality at start & end
+static double* LidDrainFlow;           // LID drain flows at start & end (cfs)
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
 // routing_open            (called by swmm_start in swmm5.c)
+// routing_saveRunoff      (called by execRunoff in swmm5.c)
 // routing_getRoutingStep  (called by swmm_step in swmm5.c)
 // routing_execute         (called by swmm_step in swmm5.c)
 // routing_close           (called by swmm_end in swmm5.c)
@@ -97,6 +105,8 @@ int routing_open()
 //  Purpose: initializes the routing analyzer.
 //
 {
+    int j, n;
+
     // --- open treatment system
     if ( !treatmnt_open() ) return ErrorCode;
 
@@ -114,6 +124,20 @@ int routing_open()
         if ( ErrorCode ) return ErrorCode;
     }
 
+    // --- allocate memory for the copy of runoff results used by routing
+    n = 0;
+    for (j = 0; j < Nobjects[SUBCATCH]; j++) n += lid_getLidUnitCount(j);
+    RunoffFlow = (double *) calloc(2 * Nobjects[SUBCATCH] + 1, sizeof(double));
+    RunoffQual = (double *) calloc(2 * Nobjects[SUBCATCH] * Nobjects[POLLUT] + 1,
+                                   sizeof(double));
+    LidDrainFlow = (double *) calloc(2 * n + 1, sizeof(double));
+    if ( !RunoffFlow || !RunoffQual || !LidDrainFlow )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return ErrorCode;
+    }
+    routing_saveRunoff();
+
     // --- open any routing interface files
     iface_openRoutingFiles();
 
@@ -145,6 +169,43 @@ void routing_close(int routingModel)
     flowrout_close(routingModel);
     treatmnt_close();
     FREE(SortedLinks);
+    FREE(RunoffFlow);
+    FREE(RunoffQual);
+    FREE(LidDrainFlow);
+}
+
+//=============================================================================
+
+void routing_saveRunoff()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: saves the latest runoff results for routing through the drainage
+//           system.
+//
+//  Note:    routing reads runoff results (and the climate conditions they
+//           were computed for) only from this copy, so the next runoff time
+//           step can be computed while routing proceeds.
+{
+    int j, p, n = 0;
+    int np = Nobjects[POLLUT];
+
+    RunoffTime[0] = OldRunoffTime;
+    RunoffTime[1] = NewRunoffTime;
+    RouteEvapRate = Evap.rate;
+    RouteHydconFactor = Adjust.hydconFactor;
+    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        RunoffFlow[2*j] = Subcatch[j].oldRunoff;
+        RunoffFlow[2*j+1] = Subcatch[j].newRunoff;
+        for (p = 0; p < np; p++)
+        {
+            RunoffQual[2*j*np + p] = Subcatch[j].oldQual[p];
+            RunoffQual[(2*j+1)*np + p] = Subcatch[j].newQual[p];
+        }
+        if ( Subcatch[j].area > 0.0 && Subcatch[j].lidArea > 0.0 )
+            n += lid_saveDrainFlows(j, &LidDrainFlow[2*n]);
+    }
 }
 
 //=============================================================================
@@ -165,7 +226,7 @@ double routing_getRoutingStep(int routingModel, double fixedStep)
     // --- find largest step possible if between routing events
     if ( NumEvents > 0 && BetweenEvents )
     {
-        nextTime = MIN(NewRunoffTime, ReportTime);
+        nextTime = MIN(RunoffTime[1], ReportTime);
         date1 = getDateTime(NewRoutingTime);
         date2 = getDateTime(nextTime);
         if ( date2 > date1 && date2 < Event[NextEvent].start )
@@ -584,12 +645,13 @@ void addWetWeatherInflows(double routingTime)
 //
 {
     int    i, j, p;
+    int    np = Nobjects[POLLUT];
     double q, w;
     double f;
 
     // --- find where current routing time lies between latest runoff times
     if ( Nobjects[SUBCATCH] == 0 ) return;
-    f = (routingTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    f = (routingTime - RunoffTime[0]) / (RunoffTime[1] - RunoffTime[0]);
     if ( f < 0.0 ) f = 0.0;
     if ( f > 1.0 ) f = 1.0;
 
@@ -601,14 +663,16 @@ void addWetWeatherInflows(double routingTime)
         if ( j >= 0)
         {
             // add runoff flow to lateral inflow
-            q = subcatch_getWtdOutflow(i, f);     // current runoff flow
+            if ( Subcatch[i].area == 0.0 ) q = 0.0;
+            else q = (1.0 - f) * RunoffFlow[2*i] + f * RunoffFlow[2*i+1];
             Node[j].newLatFlow += q;
             massbal_addInflowFlow(WET_WEATHER_INFLOW, q);
 
             // add pollutant load
-            for (p = 0; p < Nobjects[POLLUT]; p++)
+            for (p = 0; p < np; p++)
             {
-                w = surfqual_getWtdWashoff(i, p, f);
+                w = (1.0 - f) * RunoffFlow[2*i] * RunoffQual[2*i*np + p] +
+                    f * RunoffFlow[2*i+1] * RunoffQual[(2*i+1)*np + p];
                 Node[j].newQual[p] += w;
                 massbal_addInflowQual(WET_WEATHER_INFLOW, p, w);
             }
@@ -632,7 +696,7 @@ void addGroundwaterInflows(double routingTime)
 
     // --- find where current routing time lies between latest runoff times
     if ( Nobjects[SUBCATCH] == 0 ) return;
-    f = (routingTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    f = (routingTime - RunoffTime[0]) / (RunoffTime[1] - RunoffTime[0]);
     if ( f < 0.0 ) f = 0.0;
     if ( f > 1.0 ) f = 1.0;
 
@@ -678,18 +742,20 @@ void addLidDrainInflows(double routingTime)
 //  Purpose: adds inflows to nodes receiving LID drain flow.
 //
 {
-    int j;
+    int j, n = 0;
+    int np = Nobjects[POLLUT];
     double f;
 
     // for each subcatchment
     if ( Nobjects[SUBCATCH] == 0 ) return;
-    f = (routingTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    f = (routingTime - RunoffTime[0]) / (RunoffTime[1] - RunoffTime[0]);
     if ( f < 0.0 ) f = 0.0;
     if ( f > 1.0 ) f = 1.0;
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
         if ( Subcatch[j].area > 0.0 && Subcatch[j].lidArea > 0.0 )
-            lid_addDrainInflow(j, f);
+            n += lid_addDrainInflow(j, f, &LidDrainFlow[2*n],
+                                    &RunoffQual[2*j*np]);
     }
 }
 
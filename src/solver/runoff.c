@@ -30,36 +30,109 @@
 //   - Support added for saving rainfall amounts in previous 48 hours.
 //   Build 5.2.2:
 //   - Fixed possible use of canSweep in runoff_execute() with no assigned value. 
+//   Build 5.2.4:
+//   - Runoff and pollutant buildup/washoff found for blocks of subcatchments
+//     in parallel, with mass balance updates applied in subcatchment order.
+//   - Runon from upstream subcatchments gathered by each receiving
+//     subcatchment in parallel, with snow removal done beforehand.
+//   - Function runoff_canRunAhead added to see if the next runoff time step
+//     can be found while routing proceeds.
+//   - Wet LID status used for the time step kept in a shared variable
+//     since successive time steps can be found on different threads.
+//   - Groundwater of each block of subcatchments integrated as a batch.
+//   - Runoff interface file given a versioned layout with an index of time
+//     steps, memory-mapped when used so that its results are read in place
+//     and a run can start part way through it.
+//   - Snow melt tables and the time step's ATI weight set before runoff
+//     is computed.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+#ifdef _WIN32
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
 #include "headers.h"
+#include "lid.h"
 #include "odesolve.h"
 
+// Protect against lack of compiler support for OpenMP
+#if defined(_OPENMP)
+  #include <omp.h>
+#else
+  static int omp_get_thread_num(void) { return 0;}
+#endif
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+static const int SUBCATCH_BLOCK = 32;  // subcatchments per parallel task
+
+// --- Runoff interface file layouts. Both layouts hold a header followed by
+//     a fixed-size block for each time step made up of the step's length
+//     and the results of each subcatchment, all as 4-byte floats.
+//
+//     Version 1 header:
+//       "SWMM5-RUNOFF", # subcatchments, # pollutants, flow units, # steps
+//     Version 2 header:
+//       "SWMM5-RUNOFF", -2, # subcatchments, # pollutants, flow units,
+//       # results per subcatchment, # steps, (unused), starting date
+//     Version 2 files end with an index holding the elapsed time (msec) at
+//     the end of each time step, which lets a run starting at a later date
+//     go straight to the time step it needs.
+enum RunoffFileVersion {RUNOFF_FILE_V1 = 1, RUNOFF_FILE_V2 = 2};
+static const char RunoffFileStamp[] = "SWMM5-RUNOFF";
+static const int  RunoffFileHeaderV1 = 28;  // bytes in version 1 header
+static const int  RunoffFileHeaderV2 = 48;  // bytes in version 2 header
+
 //-----------------------------------------------------------------------------
 // Shared variables
 //-----------------------------------------------------------------------------
 static char  IsRaining;                // TRUE if precip. falls on study area
 static char  HasRunoff;                // TRUE if study area generates runoff
 static char  HasSnow;                  // TRUE if any snow cover on study area
+static char  AnyWetLids;               // TRUE if any LIDs are wet
 static int   Nsteps;                   // number of runoff time steps taken
 static int   MaxSteps;                 // final number of runoff time steps
 static long  MaxStepsPos;              // position in Runoff interface file
                                        //    where MaxSteps is saved
+static int   FileVersion;              // layout of Runoff interface file
+static long  FileHeaderSize;           // bytes in file's header
+static long  FileStepSize;             // bytes in each time step's block
+static int   FileStep;                 // next time step to read from file
+static int   FileSeeking;              // TRUE if run starts after file does
+static double FileSeekTime;            // runoff time of first step read when
+                                       //    FileSeeking is TRUE (msec)
+static char* FileMap;                  // memory map of a file being used
+static size_t FileMapSize;             // bytes in FileMap
+#ifdef _WIN32
+static HANDLE FileMapHandle;           // Windows file mapping object
+#endif
+static float* FileBuffer;              // one time step's block of results
+static double* StepTimes;              // elapsed time at end of each step
+static int   StepTimesSize;            // capacity of StepTimes
+static int   NumBlocks;                // number of blocks of subcatchments
+static int   RunoffThreads;            // number of threads used for runoff
+static double* OutflowLoads;           // pollutant loads for each thread
+static int*  RunonStart;               // start of each subcatchment's list of
+                                       //    runon sources in RunonSources
+static int*  RunonSources;             // subcatchments sending runon to
+                                       //    each subcatchment
+static int*  RunonNext;                // next free entry of each list
 
 //-----------------------------------------------------------------------------
 //  Exportable variables 
 //-----------------------------------------------------------------------------
 char    HasWetLids;  // TRUE if any LIDs are wet (used in lidproc.c)
 double* OutflowLoad; // exported pollutant mass load (used in surfqual.c)
-
-//-----------------------------------------------------------------------------
-//  Imported variables
-//-----------------------------------------------------------------------------
-extern float* SubcatchResults;         // Results vector defined in OUTPUT.C
+#pragma omp threadprivate(HasWetLids, OutflowLoad)
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -67,6 +140,7 @@ extern float* SubcatchResults;         // Results vector defined in OUTPUT.C
 // runoff_open     (called from swmm_start in swmm5.c)
 // runoff_execute  (called from swmm_step in swmm5.c)
 // runoff_close    (called from swmm_end in swmm5.c)
+// runoff_canRunAhead (called from runSteps in swmm5.c)
 
 //-----------------------------------------------------------------------------
 // Local functions
@@ -75,7 +149,15 @@ static double runoff_getTimeStep(DateTime currentDate);
 static void   runoff_initFile(void);
 static void   runoff_readFromFile(void);
 static void   runoff_saveToFile(float tStep);
+static void   runoff_seekFileStart(double fileStart);
+static const float* runoff_getFileStep(void);
+static void   runoff_mapFile(void);
+static void   runoff_unmapFile(void);
 static void   runoff_getOutfallRunon(double tStep);
+static void   runoff_getRunonSources(void);
+static void   runoff_addRunonSource(int j, int k, int pass);
+static void   runoff_getSubcatchRunoff(int j, double tStep, DateTime aDate,
+              char canSweep, int* hasRunoff, int* hasSnow);
 
 //=============================================================================
 
@@ -86,23 +168,52 @@ int runoff_open()
 //  Purpose: opens the runoff analyzer.
 //
 {
+    int j, n;
+
     IsRaining = FALSE;
     HasRunoff = FALSE;
     HasSnow = FALSE;
+    AnyWetLids = HasWetLids;
     Nsteps = 0;
 
     // --- open the Ordinary Differential Equation solver
     if ( !odesolve_open(MAXODES) ) report_writeErrorMsg(ERR_ODE_SOLVER, "");
 
-    // --- allocate memory for pollutant runoff loads
+    // --- tabulate areal depletion curves used for snow melt
+    if ( Nobjects[SNOWMELT] > 0 ) snow_initMeltTables();
+
+    // --- subcatchments are analyzed in blocks shared out among threads
+    NumBlocks = (Nobjects[SUBCATCH] + SUBCATCH_BLOCK - 1) / SUBCATCH_BLOCK;
+    RunoffThreads = (NumBlocks > 1) ? NumThreads : 1;
+    if ( RunoffThreads > 1 ) massbal_openDeferred(NumBlocks);
+
+    // --- allocate memory for each thread's pollutant runoff loads
+    OutflowLoads = NULL;
     OutflowLoad = NULL;
     if ( Nobjects[POLLUT] > 0 )
     {
-        OutflowLoad = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        if ( !OutflowLoad ) report_writeErrorMsg(ERR_MEMORY, "");
+        OutflowLoads = (double *) calloc(RunoffThreads * Nobjects[POLLUT],
+                                         sizeof(double));
+        if ( !OutflowLoads ) report_writeErrorMsg(ERR_MEMORY, "");
+        OutflowLoad = OutflowLoads;
     }
 
+    // --- allocate memory for the lists of runon sources (each subcatchment
+    //     can send runon to itself, its outlet and the drains of its LIDs)
+    n = 2 * Nobjects[SUBCATCH];
+    for (j = 0; j < Nobjects[SUBCATCH]; j++) n += lid_getLidUnitCount(j);
+    RunonStart = (int *) calloc(Nobjects[SUBCATCH] + 1, sizeof(int));
+    RunonNext = (int *) calloc(Nobjects[SUBCATCH] + 1, sizeof(int));
+    RunonSources = (int *) calloc(n + 1, sizeof(int));
+    if ( !RunonStart || !RunonNext || !RunonSources )
+        report_writeErrorMsg(ERR_MEMORY, "");
+
     // --- see if a runoff interface file should be opened
+    FileMap = NULL;
+    FileMapSize = 0;
+    FileBuffer = NULL;
+    StepTimes = NULL;
+    StepTimesSize = 0;
     switch ( Frunoff.mode )
     {
       case USE_FILE:
@@ -132,19 +243,32 @@ void runoff_close()
     odesolve_close();
 
     // --- free memory for pollutant runoff loads
-    FREE(OutflowLoad);
+    FREE(OutflowLoads);
+    OutflowLoad = NULL;
+    FREE(RunonStart);
+    FREE(RunonSources);
+    FREE(RunonNext);
+    massbal_closeDeferred();
 
     // --- close runoff interface file if in use
     if ( Frunoff.file )
     {
-        // --- write to file number of time steps simulated
+        // --- write to file the index of time steps simulated
+        //     and their number
         if ( Frunoff.mode == SAVE_FILE )
         {
+            fseek(Frunoff.file, 0, SEEK_END);
+            if ( Nsteps > 0 && StepTimes )
+                fwrite(StepTimes, sizeof(double), Nsteps, Frunoff.file);
             fseek(Frunoff.file, MaxStepsPos, SEEK_SET);
             fwrite(&Nsteps, sizeof(int), 1, Frunoff.file);
         }
+        runoff_unmapFile();
         fclose(Frunoff.file);
+        Frunoff.file = NULL;
     }
+    FREE(FileBuffer);
+    FREE(StepTimes);
 
     // --- close climate file if in use
     if ( Fclimate.file ) fclose(Fclimate.file);
@@ -159,13 +283,15 @@ void runoff_execute()
 //  Purpose: computes runoff from each subcatchment at current runoff time.
 //
 {
-    int      j;                        // object index
+    int      i, j, k;                  // object & block indexes
     int      day;                      // day of calendar year
     double   runoffStep;               // runoff time step (sec)
     double   oldRunoffStep;            // previous runoff time step (sec)
-    double   runoff;                   // subcatchment runoff (ft/sec)
     DateTime currentDate;              // current date/time 
     char     canSweep;                 // TRUE if street sweeping can occur
+    int      hasRunoff = FALSE;        // TRUE if any subcatchment has runoff
+    int      hasSnow = FALSE;          // TRUE if any subcatchment has snow
+    int      hasWetLids = FALSE;       // TRUE if any LIDs are wet
 
     if ( ErrorCode ) return;
 
@@ -242,43 +368,61 @@ void runoff_execute()
     // --- determine any runon from drainage system outfall nodes
     if ( oldRunoffStep > 0.0 ) runoff_getOutfallRunon(oldRunoffStep);
 
-    // --- determine runon from upstream subcatchments, and implement snow removal
-    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    // --- implement snow removal
+    if ( !IgnoreSnowmelt )
     {
-        if ( Subcatch[j].area == 0.0 ) continue;
-        subcatch_getRunon(j);
-        if ( !IgnoreSnowmelt ) snow_plowSnow(j, runoffStep);
+        snow_setTimeStep(runoffStep);
+        for (j = 0; j < Nobjects[SUBCATCH]; j++)
+        {
+            if ( Subcatch[j].area == 0.0 ) continue;
+            snow_plowSnow(j, runoffStep);
+        }
     }
-    
-    // --- determine runoff and pollutant buildup/washoff in each subcatchment
-    HasSnow = FALSE;
-    HasRunoff = FALSE;
-    HasWetLids = FALSE;
-    for (j = 0; j < Nobjects[SUBCATCH]; j++)
-    {
-        // --- find total runoff rate (in ft/sec) over the subcatchment
-        //     (the amount that actually leaves the subcatchment (in cfs)
-        //     is also computed and is stored in Subcatch[j].newRunoff)
-        if ( Subcatch[j].area == 0.0 ) continue;
-        runoff = subcatch_getRunoff(j, runoffStep);
 
-        // --- update state of study area surfaces
-        if ( runoff > 0.0 ) HasRunoff = TRUE;
-        if ( Subcatch[j].newSnowDepth > 0.0 ) HasSnow = TRUE;
-
-        // --- skip pollutant buildup/washoff if quality ignored
-        if ( IgnoreQuality ) continue;
-
-        // --- add to pollutant buildup if runoff is negligible
-        if ( runoff < MIN_RUNOFF ) surfqual_getBuildup(j, runoffStep); 
+    // --- determine runon from upstream subcatchments (since runon is
+    //     based on the previous period's runoff, each subcatchment can
+    //     gather its own runon in parallel, taking its sources in
+    //     subcatchment order so that results match a serial analysis)
+    runoff_getRunonSources();
+#pragma omp parallel for num_threads(RunoffThreads) private(i) \
+        schedule(dynamic, SUBCATCH_BLOCK)
+    for (k = 0; k < Nobjects[SUBCATCH]; k++)
+    {
+        for (i = RunonStart[k]; i < RunonStart[k+1]; i++)
+            subcatch_getRunon(RunonSources[i], k);
+    }
 
-        // --- reduce buildup by street sweeping
-        if ( canSweep && Subcatch[j].rainfall <= MIN_RUNOFF)
-            surfqual_sweepBuildup(j, currentDate);
 
-        // --- compute pollutant washoff 
-        surfqual_getWashoff(j, runoff, runoffStep);
+    // --- determine runoff and pollutant buildup/washoff in each subcatchment,
+    //     sharing out blocks of subcatchments among threads (each thread
+    //     logs its mass balance updates by block so that they can be added
+    //     to the system totals in subcatchment order once all are done;
+    //     the groundwater of the block is then integrated as one batch)
+#pragma omp parallel num_threads(RunoffThreads) private(j, k) \
+        reduction(|:hasRunoff, hasSnow, hasWetLids)
+{
+    HasWetLids = FALSE;
+    if ( OutflowLoads )
+        OutflowLoad = OutflowLoads + omp_get_thread_num() * Nobjects[POLLUT];
+    #pragma omp for schedule(dynamic)
+    for (k = 0; k < NumBlocks; k++)
+    {
+        if ( RunoffThreads > 1 ) massbal_deferTotals(k);
+        for (j = k * SUBCATCH_BLOCK;
+             j < (k + 1) * SUBCATCH_BLOCK && j < Nobjects[SUBCATCH]; j++)
+        {
+            runoff_getSubcatchRunoff(j, runoffStep, currentDate, canSweep,
+                                     &hasRunoff, &hasSnow);
+        }
+        gwater_flushBatch();
     }
+    massbal_deferTotals(-1);
+    hasWetLids |= HasWetLids;
+}
+    if ( RunoffThreads > 1 ) massbal_addDeferredTotals();
+    HasRunoff = (char)hasRunoff;
+    HasSnow = (char)hasSnow;
+    AnyWetLids = (char)hasWetLids;
 
     // --- update tracking of system-wide max. runoff rate
     stats_updateMaxRunoff();
@@ -296,6 +440,119 @@ void runoff_execute()
 
 //=============================================================================
 
+int runoff_canRunAhead()
+//
+//  Input:   none
+//  Output:  returns TRUE if the next runoff time step can be found while
+//           flow routing proceeds
+//  Purpose: checks that runoff results do not depend on the state of the
+//           drainage system and that runoff shares no time series with it.
+//
+{
+    int   i, j, p;
+    int   result = TRUE;
+    char* tseries;
+    TExtInflow* inflow;
+
+    // --- groundwater and outfall runon depend on the drainage system
+    if ( !IgnoreGwater ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].groundwater ) return FALSE;
+    }
+    for (i = 0; i < Nnodes[OUTFALL]; i++)
+    {
+        if ( Outfall[i].routeTo >= 0 ) return FALSE;
+    }
+
+    // --- flag the time series read by the runoff analysis
+    //     (a time series keeps track of its position when read)
+    tseries = (char *) calloc(Nobjects[TSERIES] + 1, sizeof(char));
+    if ( !tseries ) return FALSE;
+    for (j = 0; j < Nobjects[GAGE]; j++)
+    {
+        if ( Gage[j].dataSource == RAIN_TSERIES && Gage[j].tSeries >= 0 )
+            tseries[Gage[j].tSeries] = TRUE;
+    }
+    if ( Temp.dataSource == TSERIES_TEMP && Temp.tSeries >= 0 )
+        tseries[Temp.tSeries] = TRUE;
+    if ( Evap.type == TIMESERIES_EVAP && Evap.tSeries >= 0 )
+        tseries[Evap.tSeries] = TRUE;
+    for (i = 0; i < Nobjects[LANDUSE]; i++)
+    {
+        for (p = 0; p < Nobjects[POLLUT]; p++)
+        {
+            if ( Landuse[i].buildupFunc[p].funcType == EXTERNAL_BUILDUP )
+            {
+                j = (int)floor(Landuse[i].buildupFunc[p].coeff[2]);
+                if ( j >= 0 ) tseries[j] = TRUE;
+            }
+        }
+    }
+
+    // --- check that none of these are read during flow routing
+    for (j = 0; j < Nobjects[NODE] && result; j++)
+    {
+        inflow = Node[j].extInflow;
+        while ( inflow )
+        {
+            if ( inflow->tSeries >= 0 && tseries[inflow->tSeries] )
+                result = FALSE;
+            inflow = inflow->next;
+        }
+    }
+    for (i = 0; i < Nnodes[OUTFALL] && result; i++)
+    {
+        if ( Outfall[i].type == TIMESERIES_OUTFALL &&
+             tseries[Outfall[i].stageSeries] ) result = FALSE;
+    }
+    if ( result && controls_usesRunoffData(tseries) ) result = FALSE;
+    FREE(tseries);
+    return result;
+}
+
+//=============================================================================
+
+void runoff_getSubcatchRunoff(int j, double tStep, DateTime aDate,
+                              char canSweep, int* hasRunoff, int* hasSnow)
+//
+//  Input:   j = subcatchment index
+//           tStep = runoff time step (sec)
+//           aDate = current date/time
+//           canSweep = TRUE if street sweeping can occur
+//  Output:  hasRunoff = set to TRUE if subcatchment produces runoff
+//           hasSnow = set to TRUE if subcatchment has snow cover
+//  Purpose: computes runoff and pollutant buildup/washoff for a
+//           subcatchment.
+//
+{
+    double runoff;                     // subcatchment runoff (ft/sec)
+
+    // --- find total runoff rate (in ft/sec) over the subcatchment
+    //     (the amount that actually leaves the subcatchment (in cfs)
+    //     is also computed and is stored in Subcatch[j].newRunoff)
+    if ( Subcatch[j].area == 0.0 ) return;
+    runoff = subcatch_getRunoff(j, tStep);
+
+    // --- update state of study area surfaces
+    if ( runoff > 0.0 ) *hasRunoff = TRUE;
+    if ( Subcatch[j].newSnowDepth > 0.0 ) *hasSnow = TRUE;
+
+    // --- skip pollutant buildup/washoff if quality ignored
+    if ( IgnoreQuality ) return;
+
+    // --- add to pollutant buildup if runoff is negligible
+    if ( runoff < MIN_RUNOFF ) surfqual_getBuildup(j, tStep); 
+
+    // --- reduce buildup by street sweeping
+    if ( canSweep && Subcatch[j].rainfall <= MIN_RUNOFF)
+        surfqual_sweepBuildup(j, aDate);
+
+    // --- compute pollutant washoff 
+    surfqual_getWashoff(j, runoff, tStep);
+}
+
+//=============================================================================
+
 double runoff_getTimeStep(DateTime currentDate)
 //
 //  Input:   currentDate = current simulation date/time
@@ -319,7 +576,7 @@ double runoff_getTimeStep(DateTime currentDate)
     }
 
     // --- determine whether wet or dry time step applies
-    if ( IsRaining || HasSnow || HasRunoff || HasWetLids )
+    if ( IsRaining || HasSnow || HasRunoff || AnyWetLids )
     {
         timeStep = WetStep;
     }
@@ -336,53 +593,110 @@ void runoff_initFile(void)
 //
 //  Input:   none
 //  Output:  none
-//  Purpose: initializes a Runoff Interface file for saving results.
+//  Purpose: initializes a Runoff Interface file for saving or using results.
 //
 {
-    int   nSubcatch;
-    int   nPollut;
-    int   flowUnits;
-    char  fileStamp[] = "SWMM5-RUNOFF";
-    char  fStamp[] = "SWMM5-RUNOFF";
-
+    int    nSubcatch;
+    int    nPollut;
+    int    flowUnits;
+    int    nResults;
+    int    version;
+    int    unused = 0;
+    double startDate;
+    char   fStamp[] = "SWMM5-RUNOFF";
+
+    // --- allocate a buffer for one time step's results
     MaxSteps = 0;
+    FileStep = 0;
+    FileSeeking = FALSE;
+    nResults = MAX_SUBCATCH_RESULTS + Nobjects[POLLUT] - 1;
+    FileStepSize = (long)sizeof(float) * (1 + Nobjects[SUBCATCH] * nResults);
+    FileBuffer = (float *) calloc(1 + Nobjects[SUBCATCH] * nResults,
+                                  sizeof(float));
+    if ( !FileBuffer )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+
     if ( Frunoff.mode == SAVE_FILE )
     {
-        // --- write file stamp, # subcatchments & # pollutants to file
+        // --- write file stamp, version, # subcatchments, # pollutants,
+        //     flow units, # results per subcatchment & start date to file
+        //     (# time steps is written when the file is closed)
+        version = -RUNOFF_FILE_V2;
         nSubcatch = Nobjects[SUBCATCH];
         nPollut = Nobjects[POLLUT];
         flowUnits = FlowUnits;
-        fwrite(fileStamp, sizeof(char), strlen(fileStamp), Frunoff.file);
+        startDate = StartDateTime;
+        fwrite(RunoffFileStamp, sizeof(char), strlen(RunoffFileStamp),
+               Frunoff.file);
+        fwrite(&version, sizeof(int), 1, Frunoff.file);
         fwrite(&nSubcatch, sizeof(int), 1, Frunoff.file);
         fwrite(&nPollut, sizeof(int), 1, Frunoff.file);
         fwrite(&flowUnits, sizeof(int), 1, Frunoff.file);
+        fwrite(&nResults, sizeof(int), 1, Frunoff.file);
         MaxStepsPos = ftell(Frunoff.file); 
         fwrite(&MaxSteps, sizeof(int), 1, Frunoff.file);
+        fwrite(&unused, sizeof(int), 1, Frunoff.file);
+        fwrite(&startDate, sizeof(double), 1, Frunoff.file);
+        FileVersion = RUNOFF_FILE_V2;
+        FileHeaderSize = RunoffFileHeaderV2;
     }
 
     if ( Frunoff.mode == USE_FILE )
     {
         // --- check that interface file contains proper header records
-        fread(fStamp, sizeof(char), strlen(fileStamp), Frunoff.file);
-        if ( strcmp(fStamp, fileStamp) != 0 )
+        fread(fStamp, sizeof(char), strlen(RunoffFileStamp), Frunoff.file);
+        if ( strcmp(fStamp, RunoffFileStamp) != 0 )
         {
             report_writeErrorMsg(ERR_RUNOFF_FILE_FORMAT, "");
             return;
         }
+        version = -1;
         nSubcatch = -1;
         nPollut = -1;
         flowUnits = -1;
-        fread(&nSubcatch, sizeof(int), 1, Frunoff.file);
-        fread(&nPollut, sizeof(int), 1, Frunoff.file);
-        fread(&flowUnits, sizeof(int), 1, Frunoff.file);
-        fread(&MaxSteps, sizeof(int), 1, Frunoff.file);
+        startDate = StartDateTime;
+
+        // --- a version 1 file has its # subcatchments where a version 2
+        //     file has its (negative) version number
+        fread(&version, sizeof(int), 1, Frunoff.file);
+        if ( version == -RUNOFF_FILE_V2 )
+        {
+            FileVersion = RUNOFF_FILE_V2;
+            FileHeaderSize = RunoffFileHeaderV2;
+            fread(&nSubcatch, sizeof(int), 1, Frunoff.file);
+            fread(&nPollut, sizeof(int), 1, Frunoff.file);
+            fread(&flowUnits, sizeof(int), 1, Frunoff.file);
+            version = -1;
+            fread(&version, sizeof(int), 1, Frunoff.file);
+            if ( version != nResults ) nSubcatch = -1;
+            fread(&MaxSteps, sizeof(int), 1, Frunoff.file);
+            fread(&unused, sizeof(int), 1, Frunoff.file);
+            fread(&startDate, sizeof(double), 1, Frunoff.file);
+        }
+        else
+        {
+            FileVersion = RUNOFF_FILE_V1;
+            FileHeaderSize = RunoffFileHeaderV1;
+            nSubcatch = version;
+            fread(&nPollut, sizeof(int), 1, Frunoff.file);
+            fread(&flowUnits, sizeof(int), 1, Frunoff.file);
+            fread(&MaxSteps, sizeof(int), 1, Frunoff.file);
+        }
         if ( nSubcatch != Nobjects[SUBCATCH]
         ||   nPollut   != Nobjects[POLLUT]
         ||   flowUnits != FlowUnits
         ||   MaxSteps  <= 0 )
         {
              report_writeErrorMsg(ERR_RUNOFF_FILE_FORMAT, "");
+             return;
         }
+
+        // --- map the file into memory and find where to start reading it
+        runoff_mapFile();
+        if ( FileVersion == RUNOFF_FILE_V2 ) runoff_seekFileStart(startDate);
     }
 }
 
@@ -395,16 +709,33 @@ void  runoff_saveToFile(float tStep)
 //  Purpose: saves current runoff results to Runoff Interface file.
 //
 {
-    int j;
-    int n = MAX_SUBCATCH_RESULTS + Nobjects[POLLUT] - 1;
-    
+    int     j;
+    int     n = MAX_SUBCATCH_RESULTS + Nobjects[POLLUT] - 1;
+    double* times;
 
-    fwrite(&tStep, sizeof(float), 1, Frunoff.file);
+    // --- write the time step's length and the results of all subcatchments
+    //     as a single block
+    FileBuffer[0] = tStep;
     for (j=0; j<Nobjects[SUBCATCH]; j++)
     {
-        subcatch_getResults(j, 1.0, SubcatchResults);
-        fwrite(SubcatchResults, sizeof(float), n, Frunoff.file);
+        subcatch_getResults(j, 1.0, FileBuffer + 1 + j*n, NULL);
     }
+    fwrite(FileBuffer, 1, FileStepSize, Frunoff.file);
+
+    // --- add the time at the end of the step to the file's index
+    if ( Nsteps > StepTimesSize )
+    {
+        j = MAX(2 * StepTimesSize, 1024);
+        times = (double *) realloc(StepTimes, j * sizeof(double));
+        if ( !times )
+        {
+            report_writeErrorMsg(ERR_MEMORY, "");
+            return;
+        }
+        StepTimes = times;
+        StepTimesSize = j;
+    }
+    StepTimes[Nsteps-1] = NewRunoffTime;
 }
 
 //=============================================================================
@@ -418,8 +749,9 @@ void  runoff_readFromFile(void)
 {
     int    i, j;
     int    nResults;                   // number of results per subcatch.
-    int    kount;                      // count of items read from file
     float  tStep;                      // runoff time step (sec)
+    const float* step;                 // results of the time step
+    const float* x;                    // results of a subcatchment
     TGroundwater* gw;                  // ptr. to Groundwater object
 
     // --- make sure not past end of file
@@ -432,9 +764,16 @@ void  runoff_readFromFile(void)
     // --- replace old state with current one for all subcatchments
     for (j = 0; j < Nobjects[SUBCATCH]; j++) subcatch_setOldState(j);
 
+    // --- get the block of results for the time step
+    step = runoff_getFileStep();
+    if ( step == NULL )
+    {
+         report_writeErrorMsg(ERR_RUNOFF_FILE_READ, "");
+         return;
+    }
+
     // --- read runoff time step
-    kount = 0;
-    kount += (int)fread(&tStep, sizeof(float), 1, Frunoff.file);
+    tStep = step[0];
 
     // --- compute number of results saved for each subcatchment
     nResults = MAX_SUBCATCH_RESULTS + Nobjects[POLLUT] - 1;
@@ -442,51 +781,286 @@ void  runoff_readFromFile(void)
     // --- for each subcatchment
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
-        // --- read vector of saved results
-        kount += (int)fread(SubcatchResults, sizeof(float), nResults, Frunoff.file);
+        // --- locate vector of saved results
+        x = step + 1 + j * nResults;
 
         // --- extract hydrologic results, converting units where necessary
         //     (results were saved to file in user's units)
-        Subcatch[j].newSnowDepth = SubcatchResults[SUBCATCH_SNOWDEPTH] /
-                                   UCF(RAINDEPTH);
-        Subcatch[j].evapLoss     = SubcatchResults[SUBCATCH_EVAP] /
-                                   UCF(RAINFALL);
-        Subcatch[j].infilLoss    = SubcatchResults[SUBCATCH_INFIL] /
-                                   UCF(RAINFALL);
-        Subcatch[j].newRunoff    = SubcatchResults[SUBCATCH_RUNOFF] /
-                                   UCF(FLOW);
+        Subcatch[j].newSnowDepth = x[SUBCATCH_SNOWDEPTH] / UCF(RAINDEPTH);
+        Subcatch[j].evapLoss     = x[SUBCATCH_EVAP] / UCF(RAINFALL);
+        Subcatch[j].infilLoss    = x[SUBCATCH_INFIL] / UCF(RAINFALL);
+        Subcatch[j].newRunoff    = x[SUBCATCH_RUNOFF] / UCF(FLOW);
         gw = Subcatch[j].groundwater;
         if ( gw )
         {
-            gw->newFlow    = SubcatchResults[SUBCATCH_GW_FLOW] / UCF(FLOW);
+            gw->newFlow    = x[SUBCATCH_GW_FLOW] / UCF(FLOW);
             gw->lowerDepth = Aquifer[gw->aquifer].bottomElev -
-                             (SubcatchResults[SUBCATCH_GW_ELEV] / UCF(LENGTH));
-            gw->theta      = SubcatchResults[SUBCATCH_SOIL_MOIST];
+                             (x[SUBCATCH_GW_ELEV] / UCF(LENGTH));
+            gw->theta      = x[SUBCATCH_SOIL_MOIST];
         }
 
         // --- extract water quality results
         for (i = 0; i < Nobjects[POLLUT]; i++)
         {
-            Subcatch[j].newQual[i] = SubcatchResults[SUBCATCH_WASHOFF + i];
+            Subcatch[j].newQual[i] = x[SUBCATCH_WASHOFF + i];
         }
     }
 
-    // --- report error if not enough values were read
-    if ( kount < 1 + Nobjects[SUBCATCH] * nResults )
+    // --- update runoff time clock (the first step read by a run that
+    //     starts part way through the file ends at or before time 0)
+    if ( FileSeeking )
     {
-         report_writeErrorMsg(ERR_RUNOFF_FILE_READ, "");
-         return;
+        OldRunoffTime = FileSeekTime;
+        NewRunoffTime = FileSeekTime;
+        FileSeeking = FALSE;
+    }
+    else
+    {
+        OldRunoffTime = NewRunoffTime;
+        NewRunoffTime = OldRunoffTime + (double)(tStep)*1000.0;
+        NewRunoffTime = MIN(NewRunoffTime, TotalDuration);
     }
-
-    // --- update runoff time clock
-    OldRunoffTime = NewRunoffTime;
-    NewRunoffTime = OldRunoffTime + (double)(tStep)*1000.0;
-    NewRunoffTime = MIN(NewRunoffTime, TotalDuration);
     Nsteps++;
 }
 
 //=============================================================================
 
+void runoff_seekFileStart(double fileStart)
+//
+//  Input:   fileStart = starting date of the run that saved the file
+//  Output:  none
+//  Purpose: finds the first time step to read from a version 2 Runoff
+//           Interface file when the current run starts after the run
+//           that saved the file did.
+//
+{
+    int    lo, hi, mid;
+    double offset;                     // msec from file's start to run's start
+    size_t pos;                        // position of file's index
+
+    // --- (dates are rounded to whole seconds like the run's duration is)
+    offset = floor((StartDateTime - fileStart) * SECperDAY + 0.5) * 1000.0;
+    if ( offset <= 0.0 ) return;
+
+    // --- read the elapsed time at the end of each time step
+    StepTimes = (double *) calloc(MaxSteps, sizeof(double));
+    if ( !StepTimes )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+    StepTimesSize = MaxSteps;
+    pos = (size_t)FileHeaderSize + (size_t)MaxSteps * FileStepSize;
+    if ( FileMap && pos + MaxSteps * sizeof(double) <= FileMapSize )
+    {
+        memcpy(StepTimes, FileMap + pos, MaxSteps * sizeof(double));
+    }
+    else if ( FileMap || fseek(Frunoff.file, (long)pos, SEEK_SET) != 0 ||
+        (int)fread(StepTimes, sizeof(double), MaxSteps, Frunoff.file) <
+        MaxSteps )
+    {
+        report_writeErrorMsg(ERR_RUNOFF_FILE_READ, "");
+        return;
+    }
+
+    // --- find the first time step that ends after the run starts
+    lo = 0;
+    hi = MaxSteps;
+    while ( lo < hi )
+    {
+        mid = (lo + hi) / 2;
+        if ( StepTimes[mid] > offset ) hi = mid;
+        else lo = mid + 1;
+    }
+    if ( lo == MaxSteps )
+    {
+        report_writeErrorMsg(ERR_RUNOFF_FILE_END, "");
+        return;
+    }
+
+    // --- start from the step before it, whose results give the state
+    //     of the subcatchments when the run starts
+    if ( lo > 0 )
+    {
+        FileStep = lo - 1;
+        FileSeeking = TRUE;
+        FileSeekTime = StepTimes[lo-1] - offset;
+    }
+}
+
+//=============================================================================
+
+const float* runoff_getFileStep(void)
+//
+//  Input:   none
+//  Output:  returns the results of the next time step in the Runoff
+//           Interface file being used, or NULL if they can't be read
+//  Purpose: locates the next time step's block of results in the file's
+//           memory map, or reads it from the file if it isn't mapped.
+//
+{
+    size_t pos;
+
+    if ( FileStep >= MaxSteps ) return NULL;
+    pos = (size_t)FileHeaderSize + (size_t)FileStep * FileStepSize;
+    FileStep++;
+    if ( FileMap )
+    {
+        if ( pos + FileStepSize > FileMapSize ) return NULL;
+        return (const float *)(FileMap + pos);
+    }
+    if ( fseek(Frunoff.file, (long)pos, SEEK_SET) != 0 ) return NULL;
+    if ( fread(FileBuffer, 1, FileStepSize, Frunoff.file) <
+         (size_t)FileStepSize ) return NULL;
+    return FileBuffer;
+}
+
+//=============================================================================
+
+void runoff_mapFile(void)
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: maps a Runoff Interface file being used into memory so that
+//           its results can be read in place (the file is read in the
+//           usual way if this fails).
+//
+{
+#ifdef _WIN32
+    HANDLE hFile;
+    LARGE_INTEGER size;
+
+    FileMapHandle = NULL;
+    hFile = (HANDLE)_get_osfhandle(_fileno(Frunoff.file));
+    if ( hFile == INVALID_HANDLE_VALUE ) return;
+    if ( !GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 ) return;
+    FileMapHandle = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if ( FileMapHandle == NULL ) return;
+    FileMap = (char *) MapViewOfFile(FileMapHandle, FILE_MAP_READ, 0, 0, 0);
+    if ( FileMap == NULL )
+    {
+        CloseHandle(FileMapHandle);
+        FileMapHandle = NULL;
+        return;
+    }
+    FileMapSize = (size_t)size.QuadPart;
+#else
+    struct stat st;
+    void* map;
+
+    if ( fstat(fileno(Frunoff.file), &st) != 0 || st.st_size <= 0 ) return;
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+               fileno(Frunoff.file), 0);
+    if ( map == MAP_FAILED ) return;
+    FileMap = (char *) map;
+    FileMapSize = (size_t)st.st_size;
+#endif
+}
+
+//=============================================================================
+
+void runoff_unmapFile(void)
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: removes the memory map of a Runoff Interface file.
+//
+{
+    if ( FileMap == NULL ) return;
+#ifdef _WIN32
+    UnmapViewOfFile(FileMap);
+    CloseHandle(FileMapHandle);
+    FileMapHandle = NULL;
+#else
+    munmap(FileMap, FileMapSize);
+#endif
+    FileMap = NULL;
+    FileMapSize = 0;
+}
+
+//=============================================================================
+
+void runoff_getRunonSources()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: lists, for each subcatchment, the subcatchments that send it
+//           runon (including itself when it routes flow between its own
+//           subareas) in order of subcatchment index.
+//
+//  Note:    the lists are rebuilt each time step since the toolkit API
+//           can re-direct LID drain flows while a simulation is running.
+//
+{
+    int i, j, k, n, pass;
+
+    // --- first pass counts each subcatchment's sources, second one
+    //     places them in the lists
+    for (k = 0; k <= Nobjects[SUBCATCH]; k++)
+    {
+        RunonStart[k] = 0;
+        RunonNext[k] = -1;
+    }
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (j = 0; j < Nobjects[SUBCATCH]; j++)
+        {
+            if ( Subcatch[j].area == 0.0 ) continue;
+            runoff_addRunonSource(j, j, pass);
+            k = Subcatch[j].outSubcatch;
+            if ( k >= 0 && k != j ) runoff_addRunonSource(j, k, pass);
+            if ( Subcatch[j].lidArea <= 0.0 ) continue;
+            n = lid_getLidUnitCount(j);
+            for (i = 0; i < n; i++)
+            {
+                k = lid_getDrainSubcatch(j, i);
+                if ( k >= 0 ) runoff_addRunonSource(j, k, pass);
+            }
+        }
+
+        // --- convert source counts to starting positions of each list
+        if ( pass == 0 )
+        {
+            for (k = 0; k < Nobjects[SUBCATCH]; k++)
+            {
+                RunonStart[k+1] += RunonStart[k];
+                RunonNext[k] = RunonStart[k];
+            }
+        }
+    }
+}
+
+//=============================================================================
+
+void runoff_addRunonSource(int j, int k, int pass)
+//
+//  Input:   j = index of subcatchment sending runon
+//           k = index of subcatchment receiving runon
+//           pass = 0 when counting sources, 1 when listing them
+//  Output:  none
+//  Purpose: adds a subcatchment to the list of runon sources of another
+//           subcatchment if it is not already the last one listed.
+//
+{
+    int n;
+
+    if ( pass == 0 )
+    {
+        if ( RunonNext[k] == j ) return;
+        RunonNext[k] = j;
+        RunonStart[k+1]++;
+    }
+    else
+    {
+        n = RunonNext[k];
+        if ( n > RunonStart[k] && RunonSources[n-1] == j ) return;
+        RunonSources[n] = j;
+        RunonNext[k] = n + 1;
+    }
+}
+
+//=============================================================================
+
 
 void runoff_getOutfallRunon(double tStep)
 //
@@ -7,6 +7,11 @@
 //   Author:   L. Rossman
 //
 //   Geometry functions for custom cross-section shapes.
+//
+//   Update History
+//   ==============
+//   Build 5.2.4:
+//   - Inverse lookup index built for a shape's area table.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -56,6 +61,7 @@ int shape_validate(TShape *shape, TTable *curve)
         return FALSE;
     }
 
+    xsect_setInvIndex(&shape->areaIndex, shape->areaTbl, shape->nTbl);
     return TRUE;
 }
 
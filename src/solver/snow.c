@@ -17,6 +17,9 @@
 //     water leaves a snowpack.
 //   Build 5.2.0:
 //   - Subcatchment snow pack area should not include LID area.
+//   Build 5.2.4:
+//   - Slopes of the areal depletion curves and the time step's ATI weighting
+//     factor are computed once rather than for every snow pack sub-area.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -31,6 +34,15 @@
 // These symbolize the keywords listed in SnowmeltWords in keywords.c
 enum SnowKeywords {SNOW_PLOWABLE, SNOW_IMPERV, SNOW_PERV, SNOW_REMOVAL};
 
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+// These are set before subcatchment runoff is computed and are only read
+// while snow melt is found for each subcatchment (possibly in parallel).
+static double AdcSlope[2][10];         // slope of each ADC interval
+static double AtiStep;                 // time step of ATI weight (sec)
+static double AtiWeight;               // ATI weighting factor for time step
+
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
@@ -40,6 +52,8 @@ enum SnowKeywords {SNOW_PLOWABLE, SNOW_IMPERV, SNOW_PERV, SNOW_REMOVAL};
 //  snow_validateSnowmelt(called from project_validate)
 //  snow_readMeltParams  (called from parseLine in input.c)
 //  snow_setMeltCoeffs   (called from setTemp in climate.c)
+//  snow_initMeltTables  (called from runoff_open)
+//  snow_setTimeStep     (called from runoff_execute)
 //  snow_plowSnow        (called from runoff_execute)
 //  snow_getSnowMelt     (called from subcatch_getRunoff)
 //  snow_getSnowCover    (called from massbal_open)
@@ -357,6 +371,47 @@ void snow_setMeltCoeffs(int j, double s)
 
 //=============================================================================
 
+void snow_initMeltTables()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: tabulates the slope of each interval of the impervious and
+//           pervious areal depletion curves.
+//
+{
+    int    k;                          // type of ADC (impervious or pervious)
+    int    m;                          // interval on ADC
+    double asc2;                       // asc value at end of interval
+
+    for (k = 0; k < 2; k++)
+    {
+        for (m = 0; m < 10; m++)
+        {
+            if ( m >= 9 ) asc2 = 1.0;
+            else asc2 = Snow.adc[k][m+1];
+            AdcSlope[k][m] = (asc2 - Snow.adc[k][m]) / 0.1;
+        }
+    }
+    AtiStep = 0.0;
+    AtiWeight = 0.0;
+}
+
+//=============================================================================
+
+void snow_setTimeStep(double tStep)
+//
+//  Input:   tStep = runoff time step (sec)
+//  Output:  none
+//  Purpose: converts the ATI weighting factor from a 6-hr to a tStep basis.
+//
+{
+    if ( tStep == AtiStep ) return;
+    AtiStep = tStep;
+    AtiWeight = 1.0 - pow(1.0 - Snow.tipm, tStep / (6.0*3600.0));
+}
+
+//=============================================================================
+
 void snow_plowSnow(int j, double tStep)
 //
 //  Input:   j     = subcatchment index
@@ -648,7 +703,6 @@ double getArealSnowCover(int i, double awesi)
 {
     int     k;                         // type of ADC (impervious or pervious)
     int     m;                         // interval on ADC
-    double  asc1, asc2;                // asc values at ends of interval
 
     // --- determine which ADC to use
     if      ( i == SNOW_IMPERV ) k = 0;
@@ -660,13 +714,8 @@ double getArealSnowCover(int i, double awesi)
     if ( awesi >= 0.9999 ) return 1.0;
     m = (int)(awesi*10.0 + 0.00001);
 
-    // --- get asc values for either end of interval
-    asc1 = Snow.adc[k][m];
-    if ( m >= 9) asc2 = 1.0;
-    else asc2 = Snow.adc[k][m+1];
-
-    // --- return with interpolated asc value
-    return asc1 + (asc2 - asc1) / 0.1 * (awesi - 0.1*(float)m);
+    // --- return with asc value interpolated along the interval
+    return Snow.adc[k][m] + AdcSlope[k][m] * (awesi - 0.1*(float)m);
 }    
 
 //=============================================================================
@@ -759,22 +808,15 @@ void updateColdContent(TSnowpack* snowpack, int i, double asc, double snowfall,
     double ati;                        // antecdent temperature index (deg F)
     double cc;                         // snow pack cold content (ft)
     double ccMax;                      // max. possible cold content (ft)
-    double tipm;                       // adjusted ATI weighting factor
 
     // --- retrieve ATI & CC from snow pack object
     ati = snowpack->ati[i];
     cc = snowpack->coldc[i];
 
-    // --- if snowing, ATI = snow (air) temperature
+    // --- if snowing, ATI = snow (air) temperature, otherwise update ATI
+    //     with the weighting factor for the time step (see snow_setTimeStep)
     if ( snowfall * 43200.0 > 0.02) ati = Temp.ta;
-	else
-	{
-	    // convert ATI weighting factor from 6-hr to tStep time basis
-	    tipm = 1.0 - pow(1.0 - Snow.tipm, tStep / (6.0*3600.0));
-		
-		// update ATI
-		ati += tipm * (Temp.ta - ati);
-	}
+    else ati += AtiWeight * (Temp.ta - ati);
 
     // --- ATI cannot exceed snow melt base temperature
     k = snowpack->snowmeltIndex;
@@ -37,6 +37,12 @@
 //   Build 5.1.015: 
 //   - Support added for multiple infiltration methods within a project.
 //   - Only pervious area depression storage receives monthly adjustment.
+//   Build 5.2.4:
+//   - Water balance volumes & ponded depth ODE variables made private to
+//     each thread so subcatchments can be analyzed in parallel.
+//   - Runon routed separately for each receiving subcatchment.
+//   - Weighted outflow now found by routing from its copy of runoff results.
+//   - subcatch_getResults only computes the results asked for.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -67,6 +73,8 @@ double     VlidInfil;     // infiltration from LID units
 double     VlidOut;       // surface outflow from LID units
 double     VlidDrain;     // drain outflow from LID units
 double     VlidReturn;    // LID outflow returned to pervious area
+#pragma omp threadprivate(Vevap, Vpevap, Vinfil, Vinflow, Voutflow, VlidIn, \
+                          VlidInfil, VlidOut, VlidDrain, VlidReturn)
 
 //-----------------------------------------------------------------------------
 // Locally shared variables   
@@ -74,6 +82,7 @@ double     VlidReturn;    // LID outflow returned to pervious area
 static  TSubarea* theSubarea;     // subarea to which getDdDt() is applied
 static  double    Dstore;         // monthly adjusted depression storage (ft)
 static  double    Alpha;          // monthly adjusted runoff coeff.
+#pragma omp threadprivate(theSubarea, Dstore, Alpha)
 static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 
 //-----------------------------------------------------------------------------
@@ -99,7 +108,6 @@ static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 //  subcatch_getDepth          (called from findPondedLoads in surfqual.c)
 //  subcatch_getBuildup        (called from surfqual_getWashoff) (OWA Addition)
 
-//  subcatch_getWtdOutflow     (called from addWetWeatherInflows in routing.c)
 //  subcatch_getResults        (called from output_saveSubcatchResults)
 
 //-----------------------------------------------------------------------------
@@ -521,36 +529,44 @@ double subcatch_getStorage(int j)
 
 //=============================================================================
 
-void subcatch_getRunon(int j)
+void subcatch_getRunon(int j, int k)
 //
-//  Input:   j = subcatchment index
+//  Input:   j = index of subcatchment supplying runon
+//           k = index of subcatchment receiving runon
 //  Output:  none
 //  Purpose: Routes runoff from a subcatchment to its outlet subcatchment
 //           or between its subareas.
 //
+//  Note:    only the runon that subcatchment j sends to subcatchment k is
+//           routed here (flow between j's own subareas when k equals j),
+//           so that the runon received by different subcatchments can be
+//           found in parallel.
+//
 {
-    int    k;                          // outlet subcatchment index
     int    p;                          // pollutant index
     double q;                          // runon to outlet subcatchment (ft/sec)
     double q1, q2;                     // runoff from imperv. areas (ft/sec)
     double pervArea;                   // subcatchment pervious area (ft2)
 
-    // --- add previous period's runoff from this subcatchment to the
-    //     runon of the outflow subcatchment, if it exists
-    k = Subcatch[j].outSubcatch;
-    q = Subcatch[j].oldRunoff;
-    if ( k >= 0 && k != j )
+    if ( k != j )
     {
-        subcatch_addRunonFlow(k, q);
-        for (p = 0; p < Nobjects[POLLUT]; p++)
+        // --- add previous period's runoff from this subcatchment to the
+        //     runon of the outflow subcatchment, if it exists
+        if ( Subcatch[j].outSubcatch == k )
         {
-            Subcatch[k].newQual[p] += q * Subcatch[j].oldQual[p] * LperFT3;
+            q = Subcatch[j].oldRunoff;
+            subcatch_addRunonFlow(k, q);
+            for (p = 0; p < Nobjects[POLLUT]; p++)
+            {
+                Subcatch[k].newQual[p] += q * Subcatch[j].oldQual[p] * LperFT3;
+            }
         }
-    }
 
-    // --- add any LID underdrain flow sent from this subcatchment to
-    //     other subcatchments
-    if ( Subcatch[j].lidArea > 0.0 ) lid_addDrainRunon(j);
+        // --- add any LID underdrain flow sent from this subcatchment to
+        //     the other subcatchment
+        if ( Subcatch[j].lidArea > 0.0 ) lid_addDrainRunon(j, k);
+        return;
+    }
 
     // --- add to sub-area inflow any outflow from other subarea in previous period
     //     (NOTE: no transfer of runoff pollutant load, since runoff loads are
@@ -842,24 +858,11 @@ double subcatch_getDepth(int j)
 
 //=============================================================================
 
-double subcatch_getWtdOutflow(int j, double f)
-//
-//  Input:   j = subcatchment index
-//           f = weighting factor.
-//  Output:  returns weighted runoff value
-//  Purpose: computes wtd. combination of old and new subcatchment runoff.
-//
-{
-    if ( Subcatch[j].area == 0.0 ) return 0.0;
-    return (1.0 - f) * Subcatch[j].oldRunoff + f * Subcatch[j].newRunoff;
-}
-
-//=============================================================================
-
-void  subcatch_getResults(int j, double f, float x[])
+void  subcatch_getResults(int j, double f, float x[], char used[])
 //
 //  Input:   j = subcatchment index
 //           f = weighting factor
+//           used = TRUE for each result to compute (NULL if all)
 //  Output:  x = array of results
 //  Purpose: computes wtd. combination of old and new subcatchment results.
 //
@@ -899,6 +902,8 @@ void  subcatch_getResults(int j, double f, float x[])
 
     // --- retrieve groundwater results
     gw = Subcatch[j].groundwater;
+    if ( used && !used[SUBCATCH_GW_FLOW] && !used[SUBCATCH_GW_ELEV] &&
+         !used[SUBCATCH_SOIL_MOIST] ) gw = NULL;
     if ( gw )
     {
         z = (f1 * gw->oldFlow + f * gw->newFlow) * Subcatch[j].area * UCF(FLOW);
@@ -918,6 +923,7 @@ void  subcatch_getResults(int j, double f, float x[])
     // --- retrieve pollutant washoff
     if ( !IgnoreQuality ) for (p = 0; p < Nobjects[POLLUT]; p++ )
     {
+        if ( used && !used[SUBCATCH_WASHOFF+p] ) continue;
         if ( runoff == 0.0 ) z = 0.0;
         else z = f1 * Subcatch[j].oldQual[p] + f * Subcatch[j].newQual[p];
         x[SUBCATCH_WASHOFF+p] = (float)z;
@@ -20,6 +20,12 @@
 //   - Set low runoff flow concentrations to zero before computing runoff
 //     mass loads rather than after so that they match wet weather mass
 //     inflows reported for conveyance system nodes. 
+//   - Imported pollutant load & water balance variables are private to
+//     each thread for parallel runoff analysis.
+//   - Weighted washoff now found by routing from its copy of runoff results.
+//   - Buildup and washoff found for each land use's contiguous array of
+//     pollutant buildups, with average BMP removals found at the start
+//     of a run.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -43,6 +49,8 @@ extern double      VlidInfil;     // infiltration from LID units
 extern double      VlidOut;       // surface outflow from LID units
 extern double      VlidDrain;     // drain outflow from LID units
 extern double      VlidReturn;    // LID outflow returned to pervious area
+#pragma omp threadprivate(OutflowLoad, Vinfil, Vinflow, Voutflow, VlidIn, \
+                          VlidInfil, VlidOut, VlidDrain, VlidReturn)
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)   
@@ -51,7 +59,6 @@ extern double      VlidReturn;    // LID outflow returned to pervious area
 //  surfqual_getWashoff        (called from runoff_execute)
 //  surfqual_getBuildup        (called from runoff_execute)
 //  surfqual_sweepBuildup      (called from runoff_execute)
-//  surfqual_getWtdWashoff     (called from addWetWeatherInflows in routing.c)
 
 //-----------------------------------------------------------------------------
 // Function declarations
@@ -79,6 +86,7 @@ void surfqual_initState(int j)
         Subcatch[j].pondedQual[p] = 0.0;
         Subcatch[j].concPonded[p] = 0.0;      // (OWA addition)
         Subcatch[j].surfaceBuildup[p] = 0.0;  // (OWA addition)
+        Subcatch[j].avgBmpEffic[p] = landuse_getAvgBmpEffic(j, p);
     }
 
     // --- initialize pollutant buildup
@@ -98,11 +106,17 @@ void surfqual_getBuildup(int j, double tStep)
 {
     int     i;                         // land use index
     int     p;                         // pollutant index
+    int     noSnow;                    // TRUE if no snow cover
     double  f;                         // land use fraction
     double  area;                      // land use area (acres or hectares)
     double  curb;                      // land use curb length (user units)
     double  oldBuildup;                // buildup at start of time step
     double  newBuildup;                // buildup at end of time step
+    double* buildup;                   // land use's buildup of each pollutant
+    TBuildup* buildupFunc;             // land use's buildup functions
+
+    // --- see if snow-only buildup is in effect
+    noSnow = Subcatch[j].newSnowDepth < 0.001/12.0;
 
     // --- consider each landuse
     for (i = 0; i < Nobjects[LANDUSE]; i++)
@@ -114,20 +128,21 @@ void surfqual_getBuildup(int j, double tStep)
         // --- get land area (in acres or hectares) & curb length
         area = f * Subcatch[j].area * UCF(LANDAREA);
         curb = f * Subcatch[j].curbLength;
+        buildup = Subcatch[j].landFactor[i].buildup;
+        buildupFunc = Landuse[i].buildupFunc;
 
         // --- examine each pollutant
         for (p = 0; p < Nobjects[POLLUT]; p++)
         {
-            // --- see if snow-only buildup is in effect
-            if (Pollut[p].snowOnly 
-            && Subcatch[j].newSnowDepth < 0.001/12.0) continue;
+            if ( buildupFunc[p].funcType == NO_BUILDUP ) continue;
+            if ( Pollut[p].snowOnly && noSnow ) continue;
 
             // --- use land use's buildup function to update buildup amount
-            oldBuildup = Subcatch[j].landFactor[i].buildup[p];        
+            oldBuildup = buildup[p];
             newBuildup = landuse_getBuildup(i, p, area, curb, oldBuildup,
                          tStep);
             newBuildup = MAX(newBuildup, oldBuildup);
-            Subcatch[j].landFactor[i].buildup[p] = newBuildup;
+            buildup[p] = newBuildup;
             massbal_updateLoadingTotals(BUILDUP_LOAD, p, 
                                        (newBuildup - oldBuildup));
        }
@@ -300,21 +315,6 @@ void  surfqual_getWashoff(int j, double runoff, double tStep)
 
 //=============================================================================
 
-double surfqual_getWtdWashoff(int j, int p, double f)
-//
-//  Input:   j = subcatchment index
-//           p = pollutant index
-//           f = weighting factor
-//  Output:  returns pollutant washoff value
-//  Purpose: finds wtd. combination of old and new washoff for a pollutant.
-//
-{
-    return (1.0 - f) * Subcatch[j].oldRunoff * Subcatch[j].oldQual[p] +
-           f * Subcatch[j].newRunoff *Subcatch[j].newQual[p];
-}
-
-//=============================================================================
-
 void findPondedLoads(int j, double tStep)
 //
 //  Input:   j = subcatchment index
@@ -378,7 +378,7 @@ void findPondedLoads(int j, double tStep)
             wPonded -= wOutflow;
 
             // --- reduce outflow load by average BMP removal
-            bmpRemoval = landuse_getAvgBmpEffic(j, p) * wOutflow;
+            bmpRemoval = Subcatch[j].avgBmpEffic[p] * wOutflow;
             massbal_updateLoadingTotals(BMP_REMOVAL_LOAD, p,
                 bmpRemoval*Pollut[p].mcf);
             wOutflow -= bmpRemoval;
@@ -409,18 +409,14 @@ void  findWashoffLoads(int j, double runoff)
     double w,                          // co-pollutant load (mass)
            area = Subcatch[j].area;    // subcatchment area (ft2)
     
-    // --- examine each land use
+    // --- add the loads generated by each land use's washoff functions
     if ( runoff < MIN_RUNOFF ) return;
     for (i = 0; i < Nobjects[LANDUSE]; i++)
     {
         if ( Subcatch[j].landFactor[i].fraction > 0.0 )
         {
-            // --- compute load generated by washoff function
-            for (p = 0; p < Nobjects[POLLUT]; p++)
-            {
-                OutflowLoad[p] += landuse_getWashoffLoad(
-                    i, p, area, Subcatch[j].landFactor, runoff, Voutflow);
-            }
+            landuse_getWashoffLoads(i, area, &Subcatch[j].landFactor[i],
+                runoff, Voutflow, OutflowLoad);
         }
     }
 
@@ -42,6 +42,10 @@
 //   - Prevented possible infinite loop if swmm_step() called when ErrorCode > 0.
 //   - Prevented early exit from swmm_end() when ErrorCode > 0.
 //   - Support added for relative file names.
+//   Build 5.2.4:
+//   - Simulation time steps taken by new function runSteps, which computes
+//     runoff one time step ahead of flow routing on a second thread when
+//     runoff does not depend on the drainage system.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -103,6 +107,9 @@
 #include <math.h>
 #include <time.h>
 #include <float.h>
+#if defined(_OPENMP)
+  #include <omp.h>
+#endif
 
 //-----------------------------------------------------------------------------
 //  SWMM's header files
@@ -160,6 +167,10 @@ static int    ExceptionCount;       // number of exceptions handled
 static int    DoRunoff;             // TRUE if runoff is computed
 static int    DoRouting;            // TRUE if flow routing is computed
 static double RoutingDuration;      // duration of a set of routing steps (msecs)
+static int    RunoffAhead;          // TRUE if runoff computed ahead of routing
+static int    RunoffPending;        // TRUE if a runoff time step is under way
+static double RoutedRunoffTime;     // runoff time seen by routing (msecs)
+static long   ProgressHour;         // last hour of simulation written to console
 
 //-----------------------------------------------------------------------------
 //  External API functions (prototyped in swmm5.h)
@@ -190,6 +201,9 @@ static double RoutingDuration;      // duration of a set of routing steps (msecs
 //  Local functions
 //-----------------------------------------------------------------------------
 static void   execRouting(void);
+static void   execRunoff(void);
+static void   runRunoffAhead(void);
+static void   writeProgress(double elapsedTime);
 static void   saveResults(void);
 static double getGageValue(int index, int property);
 static double getSubcatchValue(int index, int property);
@@ -229,10 +243,6 @@ int DLLEXPORT  swmm_run(const char *f1, const char *f2, const char *f3)
 //  Purpose: runs a SWMM simulation.
 //
 {
-    long newHour, oldHour = 0;
-    long theDay, theHour;
-    double elapsedTime = 0.0;
-
     // --- initialize flags
     IsOpenFlag = FALSE;
     IsStartedFlag = FALSE;
@@ -253,20 +263,8 @@ int DLLEXPORT  swmm_run(const char *f1, const char *f2, const char *f3)
         if ( !ErrorCode )
         {
             writecon("\n o  Simulating day: 0     hour:  0");
-            do
-            {
-                swmm_step(&elapsedTime);
-                newHour = (long)(elapsedTime * 24.0);
-                if ( newHour > oldHour )
-                {
-                    theDay = (long)elapsedTime;
-                    theHour = (long)((elapsedTime - floor(elapsedTime)) * 24.0);
-                    writecon("\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
-                    snprintf(Msg, MAXMSG, "%-5ld hour: %-2ld", theDay, theHour);
-                    writecon(Msg);
-                    oldHour = newHour;
-                }
-            } while ( elapsedTime > 0.0 && !ErrorCode );
+            ProgressHour = 0;
+            runSteps(writeProgress);
             writecon("\b\b\b\b\b\b\b\b\b\b\b\b\b\b"
                      "\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
             writecon("Simulation complete           ");
@@ -290,6 +288,70 @@ int DLLEXPORT  swmm_run(const char *f1, const char *f2, const char *f3)
 
 //=============================================================================
 
+void writeProgress(double elapsedTime)
+//
+//  Input:   elapsedTime = current elapsed time in decimal days
+//  Output:  none
+//  Purpose: writes the current day and hour of a simulation to the console.
+//
+{
+    long newHour, theDay, theHour;
+
+    newHour = (long)(elapsedTime * 24.0);
+    if ( newHour > ProgressHour )
+    {
+        theDay = (long)elapsedTime;
+        theHour = (long)((elapsedTime - floor(elapsedTime)) * 24.0);
+        writecon("\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+        snprintf(Msg, MAXMSG, "%-5ld hour: %-2ld", theDay, theHour);
+        writecon(Msg);
+        ProgressHour = newHour;
+    }
+}
+
+//=============================================================================
+
+void runSteps(void (*stepCallback)(double))
+//
+//  Input:   stepCallback = function called with the elapsed time (days)
+//                          after each time step (or NULL)
+//  Output:  none
+//  Purpose: executes each time step of a started simulation until elapsed
+//           time is re-set to 0.
+//
+//  Note:    when runoff does not depend on the drainage system, the next
+//           runoff time step is found as a task on a second thread while
+//           the main thread routes flow with the runoff results it already
+//           has (see runRunoffAhead).
+//
+{
+    double elapsedTime = 0.0;
+#if defined(_OPENMP) && _OPENMP >= 200805
+    int    maxLevels = omp_get_max_active_levels();
+
+    // --- runoff & routing each keep their own team of threads
+    RunoffAhead = DoRunoff && DoRouting && NumThreads > 1 &&
+                  runoff_canRunAhead();
+    if ( RunoffAhead ) omp_set_max_active_levels(MAX(maxLevels, 2));
+
+    #pragma omp parallel num_threads(2) if (RunoffAhead)
+    #pragma omp master
+#endif
+    do
+    {
+        swmm_step(&elapsedTime);
+        if ( stepCallback ) stepCallback(elapsedTime);
+    } while ( elapsedTime > 0.0 && !ErrorCode );
+
+#if defined(_OPENMP) && _OPENMP >= 200805
+    if ( RunoffAhead ) omp_set_max_active_levels(maxLevels);
+#endif
+    RunoffAhead = FALSE;
+    RunoffPending = FALSE;
+}
+
+//=============================================================================
+
 int DLLEXPORT swmm_open(const char *f1, const char *f2, const char *f3)
 //
 //  Input:   f1 = name of input file
@@ -385,6 +447,9 @@ int DLLEXPORT swmm_start(int saveResults)
 
         // --- initialize runoff, routing & reporting time (in milliseconds)
         NewRunoffTime = 0.0;
+        RoutedRunoffTime = 0.0;
+        RunoffAhead = FALSE;
+        RunoffPending = FALSE;
         NewRoutingTime = 0.0;
         ReportTime = 1000 * (double)ReportStep;
         TotalStepCount = 0;
@@ -482,6 +547,9 @@ int DLLEXPORT swmm_step(double *elapsedTime)
         if ( SaveResultsFlag )
             saveResults();
 
+        // --- start on next runoff time step if routing can proceed without it
+        if ( RunoffAhead ) runRunoffAhead();
+
         // --- update elapsed time (days)
         if ( NewRoutingTime < RoutingDuration )
             ElapsedTime = NewRoutingTime / MSECperDAY;
@@ -586,14 +654,18 @@ void execRouting()
         }
 
         // --- compute runoff until next routing time reached or exceeded
-        if ( DoRunoff ) while ( NewRunoffTime < nextRoutingTime)
+        if ( DoRunoff ) while ( RoutedRunoffTime < nextRoutingTime)
         {
-            runoff_execute();
+            execRunoff();
             if ( ErrorCode ) return;
         }
 
         // --- if no runoff analysis, update climate state (for evaporation)
-        else climate_setState(getDateTime(NewRoutingTime));
+        else
+        {
+            climate_setState(getDateTime(NewRoutingTime));
+            if ( DoRouting ) routing_saveRunoff();
+        }
   
         // --- route flows & pollutants through drainage system
         //     (while updating NewRoutingTime)
@@ -616,6 +688,58 @@ void execRouting()
 
 //=============================================================================
 
+void execRunoff()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: makes the results of the next runoff time step available to
+//           flow routing.
+//
+{
+    // --- wait for the time step being found ahead of routing to finish,
+    //     otherwise compute it now
+    if ( RunoffPending )
+    {
+#if defined(_OPENMP) && _OPENMP >= 200805
+        #pragma omp taskwait
+#endif
+        RunoffPending = FALSE;
+    }
+    else runoff_execute();
+    if ( ErrorCode ) return;
+
+    // --- copy the results used by routing
+    if ( DoRouting ) routing_saveRunoff();
+    RoutedRunoffTime = NewRunoffTime;
+}
+
+//=============================================================================
+
+void runRunoffAhead()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: starts finding the next runoff time step as a task that runs
+//           while flow routing proceeds.
+//
+//  Note:    results saved at a reporting time come from the runoff time
+//           step that routing is using, so a step is not started once the
+//           runoff results used by routing reach the next reporting time.
+//
+{
+    if ( RunoffPending || ErrorCode ) return;
+    if ( NewRoutingTime >= RoutingDuration ) return;
+    if ( RoutedRunoffTime >= TotalDuration ) return;
+    if ( SaveResultsFlag && RoutedRunoffTime >= ReportTime ) return;
+    RunoffPending = TRUE;
+#if defined(_OPENMP) && _OPENMP >= 200805
+    #pragma omp task
+#endif
+    runoff_execute();
+}
+
+//=============================================================================
+
 void saveResults()
 //
 //  Input:   none
@@ -104,6 +104,8 @@
 #define  w_MIN_ROUTE_STEP    "MINIMUM_STEP"
 #define  w_NUM_THREADS       "THREADS"
 #define  w_SURCHARGE_METHOD  "SURCHARGE_METHOD"
+#define  w_SKIP_CONVERGED    "SKIP_CONVERGED"
+#define  w_SEPARATE_BASINS   "SEPARATE_BASINS"
 
 // Flow Units
 #define  w_CFS               "CFS"
@@ -327,6 +329,26 @@
 #define  w_CONTROLS          "CONTROL"
 #define  w_NODESTATS         "NODESTATS"
 #define  w_AVERAGES          "AVERAGES"
+#define  w_LAYOUT            "LAYOUT"
+#define  w_VARIABLES         "VARIABLES"
+
+// Binary Results Layouts
+#define  w_PERIOD            "PERIOD"
+#define  w_ELEMENT           "ELEMENT"
+#define  w_COMPRESSED        "COMPRESSED"
+
+// Binary Results Variables
+#define  w_SNOW_DEPTH        "SNOW_DEPTH"
+#define  w_EVAP_LOSS         "EVAP"
+#define  w_INFIL_LOSS        "INFIL"
+#define  w_GW_FLOW           "GW_FLOW"
+#define  w_GW_ELEV           "GW_ELEV"
+#define  w_SOIL_MOIST        "SOIL_MOIST"
+#define  w_LATERAL_INFLOW    "LATERAL_INFLOW"
+#define  w_TOTAL_INFLOW      "TOTAL_INFLOW"
+#define  w_FLOODING          "FLOODING"
+#define  w_VELOCITY          "VELOCITY"
+#define  w_CAPACITY          "CAPACITY"
 
 // Interface File Types
 #define  w_RAINFALL          "RAINFALL"
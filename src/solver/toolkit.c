@@ -50,6 +50,11 @@ int  stats_getSubcatchStat(int index, TSubcatchStats **subcatchStats);
 
 // Utilty Function Declarations
 double *newDoubleArray(int n);
+static void reportProgress(double elapsedTime);
+
+// Progress callback of a simulation being run by swmm_run_cb
+static void (*ProgressCallback) (double *);
+static clock_t ProgressCheck;
 
 
 
@@ -85,8 +90,7 @@ EXPORT_TOOLKIT int swmm_run_cb(const char* f1, const char* f2, const char* f3,
 //  Purpose: runs a SWMM simulation.
 //
 {
-    clock_t check = 0;
-    double progress, elapsedTime = 0.0;
+    double progress;
 
 
     // --- initialize flags
@@ -108,19 +112,10 @@ EXPORT_TOOLKIT int swmm_run_cb(const char* f1, const char* f2, const char* f3,
         // --- execute each time step until elapsed time is re-set to 0
         if ( !ErrorCode )
         {
-            do
-            {
-                swmm_step(&elapsedTime);
-
-                // --- callback with progress approximately twice a second
-                if ( (callback != NULL) && (clock() - check) > CLOCKS_PER_SEC )
-                {
-                    progress = NewRoutingTime / TotalDuration;
-                    callback(&progress);
-                    check = clock();
-                }
-
-            } while ( elapsedTime > 0.0 && !ErrorCode );
+            ProgressCallback = callback;
+            ProgressCheck = 0;
+            if ( callback != NULL ) runSteps(reportProgress);
+            else runSteps(NULL);
 
             if ( callback != NULL )
             {
@@ -144,6 +139,28 @@ EXPORT_TOOLKIT int swmm_run_cb(const char* f1, const char* f2, const char* f3,
 }
 
 
+static void reportProgress(double elapsedTime)
+//
+//  Input:   elapsedTime = current elapsed time in decimal days
+//  Output:  none
+//  Purpose: calls back with progress of swmm_run_cb approximately twice
+//           a second.
+//
+{
+    double progress;
+
+    // --- an elapsed time of 0 marks the end of the run, whose progress
+    //     is reported by swmm_run_cb itself
+    if ( elapsedTime <= 0.0 ) return;
+    if ( (clock() - ProgressCheck) > CLOCKS_PER_SEC )
+    {
+        progress = elapsedTime * MSECperDAY / TotalDuration;
+        ProgressCallback(&progress);
+        ProgressCheck = clock();
+    }
+}
+
+
 EXPORT_TOOLKIT int swmm_getAPIError(int errorCode, char **errorMsg)
 ///
 /// Input:   errorCode = error code
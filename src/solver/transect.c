@@ -14,6 +14,7 @@
 //   - Function added to create a transect for a Street cross-section.
 //   Build 5.2.4:
 //   - Corrected street transect points in transect_createStreetTransect.
+//   - Inverse lookup index built for a transect's area table.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -305,6 +306,9 @@ void createTables(TTransect *transect, double ymin, double ymax)
 
     // --- set width at 0 height equal to width at 4% of max. height
     transect->widthTbl[0] = transect->widthTbl[1];
+
+    // --- index the area table for finding depth given area
+    xsect_setInvIndex(&transect->areaIndex, transect->areaTbl, transect->nTbl);
 }
 
 //=============================================================================
@@ -34,6 +34,8 @@
 //   - Support added for Street cross sections.
 //   Build 5.2.2:
 //   - Feasibility check added to Mod. Baskethandle & Rect.-Round shapes.
+//   Build 5.2.4:
+//   - Inverse table lookups use a uniform-bin index instead of bisection.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -90,6 +92,16 @@ typedef struct
     TXsect* xsect;            // pointer to a cross section object
 } TXsectStar;
 
+// Built-in geometry tables searched by invLookup()
+enum InvTableType {INV_A_HORIZ_ELLIPSE, INV_A_VERT_ELLIPSE, INV_A_ARCH,
+                   INV_Y_GOTHIC, INV_Y_CATENARY, INV_Y_SEMIELLIP,
+                   INV_Y_SEMICIRC, INV_S_CIRC, INV_S_EGG, INV_S_HORSESHOE,
+                   INV_S_GOTHIC, INV_S_CATENARY, INV_S_SEMIELLIP,
+                   INV_S_BASKETHANDLE, INV_S_SEMICIRC, N_INV_TABLES};
+
+static TInvIndex InvIndex[N_INV_TABLES];  // inverse lookup index of each
+static int       InvIndexReady = FALSE;   // TRUE once InvIndex[] is built
+
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
@@ -98,6 +110,7 @@ typedef struct
 //  xsect_setIrregXsectParams
 //  xsect_setStreetXsectParams
 //  xsect_setCustomXsectParams
+//  xsect_setInvIndex
 //  xsect_getAmax
 //  xsect_getSofA
 //  xsect_getYofA
@@ -119,8 +132,10 @@ static void   evalSofA(double a, double* f, double* df, void* p);
 static double tabular_getdSdA(TXsect* xsect, double a, double *table, int nItems);
 static double generic_getdSdA(TXsect* xsect, double a);
 static double lookup(double x, double *table, int nItems);
-static double invLookup(double y, double *table, int nItems);
-static int    locate(double y, double *table, int nItems);
+static double invLookup(double y, double *table, int nItems,
+              TInvIndex* index);
+static int    locate(double y, double *table, int jLast, TInvIndex* index);
+static void   createInvIndexes(void);
 
 static double rect_closed_getSofA(TXsect* xsect, double a);
 static double rect_closed_getdSdA(TXsect* xsect, double a);
@@ -226,6 +241,7 @@ int xsect_setParams(TXsect *xsect, int type, double p[], double ucf)
     int    index;
     double aMax, theta;
 
+    if ( !InvIndexReady ) createInvIndexes();
     if ( type != DUMMY && p[0] <= 0.0 ) return FALSE;
     xsect->type  = type;
     switch ( xsect->type )
@@ -809,26 +825,32 @@ double xsect_getYofA(TXsect *xsect, double a)
         return xsect->yFull * lookup(alpha, Y_SemiCirc, N_Y_SemiCirc);
 
       case HORIZ_ELLIPSE:
-        return xsect->yFull * invLookup(alpha, A_HorizEllipse, N_A_HorizEllipse);
+        return xsect->yFull * invLookup(alpha, A_HorizEllipse, N_A_HorizEllipse,
+            &InvIndex[INV_A_HORIZ_ELLIPSE]);
 
       case VERT_ELLIPSE:
-        return xsect->yFull * invLookup(alpha, A_VertEllipse, N_A_VertEllipse);
+        return xsect->yFull * invLookup(alpha, A_VertEllipse, N_A_VertEllipse,
+            &InvIndex[INV_A_VERT_ELLIPSE]);
 
       case IRREGULAR:
         return xsect->yFull * invLookup(alpha,
-            Transect[xsect->transect].areaTbl, N_TRANSECT_TBL);
+            Transect[xsect->transect].areaTbl, N_TRANSECT_TBL,
+            &Transect[xsect->transect].areaIndex);
 
       case CUSTOM:
         return xsect->yFull * invLookup(alpha,
-            Shape[Curve[xsect->transect].refersTo].areaTbl, N_SHAPE_TBL);
+            Shape[Curve[xsect->transect].refersTo].areaTbl, N_SHAPE_TBL,
+            &Shape[Curve[xsect->transect].refersTo].areaIndex);
 
       case STREET_XSECT:
         return xsect->yFull * invLookup(alpha,
-            Street[xsect->transect].transect.areaTbl, 
-            Street[xsect->transect].transect.nTbl);
+            Street[xsect->transect].transect.areaTbl,
+            Street[xsect->transect].transect.nTbl,
+            &Street[xsect->transect].transect.areaIndex);
 
       case ARCH:
-        return xsect->yFull * invLookup(alpha, A_Arch, N_A_Arch);
+        return xsect->yFull * invLookup(alpha, A_Arch, N_A_Arch,
+            &InvIndex[INV_A_ARCH]);
 
       case RECT_CLOSED: return a / xsect->wMax;
 
@@ -880,19 +902,23 @@ double xsect_getAofY(TXsect *xsect, double y)
         return xsect->aFull * lookup(yNorm, A_Horseshoe, N_A_Horseshoe);
 
       case GOTHIC:
-        return xsect->aFull * invLookup(yNorm, Y_Gothic, N_Y_Gothic);
+        return xsect->aFull * invLookup(yNorm, Y_Gothic, N_Y_Gothic,
+            &InvIndex[INV_Y_GOTHIC]);
 
       case CATENARY:
-        return xsect->aFull * invLookup(yNorm, Y_Catenary, N_Y_Catenary);
+        return xsect->aFull * invLookup(yNorm, Y_Catenary, N_Y_Catenary,
+            &InvIndex[INV_Y_CATENARY]);
 
       case SEMIELLIPTICAL:
-        return xsect->aFull * invLookup(yNorm, Y_SemiEllip, N_Y_SemiEllip);
+        return xsect->aFull * invLookup(yNorm, Y_SemiEllip, N_Y_SemiEllip,
+            &InvIndex[INV_Y_SEMIELLIP]);
 
       case BASKETHANDLE:
         return xsect->aFull * lookup(yNorm, A_Baskethandle, N_A_Baskethandle);
 
       case SEMICIRCULAR:
-        return xsect->aFull * invLookup(yNorm, Y_SemiCirc, N_Y_SemiCirc);
+        return xsect->aFull * invLookup(yNorm, Y_SemiCirc, N_Y_SemiCirc,
+            &InvIndex[INV_Y_SEMICIRC]);
 
       case HORIZ_ELLIPSE:
         return xsect->aFull * lookup(yNorm, A_HorizEllipse, N_A_HorizEllipse);
@@ -1165,25 +1191,32 @@ double xsect_getAofS(TXsect* xsect, double s)
       case CIRCULAR:  return circ_getAofS(xsect, s);
 
       case EGGSHAPED:
-        return xsect->aFull * invLookup(psi, S_Egg, N_S_Egg);
+        return xsect->aFull * invLookup(psi, S_Egg, N_S_Egg,
+            &InvIndex[INV_S_EGG]);
 
       case HORSESHOE:
-        return xsect->aFull * invLookup(psi, S_Horseshoe, N_S_Horseshoe);
+        return xsect->aFull * invLookup(psi, S_Horseshoe, N_S_Horseshoe,
+            &InvIndex[INV_S_HORSESHOE]);
 
       case GOTHIC:
-        return xsect->aFull * invLookup(psi, S_Gothic, N_S_Gothic);
+        return xsect->aFull * invLookup(psi, S_Gothic, N_S_Gothic,
+            &InvIndex[INV_S_GOTHIC]);
 
       case CATENARY:
-        return xsect->aFull * invLookup(psi, S_Catenary, N_S_Catenary);
+        return xsect->aFull * invLookup(psi, S_Catenary, N_S_Catenary,
+            &InvIndex[INV_S_CATENARY]);
 
       case SEMIELLIPTICAL:
-        return xsect->aFull * invLookup(psi, S_SemiEllip, N_S_SemiEllip);
+        return xsect->aFull * invLookup(psi, S_SemiEllip, N_S_SemiEllip,
+            &InvIndex[INV_S_SEMIELLIP]);
 
       case BASKETHANDLE:
-        return xsect->aFull * invLookup(psi, S_BasketHandle, N_S_BasketHandle);
+        return xsect->aFull * invLookup(psi, S_BasketHandle, N_S_BasketHandle,
+            &InvIndex[INV_S_BASKETHANDLE]);
 
       case SEMICIRCULAR:
-        return xsect->aFull * invLookup(psi, S_SemiCirc, N_S_SemiCirc);
+        return xsect->aFull * invLookup(psi, S_SemiCirc, N_S_SemiCirc,
+            &InvIndex[INV_S_SEMICIRC]);
 
       default: return generic_getAofS(xsect, s);
     }
@@ -1508,11 +1541,12 @@ double lookup(double x, double *table, int nItems)
 
 //=============================================================================
 
-double invLookup(double y, double *table, int nItems)
+double invLookup(double y, double *table, int nItems, TInvIndex* index)
 //
 //  Input:   y = value of dependent variable in a geometry table
 //           table = ptr. to geometry table
 //           nItems = number of equally spaced items in table
+//           index = ptr. to the table's inverse lookup index
 //  Output:  returns value of independent table variable
 //  Purpose: performs inverse lookup in a geometry table (i.e., finds
 //           x given y).
@@ -1551,7 +1585,7 @@ double invLookup(double y, double *table, int nItems)
     }
 
     // --- otherwise locate the interval where y falls in the table
-    else i = locate(y, table, n-1);
+    else i = locate(y, table, n-1, index);
     if ( i >= n - 1 ) return ((double)n-1) * dx;
 
     // --- compute x at start and end of segment
@@ -1568,21 +1602,23 @@ double invLookup(double y, double *table, int nItems)
 
 //=============================================================================
 
-int locate(double y, double *table, int jLast)
+int locate(double y, double *table, int jLast, TInvIndex* index)
 //
 //  Input:   y      = value being located in table
 //           table  = ptr. to table with monotonically increasing entries
 //           jLast  = highest table entry index to search over
-//  Output:  returns index j of table such that table[j] <= y <= table[j+1]
-//  Purpose: uses bisection method to locate the highest table index whose
-//           table entry does not exceed a given value.
+//           index  = ptr. to the table's inverse lookup index
+//  Output:  returns index j of table such that table[j] <= y < table[j+1]
+//  Purpose: locates the highest table index whose table entry does not
+//           exceed a given value.
 //
 //  Notes:   This function is only used in conjunction with invLookup().
+//           The bin of the index that contains y gives the table interval
+//           at the start of the bin, from which only a step or two is
+//           needed to reach the interval containing y.
 //
 {
-    int j;
-    int j1 = 0;
-    int j2 = jLast;
+    int j, k;
 
     // Check if value <= first table entry
     if ( y <= table[0] ) return 0;
@@ -1590,21 +1626,86 @@ int locate(double y, double *table, int jLast)
     // Check if value >= the last entry
     if ( y >= table[jLast] ) return jLast;
 
-    // While a portion of the table still remains
-    while ( j2 - j1 > 1)
-    {
-        // Find midpoint of remaining portion of table
-        j = (j1 + j2) >> 1;
+    // Start from the table interval at the start of y's bin
+    k = (int)((y - index->yMin) * index->binsPerY);
+    if ( k < 0 ) k = 0;
+    if ( k >= N_INV_BINS ) k = N_INV_BINS - 1;
+    j = index->start[k];
+
+    // Step down or up to the interval that contains y
+    while ( j > 0 && y < table[j] ) j--;
+    while ( y >= table[j+1] ) j++;
+    return j;
+}
+
+//=============================================================================
+
+void xsect_setInvIndex(TInvIndex* index, double* table, int nItems)
+//
+//  Input:   index = ptr. to an inverse lookup index
+//           table = ptr. to geometry table
+//           nItems = number of equally spaced items in table
+//  Output:  none
+//  Purpose: builds the index used by invLookup() to locate a value in a
+//           geometry table without searching the table.
+//
+//  Notes:   The range of the table's increasing portion is divided into
+//           N_INV_BINS equal bins, each recording the table interval in
+//           which the bin starts.
+//
+{
+    int    n, j, k;
+    double y, dy;
 
-        // Value is greater or equal to midpoint: search from midpoint to j2
-        if ( y >= table[j] ) j1 = j;
+    // --- find the increasing portion of the table (see invLookup)
+    n = nItems;
+    if ( table[n-3] > table[n-1] ) n = n - 2;
+
+    // --- divide the range of this portion into equal bins
+    index->yMin = table[0];
+    dy = (table[n-1] - table[0]) / N_INV_BINS;
+    if ( dy <= 0.0 ) index->binsPerY = 0.0;
+    else index->binsPerY = 1.0 / dy;
 
-        // Value is less than midpoint: search from j1 to midpoint
-        else j2 = j;
+    // --- record the table interval at the start of each bin
+    j = 0;
+    for (k = 0; k < N_INV_BINS; k++)
+    {
+        y = table[0] + k * dy;
+        while ( j < n - 2 && y >= table[j+1] ) j++;
+        index->start[k] = (unsigned char)j;
     }
+}
+
+//=============================================================================
 
-    // Return the lower index of the remaining interval,
-    return j1;
+void createInvIndexes()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: builds the inverse lookup indexes of the built-in geometry
+//           tables searched by invLookup().
+//
+{
+    xsect_setInvIndex(&InvIndex[INV_A_HORIZ_ELLIPSE], A_HorizEllipse,
+                      N_A_HorizEllipse);
+    xsect_setInvIndex(&InvIndex[INV_A_VERT_ELLIPSE], A_VertEllipse,
+                      N_A_VertEllipse);
+    xsect_setInvIndex(&InvIndex[INV_A_ARCH], A_Arch, N_A_Arch);
+    xsect_setInvIndex(&InvIndex[INV_Y_GOTHIC], Y_Gothic, N_Y_Gothic);
+    xsect_setInvIndex(&InvIndex[INV_Y_CATENARY], Y_Catenary, N_Y_Catenary);
+    xsect_setInvIndex(&InvIndex[INV_Y_SEMIELLIP], Y_SemiEllip, N_Y_SemiEllip);
+    xsect_setInvIndex(&InvIndex[INV_Y_SEMICIRC], Y_SemiCirc, N_Y_SemiCirc);
+    xsect_setInvIndex(&InvIndex[INV_S_CIRC], S_Circ, N_S_Circ);
+    xsect_setInvIndex(&InvIndex[INV_S_EGG], S_Egg, N_S_Egg);
+    xsect_setInvIndex(&InvIndex[INV_S_HORSESHOE], S_Horseshoe, N_S_Horseshoe);
+    xsect_setInvIndex(&InvIndex[INV_S_GOTHIC], S_Gothic, N_S_Gothic);
+    xsect_setInvIndex(&InvIndex[INV_S_CATENARY], S_Catenary, N_S_Catenary);
+    xsect_setInvIndex(&InvIndex[INV_S_SEMIELLIP], S_SemiEllip, N_S_SemiEllip);
+    xsect_setInvIndex(&InvIndex[INV_S_BASKETHANDLE], S_BasketHandle,
+                      N_S_BasketHandle);
+    xsect_setInvIndex(&InvIndex[INV_S_SEMICIRC], S_SemiCirc, N_S_SemiCirc);
+    InvIndexReady = TRUE;
 }
 
 //=============================================================================
@@ -2385,7 +2486,8 @@ double circ_getAofS(TXsect* xsect, double s)
     if (psi <= 0.015) return xsect->aFull * getAcircular(psi);
 
     // --- otherwise use table
-    else return xsect->aFull * invLookup(psi, S_Circ, N_S_Circ);
+    else return xsect->aFull * invLookup(psi, S_Circ, N_S_Circ,
+            &InvIndex[INV_S_CIRC]);
 }
 
 double circ_getSofA(TXsect* xsect, double a)
@@ -24,6 +24,10 @@
 // NOTE: Reference data for the unit tests is currently tied to SWMM 5.1.7
 #define DATA_PATH "./test_example1.out"
 
+// Example 1 saved with [REPORT] VARIABLES SUBCATCHMENTS rainfall runoff Lead,
+// NODES depth flooding TSS and LINKS flow capacity Lead
+#define VARS_DATA_PATH "./test_example1_vars.out"
+
 using namespace std;
 
 // Checks for minimum number of correct decimal digits
@@ -174,6 +178,27 @@ BOOST_FIXTURE_TEST_CASE(test_getProjectSize, Fixture) {
     SMO_freeMemory((void*)i_array);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_getSavedVariables, Fixture) {
+    int* i_array = NULL;
+
+    error = SMO_getSavedVariables(p_handle, SMO_link, &i_array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    std::vector<int> test;
+    test.assign(i_array, i_array + array_dim);
+
+    // all link variables plus two pollutants were saved
+    const int ref_dim            = 7;
+    int       ref_array[ref_dim] = {0, 1, 2, 3, 4, 5, 6};
+
+    std::vector<int> ref;
+    ref.assign(ref_array, ref_array + ref_dim);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref.begin(), ref.end(), test.begin(), test.end());
+
+    SMO_freeMemory((void*)i_array);
+}
+
 BOOST_FIXTURE_TEST_CASE(test_getUnits, Fixture) {
     int*      i_array            = NULL;
 
@@ -301,6 +326,118 @@ BOOST_FIXTURE_TEST_CASE(test_getSystemSeries, Fixture) {
 }
 
 
+BOOST_FIXTURE_TEST_CASE(test_getElementSeries, Fixture) {
+    const int n_elem = 2, n_attr = 2, n_period = 11;
+    int elem[n_elem] = {1, 2};
+    int attr[n_attr] = {SMO_runoff_rate, SMO_rainfall_subcatch};
+    float bulk[n_elem * n_attr * n_period];
+
+    error = SMO_getElementSeries(p_handle, SMO_subcatch, elem, n_elem, attr,
+                                 n_attr, 0, 10, bulk, n_elem * n_attr * n_period);
+    BOOST_REQUIRE(error == 0);
+
+    // each series must match the one read on its own
+    for (int i = 0; i < n_elem; i++) {
+        for (int j = 0; j < n_attr; j++) {
+            error = SMO_getSubcatchSeries(p_handle, elem[i],
+                (SMO_subcatchAttribute)attr[j], 0, 10, &array, &array_dim);
+            BOOST_REQUIRE(error == 0);
+            BOOST_REQUIRE(array_dim == n_period);
+
+            float* test = bulk + (i * n_attr + j) * n_period;
+            BOOST_CHECK_EQUAL_COLLECTIONS(array, array + array_dim,
+                                          test, test + n_period);
+            SMO_freeMemory((void*)array);
+            array = NULL;
+        }
+    }
+
+    // a buffer that is too small is rejected
+    error = SMO_getElementSeries(p_handle, SMO_subcatch, elem, n_elem, attr,
+                                 n_attr, 0, 10, bulk, n_period);
+    BOOST_CHECK(error == 424);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_transpose, Fixture) {
+    const char* path = "./test_example1_transposed.out";
+    SMO_Handle  t_handle = NULL;
+    float*      t_array = NULL;
+    int         t_dim = 0;
+
+    // save results in blocks of 5 periods, the last one partly filled
+    error = SMO_transpose(p_handle, path, 5, 0);
+    BOOST_REQUIRE(error == 0);
+
+    SMO_init(&t_handle);
+    error = SMO_open(t_handle, path);
+    BOOST_REQUIRE(error == 0);
+
+    // series and period results must read the same in either layout
+    error = SMO_getNodeSeries(p_handle, 2, SMO_invert_depth, 3, 35, &array,
+                              &array_dim);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getNodeSeries(t_handle, 2, SMO_invert_depth, 3, 35, &t_array,
+                              &t_dim);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(array, array + array_dim,
+                                  t_array, t_array + t_dim);
+    SMO_freeMemory((void*)array);
+    SMO_freeMemory((void*)t_array);
+
+    error = SMO_getLinkResult(p_handle, 33, 1, &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getLinkResult(t_handle, 33, 1, &t_array, &t_dim);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(array, array + array_dim,
+                                  t_array, t_array + t_dim);
+    SMO_freeMemory((void*)t_array);
+
+    SMO_close(t_handle);
+    remove(path);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_transposeCompressed, Fixture) {
+    const char* path = "./test_example1_compressed.out";
+    SMO_Handle  t_handle = NULL;
+    float*      t_array = NULL;
+    int         t_dim = 0;
+
+    error = SMO_transpose(p_handle, path, 8, 1);
+    BOOST_REQUIRE(error == 0);
+
+    SMO_init(&t_handle);
+    error = SMO_open(t_handle, path);
+    BOOST_REQUIRE(error == 0);
+
+    // compression must be lossless
+    error = SMO_getSystemSeries(p_handle, SMO_runoff_flow, 0, 35, &array,
+                                &array_dim);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getSystemSeries(t_handle, SMO_runoff_flow, 0, 35, &t_array,
+                                &t_dim);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(array, array + array_dim,
+                                  t_array, t_array + t_dim);
+    SMO_freeMemory((void*)array);
+    SMO_freeMemory((void*)t_array);
+
+    error = SMO_getSubcatchResult(p_handle, 20, 3, &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getSubcatchResult(t_handle, 20, 3, &t_array, &t_dim);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(array, array + array_dim,
+                                  t_array, t_array + t_dim);
+    SMO_freeMemory((void*)t_array);
+
+    SMO_close(t_handle);
+    remove(path);
+
+    // a compressed file must be saved in blocks
+    error = SMO_transpose(p_handle, path, 0, 1);
+    BOOST_CHECK(error == 421);
+}
+
+
 BOOST_FIXTURE_TEST_CASE(test_getSubcatchResult, Fixture) {
     error = SMO_getSubcatchResult(p_handle, 1, 1, &array, &array_dim);
     BOOST_REQUIRE(error == 0);
@@ -374,3 +511,171 @@ BOOST_FIXTURE_TEST_CASE(test_getSystemResult, Fixture) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+struct VarsFixture {
+    VarsFixture() {
+        std::string path = std::string(VARS_DATA_PATH);
+
+        error = SMO_init(&p_handle);
+        SMO_clearError(p_handle);
+        error = SMO_open(p_handle, path.c_str());
+
+        array     = NULL;
+        array_dim = 0;
+    }
+    ~VarsFixture() {
+        SMO_freeMemory((void*)array);
+        error = SMO_close(p_handle);
+    }
+
+    std::string path;
+    int         error;
+    SMO_Handle  p_handle;
+
+    float* array;
+    int    array_dim;
+};
+
+BOOST_AUTO_TEST_SUITE(test_output_vars_fixture)
+
+BOOST_FIXTURE_TEST_CASE(test_openVars, VarsFixture) {
+    BOOST_REQUIRE(error == 0);
+
+    int* i_array = NULL;
+    error = SMO_getProjectSize(p_handle, &i_array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    // the same project as the full results
+    const int ref_dim            = 5;
+    int       ref_array[ref_dim] = {8, 14, 13, 1, 2};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_array, ref_array + ref_dim,
+                                  i_array, i_array + array_dim);
+    SMO_freeMemory((void*)i_array);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getSavedVariables, VarsFixture) {
+    int* i_array = NULL;
+
+    // only the selected variables are listed, in increasing order
+    error = SMO_getSavedVariables(p_handle, SMO_subcatch, &i_array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    int ref_subcatch[] = {SMO_rainfall_subcatch, SMO_runoff_rate,
+                          SMO_pollutant_conc_subcatch + 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_subcatch, ref_subcatch + 3,
+                                  i_array, i_array + array_dim);
+    SMO_freeMemory((void*)i_array);
+
+    error = SMO_getSavedVariables(p_handle, SMO_node, &i_array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    int ref_node[] = {SMO_invert_depth, SMO_flooding_losses,
+                      SMO_pollutant_conc_node};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_node, ref_node + 3,
+                                  i_array, i_array + array_dim);
+    SMO_freeMemory((void*)i_array);
+
+    error = SMO_getSavedVariables(p_handle, SMO_link, &i_array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    int ref_link[] = {SMO_flow_rate_link, SMO_capacity,
+                      SMO_pollutant_conc_link + 1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_link, ref_link + 3,
+                                  i_array, i_array + array_dim);
+    SMO_freeMemory((void*)i_array);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getSeries, VarsFixture) {
+    // a saved series matches the one from a run saving all variables
+    error = SMO_getSubcatchSeries(p_handle, 1, SMO_runoff_rate, 0, 10, &array,
+                                  &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    const int ref_dim            = 11;
+    float     ref_array[ref_dim] = {
+        0.0f, 1.243824f, 2.563968f, 4.524055f, 2.511513f, 0.6980814f,
+		0.04089493f, 0.01160567f, 0.0f, 0.0f, 0.0f};
+
+    std::vector<float> ref_vec;
+    ref_vec.assign(ref_array, ref_array + ref_dim);
+
+    std::vector<float> test_vec;
+    test_vec.assign(array, array + array_dim);
+
+    BOOST_CHECK(check_cdd_float(test_vec, ref_vec, 3));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getUnsavedSeries, VarsFixture) {
+    // a series that was not saved is an invalid parameter
+    error = SMO_getSubcatchSeries(p_handle, 1, SMO_infil_loss, 0, 10, &array,
+                                  &array_dim);
+    BOOST_CHECK(error == 421);
+    BOOST_CHECK(array == NULL);
+
+    error = SMO_getNodeSeries(p_handle, 2, SMO_hydraulic_head, 0, 10, &array,
+                              &array_dim);
+    BOOST_CHECK(error == 421);
+    BOOST_CHECK(array == NULL);
+
+    error = SMO_getLinkSeries(p_handle, 3, SMO_flow_velocity, 0, 10, &array,
+                              &array_dim);
+    BOOST_CHECK(error == 421);
+    BOOST_CHECK(array == NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getSubcatchResult, VarsFixture) {
+    error = SMO_getSubcatchResult(p_handle, 1, 1, &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    // all attributes are returned, with those not saved set to 0
+    const int ref_dim            = 10;
+    float     ref_array[ref_dim] = {
+		0.5f, 0.0f, 0.0f, 0.0f, 1.2438242f,
+        0.0f, 0.0f, 0.0f, 0.0f, 6.6963983f};
+
+    std::vector<float> ref_vec;
+    ref_vec.assign(ref_array, ref_array + ref_dim);
+
+    std::vector<float> test_vec;
+    test_vec.assign(array, array + array_dim);
+
+    BOOST_REQUIRE(array_dim == ref_dim);
+    BOOST_CHECK(check_cdd_float(test_vec, ref_vec, 3));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getNodeResult, VarsFixture) {
+    error = SMO_getNodeResult(p_handle, 2, 2, &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    const int ref_dim        = 8;
+    float ref_array[ref_dim] = {
+		0.29606342f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+		15.367908f, 0.0f};
+
+    std::vector<float> ref_vec;
+    ref_vec.assign(ref_array, ref_array + ref_dim);
+
+    std::vector<float> test_vec;
+    test_vec.assign(array, array + array_dim);
+
+    BOOST_REQUIRE(array_dim == ref_dim);
+    BOOST_CHECK(check_cdd_float(test_vec, ref_vec, 3));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_getLinkResult, VarsFixture) {
+    error = SMO_getLinkResult(p_handle, 3, 3, &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    const int ref_dim        = 7;
+    float ref_array[ref_dim] = {
+		4.631762f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+		3.8183229f};
+
+    std::vector<float> ref_vec;
+    ref_vec.assign(ref_array, ref_array + ref_dim);
+
+    std::vector<float> test_vec;
+    test_vec.assign(array, array + array_dim);
+
+    BOOST_REQUIRE(array_dim == ref_dim);
+    BOOST_CHECK(check_cdd_float(test_vec, ref_vec, 3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
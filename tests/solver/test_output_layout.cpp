@@ -0,0 +1,207 @@
+/*
+ *   test_output_layout.cpp
+ *
+ *   Created: 10/18/2026
+ *
+ *   Tests that results saved to the binary output file in the ELEMENT and
+ *   COMPRESSED layouts read back through the output API the same as those
+ *   saved in the default PERIOD layout.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <string>
+
+#include "test_solver.hpp"
+#include "swmm_output.h"
+
+#define LAYOUT_PATH_INP "tmp_layout.inp"
+#define LAYOUT_PATH_RPT "tmp_layout.rpt"
+#define PERIOD_PATH_OUT "tmp_period.out"
+#define LAYOUT_PATH_OUT "tmp_layout.out"
+
+#define ERR_NONE 0
+
+
+// Runs the example model with a line added to its [REPORT] section
+static int runWithReportLine(const char* reportLine, const char* outFile)
+{
+    std::ifstream in(DATA_PATH_INP);
+    std::ofstream out(LAYOUT_PATH_INP);
+    std::string   line;
+
+    while (std::getline(in, line)) {
+        out << line << "\n";
+        if (line.compare(0, 8, "[REPORT]") == 0)
+            out << reportLine << "\n";
+    }
+    out.close();
+
+    double elapsedTime = 0.0;
+    int    error = swmm_open(LAYOUT_PATH_INP, LAYOUT_PATH_RPT, outFile);
+    if (!error) error = swmm_start(1);
+    while (!error) {
+        error = swmm_step(&elapsedTime);
+        if (elapsedTime == 0.0) break;
+    }
+    if (!error) error = swmm_end();
+    swmm_close();
+    return error;
+}
+
+static long fileSize(const char* path)
+{
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    return (long)f.tellg();
+}
+
+// Checks that a series is read back the same from both files
+template <typename Attr, typename Getter>
+static void checkSeries(Getter getSeries, SMO_Handle ref, SMO_Handle test,
+    int index, Attr attr, int nPeriods)
+{
+    float *refArray = NULL, *testArray = NULL;
+    int    refDim = 0, testDim = 0;
+
+    BOOST_REQUIRE(getSeries(ref, index, attr, 0, nPeriods - 1, &refArray,
+                            &refDim) == ERR_NONE);
+    BOOST_REQUIRE(getSeries(test, index, attr, 0, nPeriods - 1, &testArray,
+                            &testDim) == ERR_NONE);
+    BOOST_CHECK_EQUAL_COLLECTIONS(refArray, refArray + refDim,
+                                  testArray, testArray + testDim);
+    SMO_freeMemory((void*)refArray);
+    SMO_freeMemory((void*)testArray);
+}
+
+// Checks that all results of one period are read back the same from both
+// files
+template <typename Getter>
+static void checkPeriod(Getter getResult, SMO_Handle ref, SMO_Handle test,
+    int period, int index)
+{
+    float *refArray = NULL, *testArray = NULL;
+    int    refDim = 0, testDim = 0;
+
+    BOOST_REQUIRE(getResult(ref, period, index, &refArray, &refDim) ==
+                  ERR_NONE);
+    BOOST_REQUIRE(getResult(test, period, index, &testArray, &testDim) ==
+                  ERR_NONE);
+    BOOST_CHECK_EQUAL_COLLECTIONS(refArray, refArray + refDim,
+                                  testArray, testArray + testDim);
+    SMO_freeMemory((void*)refArray);
+    SMO_freeMemory((void*)testArray);
+}
+
+// Checks that every saved result of the layout's file matches the one
+// saved period by period
+static void checkSameResults(const char* refPath, const char* testPath)
+{
+    SMO_Handle ref = NULL, test = NULL;
+    int *refSize = NULL, *testSize = NULL, *vars = NULL;
+    int  sizeDim, nVars, refPeriods, testPeriods;
+    int  i, j, p;
+
+    BOOST_REQUIRE(SMO_init(&ref) == ERR_NONE);
+    BOOST_REQUIRE(SMO_init(&test) == ERR_NONE);
+    BOOST_REQUIRE(SMO_open(ref, refPath) == ERR_NONE);
+    BOOST_REQUIRE(SMO_open(test, testPath) == ERR_NONE);
+
+    BOOST_REQUIRE(SMO_getProjectSize(ref, &refSize, &sizeDim) == ERR_NONE);
+    BOOST_REQUIRE(SMO_getProjectSize(test, &testSize, &sizeDim) == ERR_NONE);
+    BOOST_CHECK_EQUAL_COLLECTIONS(refSize, refSize + sizeDim,
+                                  testSize, testSize + sizeDim);
+
+    BOOST_REQUIRE(SMO_getTimes(ref, SMO_numPeriods, &refPeriods) == ERR_NONE);
+    BOOST_REQUIRE(SMO_getTimes(test, SMO_numPeriods, &testPeriods) ==
+                  ERR_NONE);
+    BOOST_REQUIRE_EQUAL(refPeriods, testPeriods);
+
+    // --- each saved series of each element
+    BOOST_REQUIRE(SMO_getSavedVariables(test, SMO_subcatch, &vars, &nVars) ==
+                  ERR_NONE);
+    for (i = 0; i < testSize[0]; i++)
+        for (j = 0; j < nVars; j++)
+            checkSeries(SMO_getSubcatchSeries, ref, test, i,
+                        (SMO_subcatchAttribute)vars[j], refPeriods);
+    SMO_freeMemory((void*)vars);
+
+    BOOST_REQUIRE(SMO_getSavedVariables(test, SMO_node, &vars, &nVars) ==
+                  ERR_NONE);
+    for (i = 0; i < testSize[1]; i++)
+        for (j = 0; j < nVars; j++)
+            checkSeries(SMO_getNodeSeries, ref, test, i,
+                        (SMO_nodeAttribute)vars[j], refPeriods);
+    SMO_freeMemory((void*)vars);
+
+    BOOST_REQUIRE(SMO_getSavedVariables(test, SMO_link, &vars, &nVars) ==
+                  ERR_NONE);
+    for (i = 0; i < testSize[2]; i++)
+        for (j = 0; j < nVars; j++)
+            checkSeries(SMO_getLinkSeries, ref, test, i,
+                        (SMO_linkAttribute)vars[j], refPeriods);
+    SMO_freeMemory((void*)vars);
+
+    BOOST_REQUIRE(SMO_getSavedVariables(test, SMO_sys, &vars, &nVars) ==
+                  ERR_NONE);
+    for (j = 0; j < nVars; j++) {
+        float *refArray = NULL, *testArray = NULL;
+        int    refDim = 0, testDim = 0;
+        BOOST_REQUIRE(SMO_getSystemSeries(ref, (SMO_systemAttribute)vars[j],
+            0, refPeriods - 1, &refArray, &refDim) == ERR_NONE);
+        BOOST_REQUIRE(SMO_getSystemSeries(test, (SMO_systemAttribute)vars[j],
+            0, refPeriods - 1, &testArray, &testDim) == ERR_NONE);
+        BOOST_CHECK_EQUAL_COLLECTIONS(refArray, refArray + refDim,
+                                      testArray, testArray + testDim);
+        SMO_freeMemory((void*)refArray);
+        SMO_freeMemory((void*)testArray);
+    }
+    SMO_freeMemory((void*)vars);
+
+    // --- all results of an element in a period, for the first and last
+    //     periods and one inside a block
+    int periods[] = {0, refPeriods / 2, refPeriods - 1};
+    for (p = 0; p < 3; p++) {
+        for (i = 0; i < testSize[0]; i++)
+            checkPeriod(SMO_getSubcatchResult, ref, test, periods[p], i);
+        for (i = 0; i < testSize[1]; i++)
+            checkPeriod(SMO_getNodeResult, ref, test, periods[p], i);
+        for (i = 0; i < testSize[2]; i++)
+            checkPeriod(SMO_getLinkResult, ref, test, periods[p], i);
+        checkPeriod(SMO_getSystemResult, ref, test, periods[p], 0);
+    }
+
+    SMO_freeMemory((void*)refSize);
+    SMO_freeMemory((void*)testSize);
+    SMO_close(ref);
+    SMO_close(test);
+}
+
+
+BOOST_AUTO_TEST_SUITE(test_output_layout)
+
+BOOST_AUTO_TEST_CASE(element_layout)
+{
+    BOOST_REQUIRE(runWithReportLine("LAYOUT PERIOD", PERIOD_PATH_OUT) ==
+                  ERR_NONE);
+
+    // --- a block size that doesn't divide the number of periods leaves a
+    //     partly filled last block
+    BOOST_REQUIRE(runWithReportLine("LAYOUT ELEMENT 7", LAYOUT_PATH_OUT) ==
+                  ERR_NONE);
+    BOOST_CHECK(fileSize(LAYOUT_PATH_OUT) != fileSize(PERIOD_PATH_OUT));
+    checkSameResults(PERIOD_PATH_OUT, LAYOUT_PATH_OUT);
+}
+
+BOOST_AUTO_TEST_CASE(compressed_layout)
+{
+    BOOST_REQUIRE(runWithReportLine("LAYOUT PERIOD", PERIOD_PATH_OUT) ==
+                  ERR_NONE);
+
+    BOOST_REQUIRE(runWithReportLine("LAYOUT COMPRESSED 5", LAYOUT_PATH_OUT) ==
+                  ERR_NONE);
+    BOOST_CHECK(fileSize(LAYOUT_PATH_OUT) < fileSize(PERIOD_PATH_OUT));
+    checkSameResults(PERIOD_PATH_OUT, LAYOUT_PATH_OUT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
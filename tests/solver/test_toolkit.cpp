@@ -503,6 +503,50 @@ BOOST_FIXTURE_TEST_CASE(project_info_metric_dw, FixtureMetricDW){
     BOOST_CHECK_EQUAL(value, 0.015);
 }
 
+// Runs the metric DW model with a given number of threads and collects
+// every node depth and link flow at each routing step
+static void run_metric_dw(int threads, vector<double>& results)
+{
+    int error, nNodes, nLinks, i;
+    double elapsedTime = 0.0, value;
+
+    error = swmm_open(DATA_PATH_INP_METRIC_DW, DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_setSimulationParam(SM_THREADS, threads);
+    BOOST_REQUIRE(error == ERR_NONE);
+    swmm_countObjects(SM_NODE, &nNodes);
+    swmm_countObjects(SM_LINK, &nLinks);
+    error = swmm_start(0);
+    BOOST_REQUIRE(error == ERR_NONE);
+    do
+    {
+        error = swmm_step(&elapsedTime);
+        for (i = 0; i < nNodes; i++)
+        {
+            swmm_getNodeResult(i, SM_NODEDEPTH, &value);
+            results.push_back(value);
+        }
+        for (i = 0; i < nLinks; i++)
+        {
+            swmm_getLinkResult(i, SM_LINKFLOW, &value);
+            results.push_back(value);
+        }
+    } while (elapsedTime != 0 && !error);
+    BOOST_REQUIRE(error == ERR_NONE);
+    swmm_end();
+    swmm_close();
+}
+
+// Testing that DW results do not depend on the number of threads used
+BOOST_AUTO_TEST_CASE(thread_count_invariance_metric_dw) {
+    vector<double> serial, parallel;
+
+    run_metric_dw(1, serial);
+    run_metric_dw(3, parallel);
+    BOOST_REQUIRE_EQUAL(serial.size(), parallel.size());
+    BOOST_CHECK(serial == parallel);
+}
+
 // Testing for count Objects after Open
 BOOST_FIXTURE_TEST_CASE(count_objects, FixtureOpenClose){
 